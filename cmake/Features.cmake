@@ -29,7 +29,31 @@ function(SetPlatformFeatures)
     else()
         message(STATUS "Detecting platform architecture features - ${RUN_OUTPUT_RESULT}")
 
-        add_definitions("-D_F_BITS=${RUN_RESULT}")
+        # The exit code only holds the lowest 8 feature bits so rebuild the
+        # feature bits from the names of the detected features instead. The
+        # names must be listed in the same order as the bits in Features.h.
+        set(FEATURE_NAMES MMX SSE SSE2 SSE3 SSSE3 SSE4.1 SSE4.2 FMA AVX AVX2 F16C)
+        string(REPLACE ", " ";" DETECTED_FEATURES "${RUN_OUTPUT_RESULT}")
+
+        set(FEATURE_BITS 0)
+        set(FEATURE_BIT 1)
+        foreach(FEATURE_NAME ${FEATURE_NAMES})
+            list(FIND DETECTED_FEATURES ${FEATURE_NAME} FEATURE_INDEX)
+            if(NOT FEATURE_INDEX EQUAL -1)
+                math(EXPR FEATURE_BITS "${FEATURE_BITS} | ${FEATURE_BIT}")
+            endif()
+            math(EXPR FEATURE_BIT "${FEATURE_BIT} << 1")
+        endforeach()
+
+        if(VECTOR_RUNTIME_DISPATCH)
+            # Build for the x86-64 baseline and select kernels for the other
+            # instruction sets at run time, see SphereKernels.h.
+            message(STATUS "Using runtime dispatch - baseline SSE2")
+            add_definitions("-D_F_BITS=7" "-D_RUNTIME_DISPATCH=1")
+            return()
+        endif()
+
+        add_definitions("-D_F_BITS=${FEATURE_BITS}")
 
         # Enable enhanced instruction set if available
         if(RUN_OUTPUT_RESULT MATCHES "AVX2")
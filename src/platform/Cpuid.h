@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Features.h"
+
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif // defined(_MSC_VER)
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Detection of the features supported by the processor the program is running
+ * on, as opposed to the features enabled at build time by `_F_BITS`. This is
+ * used at configure time to determine `_F_BITS` for native builds and at run
+ * time to select kernels when built with runtime dispatch.
+ */
+
+namespace cpuid {
+
+enum Register {
+    EAX = 0,
+    EBX = 1,
+    ECX = 2,
+    EDX = 3,
+};
+
+struct Feature {
+    int         feature_bits;   //  internal feature bit mask
+    char const* feature_name;
+    int         function_index; //  cpuid function index
+    Register    register_index; //  cpuid register index
+    int         register_bits;  //  cpuid register bit mask
+};
+
+//! List of features to be queried for support, in order of feature bits.
+constexpr Feature features[] = {
+    { _F_MMX,    "mmx",    1, EDX, (1<<23) },
+    { _F_SSE,    "sse",    1, EDX, (1<<25) },
+    { _F_SSE2,   "sse2",   1, EDX, (1<<26) },
+    { _F_SSE3,   "sse3",   1, ECX, (1<< 0) },
+    { _F_SSSE3,  "ssse3",  1, ECX, (1<< 9) },
+    { _F_SSE4_1, "sse4.1", 1, ECX, (1<<19) },
+    { _F_SSE4_2, "sse4.2", 1, ECX, (1<<20) },
+    { _F_FMA,    "fma",    1, ECX, (1<<12) },
+    { _F_AVX,    "avx",    1, ECX, (1<<28) },
+    { _F_AVX2,   "avx2",   7, EBX, (1<< 5) },
+    { _F_F16C,   "f16c",   1, ECX, (1<<29) },
+};
+
+constexpr size_t num_features = sizeof(features) / sizeof(features[0]);
+
+//! Features which use the 256-bit registers, see `os_saves_ymm`.
+constexpr int ymm_features = _F_FMA | _F_AVX | _F_AVX2 | _F_F16C;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query cpuid `function` and `subfunction` into `registers`.
+inline void query(int (&registers)[4], int function, int subfunction)
+{
+#if defined(_MSC_VER)
+    __cpuidex(registers, function, subfunction);
+#else
+    __asm__ ("cpuid\n\t"
+            :"=a" (registers[0]), "=b" (registers[1]), "=c" (registers[2]), "=d" (registers[3])
+            :"0" (function), "2" (subfunction) );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check for the presence of an individual feature.
+inline bool check_feature(Feature const& f)
+{
+    int registers[4];
+
+    // get highest available function index
+    query(registers, 0, 0);
+    int max_function = registers[0];
+
+    // check if feature function is available
+    if (max_function < f.function_index) {
+        return false;
+    }
+
+    // check feature register bits
+    query(registers, f.function_index, 0);
+    if (!(registers[f.register_index] & f.register_bits)) {
+        return false;
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Returns true if the operating system saves the upper halves of the 256-bit
+//! registers on context switches, without which AVX cannot be used even if the
+//! processor supports it.
+inline bool os_saves_ymm()
+{
+    int registers[4];
+
+    // check for xgetbv support (OSXSAVE)
+    query(registers, 1, 0);
+    if (!(registers[ECX] & (1<<27))) {
+        return false;
+    }
+
+    // check that both SSE and AVX state are enabled in XCR0
+#if defined(_MSC_VER)
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ ("xgetbv\n\t" : "=a" (eax), "=d" (edx) : "c" (0));
+    unsigned long long xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+    return (xcr0 & 0x6) == 0x6;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Return the feature bits supported by the processor and operating system.
+inline int detect_features()
+{
+    int bits = 0;
+    for (auto const& f: features) {
+        if (check_feature(f)) {
+            bits |= f.feature_bits;
+        }
+    }
+
+    if (bits & ymm_features && !os_saves_ymm()) {
+        bits &= ~ymm_features;
+    }
+
+    return bits;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Return the feature bits supported at run time, detected on first use.
+inline int runtime_features()
+{
+    static int const bits = detect_features();
+    return bits;
+}
+
+} // namespace cpuid
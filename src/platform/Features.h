@@ -10,12 +10,27 @@
 #define _F_FMA      (1<< 7)
 #define _F_AVX      (1<< 8)
 #define _F_AVX2     (1<< 9)
+#define _F_F16C     (1<<10)
 
 #ifndef _F_BITS
     //! If feature bits are not defined assume all features are available.
     #define _F_BITS     0xffffffff
 #endif //_F_BITS
 
+#ifndef _RUNTIME_DISPATCH
+    //! If runtime dispatch is not defined kernels are selected by `_F_BITS`,
+    //! otherwise `_F_BITS` is the baseline and kernels for other instruction
+    //! sets are selected at run time.
+    #define _RUNTIME_DISPATCH 0
+#endif //_RUNTIME_DISPATCH
+
+#ifndef _FUSED_EXPRESSIONS
+    //! If fused expressions are enabled, products of intrinsic scalars and
+    //! vectors are deferred so that a following addition or subtraction can
+    //! be fused into a multiply-add, see `intrinsic::_v_product`.
+    #define _FUSED_EXPRESSIONS 0
+#endif //_FUSED_EXPRESSIONS
+
 #define _HAS_FEATURE(x) (!!(_F_BITS & (x)))
 
 #define _HAS_MMX        _HAS_FEATURE( _F_MMX    )
@@ -28,3 +43,4 @@
 #define _HAS_FMA        _HAS_FEATURE( _F_FMA    )
 #define _HAS_AVX        _HAS_FEATURE( _F_AVX    )
 #define _HAS_AVX2       _HAS_FEATURE( _F_AVX2   )
+#define _HAS_F16C       _HAS_FEATURE( _F_F16C   )
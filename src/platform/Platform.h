@@ -32,6 +32,14 @@ inline void printf_s(char const* fmt, ...)
 #define UNREACHABLE (void )0
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+// GCC and Clang support generic vector types, see `vector/Portable.h`
+#if defined(__GNUC__) || defined(__clang__)
+#   define _HAS_VECTOR_EXTENSIONS 1
+#else
+#   define _HAS_VECTOR_EXTENSIONS 0
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // Workaround for Clang/C2 which defines _DEBUG and NDEBUG at the same time
 #if _DEBUG && NDEBUG
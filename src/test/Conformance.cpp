@@ -3,11 +3,27 @@
 #include "vector/Reference.h"
 #include "vector/Intrinsic.h"
 #include "vector/Aliased.h"
+#if _HAS_AVX
+#include "vector/Avx.h"
+#endif // _HAS_AVX
+#include "vector/Packet.h"
+#include "vector/Random.h"
+#include "vector/IntrinsicDouble.h"
+#include "vector/Intersect.h"
+#if _HAS_VECTOR_EXTENSIONS
+#include "vector/Portable.h"
+#endif // _HAS_VECTOR_EXTENSIONS
+
+#include "trace/Trace.h"
 
 #include "Platform.h"
+#if _RUNTIME_DISPATCH
+#include "Cpuid.h"
+#endif // _RUNTIME_DISPATCH
 
 #include <cstdio>
 #include <cmath>
+#include <cstring>
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Macro for defining a conformance test.
@@ -64,6 +80,40 @@ TEST(testComparison) {
     EXPECT_TRUE(a != b);
 }
 
+//------------------------------------------------------------------------------
+TEST(testSelect) {
+    S s(1.0f);
+    S t(2.0f);
+    V a(1.0f, 2.0f, 3.0f, 4.0f);
+    V b(1.0f, 1.0f, 2.0f, 3.0f);
+
+    EXPECT_TRUE(s < t);
+    EXPECT_FALSE(t < s);
+
+    // Comparisons of scalars convert implicitly to bool
+    bool lt = s < t;
+    bool gt = s > t;
+    EXPECT_TRUE(lt);
+    EXPECT_FALSE(gt);
+    EXPECT_TRUE(Any(s < t) && All(s < t) && !None(s < t));
+    EXPECT_TRUE(!Any(s > t) && !All(s > t) && None(s > t));
+    EXPECT_TRUE(All((s < t) & (s <= t)));
+    EXPECT_TRUE(None((s > t) & (s <= t)));
+    EXPECT_TRUE(All((s > t) | (s <= t)));
+
+    EXPECT_EQ(Select(s < t, s, t), s);
+    EXPECT_EQ(Select(s > t, s, t), t);
+    EXPECT_EQ(Select(s < t, a, b), a);
+    EXPECT_EQ(Select(s > t, a, b), b);
+
+    // Conditional assignment
+    V c = b;
+    c = Select(s == s, a, c);
+    EXPECT_EQ(c, a);
+    c = Select(s != s, b, c);
+    EXPECT_EQ(c, a);
+}
+
 //------------------------------------------------------------------------------
 TEST(testElements) {
     V a(1.0f, 2.0f, 3.0f, 4.0f);
@@ -84,6 +134,36 @@ TEST(testElements) {
     EXPECT_EQ(b, V(-1.0f, -2.0f, -3.0f, -4.0f));
 }
 
+//------------------------------------------------------------------------------
+TEST(testSwizzle) {
+    V a(1.0f, 2.0f, 3.0f, 4.0f);
+
+    EXPECT_EQ(a.template Extract<0>(), S(1.0f));
+    EXPECT_EQ(a.template Extract<1>(), S(2.0f));
+    EXPECT_EQ(a.template Extract<2>(), S(3.0f));
+    EXPECT_EQ(a.template Extract<3>(), S(4.0f));
+
+    EXPECT_EQ(a.template Insert<0>(S(-1.0f)), V(-1.0f, 2.0f, 3.0f, 4.0f));
+    EXPECT_EQ(a.template Insert<1>(S(-1.0f)), V(1.0f, -1.0f, 3.0f, 4.0f));
+    EXPECT_EQ(a.template Insert<2>(S(-1.0f)), V(1.0f, 2.0f, -1.0f, 4.0f));
+    EXPECT_EQ(a.template Insert<3>(S(-1.0f)), V(1.0f, 2.0f, 3.0f, -1.0f));
+
+    EXPECT_EQ((a.template Swizzle<0, 1, 2, 3>()), a);
+    EXPECT_EQ((a.template Swizzle<3, 2, 1, 0>()), V(4.0f, 3.0f, 2.0f, 1.0f));
+    EXPECT_EQ((a.template Swizzle<1, 2, 0, 3>()), V(2.0f, 3.0f, 1.0f, 4.0f));
+    EXPECT_EQ((a.template Swizzle<2, 2, 2, 2>()), V(3.0f, 3.0f, 3.0f, 3.0f));
+    EXPECT_EQ((a.template Swizzle<0, 0, 1, 1>()), V(1.0f, 1.0f, 2.0f, 2.0f));
+
+    // Element access with an index which is only known at run time.
+    for (size_t ii = 0; ii < 4; ++ii) {
+        V b = a;
+        b[ii] = -S(b[ii]);
+        for (size_t jj = 0; jj < 4; ++jj) {
+            EXPECT_EQ(b[jj], S(ii == jj ? -float(jj + 1) : float(jj + 1)));
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 TEST(testAlgebraic) {
     V a(1.0f, 2.0f, 3.0f, 4.0f);
@@ -99,6 +179,30 @@ TEST(testAlgebraic) {
     EXPECT_EQ((c + d) * a, c * a + d * a);
 }
 
+//------------------------------------------------------------------------------
+TEST(testFusedExpressions) {
+    V a(1.0f, 2.0f, 3.0f, 4.0f);
+    V b(2.0f, 3.0f, 4.0f, 5.0f);
+    S c = 0.5f;
+    S d = 3.0f;
+    S e = 2.0f;
+
+    // Values are exact with or without fused multiply-add.
+    EXPECT_EQ(a * c + b, V(2.5f, 4.0f, 5.5f, 7.0f));
+    EXPECT_EQ(b + c * a, V(2.5f, 4.0f, 5.5f, 7.0f));
+    EXPECT_EQ(a * d - b, V(1.0f, 3.0f, 5.0f, 7.0f));
+    EXPECT_EQ(b - a * d, V(-1.0f, -3.0f, -5.0f, -7.0f));
+    EXPECT_EQ(a * c + b * d, V(6.5f, 10.0f, 13.5f, 17.0f));
+    EXPECT_EQ(a * d - b * c, V(2.0f, 4.5f, 7.0f, 9.5f));
+
+    EXPECT_EQ(c * d + e, S(3.5f));
+    EXPECT_EQ(e - c * d, S(0.5f));
+    EXPECT_EQ(d * d - 4.0f * c * e, S(5.0f));
+    EXPECT_EQ(S(d * e), S(6.0f));
+    EXPECT_EQ((a * c) * b, S(20.0f));
+    EXPECT_EQ(-(a * e), V(-2.0f, -4.0f, -6.0f, -8.0f));
+}
+
 //------------------------------------------------------------------------------
 TEST(testLength) {
     V a(1.0f, 2.0f, 3.0f, 4.0f);
@@ -136,6 +240,187 @@ TEST(testCrossProduct) {
     EXPECT_EQ(a % b + b % a, V(0.0f, 0.0f, 0.0f, 0.0f));
 }
 
+//------------------------------------------------------------------------------
+TEST(testComponentWise) {
+    V a(1.0f, -2.5f, 3.5f, -4.0f);
+    V b(2.0f, -3.0f, 3.0f, 4.0f);
+
+    EXPECT_EQ(a.Min(b), V(1.0f, -3.0f, 3.0f, -4.0f));
+    EXPECT_EQ(a.Max(b), V(2.0f, -2.5f, 3.5f, 4.0f));
+    EXPECT_EQ(a.Clamp(V(0.0f, -2.0f, 0.0f, -5.0f), V(.5f, 2.0f, 3.0f, 5.0f)), V(.5f, -2.0f, 3.0f, -4.0f));
+    EXPECT_EQ(a.Clamp(S(-1.0f), S(1.0f)), V(1.0f, -1.0f, 1.0f, -1.0f));
+    EXPECT_EQ(a.Lerp(b, S(0.0f)), a);
+    EXPECT_EQ(a.Lerp(b, S(1.0f)), b);
+    EXPECT_EQ(a.Lerp(b, S(.5f)), V(1.5f, -2.75f, 3.25f, 0.0f));
+    EXPECT_EQ(a.Abs(), V(1.0f, 2.5f, 3.5f, 4.0f));
+    EXPECT_EQ(a.Floor(), V(1.0f, -3.0f, 3.0f, -4.0f));
+    EXPECT_EQ(a.Ceil(), V(1.0f, -2.0f, 4.0f, -4.0f));
+
+    //  Values which are already integers, including those which cannot be
+    //  converted to 32-bit integers.
+    V c(-0.0f, 8388609.0f, -1e10f, 1e30f);
+    EXPECT_EQ(c.Floor(), c);
+    EXPECT_EQ(c.Ceil(), c);
+    V d(-.25f, .25f, -8388607.5f, 8388607.5f);
+    EXPECT_EQ(d.Floor(), V(-1.0f, 0.0f, -8388608.0f, 8388607.0f));
+    EXPECT_EQ(d.Ceil(), V(-0.0f, 1.0f, -8388607.0f, 8388608.0f));
+}
+
+//------------------------------------------------------------------------------
+TEST(testReduction) {
+    V a(1.0f, -2.5f, 3.5f, -4.0f);
+
+    EXPECT_EQ(a.HorizontalMin(), S(-4.0f));
+    EXPECT_EQ(a.HorizontalMax(), S(3.5f));
+    EXPECT_EQ(a.HorizontalSum(), S(-2.0f));
+    EXPECT_EQ(V(4.0f, 3.0f, 2.0f, 1.0f).HorizontalMin(), S(1.0f));
+    EXPECT_EQ(V(4.0f, 3.0f, 2.0f, 1.0f).HorizontalMax(), S(4.0f));
+
+    //  Arrays with a count which is not a multiple of the width of the wider
+    //  implementations, with the extremes in each position.
+    constexpr size_t kCount = 19;
+    V src[kCount];
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        float f = float(ii) - 9.0f;
+        src[ii] = V(f, -.5f * f, .25f * f * f, 1.0f);
+    }
+
+    V min, max;
+    V::Bounds(src, kCount, min, max);
+    EXPECT_EQ(min, V(-9.0f, -4.5f, 0.0f, 1.0f));
+    EXPECT_EQ(max, V(9.0f, 4.5f, 20.25f, 1.0f));
+    EXPECT_EQ(V::MaxLength(src, kCount), src[0].Length());
+
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        V tmp[kCount];
+        for (size_t jj = 0; jj < kCount; ++jj) {
+            tmp[jj] = src[jj] * S(.125f);
+        }
+        tmp[ii] = V(-100.0f, 100.0f, 0.0f, -4.0f);
+
+        V tmin = tmp[0];
+        V tmax = tmp[0];
+        for (size_t jj = 1; jj < kCount; ++jj) {
+            tmin = tmin.Min(tmp[jj]);
+            tmax = tmax.Max(tmp[jj]);
+        }
+
+        V::Bounds(tmp, kCount, min, max);
+        EXPECT_EQ(min, tmin);
+        EXPECT_EQ(max, tmax);
+        EXPECT_EQ(V::MaxLength(tmp, kCount), tmp[ii].Length());
+    }
+
+    V::Bounds(src, 0, min, max);
+    EXPECT_EQ(min, V(HUGE_VALF, HUGE_VALF, HUGE_VALF, HUGE_VALF));
+    EXPECT_EQ(max, V(-HUGE_VALF, -HUGE_VALF, -HUGE_VALF, -HUGE_VALF));
+    EXPECT_EQ(V::MaxLength(src, 0), S(0.0f));
+}
+
+//------------------------------------------------------------------------------
+TEST(testHalfVector) {
+    using H = decltype(V().ToHalfVector());
+
+    EXPECT_EQ(sizeof(H), size_t(8));
+
+    //  Values which are exactly representable.
+    V a(1.f, -2.f, .5f, 65504.f);
+    EXPECT_EQ(a.ToHalfVector().ToVector(), a);
+    EXPECT_EQ(H(1.f, -2.f, .5f, 65504.f).ToVector(), a);
+
+    //  Subnormals, 2^-24 is the smallest.
+    V b(std::ldexp(1.f, -24), std::ldexp(1.f, -14) - std::ldexp(1.f, -24), -std::ldexp(3.f, -24), 0.f);
+    EXPECT_EQ(b.ToHalfVector().ToVector(), b);
+
+    //  Round to nearest even, including ties.
+    V c(1.f + std::ldexp(1.f, -11),         // tie rounds down to 1
+        1.f + std::ldexp(3.f, -11),         // tie rounds up to 1 + 2^-9
+        65519.f,                            // rounds down to 65504
+        std::ldexp(3.f, -26));              // rounds up to 2^-24
+    V d(1.f, 1.f + std::ldexp(1.f, -9), 65504.f, std::ldexp(1.f, -24));
+    EXPECT_EQ(c.ToHalfVector().ToVector(), d);
+
+    V e(std::ldexp(1.f, -25),               // tie rounds down to 0
+        -std::ldexp(1.f, -26),              // rounds to -0
+        1.f + std::ldexp(1.f, -11) + std::ldexp(1.f, -20),
+        2049.f);                            // tie rounds down to 2048
+    V f(0.f, 0.f, 1.f + std::ldexp(1.f, -10), 2048.f);
+    EXPECT_EQ(e.ToHalfVector().ToVector(), f);
+
+    //  Conversions must match the scalar conversions, which are used when
+    //  F16C is not available, over the whole range of half precision.
+    constexpr size_t kCount = 43 * 7;
+    V src[kCount];
+    V ref[kCount];
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        float s[4];
+        for (size_t jj = 0; jj < 4; ++jj) {
+            int exponent = int(ii / 7) - 26;
+            float mantissa = 1.f + float(ii % 7 * 4 + jj) * (1.f / 28.f + 1.f / 4096.f);
+            s[jj] = std::ldexp(jj & 1 ? -mantissa : mantissa, exponent);
+        }
+        src[ii] = V(s[0], s[1], s[2], s[3]);
+        ref[ii] = V(HalfToFloat(FloatToHalf(s[0])),
+                    HalfToFloat(FloatToHalf(s[1])),
+                    HalfToFloat(FloatToHalf(s[2])),
+                    HalfToFloat(FloatToHalf(s[3])));
+        EXPECT_EQ(src[ii].ToHalfVector().ToVector(), ref[ii]);
+    }
+
+    //  Batch conversions, with an odd count for implementations which
+    //  convert pairs of vectors.
+    H half[kCount];
+    V dst[kCount];
+    H::Pack(src, half, kCount);
+    H::Unpack(half, dst, kCount);
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        EXPECT_EQ(half[ii].ToVector(), ref[ii]);
+        EXPECT_EQ(dst[ii], ref[ii]);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(testVector3) {
+    using P = decltype(V().ToVector3());
+
+    EXPECT_EQ(sizeof(P), size_t(12));
+
+    V a(1.f, -2.f, 3.f, 4.f);
+    EXPECT_EQ(a.ToVector3().ToVector(), V(1.f, -2.f, 3.f, 0.f));
+    EXPECT_EQ(a.ToVector3().ToVector(1.f), V(1.f, -2.f, 3.f, 1.f));
+    EXPECT_EQ(P(1.f, -2.f, 3.f).ToVector(4.f), a);
+
+    //  Batch conversions, with a count which is not a multiple of the width
+    //  of the wider implementations and a start which is not aligned to it.
+    constexpr size_t kCount = 11;
+    V src[kCount];
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        float f = float(ii);
+        src[ii] = V(f, -2.f * f, .5f * f, 1.f + f);
+    }
+
+    //  The element after the last packed vector must not be overwritten.
+    P packed[kCount + 2];
+    packed[kCount + 1] = P(-1.f, -1.f, -1.f);
+    P::Pack(src, packed + 1, kCount);
+    EXPECT_EQ(packed[kCount + 1].ToVector(), V(-1.f, -1.f, -1.f, 0.f));
+
+    V points[kCount + 1];
+    points[kCount] = V(-1.f, -1.f, -1.f, -1.f);
+    P::Unpack(packed + 1, points, kCount, 1.f);
+    EXPECT_EQ(points[kCount], V(-1.f, -1.f, -1.f, -1.f));
+
+    V directions[kCount];
+    P::Unpack(packed + 1, directions, kCount);
+
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        float f = float(ii);
+        EXPECT_EQ(packed[ii + 1].ToVector(1.f + f), src[ii]);
+        EXPECT_EQ(points[ii], V(f, -2.f * f, .5f * f, 1.f));
+        EXPECT_EQ(directions[ii], V(f, -2.f * f, .5f * f, 0.f));
+    }
+}
+
 //------------------------------------------------------------------------------
 TEST(testMatrixScalarProduct) {
     M A = {
@@ -250,6 +535,1087 @@ TEST(testMatrixTranspose) {
     EXPECT_EQ(A.Transpose() * B.Transpose(), (B * A).Transpose());
 }
 
+//------------------------------------------------------------------------------
+TEST(testMatrixInverse) {
+    constexpr float kEpsilon = 1e-5f;
+
+    M I = {
+        1.f, 0.f, 0.f, 0.f,
+        0.f, 1.f, 0.f, 0.f,
+        0.f, 0.f, 1.f, 0.f,
+        0.f, 0.f, 0.f, 1.f,
+    };
+
+    M A = {
+        2.f, 0.f, 1.f, 3.f,
+        1.f, 3.f, 0.f, 2.f,
+        0.f, 1.f, 4.f, 1.f,
+        3.f, 2.f, 1.f, 5.f,
+    };
+
+    M B = {
+        2.f, 1.f, 4.f, 3.f,
+        0.f, 3.f, 2.f, 1.f,
+        0.f, 0.f, .5f, 6.f,
+        0.f, 0.f, 0.f, 4.f,
+    };
+
+    // Rows of a singular matrix are linearly dependent.
+    M C = {
+        1.f, 2.f, 3.f, 4.f,
+        2.f, 3.f, 4.f, 5.f,
+        3.f, 4.f, 5.f, 6.f,
+        4.f, 5.f, 6.f, 7.f,
+    };
+
+    EXPECT_EQ_EPS(B.Determinant(), S(12.f), kEpsilon * 12.f);
+    EXPECT_EQ_EPS(B.Transpose().Determinant(), S(12.f), kEpsilon * 12.f);
+    EXPECT_EQ_EPS(C.Determinant(), S(0.f), kEpsilon);
+    EXPECT_EQ_EPS(I.Determinant(), S(1.f), kEpsilon);
+
+    M AAi = A * A.Inverse();
+    M AiA = A.Inverse() * A;
+    M BBi = B * B.Inverse();
+    for (size_t ii = 0; ii < 4; ++ii) {
+        EXPECT_EQ_EPS((AAi[ii] - I[ii]).Length(), S(0.f), kEpsilon);
+        EXPECT_EQ_EPS((AiA[ii] - I[ii]).Length(), S(0.f), kEpsilon);
+        EXPECT_EQ_EPS((BBi[ii] - I[ii]).Length(), S(0.f), kEpsilon);
+    }
+
+    // Rotation about z with non-uniform scale, followed by a translation.
+    float c = std::cos(.5f);
+    float s = std::sin(.5f);
+    M T = {
+        2.f * c, -3.f * s, 0.f, 1.f,
+        2.f * s,  3.f * c, 0.f, 2.f,
+        0.f,      0.f,     .5f, 3.f,
+        0.f,      0.f,     0.f, 1.f,
+    };
+
+    M Ti = T.Inverse();
+    M Ta = T.InverseAffine();
+    for (size_t ii = 0; ii < 4; ++ii) {
+        EXPECT_EQ_EPS((Ta[ii] - Ti[ii]).Length(), S(0.f), kEpsilon * 10.f);
+    }
+
+    M src[5] = { A, B, T, A.Transpose(), B * A };
+    M dst[5];
+    M::InverseBatch(src, dst, 5);
+    for (size_t ii = 0; ii < 5; ++ii) {
+        M Si = src[ii].Inverse();
+        for (size_t jj = 0; jj < 4; ++jj) {
+            EXPECT_EQ_EPS((dst[ii][jj] - Si[jj]).Length(), S(0.f), kEpsilon);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(testMatrixTransformBatch) {
+    constexpr float kEpsilon = 1e-5f;
+    constexpr size_t kCount = 11;
+
+    M A = {
+        1.f, 2.f, 0.f, -1.f,
+        0.f, 1.f, 3.f,  4.f,
+        2.f, 0.f, 1.f,  2.f,
+        .5f, 0.f, 0.f,  1.f,
+    };
+
+    auto point = [](size_t ii, float w) {
+        float f = float(ii);
+        return V(f - 5.f, .5f * f, 2.f - f * f, w);
+    };
+
+    V src[kCount];
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        src[ii] = point(ii, float(ii));
+    }
+
+    //  Check each combination of output alignment and store type, the output
+    //  offset exercises the unaligned head and tail of wider implementations.
+    for (size_t offset = 0; offset < 2; ++offset) {
+        for (bool stream : { false, true }) {
+            V points[kCount + 1];
+            V directions[kCount + 1];
+            A.TransformPoints(src, points + offset, kCount, stream);
+            A.TransformDirections(src, directions + offset, kCount, stream);
+
+            for (size_t ii = 0; ii < kCount; ++ii) {
+                V p = A * point(ii, 1.f);
+                V d = A * point(ii, 0.f);
+                EXPECT_EQ_EPS((points[ii + offset] - p).Length() / p.Length(), S(0.f), kEpsilon);
+                EXPECT_EQ_EPS((directions[ii + offset] - d).Length() / d.Length(), S(0.f), kEpsilon);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(testQuaternion) {
+    using Q = decltype(M().ToQuaternion());
+    constexpr float kEpsilon = 1e-5f;
+    // Interpolation coefficients may be approximated, see `_v_slerp_coeff_ps`.
+    constexpr float kSlerpEpsilon = 1e-4f;
+    constexpr float kPi = 3.14159265f;
+
+    V ax(1.f, 0.f, 0.f, 0.f);
+    V ay(0.f, 1.f, 0.f, 0.f);
+    V az(0.f, 0.f, 1.f, 0.f);
+    V axis = V(1.f, 2.f, -2.f, 0.f) / S(3.f);
+
+    Q I(0.f, 0.f, 0.f, 1.f);
+    Q qa(axis, .7f);
+    Q qb(ax, -1.3f);
+
+    // Quaternions q and -q are the same rotation.
+    auto expectSame = [](Q const& a, Q const& b, float eps) {
+        S d = a.Dot(b);
+        EXPECT_EQ_EPS(d * d, S(1.f), eps);
+    };
+
+    auto expectNear = [](V const& a, V const& b) {
+        EXPECT_EQ_EPS((a - b).Length(), S(0.f), kEpsilon);
+    };
+
+    expectNear(Q(az, .5f * kPi).Rotate(V(1.f, 0.f, 0.f, 1.f)), V(0.f, 1.f, 0.f, 1.f));
+    expectNear(Q(ax, .5f * kPi).Rotate(V(0.f, 1.f, 0.f, 0.f)), V(0.f, 0.f, 1.f, 0.f));
+    expectNear(qa.Rotate(axis), axis);
+
+    EXPECT_EQ_EPS(qa.Length(), S(1.f), kEpsilon);
+    expectSame(qa * qa.Conjugate(), I, kEpsilon);
+    expectSame(Q(2.f, -1.f, 3.f, .5f).Normalize() * I, Q(2.f, -1.f, 3.f, .5f).Normalize(), kEpsilon);
+
+    // Composition matches the matrix product and successive rotations.
+    V v(2.f, -1.f, 3.f, 1.f);
+    expectNear((qa * qb).Rotate(v), qa.Rotate(qb.Rotate(v)));
+    expectNear(M(qa) * v, qa.Rotate(v));
+
+    M Mab = M(qa * qb);
+    M MaMb = M(qa) * M(qb);
+    for (size_t ii = 0; ii < 4; ++ii) {
+        expectNear(Mab[ii], MaMb[ii]);
+    }
+
+    // Conversion from a matrix for each choice of largest component.
+    Q qs[] = { qa, qb, Q(ax, 3.f), Q(ay, 3.f), Q(az, 3.f), Q(axis, -3.1f), I };
+    for (auto const& q : qs) {
+        expectSame(M(q).ToQuaternion(), q, kEpsilon);
+    }
+
+    // Interpolation about a single axis is linear in the angle.
+    Q q0(axis, .2f);
+    Q q1(axis, 1.4f);
+    expectSame(q0.Slerp(q1, S(0.f)), q0, kSlerpEpsilon);
+    expectSame(q0.Slerp(q1, S(1.f)), q1, kSlerpEpsilon);
+    expectSame(q0.Slerp(q1, S(.3f)), Q(axis, .56f), kSlerpEpsilon);
+    expectSame(q0.Slerp(-q1, S(.3f)), Q(axis, .56f), kSlerpEpsilon);
+    expectSame(q0.Nlerp(q1, S(.5f)), Q(axis, .8f), kEpsilon);
+    expectSame(q0.Nlerp(-q1, S(.5f)), Q(axis, .8f), kEpsilon);
+    expectSame(Q(ay, -2.5f).Slerp(Q(ay, 2.5f), S(.5f)), Q(ay, kPi), kSlerpEpsilon);
+
+    constexpr size_t kCount = 7;
+    Q a[kCount], b[kCount], c[kCount];
+    float t[kCount];
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        a[ii] = Q(axis, .4f * float(ii));
+        b[ii] = Q(ii & 1 ? ay : az, 1.f - .5f * float(ii));
+        t[ii] = float(ii) / float(kCount - 1);
+    }
+
+    Q::SlerpBatch(a, b, t, c, kCount);
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        expectSame(c[ii], a[ii].Slerp(b[ii], S(t[ii])), kSlerpEpsilon);
+        EXPECT_EQ_EPS(c[ii].Length(), S(1.f), kSlerpEpsilon);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(testAffineMatrix) {
+    using A = decltype(M().ToAffineMatrix());
+    constexpr float kEpsilon = 1e-5f;
+
+    EXPECT_EQ(sizeof(A), size_t(48));
+
+    M T = {
+        0.f, -2.f,  0.f, 1.f,
+        3.f,  0.f,  0.f, 2.f,
+        0.f,  0.f,  .5f, 3.f,
+        0.f,  0.f,  0.f, 1.f,
+    };
+
+    M U = {
+        1.f,  2.f,  0.f, -1.f,
+        0.f,  1.f,  3.f,  4.f,
+        2.f,  0.f,  1.f,  2.f,
+        0.f,  0.f,  0.f,  1.f,
+    };
+
+    A Ta = {
+        0.f, -2.f,  0.f, 1.f,
+        3.f,  0.f,  0.f, 2.f,
+        0.f,  0.f,  .5f, 3.f,
+    };
+
+    A Ua = U.ToAffineMatrix();
+
+    EXPECT_EQ(T.ToAffineMatrix(), Ta);
+    EXPECT_EQ(A(T[0], T[1], T[2], T[3]), Ta);
+    EXPECT_EQ(M(Ta), T);
+    EXPECT_EQ(M(Ua), U);
+
+    auto expectNear = [](V const& a, V const& b) {
+        EXPECT_EQ_EPS((a - b).Length(), S(0.f), kEpsilon);
+    };
+
+    V p(2.f, -1.f, 3.f, 1.f);
+    V d(2.f, -1.f, 3.f, 0.f);
+    V v(2.f, -1.f, 3.f, .5f);
+
+    expectNear(Ta * p, T * p);
+    expectNear(Ta * d, T * d);
+    expectNear(Ta * v, T * v);
+    expectNear(Ta.TransformPoint(v), T * p);
+    expectNear(Ta.TransformDirection(v), T * d);
+
+    M TU = M(Ta * Ua);
+    M UT = M(Ua * Ta);
+    M TxU = T * U;
+    M UxT = U * T;
+    for (size_t ii = 0; ii < 4; ++ii) {
+        expectNear(TU[ii], TxU[ii]);
+        expectNear(UT[ii], UxT[ii]);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Compare each lane of the packet operations against the same operations on
+//! the individual vectors.
+template<typename V, typename P>
+void testPacketLanes() {
+    constexpr size_t N = P::kWidth;
+    constexpr float kEpsilon = 1e-5f;
+
+    V a[N], b[N], c[N], d[N];
+    for (size_t ii = 0; ii < N; ++ii) {
+        float f = float(ii);
+        a[ii] = V(1.0f + f, 2.0f - f, 3.0f + .5f * f, 4.0f);
+        b[ii] = V(2.0f, 3.0f + f, -4.0f + f, 5.0f - f);
+        c[ii] = V(1.0f + f, 2.0f - f, 3.0f + .5f * f, 0.0f);
+        d[ii] = V(2.0f, 3.0f + f, -4.0f + f, 0.0f);
+    }
+
+    P pa(a), pb(b), pc(c), pd(d);
+
+    auto expectLane = [](P const& p, size_t lane, V const& v) {
+        for (size_t jj = 0; jj < 4; ++jj) {
+            float scale = 1.0f + std::abs(float(v[jj]));
+            EXPECT_EQ_EPS(p[jj][lane], float(v[jj]), kEpsilon * scale);
+        }
+    };
+
+    auto expectScalar = [](float p, float s) {
+        EXPECT_EQ_EPS(p, s, kEpsilon * (1.0f + std::abs(s)));
+    };
+
+    P sum = pa + pb;
+    P difference = pa - pb;
+    P scaled = pa * pb.Length();
+    P divided = pa / pb.Length();
+    P negated = -pa;
+    P normal = pa.Normalize();
+    P cross = pc % pd;
+    P project = pa.Project(pb);
+    P reject = pa.Reject(pb);
+    P reflect = pa.Reflect(pb);
+    P hadamard = pa.Hadamard(pb);
+    auto dot = pa * pb;
+    auto length = pa.Length();
+    auto lengthsqr = pa.LengthSqr();
+
+    for (size_t ii = 0; ii < N; ++ii) {
+        expectLane(sum, ii, a[ii] + b[ii]);
+        expectLane(difference, ii, a[ii] - b[ii]);
+        expectLane(scaled, ii, a[ii] * b[ii].Length());
+        expectLane(divided, ii, a[ii] / b[ii].Length());
+        expectLane(negated, ii, -a[ii]);
+        expectLane(normal, ii, a[ii].Normalize());
+        expectLane(cross, ii, c[ii] % d[ii]);
+        expectLane(project, ii, a[ii].Project(b[ii]));
+        expectLane(reject, ii, a[ii].Reject(b[ii]));
+        expectLane(reflect, ii, a[ii].Reflect(b[ii]));
+        expectLane(hadamard, ii, a[ii].Hadamard(b[ii]));
+        expectScalar(dot[ii], float(a[ii] * b[ii]));
+        expectScalar(length[ii], float(a[ii].Length()));
+        expectScalar(lengthsqr[ii], float(a[ii].LengthSqr()));
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Check that conversions between arrays of vectors and component arrays keep
+//! every element, including the vectors which do not fill the last packet.
+template<typename P>
+void testPacketTranspose() {
+    using V = intrinsic::Vector;
+    constexpr size_t kCount = 3 * P::kWidth + 3;
+
+    V src[kCount], dst[kCount];
+    float x[kCount], y[kCount], z[kCount], w[kCount];
+    uint32_t indices[kCount];
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        float f = float(ii);
+        src[ii] = V(f, f + .25f, f + .5f, f + .75f);
+        indices[ii] = uint32_t(ii * 7 % kCount);
+    }
+
+    auto expectComponents = [&](size_t ii, float f) {
+        EXPECT_EQ(x[ii], f);
+        EXPECT_EQ(y[ii], f + .25f);
+        EXPECT_EQ(z[ii], f + .5f);
+        EXPECT_EQ(w[ii], f + .75f);
+    };
+
+    P::Transpose(src, x, y, z, w, kCount);
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        expectComponents(ii, float(ii));
+    }
+
+    P::Transpose(x, y, z, w, dst, kCount);
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        EXPECT_EQ(dst[ii], src[ii]);
+    }
+
+    P::Gather(src, indices, x, y, z, w, kCount);
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        expectComponents(ii, float(indices[ii]));
+    }
+
+    // Scatter to the same indices is the inverse of the gather
+    for (V& v : dst) {
+        v = V(0.f, 0.f, 0.f, 0.f);
+    }
+    P::Scatter(x, y, z, w, indices, dst, kCount);
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        EXPECT_EQ(dst[ii], src[ii]);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(testPacket) {
+    testPacketLanes<V, intrinsic::VectorPacket4>();
+    testPacketTranspose<intrinsic::VectorPacket4>();
+#if _HAS_AVX
+    testPacketLanes<V, intrinsic::VectorPacket8>();
+    testPacketTranspose<intrinsic::VectorPacket8>();
+#endif // _HAS_AVX
+}
+
+//------------------------------------------------------------------------------
+//! Check that the generator is reproducible and that the moments of each
+//! distribution are close to their expected values.
+template<typename V, typename R>
+void testRandomLanes() {
+    constexpr size_t N = R::kWidth;
+    constexpr size_t kCount = 1 << 14;
+    constexpr float kEpsilon = 1e-5f;
+    constexpr float kTolerance = 2e-2f;
+
+    // Same seed and stream produce the same sequence, different streams do not
+    {
+        R r0(1234, 0), r1(1234, 0), r2(1234, 1);
+        float a[N], b[N], c[N];
+        size_t differ = 0;
+        for (size_t ii = 0; ii < 16; ++ii) {
+            r0.Uniform(a);
+            r1.Uniform(b);
+            r2.Uniform(c);
+            for (size_t jj = 0; jj < N; ++jj) {
+                EXPECT_EQ(a[jj], b[jj]);
+                differ += a[jj] != c[jj];
+            }
+        }
+        EXPECT_TRUE(differ > 15 * N);
+    }
+
+    // Uniform samples are in [0, 1) with mean 1/2 and variance 1/12
+    {
+        R r(1234);
+        float u[N];
+        double sum = 0, sumsqr = 0;
+        for (size_t ii = 0; ii < kCount; ii += N) {
+            r.Uniform(u);
+            for (size_t jj = 0; jj < N; ++jj) {
+                EXPECT_TRUE(u[jj] >= 0.f && u[jj] < 1.f);
+                sum += u[jj];
+                sumsqr += u[jj] * u[jj];
+            }
+        }
+        double mean = sum / kCount;
+        EXPECT_EQ_EPS(mean, .5, kTolerance);
+        EXPECT_EQ_EPS(sumsqr / kCount - mean * mean, 1. / 12., kTolerance);
+    }
+
+    // Directions on the sphere are unit length with mean zero, directions on
+    // the hemisphere have mean cosine 1/2, cosine weighted directions 2/3
+    {
+        R r(1234);
+        V n(1.f / 3.f, 2.f / 3.f, -2.f / 3.f, 0.f);
+        V d[N];
+        V sum(0.f, 0.f, 0.f, 0.f);
+        double hemisphere = 0, cosine = 0;
+        for (size_t ii = 0; ii < kCount; ii += N) {
+            r.UnitSphere(d);
+            for (V const& v : d) {
+                EXPECT_EQ_EPS(float(v.Length()), 1.f, kEpsilon);
+                EXPECT_EQ(float(v[3]), 0.f);
+                sum = sum + v;
+            }
+            r.Hemisphere(n, d);
+            for (size_t jj = 0; jj < N; ++jj) {
+                EXPECT_EQ_EPS(float(d[jj].Length()), 1.f, kEpsilon);
+                EXPECT_TRUE(float(d[jj] * n) >= 0.f);
+                hemisphere += float(d[jj] * n);
+            }
+            r.CosineHemisphere(n, d);
+            for (size_t jj = 0; jj < N; ++jj) {
+                EXPECT_EQ_EPS(float(d[jj].Length()), 1.f, kEpsilon);
+                EXPECT_TRUE(float(d[jj] * n) >= 0.f);
+                cosine += float(d[jj] * n);
+            }
+        }
+        EXPECT_EQ_EPS(float(sum.Length()) / kCount, 0.f, kTolerance);
+        EXPECT_EQ_EPS(hemisphere / kCount, .5, kTolerance);
+        EXPECT_EQ_EPS(cosine / kCount, 2. / 3., kTolerance);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(testRandom) {
+    testRandomLanes<V, intrinsic::Random4>();
+#if _HAS_AVX
+    testRandomLanes<V, intrinsic::Random8>();
+#endif // _HAS_AVX
+}
+
+//------------------------------------------------------------------------------
+//! Compare the batched solver on packets of `S` against the solver on each
+//! quadratic, including the quadratics which do not fill the last packet.
+template<typename S>
+void testQuadraticBatch() {
+    constexpr size_t kCount = 2 * S::kWidth + 3;
+
+    float A[kCount], B[kCount], C[kCount];
+    float t0[kCount], t1[kCount];
+    bool valid[kCount];
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        float f = float(ii);
+        A[ii] = 1.f + .5f * f;
+        B[ii] = 4.f - f;
+        C[ii] = (ii % 3) ? -f : 2.f + f;
+        // Include discriminants which are not integers.
+        if (ii % 4 == 1) {
+            C[ii] = .1f * f;
+        }
+    }
+
+    solveQuadratics<S>(A, B, C, t0, t1, valid, kCount);
+
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        float r0, r1;
+        bool real = solveQuadratic<float>(A[ii], B[ii], C[ii], r0, r1);
+        EXPECT_EQ(valid[ii], real);
+        if (real) {
+            EXPECT_EQ_EPS(t0[ii], r0, 1e-5f * (1.f + std::abs(r0)));
+            EXPECT_EQ_EPS(t1[ii], r1, 1e-5f * (1.f + std::abs(r1)));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(testQuadratic) {
+    S t0, t1;
+
+    // (t - 1)(t - 3)
+    EXPECT_TRUE(All(solveQuadratic(S(1.f), S(-4.f), S(3.f), t0, t1)));
+    EXPECT_EQ_EPS(float(t0), 1.f, 1e-6f);
+    EXPECT_EQ_EPS(float(t1), 3.f, 1e-6f);
+
+    // 2(t + 1)(t + 3)
+    EXPECT_TRUE(All(solveQuadratic(S(2.f), S(8.f), S(6.f), t0, t1)));
+    EXPECT_EQ_EPS(float(t0), -3.f, 1e-6f);
+    EXPECT_EQ_EPS(float(t1), -1.f, 1e-6f);
+
+    // (t + 2)(t - 2)
+    EXPECT_TRUE(All(solveQuadratic(S(1.f), S(0.f), S(-4.f), t0, t1)));
+    EXPECT_EQ_EPS(float(t0), -2.f, 1e-6f);
+    EXPECT_EQ_EPS(float(t1), 2.f, 1e-6f);
+
+    // t^2 + 1
+    EXPECT_TRUE(None(solveQuadratic(S(1.f), S(0.f), S(1.f), t0, t1)));
+
+    // t^2 + t + 1/10, the discriminant is not an integer
+    EXPECT_TRUE(All(solveQuadratic(S(1.f), S(1.f), S(.1f), t0, t1)));
+    EXPECT_EQ_EPS(float(t0), (-.5f - std::sqrt(.15f)), 1e-6f);
+    EXPECT_EQ_EPS(float(t1), (-.5f + std::sqrt(.15f)), 1e-6f);
+
+    // t^2, both roots are zero
+    EXPECT_TRUE(All(solveQuadratic(S(1.f), S(0.f), S(0.f), t0, t1)));
+    EXPECT_EQ(float(t0), 0.f);
+    EXPECT_EQ(float(t1), 0.f);
+
+    // The small root is accurate even though `4AC` is much smaller than `B^2`,
+    // the roots are 1e-4 and 1e4 to within 1e-12.
+    EXPECT_TRUE(All(solveQuadratic(S(1.f), S(-1e4f - 1e-4f), S(1.f), t0, t1)));
+    EXPECT_EQ_EPS(float(t0), 1e-4f, 1e-10f);
+    EXPECT_EQ_EPS(float(t1), 1e4f, 1e-2f);
+
+    testQuadraticBatch<intrinsic::ScalarPacket4>();
+#if _HAS_AVX
+    testQuadraticBatch<intrinsic::ScalarPacket8>();
+#endif // _HAS_AVX
+}
+
+//------------------------------------------------------------------------------
+TEST(testIntersect) {
+    Ray<V, S> ray = {V(0.f, 0.f, 0.f, 1.f), V(8.f, 0.f, 0.f, 1.f)};
+    Sphere<V, S> sphere = {V(4.f, 0.f, 0.f, 1.f), 2.f};
+    Capsule<V, S> capsule = {V(4.f, -2.f, 0.f, 1.f), V(4.f, 2.f, 0.f, 1.f), 1.f};
+
+    S t;
+    Hit<V, S> hit;
+
+    // Distance-only tests respect the maximum fraction.
+    EXPECT_EQ(intersectSphere(ray, sphere, S(1.f), t), true);
+    EXPECT_EQ_EPS(t, S(.25f), 1e-6f);
+    EXPECT_EQ(intersectSphere(ray, sphere, S(.2f), t), false);
+
+    EXPECT_EQ(intersectCapsule(ray, capsule, S(1.f), t), true);
+    EXPECT_EQ_EPS(t, S(.375f), 1e-6f);
+    EXPECT_EQ(intersectCapsule(ray, capsule, S(.3f), t), false);
+
+    // Attributes are computed at the given fraction.
+    hitSphere(ray, sphere, S(.25f), hit);
+    EXPECT_EQ_EPS((hit.point - V(2.f, 0.f, 0.f, 1.f)).Length(), S(0.f), 1e-6f);
+    EXPECT_EQ_EPS((hit.normal - V(-1.f, 0.f, 0.f, 0.f)).Length(), S(0.f), 1e-6f);
+
+    hitCapsule(ray, capsule, S(.375f), hit);
+    EXPECT_EQ_EPS((hit.point - V(3.f, 0.f, 0.f, 1.f)).Length(), S(0.f), 1e-6f);
+    EXPECT_EQ_EPS((hit.normal - V(-1.f, 0.f, 0.f, 0.f)).Length(), S(0.f), 1e-6f);
+
+    // Normals face the ray origin from inside of the primitive.
+    Ray<V, S> inner = {V(4.f, 0.f, 0.f, 1.f), V(8.f, 0.f, 0.f, 1.f)};
+    EXPECT_EQ(hitSphere(inner, sphere, hit), true);
+    EXPECT_EQ_EPS(hit.t, S(.5f), 1e-6f);
+    EXPECT_EQ_EPS((hit.point - V(6.f, 0.f, 0.f, 1.f)).Length(), S(0.f), 1e-6f);
+    EXPECT_EQ_EPS((hit.normal - V(-1.f, 0.f, 0.f, 0.f)).Length(), S(0.f), 1e-6f);
+
+    // Capsule end caps are intersected as spheres.
+    float const r = std::sqrt(.5f);
+    Ray<V, S> cap = {V(4.f, 6.f, -4.f, 1.f), V(4.f, -2.f, 4.f, 1.f)};
+    EXPECT_EQ(hitCapsule(cap, capsule, hit), true);
+    EXPECT_EQ_EPS(hit.t, S((4.f - r) / 8.f), 1e-6f);
+    EXPECT_EQ_EPS((hit.point - V(4.f, 2.f + r, -r, 1.f)).Length(), S(0.f), 1e-5f);
+    EXPECT_EQ_EPS((hit.normal - V(0.f, r, -r, 0.f)).Length(), S(0.f), 1e-5f);
+
+    // The nearest primitive is found by index.
+    Sphere<V, S> spheres[] = {
+        {V(6.f, 0.f, 0.f, 1.f), 1.f},
+        {V(4.f, 8.f, 0.f, 1.f), 1.f},
+        {V(4.f, 0.f, 0.f, 1.f), 1.f},
+    };
+    size_t index = 0;
+    t = 1.f;
+    EXPECT_EQ(intersectSpheres(ray, spheres, 3, t, index), true);
+    EXPECT_EQ(index, size_t(2));
+    EXPECT_EQ_EPS(t, S(.375f), 1e-6f);
+
+    Capsule<V, S> capsules[] = {
+        {V(6.f, -1.f, 0.f, 1.f), V(6.f, 1.f, 0.f, 1.f), 1.f},
+        capsule,
+    };
+    t = 1.f;
+    EXPECT_EQ(intersectCapsules(ray, capsules, 2, t, index), true);
+    EXPECT_EQ(index, size_t(1));
+    EXPECT_EQ_EPS(t, S(.375f), 1e-6f);
+}
+
+//------------------------------------------------------------------------------
+TEST(testIntersectBranchless) {
+    Sphere<V, S> spheres[] = {
+        {V(4.f, 0.f, 0.f, 1.f), 2.f},
+        {V(6.f, 1.f, -1.f, 1.f), 1.f},
+        {V(2.f, -1.f, 1.f, 1.f), .5f},
+    };
+    Capsule<V, S> capsules[] = {
+        {V(4.f, -2.f, 0.f, 1.f), V(4.f, 2.f, 0.f, 1.f), 1.f},
+        {V(3.f, 0.f, -2.f, 1.f), V(7.f, 1.f, 2.f, 1.f), .5f},
+    };
+
+    // Rays which start inside, outside, hit caps, miss, and stop short of each
+    // primitive must give the same results as the branching functions. None
+    // of the rays are parallel to a capsule axis.
+    for (size_t ii = 0; ii < 256; ++ii) {
+        float y = .5f * float(ii % 16) - 4.f;
+        float z = .5f * float(ii / 16) - 4.f;
+        float x = .75f * float(ii % 5);
+        Ray<V, S> ray = {V(x, .25f * y, .25f * z, 1.f), V(8.f - x, y, z, 1.f)};
+        S tmax = .25f + .25f * float(ii % 4);
+
+        for (auto const& sphere : spheres) {
+            S t1 = -1.f, t2 = -1.f;
+            bool b1 = intersectSphere(ray, sphere, tmax, t1);
+            bool b2 = bool(intersectSphereBranchless(ray, sphere, tmax, t2));
+            EXPECT_EQ(b1, b2);
+            EXPECT_EQ_EPS(t1, t2, 1e-6f);
+
+            Hit<V, S> hit;
+            if (hitSphere(ray, sphere, hit)) {
+                EXPECT_EQ_EPS(hit.normal.Length(), S(1.f), 1e-5f);
+            }
+        }
+
+        for (auto const& capsule : capsules) {
+            S t1 = -1.f, t2 = -1.f;
+            bool b1 = intersectCapsule(ray, capsule, tmax, t1);
+            bool b2 = bool(intersectCapsuleBranchless(ray, capsule, tmax, t2));
+            EXPECT_EQ(b1, b2);
+            EXPECT_EQ_EPS(t1, t2, 1e-6f);
+        }
+
+        S t1 = tmax, t2 = tmax;
+        size_t i1 = 0, i2 = 0;
+        EXPECT_EQ(intersectSpheres(ray, spheres, 3, t1, i1),
+                  intersectSpheresBranchless(ray, spheres, 3, t2, i2));
+        EXPECT_EQ(i1, i2);
+        EXPECT_EQ_EPS(t1, t2, 1e-6f);
+
+        t1 = tmax, t2 = tmax;
+        EXPECT_EQ(intersectCapsules(ray, capsules, 2, t1, i1),
+                  intersectCapsulesBranchless(ray, capsules, 2, t2, i2));
+        EXPECT_EQ(i1, i2);
+        EXPECT_EQ_EPS(t1, t2, 1e-6f);
+    }
+
+    // Both functions find the exact distance when the discriminant is not an
+    // integer, i.e. the square root is not truncated.
+    Ray<V, S> ray = {V(0.f, 0.f, 0.f, 1.f), V(0.f, 0.f, 1.f, 1.f)};
+    Sphere<V, S> sphere = {V(.3f, .2f, .5f, 1.f), .45f};
+    Capsule<V, S> capsule = {V(-1.f, .2f, .5f, 1.f), V(1.f, .2f, .5f, 1.f), .45f};
+
+    S t1 = -1.f, t2 = -1.f;
+    EXPECT_EQ(intersectSphere(ray, sphere, S(1.f), t1), true);
+    EXPECT_EQ(bool(intersectSphereBranchless(ray, sphere, S(1.f), t2)), true);
+    EXPECT_EQ_EPS(t1, S(.5f - .5f * std::sqrt(.29f)), 1e-6f);
+    EXPECT_EQ_EPS(t2, S(.5f - .5f * std::sqrt(.29f)), 1e-6f);
+
+    t1 = -1.f, t2 = -1.f;
+    EXPECT_EQ(intersectCapsule(ray, capsule, S(1.f), t1), true);
+    EXPECT_EQ(bool(intersectCapsuleBranchless(ray, capsule, S(1.f), t2)), true);
+    EXPECT_EQ_EPS(t1, S(.5f - .5f * std::sqrt(.65f)), 1e-6f);
+    EXPECT_EQ_EPS(t2, S(.5f - .5f * std::sqrt(.65f)), 1e-6f);
+}
+
+//------------------------------------------------------------------------------
+TEST(testSphereArray) {
+    // Use a count which is not a multiple of the packed width to cover padding.
+    constexpr size_t kCount = 37;
+
+    Sphere<V, S> spheres[kCount];
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        float x = float(ii % 6);
+        float y = float(ii / 6);
+        spheres[ii] = {V(4.f + x, y - 3.f, .5f * x - 1.f, 1.f), .2f + .05f * float(ii % 4)};
+    }
+
+    SphereArray array;
+    array.Assign(spheres, kCount);
+
+    for (size_t ii = 0; ii < 64; ++ii) {
+        float y = .125f * float(ii % 8) - .5f;
+        float z = .125f * float(ii / 8) - .5f;
+        V start(0.f, 0.f, 0.f, 1.f);
+        V end(16.f, 8.f * y, 8.f * z, 1.f);
+
+        for (size_t begin : {size_t(0), size_t(5), size_t(11)}) {
+            // Find the nearest sphere with the scalar intersection routine.
+            float tmin = 1.f;
+            size_t imin = kCount;
+            for (size_t jj = begin; jj < kCount; ++jj) {
+                Hit<V, S> hit;
+                if (hitSphere<V, S>({start, end}, spheres[jj], hit) && float(hit.t) < tmin) {
+                    tmin = float(hit.t);
+                    imin = jj;
+                }
+            }
+
+            float t = 1.f;
+            size_t index = kCount;
+            bool result = array.Nearest({start, end}, begin, kCount, t, index);
+
+            EXPECT_EQ(result, imin < kCount);
+            EXPECT_EQ(index, imin);
+            EXPECT_EQ_EPS(t, tmin, 1e-5f);
+
+            EXPECT_EQ(array.Occluded({start, end}, begin, kCount), result);
+        }
+    }
+}
+
+#if _RUNTIME_DISPATCH
+//------------------------------------------------------------------------------
+TEST(testSphereKernels) {
+    constexpr size_t kCount = 37;
+
+    Sphere<V, S> spheres[kCount];
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        float x = float(ii % 6);
+        float y = float(ii / 6);
+        spheres[ii] = {V(4.f + x, y - 3.f, .5f * x - 1.f, 1.f), .2f + .05f * float(ii % 4)};
+    }
+
+    struct Array : SphereArray {
+        using SphereArray::Data;
+    } array;
+    array.Assign(spheres, kCount);
+
+    // Every kernel supported by the processor must find the same spheres as the
+    // baseline kernel. Fractions may differ by rounding, e.g. with fused
+    // multiply-add.
+    sphere_kernels::Kernels const& baseline = sphere_kernels::kernels[sphere_kernels::num_kernels - 1];
+
+    constexpr size_t kWidth = sphere_kernels::kPacketWidth;
+
+    for (size_t kk = 0; kk < sphere_kernels::num_kernels; ++kk) {
+        sphere_kernels::Kernels const& kernels = sphere_kernels::kernels[kk];
+        if ((kernels.features & cpuid::runtime_features()) != kernels.features) {
+            continue;
+        }
+
+        for (size_t ii = 0; ii < 64; ++ii) {
+            float y = .125f * float(ii % 8) - .5f;
+            float z = .125f * float(ii / 8) - .5f;
+            SphereArray::Ray ray(V(0.f, 0.f, 0.f, 1.f), V(16.f, 8.f * y, 8.f * z, 1.f));
+
+            for (size_t begin : {size_t(0), size_t(5), size_t(11)}) {
+                float expected_t = 1.f;
+                size_t expected_index = kCount;
+                bool expected = baseline.nearest(array.Data(), ray.start, ray.dir, begin, kCount, expected_t, expected_index);
+
+                float t = 1.f;
+                size_t index = kCount;
+                bool result = kernels.nearest(array.Data(), ray.start, ray.dir, begin, kCount, t, index);
+
+                EXPECT_EQ(result, expected);
+                EXPECT_EQ(index, expected_index);
+                EXPECT_EQ_EPS(t, expected_t, 1e-5f);
+
+                EXPECT_EQ(kernels.occluded(array.Data(), ray.start, ray.dir, begin, kCount), expected);
+            }
+        }
+
+        // Packets of the rays above, which start at different points.
+        for (size_t ii = 0; ii < 64; ii += kWidth) {
+            float start[3][kWidth], dir[3][kWidth], inv_dir[3][kWidth];
+            float t0[kWidth], t1[kWidth], index0[kWidth], index1[kWidth];
+            for (size_t jj = 0; jj < kWidth; ++jj) {
+                float y = .125f * float((ii + jj) % 8) - .5f;
+                float z = .125f * float((ii + jj) / 8) - .5f;
+                start[0][jj] = 0.f;
+                start[1][jj] = .25f * float(jj);
+                start[2][jj] = 0.f;
+                dir[0][jj] = 16.f;
+                dir[1][jj] = 8.f * y;
+                dir[2][jj] = 8.f * z;
+                for (size_t ll = 0; ll < 3; ++ll) {
+                    inv_dir[ll][jj] = 1.f / (dir[ll][jj] + std::copysign(BVH::kMinDir, dir[ll][jj]));
+                }
+                t0[jj] = t1[jj] = 1.f;
+            }
+
+            int expected = baseline.nearest_packet(array.Data(), start, dir, 0, kCount, t0, index0);
+            int result = kernels.nearest_packet(array.Data(), start, dir, 0, kCount, t1, index1);
+
+            EXPECT_EQ(result, expected);
+            for (size_t jj = 0; jj < kWidth; ++jj) {
+                EXPECT_EQ(index1[jj], index0[jj]);
+                EXPECT_EQ_EPS(t1[jj], t0[jj], 1e-5f);
+            }
+
+            // Boxes around each row of spheres, entered by some of the rays,
+            // with every other lane inactive.
+            for (size_t jj = 0; jj < kCount; jj += 6) {
+                float lo[3] = {3.f, float(jj / 6) - 3.5f, -1.5f};
+                float hi[3] = {10.f, float(jj / 6) - 2.5f, 2.f};
+                int active = 0x55 & ((1 << kWidth) - 1);
+
+                //  Slab test of each active lane, see `BVH::Intersects`.
+                int enters = 0;
+                float tnear = FLT_MAX;
+                for (size_t ll = 0; ll < kWidth; ++ll) {
+                    float tmin = 0.f, tmax = t0[ll];
+                    for (size_t mm = 0; mm < 3; ++mm) {
+                        float ta = (lo[mm] - start[mm][ll]) * inv_dir[mm][ll];
+                        float tb = (hi[mm] - start[mm][ll]) * inv_dir[mm][ll];
+                        tmin = std::max(tmin, std::min(ta, tb));
+                        tmax = std::min(tmax, std::max(ta, tb));
+                    }
+                    if ((active & (1 << ll)) && tmin <= tmax) {
+                        enters |= 1 << ll;
+                        tnear = std::min(tnear, tmin);
+                    }
+                }
+
+                float tnear1 = -1.f;
+                result = kernels.enters(lo, hi, start, inv_dir, t0, active, tnear1);
+
+                EXPECT_EQ(result, enters);
+                if (enters) {
+                    EXPECT_EQ(tnear1, tnear);
+                }
+            }
+        }
+    }
+}
+#endif // _RUNTIME_DISPATCH
+
+//------------------------------------------------------------------------------
+TEST(testBVH) {
+    constexpr size_t kCount = 8 * 8 * 8;
+
+    Sphere<V, S> spheres[kCount];
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        float x = float(ii % 8);
+        float y = float((ii / 8) % 8);
+        float z = float(ii / 64);
+        spheres[ii] = {V(x + .1f * z, y - 4.f, z - 4.f, 1.f), .1f + .05f * float(ii % 5)};
+    }
+
+    BVH bvh;
+    bvh.Build(spheres, kCount);
+
+    // Leaf ranges must refer to a permutation of the original spheres.
+    Sphere<V, S> ordered[kCount];
+    std::vector<bool> visited(kCount);
+    EXPECT_EQ(bvh.Indices().size(), kCount);
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        EXPECT_EQ(visited[bvh.Indices()[ii]], false);
+        visited[bvh.Indices()[ii]] = true;
+        ordered[ii] = spheres[bvh.Indices()[ii]];
+    }
+
+    SphereArray array;
+    array.Assign(ordered, kCount);
+
+    constexpr size_t kNumRays = 256;
+    constexpr size_t kWidth = SphereArray::kWidth;
+
+    SphereArray::Ray rays[kNumRays];
+    bool expected[kNumRays];
+    float expected_t[kNumRays];
+    size_t expected_index[kNumRays];
+
+    for (size_t ii = 0; ii < kNumRays; ++ii) {
+        float y = .0625f * float(ii % 16) - .5f;
+        float z = .0625f * float(ii / 16) - .5f;
+        // Alternate directions to cover both traversal orders on each axis.
+        V start = (ii & 1) ? V(-1.f, 0.f, 0.f, 1.f) : V(9.f, 16.f * y, 16.f * z, 1.f);
+        V end = (ii & 1) ? V(9.f, 16.f * y, 16.f * z, 1.f) : V(-1.f, 0.f, 0.f, 1.f);
+
+        rays[ii] = {start, end};
+        expected_t[ii] = 1.f;
+        expected_index[ii] = kCount;
+        expected[ii] = array.Nearest(rays[ii], 0, kCount, expected_t[ii], expected_index[ii]);
+
+        float t = 1.f;
+        size_t index = kCount;
+        bool result = bvh.Nearest(array, rays[ii], t, index);
+
+        EXPECT_EQ(result, expected[ii]);
+        EXPECT_EQ(index, expected_index[ii]);
+        EXPECT_EQ(t, expected_t[ii]);
+
+        EXPECT_EQ(bvh.Occluded(array, rays[ii]), expected[ii]);
+    }
+
+    // Packets of divergent rays, with one lane inactive in every other packet.
+    for (size_t ii = 0; ii < kNumRays; ii += kWidth) {
+        SphereArray::RayPacket packet;
+        for (size_t jj = 0; jj < kWidth; ++jj) {
+            for (size_t kk = 0; kk < 3; ++kk) {
+                packet.start[kk][jj] = rays[ii + jj].start[kk];
+                packet.dir[kk][jj] = rays[ii + jj].dir[kk];
+            }
+        }
+
+        int mask = (1 << kWidth) - 1;
+        if (ii & kWidth) {
+            mask &= ~2;
+        }
+
+        for (bool hierarchy : {false, true}) {
+            float t[kWidth];
+            size_t index[kWidth];
+            std::fill(t, t + kWidth, 1.f);
+            std::fill(index, index + kWidth, kCount);
+
+            int result = hierarchy ? bvh.NearestPacket(array, packet, mask, t, index)
+                                   : array.NearestPacket(packet, mask, 0, kCount, t, index);
+
+            for (size_t jj = 0; jj < kWidth; ++jj) {
+                bool active = (mask & (1 << jj)) != 0;
+                EXPECT_EQ((result & (1 << jj)) != 0, active && expected[ii + jj]);
+                EXPECT_EQ(index[jj], active ? expected_index[ii + jj] : kCount);
+                EXPECT_EQ_EPS(t[jj], (active ? expected_t[ii + jj] : 1.f), 1e-5f);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(testTraceParallel) {
+    // Use a size which is not a multiple of the tile size to cover partial tiles.
+    constexpr size_t kSize = 72;
+
+    Image<M, V, S> serial = TraceImage<M, V, S>(kSize, kSize, 1);
+    Image<M, V, S> parallel = TraceImage<M, V, S>(kSize, kSize, 4);
+
+    for (size_t ii = 0; ii < kSize; ++ii) {
+        EXPECT_EQ(std::memcmp(serial[ii], parallel[ii], sizeof(*serial[ii]) * kSize), 0);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Only for double precision implementations, values are not representable or
+//! results are not exact in single precision.
+TEST(testDoublePrecision) {
+    //  Offsets far from the origin keep their fractional part.
+    constexpr double kOffset = 1e9;
+    V a(kOffset + .25, kOffset - .5, -kOffset + .125, 1.);
+    V b(kOffset, kOffset, -kOffset, 1.);
+    EXPECT_EQ(a - b, V(.25, -.5, .125, 0.));
+
+    //  Lengths are correctly rounded.
+    EXPECT_EQ(V(3e8, 4e8, 0., 0.).Length(), S(5e8));
+    EXPECT_EQ(V(1., 2., 3., 4.).Length(), S(std::sqrt(30.)));
+    EXPECT_EQ(V(1., 2., 3., 4.).LengthFast(), S(std::sqrt(30.)));
+
+    //  Intersection at a large offset is as accurate as at the origin.
+    Ray<V, S> ray = {V(kOffset, 0., 0., 1.), V(kOffset + 8., 0., 0., 1.)};
+    Sphere<V, S> sphere = {V(kOffset + 4., 0., 0., 1.), 2.};
+    Hit<V, S> hit;
+    EXPECT_EQ(hitSphere(ray, sphere, hit), true);
+    EXPECT_EQ_EPS(hit.t, S(.25), 1e-12);
+    EXPECT_EQ_EPS((hit.point - V(kOffset + 2., 0., 0., 1.)).Length(), S(0.), 1e-6);
+    EXPECT_EQ_EPS((hit.normal - V(-1., 0., 0., 0.)).Length(), S(0.), 1e-12);
+
+    //  Rays which miss by less than the spacing of floats at the offset.
+    Sphere<V, S> near = {V(kOffset + 4., 2. + 1e-3, 0., 1.), 2.};
+    EXPECT_EQ(hitSphere(ray, near, hit), false);
+}
+
+//------------------------------------------------------------------------------
+//! Render a scene with enough spheres for packed searches at the origin and
+//! far from it, the images are the same to within the precision of the offset.
+//! Only for double precision implementations.
+TEST(testSceneDoublePrecision) {
+    constexpr size_t kSize = 24;
+    constexpr size_t kNumSpheres = 6;
+
+    auto render = [&](double offset) {
+        V o(offset, offset, -offset, 0.);
+
+        Light<M, V, S> lights[2];
+        lights[0].origin = o + V(2., 0., 4., 1.);
+        lights[0].color = {1.f, 1.f, 1.f, 1.f};
+        lights[0].intensity = 10.f;
+        lights[1].origin = o + V(6., -4., -2., 1.);
+        lights[1].color = {.2f, 1.f, 1.f, 1.f};
+        lights[1].intensity = 10.f;
+
+        TraceSphere<M, V, S> spheres[kNumSpheres];
+        for (size_t ii = 0; ii < kNumSpheres; ++ii) {
+            double x = double(ii);
+            spheres[ii].origin = o + V(3. + x, -1.5 + .6 * x, 1. - .4 * x, 1.);
+            spheres[ii].radius = .2 + .1 * x;
+            spheres[ii].material = Material<M, V, S>{
+                Color<M, V, S>{.2f, .05f, .02f, 1.f},
+                .4f,        // roughness
+                .04f,       // reflectance
+                Color<M, V, S>{1.f, 1.f, 1.f, 1.f},
+            };
+        }
+
+        Frustum<M, V, S> view(
+            o + V(.5, .5, .4, 1.),
+            V(1., 0., 0., 0.),
+            V(0., 1., 0., 0.),
+            V(0., 0., 1., 0.),
+            .1f, 8.f, 1.f, 1.f);
+
+        Image<M, V, S> image(kSize, kSize);
+        Scene<M, V, S> scene(lights, spheres);
+        TraceView(view, scene, image);
+        return image;
+    };
+
+    Image<M, V, S> expected = render(0.);
+    Image<M, V, S> image = render(1e9);
+
+    for (size_t ii = 0; ii < kSize; ++ii) {
+        for (size_t jj = 0; jj < kSize; ++jj) {
+            for (size_t kk = 0; kk < 4; ++kk) {
+                EXPECT_EQ_EPS(S(image[ii][jj][kk]), S(expected[ii][jj][kk]), 1e-4);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Only for double precision implementations, the hierarchy must contain
+//! spheres whose bounds are not representable in single precision.
+TEST(testBVHDoublePrecision) {
+    constexpr size_t kCount = 8 * 8 * 8;
+    constexpr double kOffset = 1e9;
+
+    V o(kOffset, kOffset, -kOffset, 0.);
+
+    Sphere<V, S> spheres[kCount];
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        double x = double(ii % 8);
+        double y = double((ii / 8) % 8);
+        double z = double(ii / 64);
+        spheres[ii] = {o + V(x + .1 * z + .5, y - 3.5, z - 3.5, 1.), .1 + .05 * double(ii % 5)};
+    }
+
+    BVH bvh;
+    bvh.Build(spheres, kCount);
+
+    Sphere<V, S> ordered[kCount];
+    for (size_t ii = 0; ii < kCount; ++ii) {
+        ordered[ii] = spheres[bvh.Indices()[ii]];
+    }
+
+    for (size_t ii = 0; ii < 256; ++ii) {
+        double y = .0625 * double(ii % 16) - .5;
+        double z = .0625 * double(ii / 16) - .5;
+        // Alternate directions to cover both traversal orders on each axis.
+        V start = o + ((ii & 1) ? V(-1., 0., 0., 1.) : V(9., 16. * y, 16. * z, 1.));
+        V end = o + ((ii & 1) ? V(9., 16. * y, 16. * z, 1.) : V(-1., 0., 0., 1.));
+        Ray<V, S> ray = {start, end};
+
+        S expected_t = 1.;
+        size_t expected_index = kCount;
+        bool expected = intersectSpheres(ray, ordered, kCount, expected_t, expected_index);
+
+        S t = 1.;
+        size_t index = kCount;
+        EXPECT_EQ(bvh.Nearest(ordered, ray, t, index), expected);
+        EXPECT_EQ(index, expected_index);
+        EXPECT_EQ_EPS(t, expected_t, 1e-12);
+
+        EXPECT_EQ(bvh.Occluded(ordered, ray), expected);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Helper function for executing a conformance test for one implementation.
 template<typename Func>
@@ -272,18 +1638,47 @@ bool testFunc() {
         "failed", "ok",
     };
 
-    bool b0 = testFuncImpl<Func<reference::Matrix, reference::Vector, reference::Scalar>>();
-    bool b1 = testFuncImpl<Func<intrinsic::Matrix, intrinsic::Vector, intrinsic::Scalar>>();
-    bool b2 = testFuncImpl<Func<aliased::Matrix, aliased::Vector, aliased::Scalar>>();
+    bool results[] = {
+        testFuncImpl<Func<reference::Matrix, reference::Vector, reference::Scalar>>(),
+        testFuncImpl<Func<intrinsic::Matrix, intrinsic::Vector, intrinsic::Scalar>>(),
+        testFuncImpl<Func<aliased::Matrix, aliased::Vector, aliased::Scalar>>(),
+#if _HAS_AVX
+        testFuncImpl<Func<avx::Matrix, avx::Vector, avx::Scalar>>(),
+#endif // _HAS_AVX
+#if _HAS_VECTOR_EXTENSIONS
+        testFuncImpl<Func<portable::Matrix, portable::Vector, portable::Scalar>>(),
+#endif // _HAS_VECTOR_EXTENSIONS
+    };
+
+    // Print results
+    bool result = true;
+    printf_s("  %-24s", Func<reference::Matrix, reference::Vector, reference::Scalar>::name);
+    for (bool b : results) {
+        printf_s(" %-15s", result_strings[b]);
+        result &= b;
+    }
+    printf_s("\n");
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Helper function for executing conformance tests on the double precision
+//! implementation, which is not interchangeable with the others.
+template<template<typename, typename, typename> class Func>
+bool testFuncDouble() {
+    constexpr char const* result_strings[] = {
+        "failed", "ok",
+    };
+
+    bool b0 = testFuncImpl<Func<intrinsic_d::Matrix, intrinsic_d::Vector, intrinsic_d::Scalar>>();
 
     // Print results
-    printf_s("  %-24s %-15s %-15s %-15s\n",
-             Func<reference::Matrix, reference::Vector, reference::Scalar>::name,
-             result_strings[b0],
-             result_strings[b1],
-             result_strings[b2]);
+    printf_s("  %-24s %-15s\n",
+             Func<intrinsic_d::Matrix, intrinsic_d::Vector, intrinsic_d::Scalar>::name,
+             result_strings[b0]);
 
-    return b0 && b1 && b2;
+    return b0;
 }
 
 //------------------------------------------------------------------------------
@@ -291,14 +1686,26 @@ bool testComparison() {
     return testFunc<testComparisonT>();
 }
 
+bool testSelect() {
+    return testFunc<testSelectT>();
+}
+
 bool testElements() {
     return testFunc<testElementsT>();
 }
 
+bool testSwizzle() {
+    return testFunc<testSwizzleT>();
+}
+
 bool testAlgebraic() {
     return testFunc<testAlgebraicT>();
 }
 
+bool testFusedExpressions() {
+    return testFunc<testFusedExpressionsT>();
+}
+
 bool testLength() {
     return testFunc<testLengthT>();
 }
@@ -311,6 +1718,22 @@ bool testCrossProduct() {
     return testFunc<testCrossProductT>();
 }
 
+bool testComponentWise() {
+    return testFunc<testComponentWiseT>();
+}
+
+bool testReduction() {
+    return testFunc<testReductionT>();
+}
+
+bool testHalfVector() {
+    return testFunc<testHalfVectorT>();
+}
+
+bool testVector3() {
+    return testFunc<testVector3T>();
+}
+
 bool testMatrixProduct() {
     bool b1 = testFunc<testMatrixScalarProductT>();
     bool b2 = testFunc<testMatrixVectorProductT>();
@@ -321,3 +1744,229 @@ bool testMatrixProduct() {
 bool testMatrixTranspose() {
     return testFunc<testMatrixTransposeT>();
 }
+
+//------------------------------------------------------------------------------
+bool testMatrixInverse() {
+    return testFunc<testMatrixInverseT>();
+}
+
+//------------------------------------------------------------------------------
+bool testMatrixTransformBatch() {
+    return testFunc<testMatrixTransformBatchT>();
+}
+
+//------------------------------------------------------------------------------
+bool testQuaternion() {
+    return testFunc<testQuaternionT>();
+}
+
+//------------------------------------------------------------------------------
+bool testAffineMatrix() {
+    return testFunc<testAffineMatrixT>();
+}
+
+bool testPacket() {
+    return testFunc<testPacketT>();
+}
+
+bool testRandom() {
+    return testFunc<testRandomT>();
+}
+
+bool testQuadratic() {
+    return testFunc<testQuadraticT>();
+}
+
+bool testIntersect() {
+    bool b1 = testFunc<testIntersectT>();
+    bool b2 = testFunc<testIntersectBranchlessT>();
+    return b1 && b2;
+}
+
+bool testSphereArray() {
+    return testFunc<testSphereArrayT>();
+}
+
+#if _RUNTIME_DISPATCH
+bool testSphereKernels() {
+    return testFunc<testSphereKernelsT>();
+}
+#endif // _RUNTIME_DISPATCH
+
+bool testBVH() {
+    return testFunc<testBVHT>();
+}
+
+bool testTraceParallel() {
+    return testFunc<testTraceParallelT>();
+}
+
+//------------------------------------------------------------------------------
+//! Run the tests which do not depend on single precision or on extensions of
+//! the interface on the double precision implementation.
+bool testDouble() {
+    bool result = true;
+    result &= testFuncDouble<testComparisonT>();
+    result &= testFuncDouble<testSelectT>();
+    result &= testFuncDouble<testElementsT>();
+    result &= testFuncDouble<testAlgebraicT>();
+    result &= testFuncDouble<testFusedExpressionsT>();
+    result &= testFuncDouble<testDotProductT>();
+    result &= testFuncDouble<testCrossProductT>();
+    result &= testFuncDouble<testMatrixScalarProductT>();
+    result &= testFuncDouble<testMatrixVectorProductT>();
+    result &= testFuncDouble<testMatrixMatrixProductT>();
+    result &= testFuncDouble<testMatrixTransposeT>();
+    result &= testFuncDouble<testQuadraticT>();
+    result &= testFuncDouble<testIntersectT>();
+    result &= testFuncDouble<testIntersectBranchlessT>();
+    result &= testFuncDouble<testTraceParallelT>();
+    result &= testFuncDouble<testDoublePrecisionT>();
+    result &= testFuncDouble<testSceneDoublePrecisionT>();
+    result &= testFuncDouble<testBVHDoublePrecisionT>();
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Distance between `a` and the nearest float to `ref` in units in the last
+//! place, or the absolute error in units of 2^-24 if `absolute` is set.
+double ulpError(float a, double ref, bool absolute) {
+    if (absolute) {
+        return std::abs(double(a) - ref) * double(1 << 24);
+    }
+
+    auto key = [](float f) {
+        int32_t i;
+        std::memcpy(&i, &f, sizeof(i));
+        return i < 0 ? -int64_t(i & 0x7fffffff) : int64_t(i);
+    };
+
+    float b = float(ref);
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::isnan(a) == std::isnan(b) ? 0. : HUGE_VAL;
+    }
+    return double(std::abs(key(a) - key(b)));
+}
+
+//------------------------------------------------------------------------------
+//! Maximum error of `func` against the double precision function `ref` from the
+//! standard library, with arguments `x` and `y` generated by `arg` for each of
+//! a fixed number of samples.
+template<size_t N, typename Arg, typename Func, typename Ref>
+double testMaxError(bool absolute, Arg arg, Func func, Ref ref) {
+    using T = typename intrinsic::_math_ops<N>::type;
+
+    constexpr size_t kSamples = 1 << 16;
+
+    double max_error = 0.;
+    for (size_t ii = 0; ii < kSamples; ii += N) {
+        alignas(32) float x[N], y[N], r[N];
+        for (size_t jj = 0; jj < N; ++jj) {
+            arg(float(ii + jj) / float(kSamples), x[jj], y[jj]);
+        }
+
+        T xx, yy, rr;
+        std::memcpy(&xx, x, sizeof(xx));
+        std::memcpy(&yy, y, sizeof(yy));
+        rr = func(xx, yy);
+        std::memcpy(r, &rr, sizeof(rr));
+
+        for (size_t jj = 0; jj < N; ++jj) {
+            double error = ulpError(r[jj], ref(double(x[jj]), double(y[jj])), absolute);
+            max_error = std::max(max_error, error);
+        }
+    }
+    return max_error;
+}
+
+//------------------------------------------------------------------------------
+//! Maximum error of each transcendental function of width `N` and accuracy `A`.
+//! Errors of sin and cos are absolute since their results have zeros within
+//! the range of arguments; pow is limited to |y * log2(x)| <= 16.
+template<size_t N, intrinsic::Accuracy A>
+void testTranscendentalErrors(double (&max_error)[8]) {
+    using math = intrinsic::_math<N, A>;
+    using T = typename intrinsic::_math_ops<N>::type;
+
+    auto exp_arg = [](float t, float& x, float&) { x = -87.f + 175.f * t; };
+    auto exp2_arg = [](float t, float& x, float&) { x = -125.f + 252.f * t; };
+    // Arguments of log and pow are built from an exponent and mantissa rather
+    // than with exp2, which fast-math would otherwise cancel in the reference.
+    auto log_arg = [](float t, float& x, float&) {
+        x = std::ldexp(1.f + std::fmod(t * 4093.f, 1.f), int(-120.f + 240.f * t));
+    };
+    auto pow_arg = [](float t, float& x, float& y) {
+        x = std::ldexp(1.f + std::fmod(t * 4093.f, 1.f), int(-4.f + 8.f * t));
+        y = -4.f + 8.f * std::fmod(t * 1021.f, 1.f);
+    };
+    auto trig_arg = [](float t, float& x, float&) { x = -100.f + 200.f * t; };
+
+    max_error[0] = std::max(max_error[0], testMaxError<N>(false, exp_arg,
+        [](T x, T) { return math::exp(x); },
+        [](double x, double) { return std::exp(x); }));
+    max_error[1] = std::max(max_error[1], testMaxError<N>(false, exp2_arg,
+        [](T x, T) { return math::exp2(x); },
+        [](double x, double) { return std::exp2(x); }));
+    max_error[2] = std::max(max_error[2], testMaxError<N>(false, log_arg,
+        [](T x, T) { return math::log(x); },
+        [](double x, double) { return std::log(x); }));
+    max_error[3] = std::max(max_error[3], testMaxError<N>(false, log_arg,
+        [](T x, T) { return math::log2(x); },
+        [](double x, double) { return std::log2(x); }));
+    max_error[4] = std::max(max_error[4], testMaxError<N>(false, pow_arg,
+        [](T x, T y) { return math::pow(x, y); },
+        [](double x, double y) { return std::pow(x, y); }));
+    max_error[5] = std::max(max_error[5], testMaxError<N>(true, trig_arg,
+        [](T x, T) { return math::sin(x); },
+        [](double x, double) { return std::sin(x); }));
+    max_error[6] = std::max(max_error[6], testMaxError<N>(true, trig_arg,
+        [](T x, T) { return math::cos(x); },
+        [](double x, double) { return std::cos(x); }));
+    max_error[7] = std::max(max_error[7], testMaxError<N>(true, trig_arg,
+        [](T x, T) { T s, c; math::sincos(x, s, c); return s; },
+        [](double x, double) { return std::sin(x); }));
+    max_error[7] = std::max(max_error[7], testMaxError<N>(true, trig_arg,
+        [](T x, T) { T s, c; math::sincos(x, s, c); return c; },
+        [](double x, double) { return std::cos(x); }));
+}
+
+//------------------------------------------------------------------------------
+//! Report the maximum error of each transcendental function for each accuracy
+//! and fail if it is greater than the error allowed for that accuracy.
+bool testTranscendental() {
+    using intrinsic::Accuracy;
+
+    constexpr char const* names[] = {
+        "exp", "exp2", "log", "log2", "pow", "sin", "cos", "sincos",
+    };
+
+    //  Maximum error in units in the last place for each accuracy, pow has an
+    //  additional factor of 16 for the largest magnitude of y * log2(x).
+    constexpr double limits[] = {8192., 128., 4.};
+    constexpr double kPowFactor = 16.;
+
+    double errors[3][8] = {};
+    testTranscendentalErrors<4, Accuracy::Low>(errors[0]);
+    testTranscendentalErrors<4, Accuracy::Medium>(errors[1]);
+    testTranscendentalErrors<4, Accuracy::High>(errors[2]);
+#if _HAS_AVX
+    testTranscendentalErrors<8, Accuracy::Low>(errors[0]);
+    testTranscendentalErrors<8, Accuracy::Medium>(errors[1]);
+    testTranscendentalErrors<8, Accuracy::High>(errors[2]);
+#endif // _HAS_AVX
+
+    bool result = true;
+    for (size_t ff = 0; ff < 8; ++ff) {
+        char columns[3][32];
+        for (size_t aa = 0; aa < 3; ++aa) {
+            double limit = limits[aa] * (ff == 4 ? kPowFactor : 1.);
+            bool ok = errors[aa][ff] <= limit;
+            snprintf(columns[aa], sizeof(columns[aa]), "%s%.0f ulp", ok ? "" : "failed ", errors[aa][ff]);
+            result = result && ok;
+        }
+
+        printf_s("  %-24s %-15s %-15s %-15s\n", names[ff], columns[0], columns[1], columns[2]);
+    }
+
+    return result;
+}
@@ -1,10 +1,35 @@
 #pragma once
 
+#include "Features.h"
+
 bool testComparison();
+bool testSelect();
 bool testElements();
+bool testSwizzle();
 bool testAlgebraic();
+bool testFusedExpressions();
 bool testLength();
 bool testDotProduct();
 bool testCrossProduct();
+bool testComponentWise();
+bool testReduction();
+bool testHalfVector();
+bool testVector3();
 bool testMatrixProduct();
 bool testMatrixTranspose();
+bool testMatrixInverse();
+bool testMatrixTransformBatch();
+bool testQuaternion();
+bool testAffineMatrix();
+bool testPacket();
+bool testRandom();
+bool testQuadratic();
+bool testIntersect();
+bool testSphereArray();
+#if _RUNTIME_DISPATCH
+bool testSphereKernels();
+#endif // _RUNTIME_DISPATCH
+bool testBVH();
+bool testTraceParallel();
+bool testDouble();
+bool testTranscendental();
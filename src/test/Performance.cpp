@@ -3,6 +3,15 @@
 #include "vector/Reference.h"
 #include "vector/Intrinsic.h"
 #include "vector/Aliased.h"
+#if _HAS_AVX
+#include "vector/Avx.h"
+#endif // _HAS_AVX
+#include "vector/Packet.h"
+#include "vector/Random.h"
+#include "vector/IntrinsicDouble.h"
+#if _HAS_VECTOR_EXTENSIONS
+#include "vector/Portable.h"
+#endif // _HAS_VECTOR_EXTENSIONS
 
 #include "vector/Intersect.h"
 
@@ -10,6 +19,12 @@
 
 #include "Platform.h"
 
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <random>
+
 #if defined(__GNUC__)
 // GCC complains about initialization with multiple `*v++` which would normally
 // be valid but the order doesn't actually matter here. As long as GCC doesn't
@@ -82,6 +97,32 @@ struct vectorElemWriteT {
     std::vector<V> _output;
 };
 
+template<typename M, typename V, typename S>
+struct vectorSwizzleT {
+    static constexpr const char* name = "vectorSwizzle";
+    static constexpr const size_t size = 4;
+
+    vectorSwizzleT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii] = { *v++, *v++, *v++, *v++ };
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        V* out = _output.data();
+
+        for (auto const& in: _input) {
+            *out++ = in.template Swizzle<1, 2, 0, 3>();
+        }
+    }
+
+    std::vector<V> _input;
+    std::vector<V> _output;
+};
+
 template<typename M, typename V, typename S>
 struct vectorAddT {
     static constexpr const char* name = "vectorAdd";
@@ -472,6 +513,179 @@ struct vectorReflectT {
     std::vector<V> _output;
 };
 
+template<typename M, typename V, typename S>
+struct vectorClampT {
+    static constexpr const char* name = "vectorClamp";
+    static constexpr const size_t size = 12;
+
+    struct Args {
+        V a;
+        V lo;
+        V hi;
+    };
+
+    vectorClampT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii].a = { *v++, *v++, *v++, *v++ };
+            _input[ii].lo = { *v++, *v++, *v++, *v++ };
+            _input[ii].hi = { *v++, *v++, *v++, *v++ };
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        V* out = _output.data();
+
+        for (auto const& in: _input) {
+            *out++ = in.a.Clamp(in.lo, in.hi);
+        }
+    }
+
+    std::vector<Args> _input;
+    std::vector<V> _output;
+};
+
+template<typename M, typename V, typename S>
+struct vectorBoundsT {
+    static constexpr const char* name = "vectorBounds";
+    static constexpr const size_t size = 4;
+
+    vectorBoundsT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii] = { *v++, *v++, *v++, *v++ };
+        }
+    }
+
+    void operator()() {
+        V::Bounds(_input.data(), _input.size(), _min, _max);
+    }
+
+    std::vector<V> _input;
+    V _min;
+    V _max;
+};
+
+template<typename M, typename V, typename S>
+struct vectorMaxLengthT {
+    static constexpr const char* name = "vectorMaxLength";
+    static constexpr const size_t size = 4;
+
+    vectorMaxLengthT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii] = { *v++, *v++, *v++, *v++ };
+        }
+    }
+
+    void operator()() {
+        _output = V::MaxLength(_input.data(), _input.size());
+    }
+
+    std::vector<V> _input;
+    S _output;
+};
+
+template<typename M, typename V, typename S>
+struct halfVectorPackT {
+    static constexpr const char* name = "halfVectorPack";
+    static constexpr const size_t size = 4;
+
+    using H = decltype(V().ToHalfVector());
+
+    halfVectorPackT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii] = { *v++, *v++, *v++, *v++ };
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        H::Pack(_input.data(), _output.data(), _input.size());
+    }
+
+    std::vector<V> _input;
+    std::vector<H> _output;
+};
+
+template<typename M, typename V, typename S>
+struct halfVectorUnpackT {
+    static constexpr const char* name = "halfVectorUnpack";
+    static constexpr const size_t size = 4;
+
+    using H = decltype(V().ToHalfVector());
+
+    halfVectorUnpackT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii] = { *v++, *v++, *v++, *v++ };
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        H::Unpack(_input.data(), _output.data(), _input.size());
+    }
+
+    std::vector<H> _input;
+    std::vector<V> _output;
+};
+
+template<typename M, typename V, typename S>
+struct vector3PackT {
+    static constexpr const char* name = "vector3Pack";
+    static constexpr const size_t size = 4;
+
+    using P = decltype(V().ToVector3());
+
+    vector3PackT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii] = { *v++, *v++, *v++, *v++ };
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        P::Pack(_input.data(), _output.data(), _input.size());
+    }
+
+    std::vector<V> _input;
+    std::vector<P> _output;
+};
+
+template<typename M, typename V, typename S>
+struct vector3UnpackT {
+    static constexpr const char* name = "vector3Unpack";
+    static constexpr const size_t size = 3;
+
+    using P = decltype(V().ToVector3());
+
+    vector3UnpackT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii] = { *v++, *v++, *v++ };
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        P::Unpack(_input.data(), _output.data(), _input.size(), 1.f);
+    }
+
+    std::vector<P> _input;
+    std::vector<V> _output;
+};
+
 template<typename M, typename V, typename S>
 struct matrixScalarT {
     static constexpr const char* name = "matrixScalar";
@@ -622,141 +836,1231 @@ struct matrixTransposeT {
 };
 
 template<typename M, typename V, typename S>
-struct hitSphereT {
-    static constexpr const char* name = "hitSphere";
-    static constexpr const size_t size = 10;
+struct matrixInverseT : matrixTransposeT<M, V, S> {
+    static constexpr const char* name = "matrixInverse";
 
-    struct Args {
-        Ray<V, S> ray;
-        Sphere<V, S> sphere;
-    };
+    using matrixTransposeT<M, V, S>::matrixTransposeT;
 
-    hitSphereT(std::vector<float> const& data) {
+    void operator()() {
+        M* out = this->_output.data();
+
+        for (auto const& in : this->_input) {
+            *out++ = in.Inverse();
+        }
+    }
+};
+
+template<typename M, typename V, typename S>
+struct matrixInverseAffineT {
+    static constexpr const char* name = "matrixInverseAffine";
+    static constexpr const size_t size = 12;
+
+    matrixInverseAffineT(std::vector<float> const& data) {
         _input.resize(data.size() / size);
         float const* v = data.data();
         for (size_t ii = 0; ii < _input.size(); ++ii) {
-            _input[ii].ray = {
-                { *v++, *v++, *v++, 1.0f },
-                { *v++, *v++, *v++, 1.0f },
-            };
-            _input[ii].sphere = {
-                { *v++, *v++, *v++, 1.0f }, *v++,
+            _input[ii] = {
+                *v++, *v++, *v++, *v++,
+                *v++, *v++, *v++, *v++,
+                *v++, *v++, *v++, *v++,
+                0.f,  0.f,  0.f,  1.f,
             };
         }
         _output.resize(data.size() / size);
     }
 
     void operator()() {
-        Hit<V, S>* out = _output.data();
+        M* out = _output.data();
 
-        for (auto const& in: _input) {
-            hitSphere<V, S>(in.ray, in.sphere, *out++);
+        for (auto const& in : _input) {
+            *out++ = in.InverseAffine();
         }
     }
 
-    std::vector<Args> _input;
-    std::vector<Hit<V, S>> _output;
+    std::vector<M> _input;
+    std::vector<M> _output;
 };
 
 template<typename M, typename V, typename S>
-struct hitCapsuleT {
-    static constexpr const char* name = "hitCapsule";
-    static constexpr const size_t size = 13;
+struct matrixInverseBatchT : matrixTransposeT<M, V, S> {
+    static constexpr const char* name = "matrixInverseBatch";
 
-    struct Args {
-        Ray<V, S> ray;
-        Capsule<V, S> capsule;
-    };
+    using matrixTransposeT<M, V, S>::matrixTransposeT;
 
-    hitCapsuleT(std::vector<float> const& data) {
-        _input.resize(data.size() / size);
+    void operator()() {
+        M::InverseBatch(this->_input.data(), this->_output.data(), this->_input.size());
+    }
+};
+
+template<typename M, typename V, typename S>
+struct matrixTransformLoopT {
+    static constexpr const char* name = "matrixTransformLoop";
+    static constexpr const size_t size = 4;
+
+    matrixTransformLoopT(std::vector<float> const& data) {
         float const* v = data.data();
+        _matrix = {
+            *v++, *v++, *v++, *v++,
+            *v++, *v++, *v++, *v++,
+            *v++, *v++, *v++, *v++,
+            *v++, *v++, *v++, *v++,
+        };
+        _input.resize(data.size() / size);
+        v = data.data();
         for (size_t ii = 0; ii < _input.size(); ++ii) {
-            _input[ii].ray = {
-                { *v++, *v++, *v++, 1.0f },
-                { *v++, *v++, *v++, 1.0f },
-            };
-            _input[ii].capsule = {
-                { *v++, *v++, *v++, 1.0f },
-                { *v++, *v++, *v++, 1.0f },
-                *v++,
-            };
+            _input[ii] = { *v++, *v++, *v++, 1.f };
+            ++v;
         }
         _output.resize(data.size() / size);
     }
 
     void operator()() {
-        Hit<V, S>* out = _output.data();
+        V* out = _output.data();
 
         for (auto const& in: _input) {
-            hitCapsule<V, S>(in.ray, in.capsule, *out++);
+            *out++ = _matrix * in;
         }
     }
 
-    std::vector<Args> _input;
-    std::vector<Hit<V, S>> _output;
+    M _matrix;
+    std::vector<V> _input;
+    std::vector<V> _output;
 };
 
 template<typename M, typename V, typename S>
-struct traceSceneT {
-    static constexpr const char* name = "traceScene";
+struct matrixTransformPointsT : matrixTransformLoopT<M, V, S> {
+    static constexpr const char* name = "matrixTransformBatch";
 
-    traceSceneT(std::vector<float> const&) {}
+    using matrixTransformLoopT<M, V, S>::matrixTransformLoopT;
 
     void operator()() {
-        Trace<M, V, S>(1024, 1024);
+        this->_matrix.TransformPoints(this->_input.data(), this->_output.data(), this->_input.size());
     }
 };
 
-template<typename Func>
-double testPerformanceSingle(Func& fn) {
-    Timer t;
-
-    t.Start();
-    fn();
-    t.Stop();
-    return t.Microseconds();
-}
-
-template<template<typename, typename, typename> class Func, size_t kLoopCount = 16>
-void testPerformance(std::vector<float> const& data) {
-    double loop_timing[3][kLoopCount];
-    double timing[3];
+template<typename M, typename V, typename S>
+struct matrixTransformPointsStreamT : matrixTransformLoopT<M, V, S> {
+    static constexpr const char* name = "matrixTransformStream";
 
-    Func<reference::Matrix, reference::Vector, reference::Scalar> fn0(data);
-    Func<intrinsic::Matrix, intrinsic::Vector, intrinsic::Scalar> fn1(data);
-    Func<aliased::Matrix, aliased::Vector, aliased::Scalar> fn2(data);
+    using matrixTransformLoopT<M, V, S>::matrixTransformLoopT;
 
-    // Warm-up passes
-    for (size_t ii = 0; ii < 4; ++ii) {
-        testPerformanceSingle(fn0);
-        testPerformanceSingle(fn1);
-        testPerformanceSingle(fn2);
+    void operator()() {
+        this->_matrix.TransformPoints(this->_input.data(), this->_output.data(), this->_input.size(), true);
     }
+};
 
-    // Measured passes
-    for (size_t ii = 0; ii < kLoopCount; ++ii) {
-        loop_timing[0][ii] = testPerformanceSingle(fn0);
-        loop_timing[1][ii] = testPerformanceSingle(fn1);
-        loop_timing[2][ii] = testPerformanceSingle(fn2);
-    }
+template<typename M, typename V, typename S>
+struct affineVectorT {
+    static constexpr const char* name = "affineVector";
+    static constexpr const size_t size = 16;
 
-    // Sort passes
-    std::sort(&loop_timing[0][0], &loop_timing[0][kLoopCount]);
-    std::sort(&loop_timing[1][0], &loop_timing[1][kLoopCount]);
-    std::sort(&loop_timing[2][0], &loop_timing[2][kLoopCount]);
+    using A = decltype(M().ToAffineMatrix());
 
-    // Select median
-    timing[0] = loop_timing[0][kLoopCount/2];
-    timing[1] = loop_timing[1][kLoopCount / 2];
-    timing[2] = loop_timing[2][kLoopCount / 2];
+    struct Args {
+        A a;
+        V v;
+    };
+
+    affineVectorT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii].a = {
+                *v++, *v++, *v++, *v++,
+                *v++, *v++, *v++, *v++,
+                *v++, *v++, *v++, *v++,
+            };
+            _input[ii].v = {
+                *v++, *v++, *v++, *v++,
+            };
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        V* out = _output.data();
+
+        for (auto const& in: _input) {
+            *out++ = in.a * in.v;
+        }
+    }
+
+    std::vector<Args> _input;
+    std::vector<V> _output;
+};
+
+template<typename M, typename V, typename S>
+struct affineAffineT {
+    static constexpr const char* name = "affineAffine";
+    static constexpr const size_t size = 24;
+
+    using A = decltype(M().ToAffineMatrix());
+
+    struct Args {
+        A a;
+        A b;
+    };
+
+    affineAffineT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii].a = {
+                *v++, *v++, *v++, *v++,
+                *v++, *v++, *v++, *v++,
+                *v++, *v++, *v++, *v++,
+            };
+            _input[ii].b = {
+                *v++, *v++, *v++, *v++,
+                *v++, *v++, *v++, *v++,
+                *v++, *v++, *v++, *v++,
+            };
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        A* out = _output.data();
+
+        for (auto const& in: _input) {
+            *out++ = in.a * in.b;
+        }
+    }
+
+    std::vector<Args> _input;
+    std::vector<A> _output;
+};
+
+template<typename M, typename V, typename S>
+struct quaternionProductT {
+    static constexpr const char* name = "quaternionProduct";
+    static constexpr const size_t size = 8;
+
+    using Q = decltype(M().ToQuaternion());
+
+    struct Args {
+        Q a;
+        Q b;
+    };
+
+    quaternionProductT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii].a = Q(v[0], v[1], v[2], v[3]).Normalize();
+            _input[ii].b = Q(v[4], v[5], v[6], v[7]).Normalize();
+            v += size;
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        Q* out = _output.data();
+
+        for (auto const& in: _input) {
+            *out++ = in.a * in.b;
+        }
+    }
+
+    std::vector<Args> _input;
+    std::vector<Q> _output;
+};
+
+template<typename M, typename V, typename S>
+struct quaternionRotateT {
+    static constexpr const char* name = "quaternionRotate";
+    static constexpr const size_t size = 8;
+
+    using Q = decltype(M().ToQuaternion());
+
+    struct Args {
+        Q q;
+        V v;
+    };
+
+    quaternionRotateT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii].q = Q(v[0], v[1], v[2], v[3]).Normalize();
+            _input[ii].v = V(v[4], v[5], v[6], v[7]);
+            v += size;
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        V* out = _output.data();
+
+        for (auto const& in: _input) {
+            *out++ = in.q.Rotate(in.v);
+        }
+    }
+
+    std::vector<Args> _input;
+    std::vector<V> _output;
+};
+
+template<typename M, typename V, typename S>
+struct quaternionToMatrixT {
+    static constexpr const char* name = "quaternionToMatrix";
+    static constexpr const size_t size = 4;
+
+    using Q = decltype(M().ToQuaternion());
+
+    quaternionToMatrixT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii] = Q(v[0], v[1], v[2], v[3]).Normalize();
+            v += size;
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        M* out = _output.data();
+
+        for (auto const& in: _input) {
+            *out++ = M(in);
+        }
+    }
+
+    std::vector<Q> _input;
+    std::vector<M> _output;
+};
+
+template<typename M, typename V, typename S>
+struct quaternionSlerpT {
+    static constexpr const char* name = "quaternionSlerp";
+    static constexpr const size_t size = 9;
+
+    using Q = decltype(M().ToQuaternion());
+
+    quaternionSlerpT(std::vector<float> const& data) {
+        size_t count = data.size() / size;
+        _a.resize(count);
+        _b.resize(count);
+        _t.resize(count);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < count; ++ii) {
+            _a[ii] = Q(v[0], v[1], v[2], v[3]).Normalize();
+            _b[ii] = Q(v[4], v[5], v[6], v[7]).Normalize();
+            _t[ii] = v[8] * (1.f / 16.f);
+            v += size;
+        }
+        _output.resize(count);
+    }
+
+    void operator()() {
+        for (size_t ii = 0; ii < _output.size(); ++ii) {
+            _output[ii] = _a[ii].Slerp(_b[ii], _t[ii]);
+        }
+    }
+
+    std::vector<Q> _a;
+    std::vector<Q> _b;
+    std::vector<float> _t;
+    std::vector<Q> _output;
+};
+
+template<typename M, typename V, typename S>
+struct quaternionSlerpBatchT : quaternionSlerpT<M, V, S> {
+    static constexpr const char* name = "quaternionSlerpBatch";
+
+    using quaternionSlerpT<M, V, S>::quaternionSlerpT;
+
+    void operator()() {
+        quaternionSlerpT<M, V, S>::Q::SlerpBatch(
+            this->_a.data(), this->_b.data(), this->_t.data(), this->_output.data(), this->_output.size());
+    }
+};
+
+template<typename M, typename V, typename S>
+struct hitSphereT {
+    static constexpr const char* name = "hitSphere";
+    static constexpr const size_t size = 10;
+
+    struct Args {
+        Ray<V, S> ray;
+        Sphere<V, S> sphere;
+    };
+
+    hitSphereT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii].ray = {
+                { *v++, *v++, *v++, 1.0f },
+                { *v++, *v++, *v++, 1.0f },
+            };
+            _input[ii].sphere = {
+                { *v++, *v++, *v++, 1.0f }, *v++,
+            };
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        Hit<V, S>* out = _output.data();
+
+        for (auto const& in: _input) {
+            hitSphere<V, S>(in.ray, in.sphere, *out++);
+        }
+    }
+
+    std::vector<Args> _input;
+    std::vector<Hit<V, S>> _output;
+};
+
+template<typename M, typename V, typename S>
+struct hitCapsuleT {
+    static constexpr const char* name = "hitCapsule";
+    static constexpr const size_t size = 13;
+
+    struct Args {
+        Ray<V, S> ray;
+        Capsule<V, S> capsule;
+    };
+
+    hitCapsuleT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii].ray = {
+                { *v++, *v++, *v++, 1.0f },
+                { *v++, *v++, *v++, 1.0f },
+            };
+            _input[ii].capsule = {
+                { *v++, *v++, *v++, 1.0f },
+                { *v++, *v++, *v++, 1.0f },
+                *v++,
+            };
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        Hit<V, S>* out = _output.data();
+
+        for (auto const& in: _input) {
+            hitCapsule<V, S>(in.ray, in.capsule, *out++);
+        }
+    }
+
+    std::vector<Args> _input;
+    std::vector<Hit<V, S>> _output;
+};
+
+template<typename M, typename V, typename S>
+struct intersectSphereT {
+    static constexpr const char* name = "intersectSphere";
+    static constexpr const size_t size = 10;
+
+    struct Args {
+        Ray<V, S> ray;
+        Sphere<V, S> sphere;
+    };
+
+    intersectSphereT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii].ray = {
+                { *v++, *v++, *v++, 1.0f },
+                { *v++, *v++, *v++, 1.0f },
+            };
+            _input[ii].sphere = {
+                { *v++, *v++, *v++, 1.0f }, *v++,
+            };
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        S* out = _output.data();
+
+        for (auto const& in: _input) {
+            intersectSphere<V, S>(in.ray, in.sphere, S(1.0f), *out++);
+        }
+    }
+
+    std::vector<Args> _input;
+    std::vector<S> _output;
+};
+
+template<typename M, typename V, typename S>
+struct intersectCapsuleT {
+    static constexpr const char* name = "intersectCapsule";
+    static constexpr const size_t size = 13;
+
+    struct Args {
+        Ray<V, S> ray;
+        Capsule<V, S> capsule;
+    };
+
+    intersectCapsuleT(std::vector<float> const& data) {
+        _input.resize(data.size() / size);
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _input.size(); ++ii) {
+            _input[ii].ray = {
+                { *v++, *v++, *v++, 1.0f },
+                { *v++, *v++, *v++, 1.0f },
+            };
+            _input[ii].capsule = {
+                { *v++, *v++, *v++, 1.0f },
+                { *v++, *v++, *v++, 1.0f },
+                *v++,
+            };
+        }
+        _output.resize(data.size() / size);
+    }
+
+    void operator()() {
+        S* out = _output.data();
+
+        for (auto const& in: _input) {
+            intersectCapsule<V, S>(in.ray, in.capsule, S(1.0f), *out++);
+        }
+    }
+
+    std::vector<Args> _input;
+    std::vector<S> _output;
+};
+
+template<typename M, typename V, typename S>
+struct intersectSphereBranchlessT : intersectSphereT<M, V, S> {
+    static constexpr const char* name = "intersectSphereNoBranch";
+
+    using intersectSphereT<M, V, S>::intersectSphereT;
+
+    void operator()() {
+        S* out = this->_output.data();
+
+        for (auto const& in: this->_input) {
+            intersectSphereBranchless<V, S>(in.ray, in.sphere, S(1.0f), *out++);
+        }
+    }
+};
+
+template<typename M, typename V, typename S>
+struct intersectCapsuleBranchlessT : intersectCapsuleT<M, V, S> {
+    static constexpr const char* name = "intersectCapsuleNoBranch";
+
+    using intersectCapsuleT<M, V, S>::intersectCapsuleT;
+
+    void operator()() {
+        S* out = this->_output.data();
+
+        for (auto const& in: this->_input) {
+            intersectCapsuleBranchless<V, S>(in.ray, in.capsule, S(1.0f), *out++);
+        }
+    }
+};
+
+template<typename M, typename V, typename S>
+struct traceSceneT {
+    static constexpr const char* name = "traceScene";
+
+    traceSceneT(std::vector<float> const&) {}
+
+    void operator()() {
+        Trace<M, V, S>(1024, 1024);
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Input and output streams for packet functors, stored as consecutive packets
+//! of `num_args` vectors each followed by `num_results` results per packet. The
+//! input is read from `data` in the same order as the corresponding functor for
+//! individual vectors, so that both operate on the same values.
+template<typename P>
+struct packetDataT {
+    static constexpr size_t N = P::kWidth;
+
+    packetDataT(std::vector<float> const& data, size_t num_args, size_t num_components, size_t num_results)
+        : _count(data.size() / (num_args * num_components * N))
+        , _input(_count * num_args * 4 * N)
+        , _output(_count * num_results * N)
+    {
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _count; ++ii) {
+            float* in = _input.data() + ii * num_args * 4 * N;
+            for (size_t lane = 0; lane < N; ++lane) {
+                for (size_t arg = 0; arg < num_args; ++arg) {
+                    for (size_t jj = 0; jj < 4; ++jj) {
+                        in[(arg * 4 + jj) * N + lane] = jj < num_components ? *v++ : 0.0f;
+                    }
+                }
+            }
+        }
+    }
+
+    static P load(float const* in) {
+        return P(in, in + N, in + 2 * N, in + 3 * N);
+    }
+
+    static void store(P const& p, float* out) {
+        p.Store(out, out + N, out + 2 * N, out + 3 * N);
+    }
+
+    size_t _count;
+    std::vector<float> _input;
+    std::vector<float> _output;
+};
+
+template<typename P>
+struct vectorLengthPacketT : packetDataT<P> {
+    static constexpr const char* name = "vectorLengthPacket";
+    using packetDataT<P>::N;
+
+    vectorLengthPacketT(std::vector<float> const& data)
+        : packetDataT<P>(data, 1, 4, 1) {}
+
+    void operator()() {
+        float const* in = this->_input.data();
+        float* out = this->_output.data();
+
+        for (size_t ii = 0; ii < this->_count; ++ii, in += 4 * N, out += N) {
+            this->load(in).Length().Store(out);
+        }
+    }
+};
+
+template<typename P>
+struct vectorNormalizePacketT : packetDataT<P> {
+    static constexpr const char* name = "vectorNormalizePacket";
+    using packetDataT<P>::N;
+
+    vectorNormalizePacketT(std::vector<float> const& data)
+        : packetDataT<P>(data, 1, 4, 4) {}
+
+    void operator()() {
+        float const* in = this->_input.data();
+        float* out = this->_output.data();
+
+        for (size_t ii = 0; ii < this->_count; ++ii, in += 4 * N, out += 4 * N) {
+            this->store(this->load(in).Normalize(), out);
+        }
+    }
+};
+
+template<typename P>
+struct vectorDotPacketT : packetDataT<P> {
+    static constexpr const char* name = "vectorDotPacket";
+    using packetDataT<P>::N;
+
+    vectorDotPacketT(std::vector<float> const& data)
+        : packetDataT<P>(data, 2, 4, 1) {}
+
+    void operator()() {
+        float const* in = this->_input.data();
+        float* out = this->_output.data();
+
+        for (size_t ii = 0; ii < this->_count; ++ii, in += 8 * N, out += N) {
+            (this->load(in) * this->load(in + 4 * N)).Store(out);
+        }
+    }
+};
+
+template<typename P>
+struct vectorCrossPacketT : packetDataT<P> {
+    static constexpr const char* name = "vectorCrossPacket";
+    using packetDataT<P>::N;
+
+    vectorCrossPacketT(std::vector<float> const& data)
+        : packetDataT<P>(data, 2, 3, 4) {}
+
+    void operator()() {
+        float const* in = this->_input.data();
+        float* out = this->_output.data();
+
+        for (size_t ii = 0; ii < this->_count; ++ii, in += 8 * N, out += 4 * N) {
+            this->store(this->load(in) % this->load(in + 4 * N), out);
+        }
+    }
+};
+
+template<typename P>
+struct vectorProjectPacketT : packetDataT<P> {
+    static constexpr const char* name = "vectorProjectPacket";
+    using packetDataT<P>::N;
+
+    vectorProjectPacketT(std::vector<float> const& data)
+        : packetDataT<P>(data, 2, 4, 4) {}
+
+    void operator()() {
+        float const* in = this->_input.data();
+        float* out = this->_output.data();
+
+        for (size_t ii = 0; ii < this->_count; ++ii, in += 8 * N, out += 4 * N) {
+            this->store(this->load(in).Project(this->load(in + 4 * N)), out);
+        }
+    }
+};
+
+template<typename P>
+struct vectorRejectPacketT : packetDataT<P> {
+    static constexpr const char* name = "vectorRejectPacket";
+    using packetDataT<P>::N;
+
+    vectorRejectPacketT(std::vector<float> const& data)
+        : packetDataT<P>(data, 2, 4, 4) {}
+
+    void operator()() {
+        float const* in = this->_input.data();
+        float* out = this->_output.data();
+
+        for (size_t ii = 0; ii < this->_count; ++ii, in += 8 * N, out += 4 * N) {
+            this->store(this->load(in).Reject(this->load(in + 4 * N)), out);
+        }
+    }
+};
+
+template<typename P>
+struct vectorReflectPacketT : packetDataT<P> {
+    static constexpr const char* name = "vectorReflectPacket";
+    using packetDataT<P>::N;
+
+    vectorReflectPacketT(std::vector<float> const& data)
+        : packetDataT<P>(data, 2, 4, 4) {}
+
+    void operator()() {
+        float const* in = this->_input.data();
+        float* out = this->_output.data();
+
+        for (size_t ii = 0; ii < this->_count; ++ii, in += 8 * N, out += 4 * N) {
+            this->store(this->load(in).Reflect(this->load(in + 4 * N)), out);
+        }
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Coefficient and root arrays for the quadratic functors, with about half of
+//! the quadratics having real roots.
+struct quadraticDataT {
+    quadraticDataT(std::vector<float> const& data)
+        : _count(data.size() / 3)
+        , _A(_count)
+        , _B(_count)
+        , _C(_count)
+        , _t0(_count)
+        , _t1(_count)
+        , _valid(new bool[_count])
+    {
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _count; ++ii) {
+            _A[ii] = 1.f + std::abs(*v++);
+            _B[ii] = *v++;
+            _C[ii] = *v++;
+        }
+    }
+
+    size_t _count;
+    std::vector<float> _A, _B, _C;
+    std::vector<float> _t0, _t1;
+    std::unique_ptr<bool[]> _valid;
+};
+
+template<typename M, typename V, typename S>
+struct quadraticT : quadraticDataT {
+    static constexpr const char* name = "quadratic";
+
+    quadraticT(std::vector<float> const& data)
+        : quadraticDataT(data) {}
+
+    void operator()() {
+        for (size_t ii = 0; ii < _count; ++ii) {
+            S t0, t1;
+            _valid[ii] = Any(solveQuadratic(S(_A[ii]), S(_B[ii]), S(_C[ii]), t0, t1));
+            _t0[ii] = float(t0);
+            _t1[ii] = float(t1);
+        }
+    }
+};
+
+template<typename P>
+struct quadraticPacketT : quadraticDataT {
+    static constexpr const char* name = "quadraticPacket";
+
+    quadraticPacketT(std::vector<float> const& data)
+        : quadraticDataT(data) {}
+
+    void operator()() {
+        solveQuadratics<typename P::Scalar>(_A.data(), _B.data(), _C.data(),
+                                            _t0.data(), _t1.data(), _valid.get(), _count);
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Arrays of vectors and of their components for conversions between the two
+//! layouts, with a random permutation of the vectors for gathers and scatters.
+template<typename V>
+struct transposeDataT {
+    transposeDataT(std::vector<float> const& data)
+        : _count(data.size() / 4)
+        , _vectors(_count)
+        , _indices(_count)
+        , _x(_count)
+        , _y(_count)
+        , _z(_count)
+        , _w(_count)
+    {
+        float const* v = data.data();
+        for (size_t ii = 0; ii < _count; ++ii, v += 4) {
+            _vectors[ii] = V(v[0], v[1], v[2], v[3]);
+            _x[ii] = v[0];
+            _y[ii] = v[1];
+            _z[ii] = v[2];
+            _w[ii] = v[3];
+        }
+        std::iota(_indices.begin(), _indices.end(), 0u);
+        std::shuffle(_indices.begin(), _indices.end(), std::mt19937(1234));
+    }
+
+    size_t _count;
+    std::vector<V> _vectors;
+    std::vector<uint32_t> _indices;
+    std::vector<float> _x, _y, _z, _w;
+};
+
+template<typename M, typename V, typename S>
+struct vectorToSoAT : transposeDataT<V> {
+    static constexpr const char* name = "vectorToSoA";
+
+    vectorToSoAT(std::vector<float> const& data)
+        : transposeDataT<V>(data) {}
+
+    void operator()() {
+        for (size_t ii = 0; ii < this->_count; ++ii) {
+            V const& v = this->_vectors[ii];
+            this->_x[ii] = float(v[0]);
+            this->_y[ii] = float(v[1]);
+            this->_z[ii] = float(v[2]);
+            this->_w[ii] = float(v[3]);
+        }
+    }
+};
+
+template<typename M, typename V, typename S>
+struct vectorFromSoAT : transposeDataT<V> {
+    static constexpr const char* name = "vectorFromSoA";
+
+    vectorFromSoAT(std::vector<float> const& data)
+        : transposeDataT<V>(data) {}
+
+    void operator()() {
+        for (size_t ii = 0; ii < this->_count; ++ii) {
+            this->_vectors[ii] = V(this->_x[ii], this->_y[ii], this->_z[ii], this->_w[ii]);
+        }
+    }
+};
+
+template<typename M, typename V, typename S>
+struct vectorGatherSoAT : transposeDataT<V> {
+    static constexpr const char* name = "vectorGatherSoA";
+
+    vectorGatherSoAT(std::vector<float> const& data)
+        : transposeDataT<V>(data) {}
+
+    void operator()() {
+        for (size_t ii = 0; ii < this->_count; ++ii) {
+            V const& v = this->_vectors[this->_indices[ii]];
+            this->_x[ii] = float(v[0]);
+            this->_y[ii] = float(v[1]);
+            this->_z[ii] = float(v[2]);
+            this->_w[ii] = float(v[3]);
+        }
+    }
+};
+
+template<typename M, typename V, typename S>
+struct vectorScatterSoAT : transposeDataT<V> {
+    static constexpr const char* name = "vectorScatterSoA";
+
+    vectorScatterSoAT(std::vector<float> const& data)
+        : transposeDataT<V>(data) {}
+
+    void operator()() {
+        for (size_t ii = 0; ii < this->_count; ++ii) {
+            this->_vectors[this->_indices[ii]] = V(this->_x[ii], this->_y[ii], this->_z[ii], this->_w[ii]);
+        }
+    }
+};
+
+template<typename P>
+struct vectorToSoAPacketT : transposeDataT<intrinsic::Vector> {
+    static constexpr const char* name = "vectorToSoAPacket";
+
+    vectorToSoAPacketT(std::vector<float> const& data)
+        : transposeDataT<intrinsic::Vector>(data) {}
+
+    void operator()() {
+        P::Transpose(_vectors.data(), _x.data(), _y.data(), _z.data(), _w.data(), _count);
+    }
+};
+
+template<typename P>
+struct vectorFromSoAPacketT : transposeDataT<intrinsic::Vector> {
+    static constexpr const char* name = "vectorFromSoAPacket";
+
+    vectorFromSoAPacketT(std::vector<float> const& data)
+        : transposeDataT<intrinsic::Vector>(data) {}
+
+    void operator()() {
+        P::Transpose(_x.data(), _y.data(), _z.data(), _w.data(), _vectors.data(), _count);
+    }
+};
+
+template<typename P>
+struct vectorGatherSoAPacketT : transposeDataT<intrinsic::Vector> {
+    static constexpr const char* name = "vectorGatherSoAPacket";
+
+    vectorGatherSoAPacketT(std::vector<float> const& data)
+        : transposeDataT<intrinsic::Vector>(data) {}
+
+    void operator()() {
+        P::Gather(_vectors.data(), _indices.data(), _x.data(), _y.data(), _z.data(), _w.data(), _count);
+    }
+};
+
+template<typename P>
+struct vectorScatterSoAPacketT : transposeDataT<intrinsic::Vector> {
+    static constexpr const char* name = "vectorScatterSoAPacket";
+
+    vectorScatterSoAPacketT(std::vector<float> const& data)
+        : transposeDataT<intrinsic::Vector>(data) {}
+
+    void operator()() {
+        P::Scatter(_x.data(), _y.data(), _z.data(), _w.data(), _indices.data(), _vectors.data(), _count);
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Scalar generator with the same interface as `intrinsic::Random` for
+//! comparison, which draws one sample per call from `std::mt19937`.
+struct scalarRandom {
+    static constexpr size_t kWidth = 1;
+
+    scalarRandom(uint64_t seed)
+        : _engine(uint32_t(seed)) {}
+
+    void Uniform(float* dst) {
+        *dst = Next();
+    }
+
+    void UnitSphere(intrinsic::Vector* dst) {
+        float z = 1.f - 2.f * Next();
+        float r = std::sqrt(1.f - z * z);
+        float phi = 6.28318530717958647692f * Next();
+        *dst = intrinsic::Vector(r * std::cos(phi), r * std::sin(phi), z, 0.f);
+    }
+
+    void CosineHemisphere(intrinsic::Vector const& n, intrinsic::Vector* dst) {
+        UnitSphere(dst);
+        intrinsic::Vector d = n + *dst;
+        float lsqr = float(d.LengthSqr());
+        *dst = lsqr > 1e-12f ? d / std::sqrt(lsqr) : n;
+    }
+
+    //! Uniform sample in [0, 1) from the upper 24 bits of the engine output.
+    float Next() {
+        return float(_engine() >> 8) * (1.f / 16777216.f);
+    }
+
+    std::mt19937 _engine;
+};
+
+//------------------------------------------------------------------------------
+//! Output stream for generator functors, with one sample for each vector in
+//! the input.
+template<typename R, typename T>
+struct randomDataT {
+    static constexpr size_t N = R::kWidth;
+
+    randomDataT(std::vector<float> const& data)
+        : _random(1234)
+        , _count(data.size() / (4 * N))
+        , _output(_count * N)
+    {}
+
+    R _random;
+    size_t _count;
+    std::vector<T> _output;
+};
+
+template<typename R>
+struct randomUniformT : randomDataT<R, float> {
+    static constexpr const char* name = "randomUniform";
+    using randomDataT<R, float>::N;
+
+    randomUniformT(std::vector<float> const& data)
+        : randomDataT<R, float>(data) {}
+
+    void operator()() {
+        float* out = this->_output.data();
+
+        for (size_t ii = 0; ii < this->_count; ++ii, out += N) {
+            this->_random.Uniform(out);
+        }
+    }
+};
+
+template<typename R>
+struct randomUnitSphereT : randomDataT<R, intrinsic::Vector> {
+    static constexpr const char* name = "randomUnitSphere";
+    using randomDataT<R, intrinsic::Vector>::N;
+
+    randomUnitSphereT(std::vector<float> const& data)
+        : randomDataT<R, intrinsic::Vector>(data) {}
+
+    void operator()() {
+        intrinsic::Vector* out = this->_output.data();
+
+        for (size_t ii = 0; ii < this->_count; ++ii, out += N) {
+            this->_random.UnitSphere(out);
+        }
+    }
+};
+
+template<typename R>
+struct randomCosineHemisphereT : randomDataT<R, intrinsic::Vector> {
+    static constexpr const char* name = "randomCosineHemisphere";
+    using randomDataT<R, intrinsic::Vector>::N;
+
+    randomCosineHemisphereT(std::vector<float> const& data)
+        : randomDataT<R, intrinsic::Vector>(data) {}
+
+    void operator()() {
+        intrinsic::Vector n(0.f, 0.f, 1.f, 0.f);
+        intrinsic::Vector* out = this->_output.data();
+
+        for (size_t ii = 0; ii < this->_count; ++ii, out += N) {
+            this->_random.CosineHemisphere(n, out);
+        }
+    }
+};
+
+template<typename Func>
+double testPerformanceSingle(Func& fn) {
+    Timer t;
+
+    t.Start();
+    fn();
+    t.Stop();
+    return t.Microseconds();
+}
+
+template<template<typename, typename, typename> class Func, size_t kLoopCount = 16>
+void testPerformance(std::vector<float> const& data) {
+    constexpr size_t kNumFuncs = 3 + _HAS_AVX + _HAS_VECTOR_EXTENSIONS;
+    double loop_timing[kNumFuncs][kLoopCount];
+    double timing[kNumFuncs];
+
+    Func<reference::Matrix, reference::Vector, reference::Scalar> fn0(data);
+    Func<intrinsic::Matrix, intrinsic::Vector, intrinsic::Scalar> fn1(data);
+    Func<aliased::Matrix, aliased::Vector, aliased::Scalar> fn2(data);
+#if _HAS_AVX
+    Func<avx::Matrix, avx::Vector, avx::Scalar> fn3(data);
+#endif // _HAS_AVX
+#if _HAS_VECTOR_EXTENSIONS
+    Func<portable::Matrix, portable::Vector, portable::Scalar> fn4(data);
+#endif // _HAS_VECTOR_EXTENSIONS
+
+    // Warm-up passes
+    for (size_t ii = 0; ii < 4; ++ii) {
+        testPerformanceSingle(fn0);
+        testPerformanceSingle(fn1);
+        testPerformanceSingle(fn2);
+#if _HAS_AVX
+        testPerformanceSingle(fn3);
+#endif // _HAS_AVX
+#if _HAS_VECTOR_EXTENSIONS
+        testPerformanceSingle(fn4);
+#endif // _HAS_VECTOR_EXTENSIONS
+    }
+
+    // Measured passes
+    for (size_t ii = 0; ii < kLoopCount; ++ii) {
+        size_t jj = 0;
+        loop_timing[jj++][ii] = testPerformanceSingle(fn0);
+        loop_timing[jj++][ii] = testPerformanceSingle(fn1);
+        loop_timing[jj++][ii] = testPerformanceSingle(fn2);
+#if _HAS_AVX
+        loop_timing[jj++][ii] = testPerformanceSingle(fn3);
+#endif // _HAS_AVX
+#if _HAS_VECTOR_EXTENSIONS
+        loop_timing[jj++][ii] = testPerformanceSingle(fn4);
+#endif // _HAS_VECTOR_EXTENSIONS
+    }
+
+    // Sort passes and select median
+    for (size_t ii = 0; ii < kNumFuncs; ++ii) {
+        std::sort(&loop_timing[ii][0], &loop_timing[ii][kLoopCount]);
+        timing[ii] = loop_timing[ii][kLoopCount / 2];
+    }
+
+    // Print results, followed by the speed of each implementation relative
+    // to the reference implementation
+    printf_s("  %-24s", Func<reference::Matrix, reference::Vector, reference::Scalar>::name);
+    for (size_t ii = 0; ii < kNumFuncs; ++ii) {
+        printf_s(" %12.4f \xc2\xb5s", timing[ii]);
+    }
+    for (size_t ii = 1; ii < kNumFuncs; ++ii) {
+        printf_s(" %7.2f%%", 1.0e2 * timing[0] / timing[ii]);
+    }
+    printf_s("\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compare the intrinsic implementation of `Func` on individual vectors with
+//! `PacketFunc` on packets of 4 and 8 vectors over the same input.
+template<template<typename, typename, typename> class Func,
+         template<typename> class PacketFunc,
+         size_t kLoopCount = 16>
+void testPerformancePacket(std::vector<float> const& data) {
+#if _HAS_AVX
+    constexpr size_t kNumFuncs = 3;
+#else
+    constexpr size_t kNumFuncs = 2;
+#endif // _HAS_AVX
+    double loop_timing[kNumFuncs][kLoopCount];
+    double timing[kNumFuncs];
+
+    Func<intrinsic::Matrix, intrinsic::Vector, intrinsic::Scalar> fn0(data);
+    PacketFunc<intrinsic::VectorPacket4> fn1(data);
+#if _HAS_AVX
+    PacketFunc<intrinsic::VectorPacket8> fn2(data);
+#endif // _HAS_AVX
+
+    // Warm-up passes
+    for (size_t ii = 0; ii < 4; ++ii) {
+        testPerformanceSingle(fn0);
+        testPerformanceSingle(fn1);
+#if _HAS_AVX
+        testPerformanceSingle(fn2);
+#endif // _HAS_AVX
+    }
+
+    // Measured passes
+    for (size_t ii = 0; ii < kLoopCount; ++ii) {
+        loop_timing[0][ii] = testPerformanceSingle(fn0);
+        loop_timing[1][ii] = testPerformanceSingle(fn1);
+#if _HAS_AVX
+        loop_timing[2][ii] = testPerformanceSingle(fn2);
+#endif // _HAS_AVX
+    }
+
+    // Sort passes and select median
+    for (size_t ii = 0; ii < kNumFuncs; ++ii) {
+        std::sort(&loop_timing[ii][0], &loop_timing[ii][kLoopCount]);
+        timing[ii] = loop_timing[ii][kLoopCount / 2];
+    }
+
+    // Print intrinsic and packet times
+#if _HAS_AVX
+    printf_s("  %-24s %12.4f \xc2\xb5s %12.4f \xc2\xb5s %12.4f \xc2\xb5s %7.2f%% %7.2f%%\n",
+             PacketFunc<intrinsic::VectorPacket4>::name,
+             timing[0], timing[1], timing[2],
+             1.0e2 * timing[0] / timing[1],
+             1.0e2 * timing[0] / timing[2]);
+#else
+    printf_s("  %-24s %12.4f \xc2\xb5s %12.4f \xc2\xb5s %12s    %7.2f%%\n",
+             PacketFunc<intrinsic::VectorPacket4>::name,
+             timing[0], timing[1], "-",
+             1.0e2 * timing[0] / timing[1]);
+#endif // _HAS_AVX
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compare `Func` drawing samples one at a time from `std::mt19937` with the
+//! same number of samples drawn from packet generators of 4 and 8 lanes.
+template<template<typename> class Func, size_t kLoopCount = 16>
+void testPerformanceRandom(std::vector<float> const& data) {
+    constexpr size_t kNumFuncs = 2 + _HAS_AVX;
+    double loop_timing[kNumFuncs][kLoopCount];
+    double timing[kNumFuncs];
+
+    Func<scalarRandom> fn0(data);
+    Func<intrinsic::Random4> fn1(data);
+#if _HAS_AVX
+    Func<intrinsic::Random8> fn2(data);
+#endif // _HAS_AVX
+
+    // Warm-up passes
+    for (size_t ii = 0; ii < 4; ++ii) {
+        testPerformanceSingle(fn0);
+        testPerformanceSingle(fn1);
+#if _HAS_AVX
+        testPerformanceSingle(fn2);
+#endif // _HAS_AVX
+    }
 
-    // Print results
+    // Measured passes
+    for (size_t ii = 0; ii < kLoopCount; ++ii) {
+        loop_timing[0][ii] = testPerformanceSingle(fn0);
+        loop_timing[1][ii] = testPerformanceSingle(fn1);
+#if _HAS_AVX
+        loop_timing[2][ii] = testPerformanceSingle(fn2);
+#endif // _HAS_AVX
+    }
+
+    // Sort passes and select median
+    for (size_t ii = 0; ii < kNumFuncs; ++ii) {
+        std::sort(&loop_timing[ii][0], &loop_timing[ii][kLoopCount]);
+        timing[ii] = loop_timing[ii][kLoopCount / 2];
+    }
+
+    // Print scalar and packet times
+#if _HAS_AVX
     printf_s("  %-24s %12.4f \xc2\xb5s %12.4f \xc2\xb5s %12.4f \xc2\xb5s %7.2f%% %7.2f%%\n",
-             Func<reference::Matrix, reference::Vector, reference::Scalar>::name,
+             Func<scalarRandom>::name,
              timing[0], timing[1], timing[2],
              1.0e2 * timing[0] / timing[1],
              1.0e2 * timing[0] / timing[2]);
+#else
+    printf_s("  %-24s %12.4f \xc2\xb5s %12.4f \xc2\xb5s %12s    %7.2f%%\n",
+             Func<scalarRandom>::name,
+             timing[0], timing[1], "-",
+             1.0e2 * timing[0] / timing[1]);
+#endif // _HAS_AVX
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compare the single precision intrinsic implementation of `Func` with the
+//! double precision implementation over the same input.
+template<template<typename, typename, typename> class Func, size_t kLoopCount = 16>
+void testPerformanceDouble(std::vector<float> const& data) {
+    constexpr size_t kNumFuncs = 2;
+    double loop_timing[kNumFuncs][kLoopCount];
+    double timing[kNumFuncs];
+
+    Func<intrinsic::Matrix, intrinsic::Vector, intrinsic::Scalar> fn0(data);
+    Func<intrinsic_d::Matrix, intrinsic_d::Vector, intrinsic_d::Scalar> fn1(data);
+
+    // Warm-up passes
+    for (size_t ii = 0; ii < 4; ++ii) {
+        testPerformanceSingle(fn0);
+        testPerformanceSingle(fn1);
+    }
+
+    // Measured passes
+    for (size_t ii = 0; ii < kLoopCount; ++ii) {
+        loop_timing[0][ii] = testPerformanceSingle(fn0);
+        loop_timing[1][ii] = testPerformanceSingle(fn1);
+    }
+
+    // Sort passes and select median
+    for (size_t ii = 0; ii < kNumFuncs; ++ii) {
+        std::sort(&loop_timing[ii][0], &loop_timing[ii][kLoopCount]);
+        timing[ii] = loop_timing[ii][kLoopCount / 2];
+    }
+
+    // Print single and double precision times
+    printf_s("  %-24s %12.4f \xc2\xb5s %12.4f \xc2\xb5s %7.2f%%\n",
+             Func<intrinsic::Matrix, intrinsic::Vector, intrinsic::Scalar>::name,
+             timing[0], timing[1],
+             1.0e2 * timing[0] / timing[1]);
 }
 
 void testVectorElemRead(std::vector<float> const& data) {
@@ -767,6 +2071,10 @@ void testVectorElemWrite(std::vector<float> const& data) {
     return testPerformance<vectorElemWriteT>(data);
 }
 
+void testVectorSwizzle(std::vector<float> const& data) {
+    return testPerformance<vectorSwizzleT>(data);
+}
+
 void testVectorAdd(std::vector<float> const& data) {
     return testPerformance<vectorAddT>(data);
 }
@@ -819,6 +2127,82 @@ void testVectorReflect(std::vector<float> const& data) {
     return testPerformance<vectorReflectT>(data);
 }
 
+void testVectorClamp(std::vector<float> const& data) {
+    return testPerformance<vectorClampT>(data);
+}
+
+void testVectorBounds(std::vector<float> const& data) {
+    return testPerformance<vectorBoundsT>(data);
+}
+
+void testVectorMaxLength(std::vector<float> const& data) {
+    return testPerformance<vectorMaxLengthT>(data);
+}
+
+void testVectorLengthPacket(std::vector<float> const& data) {
+    return testPerformancePacket<vectorLengthT, vectorLengthPacketT>(data);
+}
+
+void testVectorNormalizePacket(std::vector<float> const& data) {
+    return testPerformancePacket<vectorNormalizeT, vectorNormalizePacketT>(data);
+}
+
+void testVectorDotPacket(std::vector<float> const& data) {
+    return testPerformancePacket<vectorDotT, vectorDotPacketT>(data);
+}
+
+void testVectorCrossPacket(std::vector<float> const& data) {
+    return testPerformancePacket<vectorCrossT, vectorCrossPacketT>(data);
+}
+
+void testVectorProjectPacket(std::vector<float> const& data) {
+    return testPerformancePacket<vectorProjectT, vectorProjectPacketT>(data);
+}
+
+void testVectorRejectPacket(std::vector<float> const& data) {
+    return testPerformancePacket<vectorRejectT, vectorRejectPacketT>(data);
+}
+
+void testVectorReflectPacket(std::vector<float> const& data) {
+    return testPerformancePacket<vectorReflectT, vectorReflectPacketT>(data);
+}
+
+void testVectorToSoA(std::vector<float> const& data) {
+    return testPerformancePacket<vectorToSoAT, vectorToSoAPacketT>(data);
+}
+
+void testVectorFromSoA(std::vector<float> const& data) {
+    return testPerformancePacket<vectorFromSoAT, vectorFromSoAPacketT>(data);
+}
+
+void testVectorGatherSoA(std::vector<float> const& data) {
+    return testPerformancePacket<vectorGatherSoAT, vectorGatherSoAPacketT>(data);
+}
+
+void testVectorScatterSoA(std::vector<float> const& data) {
+    return testPerformancePacket<vectorScatterSoAT, vectorScatterSoAPacketT>(data);
+}
+
+void testQuadratic(std::vector<float> const& data) {
+    return testPerformancePacket<quadraticT, quadraticPacketT>(data);
+}
+
+void testHalfVectorPack(std::vector<float> const& data) {
+    return testPerformance<halfVectorPackT>(data);
+}
+
+void testHalfVectorUnpack(std::vector<float> const& data) {
+    return testPerformance<halfVectorUnpackT>(data);
+}
+
+void testVector3Pack(std::vector<float> const& data) {
+    return testPerformance<vector3PackT>(data);
+}
+
+void testVector3Unpack(std::vector<float> const& data) {
+    return testPerformance<vector3UnpackT>(data);
+}
+
 void testMatrixScalar(std::vector<float> const& data) {
     return testPerformance<matrixScalarT>(data);
 }
@@ -835,6 +2219,70 @@ void testMatrixTranspose(std::vector<float> const& data) {
     return testPerformance<matrixTransposeT>(data);
 }
 
+void testMatrixInverse(std::vector<float> const& data) {
+    return testPerformance<matrixInverseT>(data);
+}
+
+void testMatrixInverseAffine(std::vector<float> const& data) {
+    return testPerformance<matrixInverseAffineT>(data);
+}
+
+void testMatrixInverseBatch(std::vector<float> const& data) {
+    return testPerformance<matrixInverseBatchT>(data);
+}
+
+void testMatrixTransformLoop(std::vector<float> const& data) {
+    return testPerformance<matrixTransformLoopT>(data);
+}
+
+void testMatrixTransformPoints(std::vector<float> const& data) {
+    return testPerformance<matrixTransformPointsT>(data);
+}
+
+void testMatrixTransformPointsStream(std::vector<float> const& data) {
+    return testPerformance<matrixTransformPointsStreamT>(data);
+}
+
+void testAffineVector(std::vector<float> const& data) {
+    return testPerformance<affineVectorT>(data);
+}
+
+void testAffineAffine(std::vector<float> const& data) {
+    return testPerformance<affineAffineT>(data);
+}
+
+void testQuaternionProduct(std::vector<float> const& data) {
+    return testPerformance<quaternionProductT>(data);
+}
+
+void testQuaternionRotate(std::vector<float> const& data) {
+    return testPerformance<quaternionRotateT>(data);
+}
+
+void testQuaternionToMatrix(std::vector<float> const& data) {
+    return testPerformance<quaternionToMatrixT>(data);
+}
+
+void testQuaternionSlerp(std::vector<float> const& data) {
+    return testPerformance<quaternionSlerpT>(data);
+}
+
+void testQuaternionSlerpBatch(std::vector<float> const& data) {
+    return testPerformance<quaternionSlerpBatchT>(data);
+}
+
+void testRandomUniform(std::vector<float> const& data) {
+    return testPerformanceRandom<randomUniformT>(data);
+}
+
+void testRandomUnitSphere(std::vector<float> const& data) {
+    return testPerformanceRandom<randomUnitSphereT>(data);
+}
+
+void testRandomCosineHemisphere(std::vector<float> const& data) {
+    return testPerformanceRandom<randomCosineHemisphereT>(data);
+}
+
 void testHitSphere(std::vector<float> const& data) {
     return testPerformance<hitSphereT>(data);
 }
@@ -843,6 +2291,158 @@ void testHitCapsule(std::vector<float> const& data) {
     return testPerformance<hitCapsuleT>(data);
 }
 
+void testIntersectSphere(std::vector<float> const& data) {
+    return testPerformance<intersectSphereT>(data);
+}
+
+void testIntersectCapsule(std::vector<float> const& data) {
+    return testPerformance<intersectCapsuleT>(data);
+}
+
+void testIntersectSphereBranchless(std::vector<float> const& data) {
+    return testPerformance<intersectSphereBranchlessT>(data);
+}
+
+void testIntersectCapsuleBranchless(std::vector<float> const& data) {
+    return testPerformance<intersectCapsuleBranchlessT>(data);
+}
+
 void testTraceScene(std::vector<float> const& data) {
     return testPerformance<traceSceneT>(data);
 }
+
+void testVectorAddDouble(std::vector<float> const& data) {
+    return testPerformanceDouble<vectorAddT>(data);
+}
+
+void testVectorDotDouble(std::vector<float> const& data) {
+    return testPerformanceDouble<vectorDotT>(data);
+}
+
+void testVectorLengthDouble(std::vector<float> const& data) {
+    return testPerformanceDouble<vectorLengthT>(data);
+}
+
+void testVectorNormalizeDouble(std::vector<float> const& data) {
+    return testPerformanceDouble<vectorNormalizeT>(data);
+}
+
+void testVectorCrossDouble(std::vector<float> const& data) {
+    return testPerformanceDouble<vectorCrossT>(data);
+}
+
+void testMatrixVectorDouble(std::vector<float> const& data) {
+    return testPerformanceDouble<matrixVectorT>(data);
+}
+
+void testMatrixMatrixDouble(std::vector<float> const& data) {
+    return testPerformanceDouble<matrixMatrixT>(data);
+}
+
+void testHitSphereDouble(std::vector<float> const& data) {
+    return testPerformanceDouble<hitSphereT>(data);
+}
+
+void testTraceSceneDouble(std::vector<float> const& data) {
+    return testPerformanceDouble<traceSceneT>(data);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Measure the time to build a hierarchy over `count` spheres and the time to
+//! find the nearest intersection for a batch of rays with and without it.
+void testSceneHierarchySingle(std::vector<float> const& data, size_t count) {
+    constexpr size_t kLoopCount = 5;
+    constexpr size_t kNumRays = 1024;
+    constexpr float kExtent = 16.f;
+
+    struct SphereData {
+        float origin[3];
+        float radius;
+    };
+
+    // Scale radii with density so that rays hit a similar number of spheres
+    // regardless of the size of the scene.
+    float radius = .25f * kExtent / std::cbrt(float(count));
+
+    float const* v = data.data();
+    std::vector<SphereData> spheres(count);
+    for (auto& sphere : spheres) {
+        sphere = {{ *v++, *v++, *v++ }, radius * (.5f + *v++ / kExtent) };
+    }
+
+    std::vector<SphereArray::Ray> rays(kNumRays);
+    for (auto& ray : rays) {
+        ray.start[0] = *v++; ray.start[1] = *v++; ray.start[2] = *v++;
+        ray.dir[0] = *v++ - ray.start[0];
+        ray.dir[1] = *v++ - ray.start[1];
+        ray.dir[2] = *v++ - ray.start[2];
+    }
+
+    double loop_timing[3][kLoopCount];
+    double timing[3];
+
+    BVH bvh;
+    SphereArray linear, ordered;
+    linear.Assign(spheres.data(), count);
+
+    std::vector<SphereData> reordered(count);
+    size_t num_hits[2] = {};
+
+    for (size_t ii = 0; ii < kLoopCount; ++ii) {
+        Timer t;
+
+        t.Start();
+        bvh.Build(spheres.data(), count);
+        for (size_t jj = 0; jj < count; ++jj) {
+            reordered[jj] = spheres[bvh.Indices()[jj]];
+        }
+        ordered.Assign(reordered.data(), count);
+        t.Stop();
+        loop_timing[0][ii] = t.Microseconds();
+
+        t.Reset();
+        t.Start();
+        for (auto const& ray : rays) {
+            float tmin = 1.f;
+            size_t index;
+            num_hits[0] += linear.Nearest(ray, 0, count, tmin, index);
+        }
+        t.Stop();
+        loop_timing[1][ii] = t.Microseconds();
+
+        t.Reset();
+        t.Start();
+        for (auto const& ray : rays) {
+            float tmin = 1.f;
+            size_t index;
+            num_hits[1] += bvh.Nearest(ordered, ray, tmin, index);
+        }
+        t.Stop();
+        loop_timing[2][ii] = t.Microseconds();
+    }
+
+    // Sort passes
+    std::sort(&loop_timing[0][0], &loop_timing[0][kLoopCount]);
+    std::sort(&loop_timing[1][0], &loop_timing[1][kLoopCount]);
+    std::sort(&loop_timing[2][0], &loop_timing[2][kLoopCount]);
+
+    // Select median
+    timing[0] = loop_timing[0][kLoopCount / 2];
+    timing[1] = loop_timing[1][kLoopCount / 2];
+    timing[2] = loop_timing[2][kLoopCount / 2];
+
+    // Flag results where the hierarchy disagrees with the linear search.
+    char name[64];
+    snprintf(name, sizeof(name), "sceneHierarchy[%zu]%s", count, num_hits[0] == num_hits[1] ? "" : "*");
+
+    // Print build, linear traversal, and hierarchy traversal times
+    printf_s("  %-24s %12.4f \xc2\xb5s %12.4f \xc2\xb5s %12.4f \xc2\xb5s %7.2f%%\n",
+             name, timing[0], timing[1], timing[2],
+             1.0e2 * timing[1] / timing[2]);
+}
+
+void testSceneHierarchy(std::vector<float> const& data) {
+    for (size_t count = 10; count <= 1000000; count *= 10) {
+        testSceneHierarchySingle(data, count);
+    }
+}
@@ -7,6 +7,7 @@
 
 void testVectorElemRead(std::vector<float> const& data);
 void testVectorElemWrite(std::vector<float> const& data);
+void testVectorSwizzle(std::vector<float> const& data);
 void testVectorAdd(std::vector<float> const& data);
 void testVectorSub(std::vector<float> const& data);
 void testScalarMul(std::vector<float> const& data);
@@ -20,10 +21,59 @@ void testVectorCross(std::vector<float> const& data);
 void testVectorProject(std::vector<float> const& data);
 void testVectorReject(std::vector<float> const& data);
 void testVectorReflect(std::vector<float> const& data);
+void testVectorClamp(std::vector<float> const& data);
+void testVectorBounds(std::vector<float> const& data);
+void testVectorMaxLength(std::vector<float> const& data);
+void testVectorLengthPacket(std::vector<float> const& data);
+void testVectorNormalizePacket(std::vector<float> const& data);
+void testVectorDotPacket(std::vector<float> const& data);
+void testVectorCrossPacket(std::vector<float> const& data);
+void testVectorProjectPacket(std::vector<float> const& data);
+void testVectorRejectPacket(std::vector<float> const& data);
+void testVectorReflectPacket(std::vector<float> const& data);
+void testVectorToSoA(std::vector<float> const& data);
+void testVectorFromSoA(std::vector<float> const& data);
+void testVectorGatherSoA(std::vector<float> const& data);
+void testVectorScatterSoA(std::vector<float> const& data);
+void testQuadratic(std::vector<float> const& data);
+void testHalfVectorPack(std::vector<float> const& data);
+void testHalfVectorUnpack(std::vector<float> const& data);
+void testVector3Pack(std::vector<float> const& data);
+void testVector3Unpack(std::vector<float> const& data);
 void testMatrixScalar(std::vector<float> const& data);
 void testMatrixVector(std::vector<float> const& data);
 void testMatrixMatrix(std::vector<float> const& data);
 void testMatrixTranspose(std::vector<float> const& data);
+void testMatrixInverse(std::vector<float> const& data);
+void testMatrixInverseAffine(std::vector<float> const& data);
+void testMatrixInverseBatch(std::vector<float> const& data);
+void testMatrixTransformLoop(std::vector<float> const& data);
+void testMatrixTransformPoints(std::vector<float> const& data);
+void testMatrixTransformPointsStream(std::vector<float> const& data);
+void testAffineVector(std::vector<float> const& data);
+void testAffineAffine(std::vector<float> const& data);
+void testQuaternionProduct(std::vector<float> const& data);
+void testQuaternionRotate(std::vector<float> const& data);
+void testQuaternionToMatrix(std::vector<float> const& data);
+void testQuaternionSlerp(std::vector<float> const& data);
+void testQuaternionSlerpBatch(std::vector<float> const& data);
+void testRandomUniform(std::vector<float> const& data);
+void testRandomUnitSphere(std::vector<float> const& data);
+void testRandomCosineHemisphere(std::vector<float> const& data);
 void testHitSphere(std::vector<float> const& data);
 void testHitCapsule(std::vector<float> const& data);
+void testIntersectSphere(std::vector<float> const& data);
+void testIntersectCapsule(std::vector<float> const& data);
+void testIntersectSphereBranchless(std::vector<float> const& data);
+void testIntersectCapsuleBranchless(std::vector<float> const& data);
 void testTraceScene(std::vector<float> const& data);
+void testVectorAddDouble(std::vector<float> const& data);
+void testVectorDotDouble(std::vector<float> const& data);
+void testVectorLengthDouble(std::vector<float> const& data);
+void testVectorNormalizeDouble(std::vector<float> const& data);
+void testVectorCrossDouble(std::vector<float> const& data);
+void testMatrixVectorDouble(std::vector<float> const& data);
+void testMatrixMatrixDouble(std::vector<float> const& data);
+void testHitSphereDouble(std::vector<float> const& data);
+void testTraceSceneDouble(std::vector<float> const& data);
+void testSceneHierarchy(std::vector<float> const& data);
@@ -59,19 +59,47 @@ int main()
 
     printf_s("Testing conformance...\n");
     testComparison();
+    testSelect();
     testElements();
+    testSwizzle();
     testAlgebraic();
+    testFusedExpressions();
     testLength();
     testDotProduct();
     testCrossProduct();
+    testComponentWise();
+    testReduction();
+    testHalfVector();
+    testVector3();
     testMatrixProduct();
     testMatrixTranspose();
+    testMatrixInverse();
+    testMatrixTransformBatch();
+    testQuaternion();
+    testAffineMatrix();
+    testPacket();
+    testRandom();
+    testQuadratic();
+    testIntersect();
+    testSphereArray();
+#if _RUNTIME_DISPATCH
+    testSphereKernels();
+#endif // _RUNTIME_DISPATCH
+    testBVH();
+    testTraceParallel();
+
+    printf_s("Testing double precision conformance...\n");
+    testDouble();
+
+    printf_s("Testing transcendental accuracy (low, medium, high)...\n");
+    testTranscendental();
 
     printf_s("Testing performance...\n");
     EnablePerformanceProfiling();
 
     testVectorElemRead(values);
     testVectorElemWrite(values);
+    testVectorSwizzle(values);
     testVectorAdd(values);
     testVectorSub(values);
     testScalarMul(values);
@@ -85,13 +113,64 @@ int main()
     testVectorProject(values);
     testVectorReject(values);
     testVectorReflect(values);
+    testVectorClamp(values);
+    testVectorBounds(values);
+    testVectorMaxLength(values);
+    testVectorLengthPacket(values);
+    testVectorNormalizePacket(values);
+    testVectorDotPacket(values);
+    testVectorCrossPacket(values);
+    testVectorProjectPacket(values);
+    testVectorRejectPacket(values);
+    testVectorReflectPacket(values);
+    testVectorToSoA(values);
+    testVectorFromSoA(values);
+    testVectorGatherSoA(values);
+    testVectorScatterSoA(values);
+    testQuadratic(values);
+    testHalfVectorPack(values);
+    testHalfVectorUnpack(values);
+    testVector3Pack(values);
+    testVector3Unpack(values);
     testMatrixScalar(values);
     testMatrixVector(values);
     testMatrixMatrix(values);
     testMatrixTranspose(values);
+    testMatrixInverse(values);
+    testMatrixInverseAffine(values);
+    testMatrixInverseBatch(values);
+    testMatrixTransformLoop(values);
+    testMatrixTransformPoints(values);
+    testMatrixTransformPointsStream(values);
+    testAffineVector(values);
+    testAffineAffine(values);
+    testQuaternionProduct(values);
+    testQuaternionRotate(values);
+    testQuaternionToMatrix(values);
+    testQuaternionSlerp(values);
+    testQuaternionSlerpBatch(values);
+    testRandomUniform(values);
+    testRandomUnitSphere(values);
+    testRandomCosineHemisphere(values);
     testHitSphere(values);
     testHitCapsule(values);
+    testIntersectSphere(values);
+    testIntersectCapsule(values);
+    testIntersectSphereBranchless(values);
+    testIntersectCapsuleBranchless(values);
     testTraceScene(values);
+    testSceneHierarchy(values);
+
+    printf_s("Testing double precision performance (intrinsic, intrinsic_d)...\n");
+    testVectorAddDouble(values);
+    testVectorDotDouble(values);
+    testVectorLengthDouble(values);
+    testVectorNormalizeDouble(values);
+    testVectorCrossDouble(values);
+    testMatrixVectorDouble(values);
+    testMatrixMatrixDouble(values);
+    testHitSphereDouble(values);
+    testTraceSceneDouble(values);
 
     return 0;
 }
@@ -0,0 +1,589 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "SphereArray.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Bounding volume hierarchy over spheres built with a binned surface area
+ * heuristic. Spheres are referenced by contiguous ranges in leaf nodes, so the
+ * spheres must be reordered according to `Indices()` after building and the
+ * leaf ranges are then intersected directly with a `SphereArray`.
+ *
+ * Nodes are stored in depth-first order; the first child of an interior node
+ * immediately follows its parent and the second child is at `offset`. Traversal
+ * visits the nearer child first and skips deferred nodes which are entered past
+ * the nearest intersection found so far.
+ */
+class BVH {
+public:
+    struct Node {
+        float min[3];
+        float max[3];
+        uint32_t offset;    //!< index of first sphere for leaves, second child otherwise
+        uint32_t count;     //!< number of spheres for leaves, zero otherwise
+    };
+
+    static_assert(sizeof(Node) == 32, "Bad node size!");
+
+    //! Maximum number of spheres in a leaf node.
+    static constexpr size_t kMaxLeafSize = SphereArray::kWidth;
+
+    //! Maximum depth of the hierarchy, which bounds the traversal stack.
+    static constexpr size_t kMaxDepth = 64;
+
+    //! Magnitude added to ray directions before taking the reciprocal, see
+    //! `InverseDirection`.
+    static constexpr float kMinDir = 1e-20f;
+
+public:
+    //! Build the hierarchy over `spheres`, which can be any type with `origin`
+    //! and `radius` members. Bounds are rounded outward to single precision so
+    //! that they contain spheres of any precision.
+    template<typename T>
+    void Build(T const* spheres, size_t count) {
+        std::vector<Bounds> bounds(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            for (size_t kk = 0; kk < 3; ++kk) {
+                auto min = spheres[ii].origin[kk] - spheres[ii].radius;
+                auto max = spheres[ii].origin[kk] + spheres[ii].radius;
+                bounds[ii].min[kk] = std::nextafter(float(min), -std::numeric_limits<float>::max());
+                bounds[ii].max[kk] = std::nextafter(float(max), std::numeric_limits<float>::max());
+            }
+        }
+        Build(bounds, count);
+    }
+
+    //! Order in which spheres must be stored for the ranges referenced by leaf
+    //! nodes, i.e. element `ii` of the reordered array is `Indices()[ii]`.
+    std::vector<uint32_t> const& Indices() const {
+        return _indices;
+    }
+
+    std::vector<Node> const& Nodes() const {
+        return _nodes;
+    }
+
+    bool Empty() const {
+        return _nodes.empty();
+    }
+
+    //! Find the nearest sphere in `spheres`, which must be ordered according to
+    //! `Indices()`, intersected by `ray`. Same semantics as `SphereArray::Nearest`.
+    bool Nearest(SphereArray const& spheres, SphereArray::Ray const& ray, float& t, size_t& index) const {
+        return Nearest(spheres, ray, 0, t, index);
+    }
+
+    //! Find the nearest sphere for each lane of `rays` whose bit is set in
+    //! `mask`. Same semantics as `SphereArray::NearestPacket`. Lanes traverse
+    //! the hierarchy together until only one lane remains active in a subtree,
+    //! which then continues as a single ray.
+    int NearestPacket(SphereArray const& spheres, SphereArray::RayPacket const& rays, int mask, float (&t)[SphereArray::kWidth], size_t (&index)[SphereArray::kWidth]) const;
+
+    //! Returns true if any sphere in `spheres`, which must be ordered according
+    //! to `Indices()`, intersects `ray`. Same semantics as `SphereArray::Occluded`.
+    bool Occluded(SphereArray const& spheres, SphereArray::Ray const& ray) const;
+
+    //! Find the nearest of the spheres used to build the hierarchy, reordered
+    //! according to `Indices()`, intersected by `ray` with `intersectSpheres`.
+    //! For scalar types which `SphereArray` does not represent, e.g. double
+    //! precision, the nodes are entered in the precision of `S`.
+    template<typename T, typename V, typename S>
+    bool Nearest(T const* spheres, Ray<V, S> const& ray, S& t, size_t& index) const;
+
+    //! Returns true if any of the spheres used to build the hierarchy, reordered
+    //! according to `Indices()`, intersects `ray` at a fraction in [0, 1).
+    template<typename T, typename V, typename S>
+    bool Occluded(T const* spheres, Ray<V, S> const& ray) const;
+
+protected:
+    struct Bounds {
+        float min[3];
+        float max[3];
+    };
+
+    std::vector<Node> _nodes;
+    std::vector<uint32_t> _indices;
+
+protected:
+    bool Nearest(SphereArray const& spheres, SphereArray::Ray const& ray, uint32_t root, float& t, size_t& index) const;
+
+    //! Visit the leaves entered by the ray from `start` with `inv_dir` nearest
+    //! first, beginning at `root`, with `leaf(begin, end, t)` which returns
+    //! true if it found a nearer fraction `t` in the range of spheres.
+    template<typename R, typename T, typename Leaf>
+    bool TraverseNearest(R const (&start)[3], R const (&inv_dir)[3], uint32_t root, T& t, Leaf const& leaf) const;
+
+    //! Visit the leaves entered by the ray from `start` with `inv_dir` until
+    //! `leaf(begin, end)` returns true for one of them.
+    template<typename R, typename Leaf>
+    bool TraverseOccluded(R const (&start)[3], R const (&inv_dir)[3], Leaf const& leaf) const;
+
+    void Build(std::vector<Bounds> const& bounds, size_t count);
+    void BuildRecursive(std::vector<Bounds> const& bounds, std::vector<float> const& centroids, size_t begin, size_t end, size_t depth);
+
+    //! Reciprocal of each component of `dir`. Components are offset away from
+    //! zero so that axis-aligned rays have a large but finite reciprocal;
+    //! fast-math builds assume that infinities do not occur and fold the slab
+    //! tests incorrectly otherwise.
+    template<typename R>
+    static void InverseDirection(R const (&dir)[3], R (&inv_dir)[3]) {
+        for (size_t kk = 0; kk < 3; ++kk) {
+            inv_dir[kk] = R(1) / (dir[kk] + std::copysign(R(kMinDir), dir[kk]));
+        }
+    }
+
+    //! Returns true if the ray from `start` with `inv_dir` enters `node` at a
+    //! fraction `tnear` before `tmax`.
+    template<typename R>
+    static bool Intersects(Node const& node, R const (&start)[3], R const (&inv_dir)[3], R tmax, R& tnear) {
+        R tmin = R(0);
+        for (size_t kk = 0; kk < 3; ++kk) {
+            R t0 = (R(node.min[kk]) - start[kk]) * inv_dir[kk];
+            R t1 = (R(node.max[kk]) - start[kk]) * inv_dir[kk];
+            tmin = std::max(tmin, std::min(t0, t1));
+            tmax = std::min(tmax, std::max(t0, t1));
+        }
+        tnear = tmin;
+        return tmin <= tmax;
+    }
+
+    static float SurfaceArea(Bounds const& b) {
+        float dx = b.max[0] - b.min[0];
+        float dy = b.max[1] - b.min[1];
+        float dz = b.max[2] - b.min[2];
+        return 2.f * (dx * dy + dy * dz + dz * dx);
+    }
+
+    static void Empty(Bounds& b) {
+        for (size_t kk = 0; kk < 3; ++kk) {
+            b.min[kk] = std::numeric_limits<float>::max();
+            b.max[kk] = -std::numeric_limits<float>::max();
+        }
+    }
+
+    static void Grow(Bounds& b, Bounds const& a) {
+        for (size_t kk = 0; kk < 3; ++kk) {
+            b.min[kk] = std::min(b.min[kk], a.min[kk]);
+            b.max[kk] = std::max(b.max[kk], a.max[kk]);
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+inline void BVH::Build(std::vector<Bounds> const& bounds, size_t count)
+{
+    assert(count < UINT32_MAX && "Too many spheres!");
+
+    _nodes.clear();
+    _indices.resize(count);
+
+    if (!count) {
+        return;
+    }
+
+    std::vector<float> centroids(count * 3);
+    for (size_t ii = 0; ii < count; ++ii) {
+        _indices[ii] = uint32_t(ii);
+        for (size_t kk = 0; kk < 3; ++kk) {
+            centroids[ii * 3 + kk] = .5f * (bounds[ii].min[kk] + bounds[ii].max[kk]);
+        }
+    }
+
+    BuildRecursive(bounds, centroids, 0, count, 0);
+}
+
+//------------------------------------------------------------------------------
+inline void BVH::BuildRecursive(std::vector<Bounds> const& bounds, std::vector<float> const& centroids, size_t begin, size_t end, size_t depth)
+{
+    constexpr size_t kNumBins = 16;
+
+    size_t node_index = _nodes.size();
+    _nodes.push_back({});
+
+    Bounds node_bounds, centroid_bounds;
+    Empty(node_bounds);
+    Empty(centroid_bounds);
+
+    for (size_t ii = begin; ii < end; ++ii) {
+        Grow(node_bounds, bounds[_indices[ii]]);
+        float const* c = &centroids[_indices[ii] * 3];
+        Grow(centroid_bounds, {{c[0], c[1], c[2]}, {c[0], c[1], c[2]}});
+    }
+
+    Node& node = _nodes[node_index];
+    std::copy(node_bounds.min, node_bounds.min + 3, node.min);
+    std::copy(node_bounds.max, node_bounds.max + 3, node.max);
+
+    // A leaf is intersected with a single packed search which costs about the
+    // same for any number of spheres up to the packed width, so splitting is
+    // only worthwhile for nodes which do not fit in one leaf.
+    size_t count = end - begin;
+    if (count <= kMaxLeafSize) {
+        node.offset = uint32_t(begin);
+        node.count = uint32_t(count);
+        return;
+    }
+
+    // Split along the axis with the largest centroid extent.
+    size_t axis = 0;
+    for (size_t kk = 1; kk < 3; ++kk) {
+        if (centroid_bounds.max[kk] - centroid_bounds.min[kk] > centroid_bounds.max[axis] - centroid_bounds.min[axis]) {
+            axis = kk;
+        }
+    }
+
+    float cmin = centroid_bounds.min[axis];
+    float extent = centroid_bounds.max[axis] - cmin;
+    size_t mid = begin + count / 2;
+
+    if (depth >= kMaxDepth / 2) {
+        // Fall back to median splits so that degenerate distributions cannot
+        // exceed the maximum depth; each split halves the number of spheres.
+        std::nth_element(_indices.begin() + begin, _indices.begin() + mid, _indices.begin() + end,
+            [&](uint32_t lhs, uint32_t rhs) { return centroids[lhs * 3 + axis] < centroids[rhs * 3 + axis]; });
+    } else if (extent > 0.f) {
+        //  Bin centroids along the split axis.
+        Bounds bin_bounds[kNumBins];
+        size_t bin_count[kNumBins] = {};
+        for (size_t ii = 0; ii < kNumBins; ++ii) {
+            Empty(bin_bounds[ii]);
+        }
+
+        float scale = float(kNumBins) / extent;
+        auto bin_index = [&](uint32_t index) {
+            size_t bin = size_t((centroids[index * 3 + axis] - cmin) * scale);
+            return std::min(bin, kNumBins - 1);
+        };
+
+        for (size_t ii = begin; ii < end; ++ii) {
+            size_t bin = bin_index(_indices[ii]);
+            ++bin_count[bin];
+            Grow(bin_bounds[bin], bounds[_indices[ii]]);
+        }
+
+        //  Sweep from the right to accumulate the area of each right partition.
+        float right_area[kNumBins];
+        size_t right_count[kNumBins];
+        Bounds accum;
+        Empty(accum);
+        size_t accum_count = 0;
+        for (size_t ii = kNumBins - 1; ii > 0; --ii) {
+            Grow(accum, bin_bounds[ii]);
+            accum_count += bin_count[ii];
+            right_area[ii] = accum_count ? SurfaceArea(accum) : 0.f;
+            right_count[ii] = accum_count;
+        }
+
+        //  Sweep from the left to find the split with the lowest cost.
+        float best_cost = std::numeric_limits<float>::max();
+        size_t best_split = 0;
+        Empty(accum);
+        accum_count = 0;
+        for (size_t ii = 0; ii < kNumBins - 1; ++ii) {
+            Grow(accum, bin_bounds[ii]);
+            accum_count += bin_count[ii];
+            if (!accum_count || !right_count[ii + 1]) {
+                continue;
+            }
+            float cost = SurfaceArea(accum) * float(accum_count)
+                       + right_area[ii + 1] * float(right_count[ii + 1]);
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_split = ii + 1;
+            }
+        }
+
+        if (best_split) {
+            auto it = std::partition(_indices.begin() + begin, _indices.begin() + end,
+                [&](uint32_t index) { return bin_index(index) < best_split; });
+            mid = size_t(it - _indices.begin());
+        }
+    }
+
+    node.count = 0;
+
+    BuildRecursive(bounds, centroids, begin, mid, depth + 1);
+    _nodes[node_index].offset = uint32_t(_nodes.size());
+    BuildRecursive(bounds, centroids, mid, end, depth + 1);
+}
+
+//------------------------------------------------------------------------------
+inline bool BVH::Nearest(SphereArray const& spheres, SphereArray::Ray const& ray, uint32_t root, float& t, size_t& index) const
+{
+    float inv_dir[3];
+    InverseDirection(ray.dir, inv_dir);
+
+    return TraverseNearest(ray.start, inv_dir, root, t, [&](size_t begin, size_t end, float& t) {
+        return spheres.Nearest(ray, begin, end, t, index);
+    });
+}
+
+//------------------------------------------------------------------------------
+template<typename R, typename T, typename Leaf>
+inline bool BVH::TraverseNearest(R const (&start)[3], R const (&inv_dir)[3], uint32_t root, T& t, Leaf const& leaf) const
+{
+    if (_nodes.empty()) {
+        return false;
+    }
+
+    struct Entry {
+        uint32_t node;
+        R tnear;
+    };
+
+    Entry stack[kMaxDepth];
+    size_t stack_size = 0;
+    bool result = false;
+
+    R tnear;
+    if (!Intersects(_nodes[root], start, inv_dir, R(t), tnear)) {
+        return false;
+    }
+
+    uint32_t current = root;
+    for (;;) {
+        Node const& node = _nodes[current];
+
+        if (node.count) {
+            result |= leaf(size_t(node.offset), size_t(node.offset + node.count), t);
+        } else {
+            //  Descend into the nearer child and defer the farther one.
+            uint32_t first = current + 1;
+            uint32_t second = node.offset;
+            R tfirst, tsecond;
+            bool hit_first = Intersects(_nodes[first], start, inv_dir, R(t), tfirst);
+            bool hit_second = Intersects(_nodes[second], start, inv_dir, R(t), tsecond);
+
+            if (hit_first && hit_second) {
+                if (tsecond < tfirst) {
+                    std::swap(first, second);
+                    std::swap(tfirst, tsecond);
+                }
+                assert(stack_size < kMaxDepth);
+                stack[stack_size++] = {second, tsecond};
+                current = first;
+                continue;
+            } else if (hit_first) {
+                current = first;
+                continue;
+            } else if (hit_second) {
+                current = second;
+                continue;
+            }
+        }
+
+        //  Resume with the nearest deferred node which may still contain a
+        //  closer intersection than the current nearest fraction.
+        while (stack_size && stack[stack_size - 1].tnear > R(t)) {
+            --stack_size;
+        }
+        if (!stack_size) {
+            break;
+        }
+        current = stack[--stack_size].node;
+    }
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+inline int BVH::NearestPacket(SphereArray const& spheres, SphereArray::RayPacket const& rays, int mask, float (&t)[SphereArray::kWidth], size_t (&index)[SphereArray::kWidth]) const
+{
+    if (_nodes.empty() || !mask) {
+        return 0;
+    }
+
+    //  Reciprocal directions of each lane, the same as for a single ray.
+    float inv_dir[3][SphereArray::kWidth];
+    for (size_t ii = 0; ii < SphereArray::kWidth; ++ii) {
+        float lane_inv_dir[3];
+        InverseDirection(rays.Lane(ii).dir, lane_inv_dir);
+        for (size_t kk = 0; kk < 3; ++kk) {
+            inv_dir[kk][ii] = lane_inv_dir[kk];
+        }
+    }
+
+    //  Find the lanes in `active` which enter `node` before their current
+    //  nearest fraction and the minimum entry fraction of those lanes.
+    auto intersects = [&](Node const& node, int active, float& tnear) {
+#if _RUNTIME_DISPATCH
+        return sphere_kernels::Select().enters(node.min, node.max, rays.start, inv_dir, t, active, tnear);
+#else
+        return sphere_kernels::native::enters(node.min, node.max, rays.start, inv_dir, t, active, tnear);
+#endif
+    };
+
+    struct Entry {
+        uint32_t node;
+        int mask;
+    };
+
+    Entry stack[kMaxDepth];
+    size_t stack_size = 0;
+    int result = 0;
+
+    float tnear;
+    int active = intersects(_nodes[0], mask, tnear);
+    uint32_t current = 0;
+
+    while (active) {
+        Node const& node = _nodes[current];
+
+        if (!(active & (active - 1))) {
+            //  Only one lane remains, continue without the overhead of masking.
+            size_t lane = 0;
+            while (!(active & (1 << lane))) {
+                ++lane;
+            }
+            if (Nearest(spheres, rays.Lane(lane), current, t[lane], index[lane])) {
+                result |= active;
+            }
+        } else if (node.count) {
+            result |= spheres.NearestPacket(rays, active, node.offset, node.offset + node.count, t, index);
+        } else {
+            //  Descend into the child entered first by any lane and defer the
+            //  other with the lanes which enter it.
+            uint32_t first = current + 1;
+            uint32_t second = node.offset;
+            float tfirst, tsecond;
+            int first_mask = intersects(_nodes[first], active, tfirst);
+            int second_mask = intersects(_nodes[second], active, tsecond);
+
+            if (first_mask && second_mask) {
+                if (tsecond < tfirst) {
+                    std::swap(first, second);
+                    std::swap(first_mask, second_mask);
+                }
+                assert(stack_size < kMaxDepth);
+                stack[stack_size++] = {second, second_mask};
+                current = first;
+                active = first_mask;
+                continue;
+            } else if (first_mask) {
+                current = first;
+                active = first_mask;
+                continue;
+            } else if (second_mask) {
+                current = second;
+                active = second_mask;
+                continue;
+            }
+        }
+
+        //  Resume with the most recently deferred node for any of its lanes
+        //  which may still find a closer intersection within it.
+        active = 0;
+        while (stack_size && !active) {
+            Entry const& entry = stack[--stack_size];
+            current = entry.node;
+            active = intersects(_nodes[current], entry.mask, tnear);
+        }
+    }
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+inline bool BVH::Occluded(SphereArray const& spheres, SphereArray::Ray const& ray) const
+{
+    float inv_dir[3];
+    InverseDirection(ray.dir, inv_dir);
+
+    return TraverseOccluded(ray.start, inv_dir, [&](size_t begin, size_t end) {
+        return spheres.Occluded(ray, begin, end);
+    });
+}
+
+//------------------------------------------------------------------------------
+template<typename R, typename Leaf>
+inline bool BVH::TraverseOccluded(R const (&start)[3], R const (&inv_dir)[3], Leaf const& leaf) const
+{
+    if (_nodes.empty()) {
+        return false;
+    }
+
+    //  Any intersection terminates the search so the order of traversal does
+    //  not matter and nodes never need to be revisited against a closer `t`.
+    uint32_t stack[kMaxDepth];
+    size_t stack_size = 0;
+
+    stack[stack_size++] = 0;
+    while (stack_size) {
+        uint32_t current = stack[--stack_size];
+        Node const& node = _nodes[current];
+        R tnear;
+
+        if (!Intersects(node, start, inv_dir, R(1), tnear)) {
+            continue;
+        }
+
+        if (node.count) {
+            if (leaf(size_t(node.offset), size_t(node.offset + node.count))) {
+                return true;
+            }
+            continue;
+        }
+
+        assert(stack_size + 2 <= kMaxDepth);
+        stack[stack_size++] = node.offset;
+        stack[stack_size++] = current + 1;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+template<typename T, typename V, typename S>
+inline bool BVH::Nearest(T const* spheres, Ray<V, S> const& ray, S& t, size_t& index) const
+{
+    using R = typename ValueType<S>::type;
+
+    V const d = ray.end - ray.start;
+    R start[3], dir[3], inv_dir[3];
+    for (size_t kk = 0; kk < 3; ++kk) {
+        start[kk] = R(ray.start[kk]);
+        dir[kk] = R(d[kk]);
+    }
+    InverseDirection(dir, inv_dir);
+
+    return TraverseNearest(start, inv_dir, 0, t, [&](size_t begin, size_t end, S& t) {
+        size_t offset;
+        if (!intersectSpheres<V, S>(ray, spheres + begin, end - begin, t, offset)) {
+            return false;
+        }
+        index = begin + offset;
+        return true;
+    });
+}
+
+//------------------------------------------------------------------------------
+template<typename T, typename V, typename S>
+inline bool BVH::Occluded(T const* spheres, Ray<V, S> const& ray) const
+{
+    using R = typename ValueType<S>::type;
+
+    V const d = ray.end - ray.start;
+    R start[3], dir[3], inv_dir[3];
+    for (size_t kk = 0; kk < 3; ++kk) {
+        start[kk] = R(ray.start[kk]);
+        dir[kk] = R(d[kk]);
+    }
+    InverseDirection(dir, inv_dir);
+
+    return TraverseOccluded(start, inv_dir, [&](size_t begin, size_t end) {
+        for (size_t ii = begin; ii < end; ++ii) {
+            S t;
+            if (intersectSphere<V, S>(ray, spheres[ii], S(1.0f), t)) {
+                return true;
+            }
+        }
+        return false;
+    });
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "vector/Mask.h"
+
 template<typename M, typename V, typename S>
 class Color {
 public:
@@ -39,6 +41,12 @@ public:
         return c._value * s;
     }
 
+    //! Return `a` if `mask` is set, otherwise `b`, for each channel.
+    template<typename K>
+    friend Color Select(K const& mask, Color const& a, Color const& b) {
+        return Select(mask, a._value, b._value);
+    }
+
 private:
     V _value;
 
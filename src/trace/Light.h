@@ -180,7 +180,7 @@ public:
     template<typename M, typename V, typename S>
     static S G(Material<M, V, S> const&, V const& n, V const& l, V const& v, V const& h) {
         S k = 2.f * (n * h) / (v * h);
-        return min3(S(1.f), k * (n * v), k * (n * l));
+        return min3<S>(S(1.f), k * (n * v), k * (n * l));
     }
 
 protected:
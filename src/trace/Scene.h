@@ -1,10 +1,13 @@
 #pragma once
 
 #include <algorithm>
+#include <type_traits>
 #include <vector>
 
+#include "BVH.h"
 #include "Color.h"
 #include "Light.h"
+#include "SphereArray.h"
 
 #include "vector/Intersect.h"
 
@@ -33,18 +36,31 @@ public:
     using TraceHit = ::TraceHit<M, V, S>;
     using TraceSphere = ::TraceSphere<M, V, S>;
 
+    //! Number of rays traced together by `TraceColorPacket`.
+    static constexpr size_t kPacketSize = SphereArray::kWidth;
+
+    //! `SphereArray` searches in single precision, which is only used for
+    //! scalars of single precision elements. Scenes in higher precision
+    //! intersect spheres with the generic functions of `Intersect.h`, culled
+    //! by the `BVH` in large scenes.
+    static constexpr bool kPacked = std::is_same<typename ValueType<S>::type, float>::value;
+
 public:
     Scene() {}
 
     template<size_t Size>
     Scene(TraceSphere const (&spheres)[Size])
-        : _spheres(spheres, spheres + Size) {}
+        : _spheres(spheres, spheres + Size) {
+        Build();
+    }
 
     template<size_t NumLights, size_t NumSpheres>
     Scene(Light const (&lights)[NumLights],
           TraceSphere const (&spheres)[NumSpheres])
         : _lights(lights, lights + NumLights)
-        , _spheres(spheres, spheres + NumSpheres) {}
+        , _spheres(spheres, spheres + NumSpheres) {
+        Build();
+    }
 
     //! Calculate the illuminated surface color at the nearest intersection of
     //! an object in the scene with the ray from `start` to `end`.
@@ -53,36 +69,160 @@ public:
         TraceHit hit = {};
 
         if (Trace(start, end, hit)) {
-            V view = (start - hit.point).Normalize();
-            V hitpoint = hit.point + hit.normal * kEpsilon;
-            color = Shade(hit.material, hitpoint, hit.normal, view, hit_count);
+            color = ShadeHit(start, hit, hit_count);
             return true;
         }
         return false;
     }
 
+    //! Calculate the illuminated surface colors for a packet of coherent rays,
+    //! such as neighboring primary rays. Visibility is resolved for the whole
+    //! packet at once and only the rays which hit a surface are shaded, one at
+    //! a time. Returns the mask of rays for which `color` was written.
+    int TraceColorPacket(V const (&start)[kPacketSize], V const (&end)[kPacketSize], Color (&color)[kPacketSize], int hit_count = 4) const
+    {
+        constexpr int kAllLanes = (1 << kPacketSize) - 1;
+
+        if (!kPacked) {
+            int mask = 0;
+            for (size_t ii = 0; ii < kPacketSize; ++ii) {
+                if (TraceColor(start[ii], end[ii], color[ii], hit_count)) {
+                    mask |= 1 << ii;
+                }
+            }
+            return mask;
+        }
+
+        SphereArray::RayPacket packet(start, end);
+        float t[kPacketSize];
+        size_t index[kPacketSize];
+
+        std::fill(t, t + kPacketSize, 1.0f);
+
+        int mask = _bvh.Empty()
+            ? _sphere_array.NearestPacket(packet, kAllLanes, 0, _sphere_array.Size(), t, index)
+            : _bvh.NearestPacket(_sphere_array, packet, kAllLanes, t, index);
+
+        for (size_t ii = 0; ii < kPacketSize; ++ii) {
+            if (mask & (1 << ii)) {
+                TraceHit hit;
+                hitSphere<V, S>({start[ii], end[ii]}, _spheres[index[ii]], S(t[ii]), hit);
+                hit.material = _spheres[index[ii]].material;
+                color[ii] = ShadeHit(start[ii], hit, hit_count);
+            }
+        }
+
+        return mask;
+    }
+
 protected:
     static constexpr float kEpsilon = 1e-5f;
+    static constexpr size_t kPackedThreshold = 4;
+    // Traversal overhead outweighs the spheres culled by the hierarchy in
+    // smaller scenes; see `testSceneHierarchy` for the crossover.
+    static constexpr size_t kHierarchyThreshold = 1024;
 
     std::vector<Light> _lights;
     std::vector<TraceSphere> _spheres;
+    SphereArray _sphere_array;
+    BVH _bvh;
 
 protected:
+    //! Build acceleration structures for the spheres in the scene. Spheres are
+    //! reordered so that each leaf of the hierarchy is a contiguous range.
+    void Build()
+    {
+        if (_spheres.size() >= kHierarchyThreshold) {
+            _bvh.Build(_spheres.data(), _spheres.size());
+
+            std::vector<TraceSphere> spheres;
+            spheres.reserve(_spheres.size());
+            for (uint32_t index : _bvh.Indices()) {
+                spheres.push_back(_spheres[index]);
+            }
+            _spheres.swap(spheres);
+        }
+
+        if (kPacked) {
+            _sphere_array.Assign(_spheres.data(), _spheres.size());
+        }
+    }
+
+    //! Calculate the illuminated surface color of `hit` as seen from `start`.
+    Color ShadeHit(V const& start, TraceHit const& hit, int hit_count) const
+    {
+        V view = (start - hit.point).Normalize();
+        V hitpoint = hit.point + hit.normal * kEpsilon;
+        return Shade(hit.material, hitpoint, hit.normal, view, hit_count);
+    }
+
     //! Find the nearest surface intersection between start and end.
     bool Trace(V const& start, V const& end, TraceHit& hit) const
     {
-        S mindist = 1.0f;
-        for (auto const& sphere: _spheres) {
-            TraceHit tmp;
-
-            if (hitSphere({start, end}, sphere, tmp) && tmp.t < mindist) {
-                hit = tmp;
-                hit.material = sphere.material;
-                mindist = hit.t;
+        size_t index = 0;
+
+        // Testing a few spheres individually is cheaper than a packed search
+        // whose latency is dominated by the reduction across lanes.
+        if (!kPacked || _spheres.size() < kPackedThreshold) {
+            S t = 1.0f;
+
+            if (_bvh.Empty()) {
+                if (!intersectSpheres<V, S>({start, end}, _spheres.data(), _spheres.size(), t, index)) {
+                    return false;
+                }
+            } else if (!_bvh.Nearest(_spheres.data(), Ray<V, S>{start, end}, t, index)) {
+                return false;
             }
+
+            hitSphere<V, S>({start, end}, _spheres[index], t, hit);
+            hit.material = _spheres[index].material;
+            return true;
         }
 
-        return (mindist < 1.0f);
+        SphereArray::Ray ray(start, end);
+        float t = 1.0f;
+
+        if (_bvh.Empty()) {
+            if (!_sphere_array.Nearest(ray, 0, _sphere_array.Size(), t, index)) {
+                return false;
+            }
+        } else if (!_bvh.Nearest(_sphere_array, ray, t, index)) {
+            return false;
+        }
+
+        // Only compute the hit point, normal, and material of the nearest
+        // sphere found by the packed search.
+        hitSphere<V, S>({start, end}, _spheres[index], S(t), hit);
+        hit.material = _spheres[index].material;
+        return true;
+    }
+
+    //! Returns true if any surface intersects the segment between start and
+    //! end. Unlike `Trace` this returns on the first intersection found and
+    //! never computes the hit point, normal, or material.
+    bool Occluded(V const& start, V const& end) const
+    {
+        if (!kPacked) {
+            if (_bvh.Empty()) {
+                for (auto const& sphere : _spheres) {
+                    S t;
+                    if (intersectSphere<V, S>({start, end}, sphere, 1.0f, t)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            return _bvh.Occluded(_spheres.data(), Ray<V, S>{start, end});
+        }
+
+        SphereArray::Ray ray(start, end);
+
+        // Unlike the nearest intersection there is no reduction across lanes
+        // so the packed search is used even for a few spheres.
+        if (_bvh.Empty()) {
+            return _sphere_array.Occluded(ray, 0, _sphere_array.Size());
+        }
+        return _bvh.Occluded(_sphere_array, ray);
     }
 
     //! Calculate the indirect illumination at a point from the given direction.
@@ -121,9 +261,7 @@ protected:
 
         // Add the direct illumination of each light in the scene.
         for (auto const& light: _lights) {
-            TraceHit hit;
-
-            if (Trace(origin, light.origin, hit)) {
+            if (Occluded(origin, light.origin)) {
                 continue;
             }
 
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+#include "vector/Intersect.h"
+#include "vector/Intrinsic.h"
+
+#include "SphereKernels.h"
+
+#if !_RUNTIME_DISPATCH
+//  Kernels for the instruction set of the including translation unit.
+namespace sphere_kernels {
+namespace native {
+#include "SphereKernels.inl"
+} // namespace native
+} // namespace sphere_kernels
+#endif // !_RUNTIME_DISPATCH
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Structure-of-arrays storage of sphere origins and squared radii which allows
+ * a single ray to be intersected with a group of spheres per iteration, using
+ * the kernels in `SphereKernels.h`. Arrays are padded to a multiple of the
+ * widest group so that every group can be loaded in full; padding and elements
+ * outside of the queried range are masked out.
+ *
+ * The nearest intersection is tracked per lane and reduced across lanes once at
+ * the end so the inner loop is free of data-dependent branches.
+ *
+ * A packet of `kWidth` coherent rays can instead be intersected with a single
+ * sphere per iteration, in which case each lane tracks the nearest intersection
+ * of its own ray and no reduction is needed.
+ */
+class SphereArray {
+public:
+    static constexpr size_t kWidth = sphere_kernels::kPacketWidth;
+
+    //! Ray origin and direction in single precision.
+    struct Ray {
+        float start[3];
+        float dir[3];
+
+        Ray() {}
+
+        template<typename V>
+        Ray(V const& start_point, V const& end_point) {
+            V const d = end_point - start_point;
+            start[0] = float(start_point[0]);
+            start[1] = float(start_point[1]);
+            start[2] = float(start_point[2]);
+            dir[0] = float(d[0]);
+            dir[1] = float(d[1]);
+            dir[2] = float(d[2]);
+        }
+    };
+
+    //! Packet of `kWidth` rays in structure-of-arrays form.
+    struct RayPacket {
+        float start[3][kWidth];
+        float dir[3][kWidth];
+
+        RayPacket() {}
+
+        template<typename V>
+        RayPacket(V const* start_points, V const* end_points) {
+            for (size_t ii = 0; ii < kWidth; ++ii) {
+                Ray ray(start_points[ii], end_points[ii]);
+                for (size_t kk = 0; kk < 3; ++kk) {
+                    start[kk][ii] = ray.start[kk];
+                    dir[kk][ii] = ray.dir[kk];
+                }
+            }
+        }
+
+        Ray Lane(size_t lane) const {
+            Ray ray;
+            for (size_t kk = 0; kk < 3; ++kk) {
+                ray.start[kk] = start[kk][lane];
+                ray.dir[kk] = dir[kk][lane];
+            }
+            return ray;
+        }
+    };
+
+public:
+    SphereArray()
+        : _size(0) {}
+
+    //! Replace the contents of the array with the origins and radii of
+    //! `spheres`, which can be any type with `origin` and `radius` members.
+    template<typename T>
+    void Assign(T const* spheres, size_t count) {
+        // Element indices are tracked in single precision during traversal.
+        assert(count < (size_t(1) << 24) && "Too many spheres!");
+
+        size_t padded = (count + kPadding - 1) & ~(kPadding - 1);
+        _x.assign(padded, 0.f);
+        _y.assign(padded, 0.f);
+        _z.assign(padded, 0.f);
+        _rsqr.assign(padded, 0.f);
+        _size = count;
+
+        for (size_t ii = 0; ii < count; ++ii) {
+            float radius = float(spheres[ii].radius);
+            _x[ii] = float(spheres[ii].origin[0]);
+            _y[ii] = float(spheres[ii].origin[1]);
+            _z[ii] = float(spheres[ii].origin[2]);
+            _rsqr[ii] = radius * radius;
+        }
+    }
+
+    size_t Size() const {
+        return _size;
+    }
+
+    //! Find the nearest sphere in [begin, end) which intersects `ray` at a
+    //! fraction in [0, t). On input `t` is the maximum fraction and must not
+    //! be greater than one; if an intersection is found `t` and `index` are
+    //! updated with its fraction and the index of the sphere.
+    bool Nearest(Ray const& ray, size_t begin, size_t end, float& t, size_t& index) const;
+
+    //! Find the nearest sphere in [begin, end) for each lane of `rays` whose bit
+    //! is set in `mask`. Same semantics as `Nearest` for each lane; returns the
+    //! mask of lanes for which `t` and `index` were updated.
+    int NearestPacket(RayPacket const& rays, int mask, size_t begin, size_t end, float (&t)[kWidth], size_t (&index)[kWidth]) const;
+
+    //! Returns true if any sphere in [begin, end) intersects `ray` at a
+    //! fraction in [0, 1). Returns as soon as an intersection is found.
+    bool Occluded(Ray const& ray, size_t begin, size_t end) const;
+
+protected:
+    //! Padding required by both packets and the intersection kernels.
+    static constexpr size_t kPadding = kWidth > sphere_kernels::kPadding
+                                     ? kWidth : sphere_kernels::kPadding;
+
+    size_t _size;
+
+    std::vector<float> _x;
+    std::vector<float> _y;
+    std::vector<float> _z;
+    std::vector<float> _rsqr;
+
+protected:
+    sphere_kernels::Spheres Data() const {
+        return {_x.data(), _y.data(), _z.data(), _rsqr.data()};
+    }
+};
+
+//------------------------------------------------------------------------------
+inline bool SphereArray::Nearest(Ray const& ray, size_t begin, size_t end, float& t, size_t& index) const
+{
+#if _RUNTIME_DISPATCH
+    return sphere_kernels::Select().nearest(Data(), ray.start, ray.dir, begin, end, t, index);
+#else
+    return sphere_kernels::native::nearest(Data(), ray.start, ray.dir, begin, end, t, index);
+#endif
+}
+
+//------------------------------------------------------------------------------
+inline bool SphereArray::Occluded(Ray const& ray, size_t begin, size_t end) const
+{
+#if _RUNTIME_DISPATCH
+    return sphere_kernels::Select().occluded(Data(), ray.start, ray.dir, begin, end);
+#else
+    return sphere_kernels::native::occluded(Data(), ray.start, ray.dir, begin, end);
+#endif
+}
+
+//------------------------------------------------------------------------------
+inline int SphereArray::NearestPacket(RayPacket const& rays, int mask, size_t begin, size_t end, float (&t)[kWidth], size_t (&index)[kWidth]) const
+{
+    // Inactive lanes start with a maximum fraction of zero, which no
+    // intersection can improve on.
+    float best_t[kWidth];
+    for (size_t ii = 0; ii < kWidth; ++ii) {
+        best_t[ii] = (mask & (1 << ii)) ? t[ii] : 0.f;
+    }
+
+    float best_index[kWidth];
+#if _RUNTIME_DISPATCH
+    int result = sphere_kernels::Select().nearest_packet(Data(), rays.start, rays.dir, begin, end, best_t, best_index) & mask;
+#else
+    int result = sphere_kernels::native::nearest_packet(Data(), rays.start, rays.dir, begin, end, best_t, best_index) & mask;
+#endif
+
+    for (size_t ii = 0; ii < kWidth; ++ii) {
+        if (result & (1 << ii)) {
+            t[ii] = best_t[ii];
+            index[ii] = size_t(best_index[ii]);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,38 @@
+#include "SphereKernels.h"
+
+#include "Cpuid.h"
+
+#include <cassert>
+
+namespace sphere_kernels {
+
+//------------------------------------------------------------------------------
+Kernels const kernels[] = {
+    {"avx2",    _F_AVX2 | _F_FMA | _F_AVX,  avx2::Nearest,      avx2::Occluded,     avx2::NearestPacket,    avx2::Enters    },
+    {"avx",     _F_AVX,                     avx::Nearest,       avx::Occluded,      avx::NearestPacket,     avx::Enters     },
+    {"sse4.1",  _F_SSE4_1,                  sse4_1::Nearest,    sse4_1::Occluded,   sse4_1::NearestPacket,  sse4_1::Enters  },
+    {"sse2",    _F_SSE2,                    sse2::Nearest,      sse2::Occluded,     sse2::NearestPacket,    sse2::Enters    },
+};
+
+size_t const num_kernels = sizeof(kernels) / sizeof(kernels[0]);
+
+//------------------------------------------------------------------------------
+static Kernels const& SelectFeatures(int features)
+{
+    for (auto const& k : kernels) {
+        if ((k.features & features) == k.features) {
+            return k;
+        }
+    }
+    assert(false && "Processor does not support the baseline instruction set!");
+    return kernels[num_kernels - 1];
+}
+
+//------------------------------------------------------------------------------
+Kernels const& Select()
+{
+    static Kernels const& selected = SelectFeatures(cpuid::runtime_features());
+    return selected;
+}
+
+} // namespace sphere_kernels
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Features.h"
+
+#include <cfloat>
+#include <cstddef>
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Intersection kernels for `SphereArray`. The kernels are written once in
+ * `SphereKernels.inl` against the instruction set enabled by `_F_BITS` where
+ * they are included.
+ *
+ * Native builds include the kernels directly in `SphereArray.h`. With runtime
+ * dispatch the kernels are instead compiled once per instruction set in the
+ * `SphereKernels_*.cpp` files and the best kernel supported by the processor
+ * is selected on first use. Packets have the same width `kPacketWidth` for
+ * every instruction set so that they can be passed to any of the kernels;
+ * kernels with narrower registers process each packet in several parts.
+ *
+ * Kernel translation units only include intrinsic headers and the templates
+ * of `vector/Intersect.h`, which are only instantiated with types local to
+ * each kernel namespace, so that no inline function is compiled for more than
+ * one instruction set, which would allow the linker to choose an unsupported
+ * one.
+ */
+
+namespace sphere_kernels {
+
+//! Structure-of-arrays sphere data, padded to a multiple of `kPadding`.
+struct Spheres {
+    float const* x;
+    float const* y;
+    float const* z;
+    float const* rsqr;
+};
+
+//! Padding required by the widest kernel.
+constexpr size_t kPadding = 8;
+
+//! Number of rays in a packet for `NearestPacketFunc` and `EntersFunc`, the
+//! register width of native builds and the widest register otherwise.
+#if _RUNTIME_DISPATCH || _HAS_AVX
+constexpr size_t kPacketWidth = 8;
+#else
+constexpr size_t kPacketWidth = 4;
+#endif
+
+//! Find the nearest sphere in [begin, end) which intersects the ray at a
+//! fraction in [0, t), see `SphereArray::Nearest`.
+using NearestFunc = bool (*)(Spheres const& spheres, float const* start, float const* dir, size_t begin, size_t end, float& t, size_t& index);
+
+//! Returns true if any sphere in [begin, end) intersects the ray at a fraction
+//! in [0, 1), see `SphereArray::Occluded`.
+using OccludedFunc = bool (*)(Spheres const& spheres, float const* start, float const* dir, size_t begin, size_t end);
+
+//! Find the nearest sphere in [begin, end) for each ray of a packet, see
+//! `SphereArray::NearestPacket`. Sphere indices are returned as `float`.
+using NearestPacketFunc = int (*)(Spheres const& spheres, float const (&start)[3][kPacketWidth], float const (&dir)[3][kPacketWidth], size_t begin, size_t end, float (&t)[kPacketWidth], float (&index)[kPacketWidth]);
+
+//! Return the rays of a packet in `active` which enter the box [lo, hi] and
+//! their minimum entry fraction, see `BVH::NearestPacket`.
+using EntersFunc = int (*)(float const (&lo)[3], float const (&hi)[3], float const (&start)[3][kPacketWidth], float const (&inv_dir)[3][kPacketWidth], float const (&t)[kPacketWidth], int active, float& tnear);
+
+struct Kernels {
+    char const* name;
+    int features;           //  required feature bits
+    NearestFunc nearest;
+    OccludedFunc occluded;
+    NearestPacketFunc nearest_packet;
+    EntersFunc enters;
+};
+
+#if _RUNTIME_DISPATCH
+
+#define SPHERE_KERNELS(isa)                                                     \
+namespace isa {                                                                 \
+bool Nearest(Spheres const& spheres, float const* start, float const* dir, size_t begin, size_t end, float& t, size_t& index); \
+bool Occluded(Spheres const& spheres, float const* start, float const* dir, size_t begin, size_t end); \
+int NearestPacket(Spheres const& spheres, float const (&start)[3][kPacketWidth], float const (&dir)[3][kPacketWidth], size_t begin, size_t end, float (&t)[kPacketWidth], float (&index)[kPacketWidth]); \
+int Enters(float const (&lo)[3], float const (&hi)[3], float const (&start)[3][kPacketWidth], float const (&inv_dir)[3][kPacketWidth], float const (&t)[kPacketWidth], int active, float& tnear); \
+}
+
+SPHERE_KERNELS(sse2)
+SPHERE_KERNELS(sse4_1)
+SPHERE_KERNELS(avx)
+SPHERE_KERNELS(avx2)
+
+#undef SPHERE_KERNELS
+
+//! Kernels for each instruction set from most to least capable.
+extern Kernels const kernels[];
+extern size_t const num_kernels;
+
+//! Return the most capable kernels supported by the processor. The kernels
+//! are selected on first use and the same kernels are returned thereafter.
+Kernels const& Select();
+
+#endif // _RUNTIME_DISPATCH
+
+} // namespace sphere_kernels
@@ -0,0 +1,405 @@
+//
+//  Intersection kernels for `SphereArray`, see `SphereKernels.h`. This file is
+//  included inside of a namespace for each instruction set and intentionally
+//  has no include guard. Intrinsic headers and `vector/Intersect.h` must be
+//  included beforehand.
+//
+
+////////////////////////////////////////////////////////////////////////////////
+//  Register operations for the instruction set enabled by `_F_BITS`.
+
+#if _HAS_AVX
+
+constexpr size_t kWidth = 8;
+
+using reg = __m256;
+
+static inline reg set1(float a) { return _mm256_set1_ps(a); }
+static inline reg loadu(float const* a) { return _mm256_loadu_ps(a); }
+static inline void storeu(float* a, reg b) { _mm256_storeu_ps(a, b); }
+static inline reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+static inline reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+static inline reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+static inline reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+static inline reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+static inline reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+static inline reg sqrt(reg a) { return _mm256_sqrt_ps(a); }
+#if _HAS_FMA
+static inline reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+static inline reg fmadd(reg a, reg b, reg c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+static inline reg and_(reg a, reg b) { return _mm256_and_ps(a, b); }
+static inline reg or_(reg a, reg b) { return _mm256_or_ps(a, b); }
+static inline reg cmpeq(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+static inline reg cmplt(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline reg cmple(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+static inline reg cmpge(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+static inline int movemask(reg a) { return _mm256_movemask_ps(a); }
+static inline float first(reg a) { return _mm256_cvtss_f32(a); }
+
+//! dst[i] = mask[i] ? b[i] : a[i]
+static inline reg blendv(reg a, reg b, reg mask) { return _mm256_blendv_ps(a, b, mask); }
+
+static inline reg lanes() { return _mm256_set_ps(7.f, 6.f, 5.f, 4.f, 3.f, 2.f, 1.f, 0.f); }
+
+//! Set each element `i` for which bit `i` of `bits` is set, i.e. the inverse
+//! of `movemask`.
+static inline reg lanemask(int bits) {
+#if _HAS_AVX2
+    __m256i b = _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1);
+    return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), b), b));
+#else
+    __m128i b = _mm_set_epi32(8, 4, 2, 1);
+    __m128i lo = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), b), b);
+    __m128i hi = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits >> 4), b), b);
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_castsi128_ps(lo)), _mm_castsi128_ps(hi), 1);
+#endif
+}
+
+//! Minimum of all elements broadcast to each element.
+static inline reg hmin(reg a) {
+    a = _mm256_min_ps(a, _mm256_permute2f128_ps(a, a, 0x01));
+    a = _mm256_min_ps(a, _mm256_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm256_min_ps(a, _mm256_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+#else // _HAS_AVX
+
+constexpr size_t kWidth = 4;
+
+using reg = __m128;
+
+static inline reg set1(float a) { return _mm_set_ps1(a); }
+static inline reg loadu(float const* a) { return _mm_loadu_ps(a); }
+static inline void storeu(float* a, reg b) { _mm_storeu_ps(a, b); }
+static inline reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+static inline reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+static inline reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+static inline reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+static inline reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+static inline reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+static inline reg sqrt(reg a) { return _mm_sqrt_ps(a); }
+#if _HAS_FMA
+static inline reg fmadd(reg a, reg b, reg c) { return _mm_fmadd_ps(a, b, c); }
+#else
+static inline reg fmadd(reg a, reg b, reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+#endif
+static inline reg and_(reg a, reg b) { return _mm_and_ps(a, b); }
+static inline reg or_(reg a, reg b) { return _mm_or_ps(a, b); }
+static inline reg cmpeq(reg a, reg b) { return _mm_cmpeq_ps(a, b); }
+static inline reg cmplt(reg a, reg b) { return _mm_cmplt_ps(a, b); }
+static inline reg cmple(reg a, reg b) { return _mm_cmple_ps(a, b); }
+static inline reg cmpge(reg a, reg b) { return _mm_cmpge_ps(a, b); }
+static inline int movemask(reg a) { return _mm_movemask_ps(a); }
+static inline float first(reg a) { return _mm_cvtss_f32(a); }
+
+//! dst[i] = mask[i] ? b[i] : a[i]
+static inline reg blendv(reg a, reg b, reg mask) {
+#if _HAS_SSE4_1
+    return _mm_blendv_ps(a, b, mask);
+#else
+    return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+#endif
+}
+
+static inline reg lanes() { return _mm_set_ps(3.f, 2.f, 1.f, 0.f); }
+
+//! Set each element `i` for which bit `i` of `bits` is set, i.e. the inverse
+//! of `movemask`.
+static inline reg lanemask(int bits) {
+    __m128i b = _mm_set_epi32(8, 4, 2, 1);
+    return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), b), b));
+}
+
+//! Minimum of all elements broadcast to each element.
+static inline reg hmin(reg a) {
+    a = _mm_min_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_min_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+#endif // _HAS_AVX
+
+////////////////////////////////////////////////////////////////////////////////
+//  Registers as a scalar type so that the roots of each lane are found with
+//  the shared `solveQuadratic` from `Intersect.h`.
+
+struct Mask {
+    reg value;
+};
+
+struct Scalar {
+    reg value;
+
+    Scalar() {}
+    Scalar(reg a) : value(a) {}
+    Scalar(float a) : value(set1(a)) {}
+};
+
+static inline Scalar operator-(Scalar a) { return sub(set1(0.f), a.value); }
+static inline Scalar operator+(Scalar a, Scalar b) { return add(a.value, b.value); }
+static inline Scalar operator-(Scalar a, Scalar b) { return sub(a.value, b.value); }
+static inline Scalar operator*(Scalar a, Scalar b) { return mul(a.value, b.value); }
+static inline Scalar operator/(Scalar a, Scalar b) { return div(a.value, b.value); }
+static inline Mask operator==(Scalar a, Scalar b) { return {cmpeq(a.value, b.value)}; }
+static inline Mask operator<(Scalar a, Scalar b) { return {cmplt(a.value, b.value)}; }
+static inline Mask operator>=(Scalar a, Scalar b) { return {cmpge(a.value, b.value)}; }
+static inline Scalar abs(Scalar a) { return max(a.value, sub(set1(0.f), a.value)); }
+static inline Scalar sqrt(Scalar a) { return sqrt(a.value); }
+
+//! Return `a` if `mask` is set, otherwise `b`.
+static inline Scalar Select(Mask mask, Scalar a, Scalar b) { return blendv(b.value, a.value, mask.value); }
+
+////////////////////////////////////////////////////////////////////////////////
+//! A ray broadcast to each lane, which computes the roots of its intersection
+//! with a group of `kWidth` spheres.
+struct RayGroup {
+    reg sx, sy, sz;
+    reg dx, dy, dz;
+    reg A, A4;
+
+    RayGroup(float const* start, float const* dir) {
+        float dsqr = dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2];
+
+        sx = set1(start[0]);
+        sy = set1(start[1]);
+        sz = set1(start[2]);
+        dx = set1(dir[0]);
+        dy = set1(dir[1]);
+        dz = set1(dir[2]);
+        A = set1(dsqr);
+        A4 = set1(4.f * dsqr);
+    }
+
+    bool Roots(Spheres const& spheres, size_t ii, reg& Dvalid, reg& t0, reg& t1) const {
+        //  sphereVec = ray.start - sphere.origin
+        reg ox = sub(sx, loadu(spheres.x + ii));
+        reg oy = sub(sy, loadu(spheres.y + ii));
+        reg oz = sub(sz, loadu(spheres.z + ii));
+
+        //  B = 2 * rayVec * sphereVec
+        reg B = mul(set1(2.f), fmadd(dx, ox, fmadd(dy, oy, mul(dz, oz))));
+        //  C = sphereVec * sphereVec - radius * radius
+        reg C = sub(fmadd(ox, ox, fmadd(oy, oy, mul(oz, oz))), loadu(spheres.rsqr + ii));
+
+        // Skip the remaining work if the ray misses every sphere in the group.
+        if (!movemask(cmpge(sub(mul(B, B), mul(A4, C)), set1(0.f)))) {
+            return false;
+        }
+
+        Scalar r0, r1;
+        Dvalid = solveQuadratic(Scalar(A), Scalar(B), Scalar(C), r0, r1).value;
+        t0 = r0.value;
+        t1 = r1.value;
+        return true;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+static inline bool nearest(Spheres const& spheres, float const* start, float const* dir, size_t begin, size_t end, float& t, size_t& index)
+{
+    RayGroup ray(start, dir);
+
+    reg zero = set1(0.f);
+    reg one = set1(1.f);
+    reg first_index = set1(float(begin));
+    reg last_index = set1(float(end));
+
+    reg best_t = set1(t);
+    reg best_index = set1(-1.f);
+
+    for (size_t ii = begin & ~(kWidth - 1); ii < end; ii += kWidth) {
+        reg Dvalid, t0, t1;
+
+        if (!ray.Roots(spheres, ii, Dvalid, t0, t1)) {
+            continue;
+        }
+
+        reg group_index = add(set1(float(ii)), lanes());
+
+        //  t = (0 <= t0 <= 1) ? t0 : t1
+        reg t0_valid = and_(cmpge(t0, zero), cmple(t0, one));
+        reg tt = blendv(t1, t0, t0_valid);
+
+        reg mask = and_(
+            and_(Dvalid, cmpge(tt, zero)),
+            and_(cmplt(tt, best_t),
+                 and_(cmpge(group_index, first_index), cmplt(group_index, last_index))));
+
+        best_t = blendv(best_t, tt, mask);
+        best_index = blendv(best_index, group_index, mask);
+    }
+
+    // Most searches from a hierarchy miss every sphere, skip the reduction.
+    if (!movemask(cmpge(best_index, zero))) {
+        return false;
+    }
+
+    // Reduce across lanes, preferring the lowest index among equal
+    // fractions to match the order of a sequential search.
+    reg min_t = hmin(best_t);
+
+    reg is_nearest = and_(cmpeq(best_t, min_t), cmpge(best_index, zero));
+    if (!movemask(is_nearest)) {
+        return false;
+    }
+
+    reg min_index = hmin(blendv(last_index, best_index, is_nearest));
+
+    t = first(min_t);
+    index = size_t(first(min_index));
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static inline bool occluded(Spheres const& spheres, float const* start, float const* dir, size_t begin, size_t end)
+{
+    RayGroup ray(start, dir);
+
+    reg zero = set1(0.f);
+    reg one = set1(1.f);
+    reg first_index = set1(float(begin));
+    reg last_index = set1(float(end));
+
+    for (size_t ii = begin & ~(kWidth - 1); ii < end; ii += kWidth) {
+        reg Dvalid, t0, t1;
+
+        if (!ray.Roots(spheres, ii, Dvalid, t0, t1)) {
+            continue;
+        }
+
+        reg group_index = add(set1(float(ii)), lanes());
+
+        //  Either root in [0, 1) blocks the ray, there is no need to find
+        //  which one is nearer.
+        reg t0_valid = and_(cmpge(t0, zero), cmplt(t0, one));
+        reg t1_valid = and_(cmpge(t1, zero), cmplt(t1, one));
+
+        reg mask = and_(
+            and_(Dvalid, or_(t0_valid, t1_valid)),
+            and_(cmpge(group_index, first_index), cmplt(group_index, last_index)));
+
+        if (movemask(mask)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Number of registers for each packet of `kPacketWidth` rays.
+constexpr size_t kPacketRegs = kPacketWidth / kWidth;
+
+static_assert(kPacketRegs * kWidth == kPacketWidth, "Bad packet width!");
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the nearest sphere in [begin, end) for each lane of a packet of rays,
+//! see `SphereArray::NearestPacket`. On input `t` is the maximum fraction for
+//! each lane; returns the mask of lanes for which `t` and `index` were updated.
+static inline int nearest_packet(Spheres const& spheres, float const (&start)[3][kPacketWidth], float const (&dir)[3][kPacketWidth], size_t begin, size_t end, float (&t)[kPacketWidth], float (&index)[kPacketWidth])
+{
+    reg zero = set1(0.f);
+    reg one = set1(1.f);
+    reg two = set1(2.f);
+
+    int result = 0;
+
+    for (size_t rr = 0; rr < kPacketWidth; rr += kWidth) {
+        reg sx = loadu(start[0] + rr);
+        reg sy = loadu(start[1] + rr);
+        reg sz = loadu(start[2] + rr);
+        reg dx = loadu(dir[0] + rr);
+        reg dy = loadu(dir[1] + rr);
+        reg dz = loadu(dir[2] + rr);
+
+        reg A = fmadd(dx, dx, fmadd(dy, dy, mul(dz, dz)));
+        reg A4 = mul(set1(4.f), A);
+
+        reg best_t = loadu(t + rr);
+        reg best_index = set1(-1.f);
+
+        for (size_t ii = begin; ii < end; ++ii) {
+            //  sphereVec = ray.start - sphere.origin
+            reg ox = sub(sx, set1(spheres.x[ii]));
+            reg oy = sub(sy, set1(spheres.y[ii]));
+            reg oz = sub(sz, set1(spheres.z[ii]));
+
+            //  B = 2 * rayVec * sphereVec
+            reg B = mul(two, fmadd(dx, ox, fmadd(dy, oy, mul(dz, oz))));
+            //  C = sphereVec * sphereVec - radius * radius
+            reg C = sub(fmadd(ox, ox, fmadd(oy, oy, mul(oz, oz))), set1(spheres.rsqr[ii]));
+
+            // Coherent rays tend to all miss the same spheres.
+            if (!movemask(cmpge(sub(mul(B, B), mul(A4, C)), zero))) {
+                continue;
+            }
+
+            Scalar r0, r1;
+            reg Dvalid = solveQuadratic(Scalar(A), Scalar(B), Scalar(C), r0, r1).value;
+            reg t0 = r0.value;
+            reg t1 = r1.value;
+
+            //  t = (0 <= t0 <= 1) ? t0 : t1
+            reg t0_valid = and_(cmpge(t0, zero), cmple(t0, one));
+            reg tt = blendv(t1, t0, t0_valid);
+
+            reg hit = and_(Dvalid, and_(cmpge(tt, zero), cmplt(tt, best_t)));
+
+            best_t = blendv(best_t, tt, hit);
+            best_index = blendv(best_index, set1(float(ii)), hit);
+        }
+
+        storeu(t + rr, best_t);
+        storeu(index + rr, best_index);
+        result |= movemask(cmpge(best_index, zero)) << rr;
+    }
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Return the lanes in `active` of a packet of rays from `start` with
+//! reciprocal directions `inv_dir` which enter the box [lo, hi] at a fraction
+//! before their fraction in `t`, and the minimum entry fraction of those lanes
+//! in `tnear`, see `BVH::NearestPacket`.
+static inline int enters(float const (&lo)[3], float const (&hi)[3], float const (&start)[3][kPacketWidth], float const (&inv_dir)[3][kPacketWidth], float const (&t)[kPacketWidth], int active, float& tnear)
+{
+    reg lx = set1(lo[0]), ly = set1(lo[1]), lz = set1(lo[2]);
+    reg hx = set1(hi[0]), hy = set1(hi[1]), hz = set1(hi[2]);
+
+    reg nearest = set1(FLT_MAX);
+    int result = 0;
+
+    for (size_t rr = 0; rr < kPacketWidth; rr += kWidth) {
+        reg sx = loadu(start[0] + rr);
+        reg sy = loadu(start[1] + rr);
+        reg sz = loadu(start[2] + rr);
+        reg ix = loadu(inv_dir[0] + rr);
+        reg iy = loadu(inv_dir[1] + rr);
+        reg iz = loadu(inv_dir[2] + rr);
+
+        reg t0x = mul(sub(lx, sx), ix);
+        reg t1x = mul(sub(hx, sx), ix);
+        reg t0y = mul(sub(ly, sy), iy);
+        reg t1y = mul(sub(hy, sy), iy);
+        reg t0z = mul(sub(lz, sz), iz);
+        reg t1z = mul(sub(hz, sz), iz);
+
+        reg tmin = max(max(min(t0x, t1x), min(t0y, t1y)),
+                       max(min(t0z, t1z), set1(0.f)));
+        reg tmax = min(min(max(t0x, t1x), max(t0y, t1y)),
+                       min(max(t0z, t1z), loadu(t + rr)));
+
+        // Lanes which are not active must not bring `tnear` closer.
+        reg hit = and_(cmple(tmin, tmax), lanemask(active >> rr));
+
+        nearest = min(nearest, blendv(set1(FLT_MAX), tmin, hit));
+        result |= movemask(hit) << rr;
+    }
+
+    if (result) {
+        tnear = first(hmin(nearest));
+    }
+    return result;
+}
@@ -0,0 +1,43 @@
+// Compiled with the instruction set enabled for sse2, see CMakeLists.txt.
+#include "Features.h"
+
+#undef _F_BITS
+#define _F_BITS (_F_MMX | _F_SSE | _F_SSE2)
+
+#include "SphereKernels.h"
+
+#include "vector/Intersect.h"
+
+#include <immintrin.h>
+
+namespace sphere_kernels {
+namespace sse2 {
+
+#include "SphereKernels.inl"
+
+//------------------------------------------------------------------------------
+bool Nearest(Spheres const& spheres, float const* start, float const* dir, size_t begin, size_t end, float& t, size_t& index)
+{
+    return nearest(spheres, start, dir, begin, end, t, index);
+}
+
+//------------------------------------------------------------------------------
+bool Occluded(Spheres const& spheres, float const* start, float const* dir, size_t begin, size_t end)
+{
+    return occluded(spheres, start, dir, begin, end);
+}
+
+//------------------------------------------------------------------------------
+int NearestPacket(Spheres const& spheres, float const (&start)[3][kPacketWidth], float const (&dir)[3][kPacketWidth], size_t begin, size_t end, float (&t)[kPacketWidth], float (&index)[kPacketWidth])
+{
+    return nearest_packet(spheres, start, dir, begin, end, t, index);
+}
+
+//------------------------------------------------------------------------------
+int Enters(float const (&lo)[3], float const (&hi)[3], float const (&start)[3][kPacketWidth], float const (&inv_dir)[3][kPacketWidth], float const (&t)[kPacketWidth], int active, float& tnear)
+{
+    return enters(lo, hi, start, inv_dir, t, active, tnear);
+}
+
+} // namespace sse2
+} // namespace sphere_kernels
@@ -0,0 +1,144 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+ThreadPool::ThreadPool(size_t num_threads)
+    : _generation(0)
+    , _num_active(0)
+    , _shutdown(false)
+{
+    if (!num_threads) {
+        num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    for (size_t ii = 0; ii < num_threads; ++ii) {
+        _queues.emplace_back(new Queue);
+    }
+
+    // Worker zero is the calling thread.
+    for (size_t ii = 1; ii < num_threads; ++ii) {
+        _threads.emplace_back(&ThreadPool::WorkerMain, this, ii);
+    }
+}
+
+//------------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _shutdown = true;
+    }
+    _start_cv.notify_all();
+
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::Run(size_t count, std::function<void(size_t)> const& fn)
+{
+    if (!count) {
+        return;
+    }
+
+    // Distribute tasks in contiguous ranges so that neighboring tasks, which
+    // are likely to have similar cost and touch similar data, start out on the
+    // same worker. Any imbalance is corrected by stealing.
+    size_t num_queues = _queues.size();
+    size_t chunk = (count + num_queues - 1) / num_queues;
+    for (size_t ii = 0; ii < num_queues; ++ii) {
+        std::lock_guard<std::mutex> lock(_queues[ii]->mutex);
+        for (size_t jj = ii * chunk; jj < std::min(count, (ii + 1) * chunk); ++jj) {
+            _queues[ii]->tasks.push_back(jj);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _task = fn;
+        _num_active = _threads.size();
+        ++_generation;
+    }
+    _start_cv.notify_all();
+
+    WorkerLoop(0);
+
+    // Workers only exit their loop once every queue is empty, so when all of
+    // the background workers have finished every task has been executed.
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _finish_cv.wait(lock, [this]() { return _num_active == 0; });
+        _task = nullptr;
+    }
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::WorkerMain(size_t worker)
+{
+    size_t generation = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _start_cv.wait(lock, [&]() { return _shutdown || _generation != generation; });
+            if (_shutdown) {
+                return;
+            }
+            generation = _generation;
+        }
+
+        WorkerLoop(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_num_active == 0) {
+                _finish_cv.notify_one();
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::WorkerLoop(size_t worker)
+{
+    size_t task;
+
+    while (Pop(worker, task) || Steal(worker, task)) {
+        _task(task);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool ThreadPool::Pop(size_t worker, size_t& task)
+{
+    Queue& queue = *_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.tasks.empty()) {
+        return false;
+    }
+
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool ThreadPool::Steal(size_t worker, size_t& task)
+{
+    size_t num_queues = _queues.size();
+
+    for (size_t ii = 1; ii < num_queues; ++ii) {
+        Queue& queue = *_queues[(worker + ii) % num_queues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (!queue.tasks.empty()) {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
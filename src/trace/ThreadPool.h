@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Fixed-size pool of worker threads which execute batches of independent tasks
+ * using work-stealing. Each batch of tasks is split into contiguous ranges, one
+ * per worker, and each worker consumes its own range from the back of its queue.
+ * Workers which run out of work steal from the front of other workers' queues,
+ * which keeps every thread busy when the cost of individual tasks is uneven.
+ *
+ * The calling thread participates as worker zero so a pool with one thread
+ * executes every task serially on the caller.
+ */
+class ThreadPool {
+public:
+    //! Create a pool with `num_threads` workers including the calling thread.
+    //! A value of zero uses the number of hardware threads.
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    size_t NumThreads() const {
+        return _queues.size();
+    }
+
+    //! Execute `fn(index)` for each index in [0, count) and wait for all tasks
+    //! to complete. Tasks may be executed in any order and on any worker.
+    template<typename Func>
+    void ParallelFor(size_t count, Func const& fn) {
+        Run(count, std::function<void(size_t)>(std::cref(fn)));
+    }
+
+protected:
+    //! Per-worker task queue. Owners pop from the back, thieves from the front.
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+
+    std::mutex _mutex;
+    std::condition_variable _start_cv;
+    std::condition_variable _finish_cv;
+
+    std::function<void(size_t)> _task;  //!< task function for the current batch
+    size_t _generation;                 //!< incremented for each batch
+    size_t _num_active;                 //!< number of background workers still running
+    bool _shutdown;
+
+protected:
+    void Run(size_t count, std::function<void(size_t)> const& fn);
+
+    void WorkerMain(size_t worker);
+    void WorkerLoop(size_t worker);
+
+    bool Pop(size_t worker, size_t& task);
+    bool Steal(size_t worker, size_t& task);
+};
@@ -7,8 +7,8 @@ int main()
 {
     constexpr size_t kSize = 1024;
 
-    Trace<reference::Matrix, reference::Vector, reference::Scalar>(kSize, kSize, "trace/default.bmp");
-    Trace<intrinsic::Matrix, intrinsic::Vector, intrinsic::Scalar>(kSize, kSize, "trace/intrinsic.bmp");
+    Trace<reference::Matrix, reference::Vector, reference::Scalar>(kSize, kSize, "trace/default.bmp", 0);
+    Trace<intrinsic::Matrix, intrinsic::Vector, intrinsic::Scalar>(kSize, kSize, "trace/intrinsic.bmp", 0);
 
     return 0;
 }
@@ -3,18 +3,63 @@
 #include "Frustum.h"
 #include "Scene.h"
 #include "Image.h"
+#include "ThreadPool.h"
 
+#include <algorithm>
+
+//! Trace the pixels of `image` in the rectangle [row_begin, row_end) x [col_begin, col_end).
+//! Primary rays are traced in packets of neighboring pixels, two rows high,
+//! and pixels at the edges of the rectangle which do not fill a whole packet
+//! are traced individually.
 template<typename M, typename V, typename S, typename L>
-void TraceView(Frustum<M, V, S> const& view, Scene<M, V, S, L> const& scene, Image<M, V, S>& image)
+void TraceTile(Frustum<M, V, S> const& view, Scene<M, V, S, L> const& scene, Image<M, V, S>& image,
+               size_t row_begin, size_t row_end, size_t col_begin, size_t col_end)
 {
+    constexpr size_t kPacketSize = Scene<M, V, S, L>::kPacketSize;
+    constexpr size_t kPacketRows = 2;
+    constexpr size_t kPacketCols = kPacketSize / kPacketRows;
+
     Color<M, V, S> default_color = {.1f, .1f, .1f, 1.f};
     S zscale = view.Near() / view.Far();
 
     V dz = view.Forward();
-    for (size_t ii = 0; ii < image.Height(); ++ii) {
-        V dh = view.Up() * (1.0f - 2.0f * (float(ii) + 0.5f) / float(image.Height()));
-        for (size_t jj = 0; jj < image.Width(); ++jj) {
-            V dw = view.Left() * (1.0f - 2.0f * (float(jj) + 0.5f) / float(image.Width()));
+
+    auto row_vector = [&](size_t ii) {
+        return V(view.Up() * (1.0f - 2.0f * (float(ii) + 0.5f) / float(image.Height())));
+    };
+    auto col_vector = [&](size_t jj) {
+        return V(view.Left() * (1.0f - 2.0f * (float(jj) + 0.5f) / float(image.Width())));
+    };
+
+    size_t packet_row_end = row_begin + (row_end - row_begin) / kPacketRows * kPacketRows;
+    size_t packet_col_end = col_begin + (col_end - col_begin) / kPacketCols * kPacketCols;
+
+    for (size_t ii = row_begin; ii < packet_row_end; ii += kPacketRows) {
+        for (size_t jj = col_begin; jj < packet_col_end; jj += kPacketCols) {
+            V start[kPacketSize];
+            V end[kPacketSize];
+            Color<M, V, S> color[kPacketSize];
+
+            for (size_t kk = 0; kk < kPacketSize; ++kk) {
+                V dfar = dz + row_vector(ii + kk / kPacketCols) + col_vector(jj + kk % kPacketCols);
+                end[kk] = view.Origin() + dfar;
+                start[kk] = view.Origin() + dfar * zscale;
+            }
+
+            int mask = scene.TraceColorPacket(start, end, color);
+
+            for (size_t kk = 0; kk < kPacketSize; ++kk) {
+                image[ii + kk / kPacketCols][jj + kk % kPacketCols] = (mask & (1 << kk)) ? color[kk] : default_color;
+            }
+        }
+    }
+
+    for (size_t ii = row_begin; ii < row_end; ++ii) {
+        V dh = row_vector(ii);
+        // Rows which were traced in packets only have remaining columns.
+        size_t jj_begin = ii < packet_row_end ? packet_col_end : col_begin;
+        for (size_t jj = jj_begin; jj < col_end; ++jj) {
+            V dw = col_vector(jj);
 
             V dfar = dz + dh + dw;
             V end = view.Origin() + dfar;
@@ -27,8 +72,36 @@ void TraceView(Frustum<M, V, S> const& view, Scene<M, V, S, L> const& scene, Ima
     }
 }
 
+template<typename M, typename V, typename S, typename L>
+void TraceView(Frustum<M, V, S> const& view, Scene<M, V, S, L> const& scene, Image<M, V, S>& image)
+{
+    TraceTile(view, scene, image, 0, image.Height(), 0, image.Width());
+}
+
+//! Trace the view by splitting the image into square tiles which are executed
+//! on `pool`. Each pixel is traced exactly as in `TraceView` so the resulting
+//! image is identical regardless of the number of threads.
+template<typename M, typename V, typename S, typename L>
+void TraceView(Frustum<M, V, S> const& view, Scene<M, V, S, L> const& scene, Image<M, V, S>& image, ThreadPool& pool)
+{
+    constexpr size_t kTileSize = 16;
+
+    size_t rows = (image.Height() + kTileSize - 1) / kTileSize;
+    size_t cols = (image.Width() + kTileSize - 1) / kTileSize;
+
+    pool.ParallelFor(rows * cols, [&](size_t tile) {
+        size_t row = (tile / cols) * kTileSize;
+        size_t col = (tile % cols) * kTileSize;
+
+        TraceTile(view, scene, image,
+                  row, std::min(row + kTileSize, image.Height()),
+                  col, std::min(col + kTileSize, image.Width()));
+    });
+}
+
+//! Render the test scene. A `num_threads` of zero uses all hardware threads.
 template<typename M, typename V, typename S, typename L = L_BlinnPhong>
-void Trace(size_t width, size_t height, char const* filename = nullptr) {
+Image<M, V, S> TraceImage(size_t width, size_t height, size_t num_threads = 1) {
     Light<M, V, S>          lights[2];
 
     lights[0].origin        = V(2.f, 0.f, 4.f, 1.f);
@@ -69,7 +142,19 @@ void Trace(size_t width, size_t height, char const* filename = nullptr) {
     Image<M, V, S>      image(width, height);
     Scene<M, V, S, L>   scene(lights, spheres);
 
-    TraceView(view, scene, image);
+    if (num_threads == 1) {
+        TraceView(view, scene, image);
+    } else {
+        ThreadPool pool(num_threads);
+        TraceView(view, scene, image, pool);
+    }
+
+    return image;
+}
+
+template<typename M, typename V, typename S, typename L = L_BlinnPhong>
+void Trace(size_t width, size_t height, char const* filename = nullptr, size_t num_threads = 1) {
+    Image<M, V, S> image = TraceImage<M, V, S, L>(width, height, num_threads);
 
     if (filename) {
         image.Save(filename);
@@ -31,11 +31,47 @@ namespace aliased {
 
 // Forward declarations
 class Vector;
+class HalfVector;
+class Vector3;
+class Quaternion;
+class AffineMatrix;
 class Matrix;
 
 using intrinsic::_v_shuffle_ps;
 using intrinsic::_v_blend_ps;
+using intrinsic::_v_extract_ps;
+using intrinsic::_v_insert_ps;
 using intrinsic::_v_dp_ps;
+using intrinsic::_v_abs_ps;
+using intrinsic::_v_floor_ps;
+using intrinsic::_v_ceil_ps;
+using intrinsic::_v_reduce_min_ps;
+using intrinsic::_v_reduce_max_ps;
+using intrinsic::_v_reduce_add_ps;
+using intrinsic::_v_bounds_batch_ps;
+using intrinsic::_v_max_lsqr_batch_ps;
+using intrinsic::_v_fmadd_ps;
+using intrinsic::_v_sincos_ps;
+using intrinsic::_v_determinant_ps;
+using intrinsic::_v_inverse_ps;
+using intrinsic::_v_inverse_affine_ps;
+using intrinsic::_v_quat_mul_ps;
+using intrinsic::_v_quat_rotate_ps;
+using intrinsic::_v_quat_slerp_ps;
+using intrinsic::_v_quat_slerp4_ps;
+using intrinsic::_v_quat_to_matrix_ps;
+using intrinsic::_v_matrix_to_quat_ps;
+using intrinsic::_v_transpose_ps;
+using intrinsic::_v_affine_mul_ps;
+using intrinsic::_v_transform_batch_ps;
+using intrinsic::_v_cvtps_ph;
+using intrinsic::_v_cvtph_ps;
+using intrinsic::_v_cvtps_ph_batch;
+using intrinsic::_v_cvtph_ps_batch;
+using intrinsic::_v_load3_ps;
+using intrinsic::_v_store3_ps;
+using intrinsic::_v_load3_ps_batch;
+using intrinsic::_v_store3_ps_batch;
 
 using Scalar = float;
 
@@ -60,6 +96,26 @@ public:
         return (&x)[index];
     }
 
+    //! Return element `I` of this vector.
+    template<int I>
+    Scalar VECTORCALL Extract() const {
+        static_assert(0 <= I && I < 4, "Element index out of range!");
+        return _mm_cvtss_f32(_v_extract_ps<I>(_value));
+    }
+
+    //! Return this vector with element `I` replaced by `s`.
+    template<int I>
+    Vector VECTORCALL Insert(Scalar s) const {
+        static_assert(0 <= I && I < 4, "Element index out of range!");
+        return _v_insert_ps<I>(_value, _mm_set1_ps(s));
+    }
+
+    //! Return the vector { v[X], v[Y], v[Z], v[W] } of elements of this vector.
+    template<int X, int Y, int Z, int W>
+    Vector VECTORCALL Swizzle() const {
+        return _v_shuffle_ps<W, Z, Y, X>(_value, _value);
+    }
+
     bool VECTORCALL operator==(Vector const& a) const {
         return _mm_movemask_ps(_mm_cmpeq_ps(_value, a._value)) == 0xf;
     }
@@ -168,6 +224,79 @@ public:
         return _mm_mul_ps(_value, a._value);
     }
 
+    //! Return the component-wise minimum with `a`.
+    Vector VECTORCALL Min(Vector const& a) const {
+        return _mm_min_ps(_value, a._value);
+    }
+
+    //! Return the component-wise maximum with `a`.
+    Vector VECTORCALL Max(Vector const& a) const {
+        return _mm_max_ps(_value, a._value);
+    }
+
+    //! Return each element clamped to the same element of `lo` and `hi`.
+    Vector VECTORCALL Clamp(Vector const& lo, Vector const& hi) const {
+        return _mm_min_ps(_mm_max_ps(_value, lo._value), hi._value);
+    }
+
+    //! Return each element clamped to `lo` and `hi`.
+    Vector VECTORCALL Clamp(Scalar lo, Scalar hi) const {
+        return _mm_min_ps(_mm_max_ps(_value, _mm_set_ps1(lo)), _mm_set_ps1(hi));
+    }
+
+    //! Return the linear interpolation from this vector to `a` by `t`.
+    Vector VECTORCALL Lerp(Vector const& a, Scalar t) const {
+        return _v_fmadd_ps(_mm_sub_ps(a._value, _value), _mm_set_ps1(t), _value);
+    }
+
+    //! Return the component-wise absolute value.
+    Vector VECTORCALL Abs() const {
+        return _v_abs_ps(_value);
+    }
+
+    //! Return each element rounded toward negative infinity.
+    Vector VECTORCALL Floor() const {
+        return _v_floor_ps(_value);
+    }
+
+    //! Return each element rounded toward positive infinity.
+    Vector VECTORCALL Ceil() const {
+        return _v_ceil_ps(_value);
+    }
+
+    //! Return the minimum of the elements of this vector.
+    Scalar VECTORCALL HorizontalMin() const {
+        return _mm_cvtss_f32(_v_reduce_min_ps(_value));
+    }
+
+    //! Return the maximum of the elements of this vector.
+    Scalar VECTORCALL HorizontalMax() const {
+        return _mm_cvtss_f32(_v_reduce_max_ps(_value));
+    }
+
+    //! Return the sum of the elements of this vector.
+    Scalar VECTORCALL HorizontalSum() const {
+        return _mm_cvtss_f32(_v_reduce_add_ps(_value));
+    }
+
+    //! Return the component-wise minimum and maximum of `count` vectors in
+    //! `src`, which are +infinity and -infinity if `count` is zero.
+    static void VECTORCALL Bounds(Vector const* src, size_t count, Vector& min, Vector& max) {
+        _v_bounds_batch_ps(&src->_value, count, min._value, max._value);
+    }
+
+    //! Return the maximum length of `count` vectors in `src`, or zero if
+    //! `count` is zero.
+    static Scalar VECTORCALL MaxLength(Vector const* src, size_t count) {
+        return _mm_cvtss_f32(_mm_sqrt_ss(_v_max_lsqr_batch_ps(&src->_value, count)));
+    }
+
+    //! Return this vector converted to half precision for storage.
+    HalfVector VECTORCALL ToHalfVector() const;
+
+    //! Return the first three elements of this vector for packed storage.
+    Vector3 VECTORCALL ToVector3() const;
+
 private:
 
 #if defined(_MSC_VER)
@@ -189,6 +318,10 @@ private:
 #endif // defined(_MSC_VER)
 
 private:
+    friend HalfVector;
+    friend Vector3;
+    friend Quaternion;
+    friend AffineMatrix;
     friend Matrix;
 
     Vector(__m128 const& value)
@@ -197,6 +330,268 @@ private:
 
 static_assert(alignof(Vector) == alignof(__m128), "Bad alignment!");
 
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Half precision storage for a `Vector` in 8 bytes, see `intrinsic::HalfVector`.
+ */
+class alignas(8) HalfVector {
+public:
+    HalfVector() {}
+    HalfVector(float X, float Y, float Z, float W)
+        : HalfVector(Vector(X, Y, Z, W)) {}
+    //! Convert `v` to half precision, rounding to nearest even.
+    explicit HalfVector(Vector const& v) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(_value), _v_cvtps_ph(v._value));
+    }
+
+    //! Return this vector converted to single precision.
+    Vector VECTORCALL ToVector() const {
+        return _v_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(_value)));
+    }
+
+    //! Convert `count` vectors from `src` to half precision in `dst`.
+    static void VECTORCALL Pack(Vector const* src, HalfVector* dst, size_t count) {
+        _v_cvtps_ph_batch(&src->_value, dst->_value, count);
+    }
+
+    //! Convert `count` vectors from `src` to single precision in `dst`.
+    static void VECTORCALL Unpack(HalfVector const* src, Vector* dst, size_t count) {
+        _v_cvtph_ps_batch(src->_value, &dst->_value, count);
+    }
+
+private:
+    uint16_t _value[4];
+};
+
+static_assert(sizeof(HalfVector) == 8, "Bad size!");
+
+inline HalfVector VECTORCALL Vector::ToHalfVector() const {
+    return HalfVector(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Packed storage for the first three elements of a `Vector` in 12 bytes, see
+ * `intrinsic::Vector3`.
+ */
+class Vector3 {
+public:
+    Vector3() {}
+    Vector3(float X, float Y, float Z)
+        : _value{X, Y, Z} {}
+    //! Store the first three elements of `v`.
+    explicit Vector3(Vector const& v) {
+        _v_store3_ps(_value, v._value);
+    }
+
+    //! Return this vector with `w` in the fourth element, e.g. 1 for points.
+    Vector VECTORCALL ToVector(float w = 0.f) const {
+        return _v_load3_ps(_value, _mm_set_ss(w));
+    }
+
+    //! Store the first three elements of `count` vectors from `src` in `dst`.
+    static void VECTORCALL Pack(Vector const* src, Vector3* dst, size_t count) {
+        _v_store3_ps_batch(&src->_value, dst->_value, count);
+    }
+
+    //! Load `count` vectors from `src` to `dst` with `w` in the fourth element.
+    static void VECTORCALL Unpack(Vector3 const* src, Vector* dst, size_t count, float w = 0.f) {
+        _v_load3_ps_batch(src->_value, &dst->_value, count, w);
+    }
+
+private:
+    float _value[3];
+};
+
+static_assert(sizeof(Vector3) == 12, "Bad size!");
+
+inline Vector3 VECTORCALL Vector::ToVector3() const {
+    return Vector3(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Rotation quaternion stored in a single register as { w, z, y, x }, where w
+ * is the real part, see `intrinsic::Quaternion`.
+ */
+class Quaternion {
+public:
+    Quaternion() {}
+    Quaternion(float X, float Y, float Z, float W)
+        : _value(_mm_set_ps(W, Z, Y, X)) {}
+
+    //! Construct a rotation of `angle` radians about the unit vector `axis`.
+    Quaternion(Vector const& axis, float angle) {
+        __m128 s, c;
+        _v_sincos_ps(_mm_set_ps1(.5f * angle), s, c);
+        _value = _v_blend_ps<1, 0, 0, 0>(_mm_mul_ps(axis._value, s), c);
+    }
+
+    bool VECTORCALL operator==(Quaternion const& a) const {
+        return _mm_movemask_ps(_mm_cmpeq_ps(_value, a._value)) == 0xf;
+    }
+
+    bool VECTORCALL operator!=(Quaternion const& a) const {
+        return _mm_movemask_ps(_mm_cmpneq_ps(_value, a._value)) != 0x0;
+    }
+
+    //! Hamilton product, i.e. the rotation by `a` followed by this rotation.
+    Quaternion VECTORCALL operator*(Quaternion const& a) const {
+        return _v_quat_mul_ps(_value, a._value);
+    }
+
+    Quaternion VECTORCALL operator-() const {
+        return _mm_sub_ps(_mm_setzero_ps(), _value);
+    }
+
+    //! Return the conjugate, which is the inverse rotation.
+    Quaternion VECTORCALL Conjugate() const {
+        return _mm_xor_ps(_value, _mm_set_ps(0.f, -0.f, -0.f, -0.f));
+    }
+
+    //! Dot product in R4.
+    Scalar VECTORCALL Dot(Quaternion const& a) const {
+        return _mm_cvtss_f32(_v_dp_ps(_value, a._value));
+    }
+
+    Scalar VECTORCALL Length() const {
+        return _mm_cvtss_f32(_mm_sqrt_ps(_v_dp_ps(_value, _value)));
+    }
+
+    Quaternion VECTORCALL Normalize() const {
+        return _mm_div_ps(_value, _mm_sqrt_ps(_v_dp_ps(_value, _value)));
+    }
+
+    //! Return `v` rotated by this quaternion. The w component is unchanged.
+    Vector VECTORCALL Rotate(Vector const& v) const {
+        return _v_quat_rotate_ps(_value, v._value);
+    }
+
+    //! Return the normalized linear interpolation to `a` at the fraction `t`.
+    Quaternion VECTORCALL Nlerp(Quaternion const& a, Scalar t) const {
+        auto d = _v_dp_ps(_value, a._value);
+        auto sign = _mm_and_ps(d, _mm_set_ps1(-0.f));
+        auto r1 = _mm_sub_ps(_mm_xor_ps(a._value, sign), _value);
+        auto r2 = _v_fmadd_ps(r1, _mm_set_ps1(t), _value);
+        return _mm_div_ps(r2, _mm_sqrt_ps(_v_dp_ps(r2, r2)));
+    }
+
+    //! Return the spherical linear interpolation to `a` at the fraction `t`.
+    Quaternion VECTORCALL Slerp(Quaternion const& a, Scalar t) const {
+        return _v_quat_slerp_ps(_value, a._value, _mm_set_ps1(t));
+    }
+
+    //! Spherical linear interpolation of `count` pairs of quaternions from `a`
+    //! and `b` at the fractions `t` into `dst`, see `_v_quat_slerp4_ps`.
+    static void VECTORCALL SlerpBatch(Quaternion const* a, Quaternion const* b, float const* t, Quaternion* dst, size_t count) {
+        size_t ii = 0;
+
+        for (; ii + 3 < count; ii += 4) {
+            __m128 const src0[4] = { a[ii]._value, a[ii + 1]._value, a[ii + 2]._value, a[ii + 3]._value };
+            __m128 const src1[4] = { b[ii]._value, b[ii + 1]._value, b[ii + 2]._value, b[ii + 3]._value };
+            __m128 r[4];
+            _v_quat_slerp4_ps(src0, src1, _mm_loadu_ps(t + ii), r);
+
+            dst[ii + 0]._value = r[0];
+            dst[ii + 1]._value = r[1];
+            dst[ii + 2]._value = r[2];
+            dst[ii + 3]._value = r[3];
+        }
+
+        for (; ii < count; ++ii) {
+            dst[ii]._value = _v_quat_slerp_ps(a[ii]._value, b[ii]._value, _mm_set_ps1(t[ii]));
+        }
+    }
+
+private:
+    __m128 _value;
+
+private:
+    friend Matrix;
+
+    Quaternion(__m128 const& value)
+        : _value(value) {}
+};
+
+static_assert(alignof(Quaternion) == alignof(__m128), "Bad alignment!");
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Affine transform stored as the first three rows of a 4x4 matrix, the last
+ * row is implicitly { 0, 0, 0, 1 }, see `intrinsic::AffineMatrix`.
+ */
+class AffineMatrix {
+public:
+    AffineMatrix() {}
+    //! Construct with column vectors, the last element of each is ignored.
+    AffineMatrix(Vector const& X, Vector const& Y, Vector const& Z, Vector const& W) {
+        __m128 const src[4] = { X._value, Y._value, Z._value, W._value };
+        __m128 dst[4];
+        _v_transpose_ps(src, dst);
+        x = dst[0];
+        y = dst[1];
+        z = dst[2];
+    }
+    AffineMatrix(float m11, float m12, float m13, float m14,
+                 float m21, float m22, float m23, float m24,
+                 float m31, float m32, float m33, float m34)
+        : x(m11, m12, m13, m14)
+        , y(m21, m22, m23, m24)
+        , z(m31, m32, m33, m34) {}
+
+    bool VECTORCALL operator==(AffineMatrix const& a) const {
+        return x == a.x && y == a.y && z == a.z;
+    }
+
+    bool VECTORCALL operator!=(AffineMatrix const& a) const {
+        return x != a.x || y != a.y || z != a.z;
+    }
+
+    //! Product with `v` as a 4x4 matrix, i.e. the last element is unchanged.
+    Vector VECTORCALL operator*(Vector const& v) const {
+        __m128 const src[3] = { x._value, y._value, z._value };
+        return _v_affine_mul_ps(src, v._value);
+    }
+
+    //! Return the composition of this transform with `a`, i.e. the transform
+    //! by `a` followed by this transform.
+    AffineMatrix VECTORCALL operator*(AffineMatrix const& a) const {
+        __m128 const src0[3] = { x._value, y._value, z._value };
+        __m128 const src1[3] = { a.x._value, a.y._value, a.z._value };
+        __m128 dst[3];
+        _v_affine_mul_ps(src0, src1, dst);
+        return AffineMatrix(dst[0], dst[1], dst[2]);
+    }
+
+    //! Return the point `p` transformed by rotation, scale and translation.
+    //! The last element of `p` is ignored and the last element of the result
+    //! is one.
+    Vector VECTORCALL TransformPoint(Vector const& p) const {
+        __m128 const src[3] = { x._value, y._value, z._value };
+        return _v_affine_mul_ps(src, _v_blend_ps<1, 0, 0, 0>(p._value, _mm_set_ps1(1.f)));
+    }
+
+    //! Return the direction `v` transformed by rotation and scale only. The
+    //! last element of `v` is ignored and the last element of the result is
+    //! zero.
+    Vector VECTORCALL TransformDirection(Vector const& v) const {
+        __m128 const src[3] = { x._value, y._value, z._value };
+        return _v_affine_mul_ps(src, _v_blend_ps<1, 0, 0, 0>(v._value, _mm_setzero_ps()));
+    }
+
+protected:
+    //! Rows of the matrix, e.g. `x` produces the x component of a product.
+    Vector x, y, z;
+
+protected:
+    friend Matrix;
+
+    AffineMatrix(__m128 const& X, __m128 const& Y, __m128 const& Z)
+        : x(X), y(Y), z(Z) {}
+};
+
+static_assert(sizeof(AffineMatrix) == 3 * sizeof(__m128), "Bad size!");
+
 ////////////////////////////////////////////////////////////////////////////////
 /**
  */
@@ -215,6 +610,27 @@ public:
         , z(m13, m23, m33, m43)
         , w(m14, m24, m34, m44) {}
 
+    //! Construct the rotation matrix of the unit quaternion `q`.
+    explicit Matrix(Quaternion const& q) {
+        __m128 dst[4];
+        _v_quat_to_matrix_ps(q._value, dst);
+        x = dst[0];
+        y = dst[1];
+        z = dst[2];
+        w = dst[3];
+    }
+
+    //! Construct from an affine transform.
+    explicit Matrix(AffineMatrix const& a) {
+        __m128 const src[4] = { a.x._value, a.y._value, a.z._value, _mm_set_ps(1.f, 0.f, 0.f, 0.f) };
+        __m128 dst[4];
+        _v_transpose_ps(src, dst);
+        x = dst[0];
+        y = dst[1];
+        z = dst[2];
+        w = dst[3];
+    }
+
     Vector& VECTORCALL operator[](size_t index) {
         return (&x)[index];
     }
@@ -321,6 +737,77 @@ public:
                       _mm_mul_ps(w._value, a.w._value));
     }
 
+    //! Return the determinant.
+    Scalar VECTORCALL Determinant() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        return _mm_cvtss_f32(_v_determinant_ps(src));
+    }
+
+    //! Return the inverse. The result is not finite if the matrix is singular,
+    //! i.e. if the determinant is zero.
+    Matrix VECTORCALL Inverse() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        __m128 dst[4];
+        _v_inverse_ps(src, dst);
+        return Matrix(dst[0], dst[1], dst[2], dst[3]);
+    }
+
+    //! Return the inverse of an affine transform which is composed of only
+    //! rotation, scale and translation, see `_v_inverse_affine_ps`.
+    Matrix VECTORCALL InverseAffine() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        __m128 dst[4];
+        _v_inverse_affine_ps(src, dst);
+        return Matrix(dst[0], dst[1], dst[2], dst[3]);
+    }
+
+    //! Invert `count` matrices from `src` into `dst`.
+    static void VECTORCALL InverseBatch(Matrix const* src, Matrix* dst, size_t count) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = src[ii].Inverse();
+        }
+    }
+
+    //! Transform `count` points from `src` into `dst`, treating the last
+    //! element of each point as one. If `stream` is true the results are
+    //! written with non-temporal stores, which is faster when `dst` is larger
+    //! than the last level cache and is not read again soon.
+    void VECTORCALL TransformPoints(Vector const* src, Vector* dst, size_t count, bool stream = false) const {
+        __m128 const m[4] = { x._value, y._value, z._value, w._value };
+        if (stream) {
+            _v_transform_batch_ps<true, true>(m, &src->_value, &dst->_value, count);
+        } else {
+            _v_transform_batch_ps<true, false>(m, &src->_value, &dst->_value, count);
+        }
+    }
+
+    //! Transform `count` directions from `src` into `dst`, treating the last
+    //! element of each direction as zero, see `TransformPoints`.
+    void VECTORCALL TransformDirections(Vector const* src, Vector* dst, size_t count, bool stream = false) const {
+        __m128 const m[4] = { x._value, y._value, z._value, w._value };
+        if (stream) {
+            _v_transform_batch_ps<false, true>(m, &src->_value, &dst->_value, count);
+        } else {
+            _v_transform_batch_ps<false, false>(m, &src->_value, &dst->_value, count);
+        }
+    }
+
+    //! Return the unit quaternion of the rotation in the upper 3x3 block,
+    //! which must be orthonormal.
+    Quaternion VECTORCALL ToQuaternion() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        return _v_matrix_to_quat_ps(src);
+    }
+
+    //! Return the first three rows as an affine transform. The last row must
+    //! be { 0, 0, 0, 1 }.
+    AffineMatrix VECTORCALL ToAffineMatrix() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        __m128 dst[4];
+        _v_transpose_ps(src, dst);
+        return AffineMatrix(dst[0], dst[1], dst[2]);
+    }
+
 protected:
     Vector x, y, z, w;
 
@@ -0,0 +1,511 @@
+#pragma once
+
+#include "Features.h"
+#include "Platform.h"
+
+#include "Intrinsic.h"
+
+#include <cassert>
+#include <cstdint>
+
+#include <immintrin.h>
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Following the conventions used in Intel documentation, register values are
+ * written from most to least significant. A 256-bit register holds a pair of
+ * column vectors, i.e.
+ *
+ *              [255:128][127:0]
+ *  XY[255:0] = {      y,      x}
+ *
+ * A single vector only fills half of a 256-bit register so `Vector`,
+ * `HalfVector`, `Vector3`, `Scalar`, `Quaternion` and `AffineMatrix` are
+ * shared with the `intrinsic` implementation, which is compiled with VEX
+ * encoding when AVX is enabled. Matrix operations process pairs of columns in
+ * each register.
+ */
+
+#if !_HAS_AVX
+#   error AVX implementation requires at least AVX instruction set!
+#endif
+
+namespace avx {
+
+////////////////////////////////////////////////////////////////////////////////
+//! Duplicate `src` into the upper and lower halves of the result.
+//!     dst[255:0] = { src[127:0], src[127:0] }
+inline __m256 VECTORCALL _v_dup_ps(__m128 src)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(src), src, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Multiply and add, fused if available.
+//!     dst[255:0] = src0[255:0] * src1[255:0] + src2[255:0]
+inline __m256 VECTORCALL _v_fmadd_ps(__m256 src0, __m256 src1, __m256 src2)
+{
+#if _HAS_FMA
+    return _mm256_fmadd_ps(src0, src1, src2);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(src0, src1), src2);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Select elements of `src0` and `src1` within each 128-bit half based on the
+//! template arguments, see `intrinsic::_v_shuffle_ps`.
+template<int W, int Z, int Y, int X>
+inline __m256 VECTORCALL _v_shuffle_ps(__m256 src0, __m256 src1)
+{
+    static_assert(0 <= W && W < 4, "Element index out of range!");
+    static_assert(0 <= Z && Z < 4, "Element index out of range!");
+    static_assert(0 <= Y && Y < 4, "Element index out of range!");
+    static_assert(0 <= X && X < 4, "Element index out of range!");
+
+    return _mm256_shuffle_ps(src0, src1, ((W << 6) | (Z << 4) | (Y << 2) | (X << 0)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Equivalents of the `intrinsic` 2x2 matrix products and 4x4 inverse, which
+//  operate on a different matrix in each 128-bit half of the registers.
+
+//! Same as `_mm_movelh_ps` in each 128-bit half.
+inline __m256 VECTORCALL _v_movelh_ps(__m256 src0, __m256 src1)
+{
+    return _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(src0), _mm256_castps_pd(src1)));
+}
+
+//! Same as `_mm_movehl_ps` in each 128-bit half.
+inline __m256 VECTORCALL _v_movehl_ps(__m256 src0, __m256 src1)
+{
+    return _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(src1), _mm256_castps_pd(src0)));
+}
+
+//! dst = src0 * src1
+inline __m256 VECTORCALL _v_mat2mul_ps(__m256 src0, __m256 src1)
+{
+    auto r1 = _mm256_mul_ps(src0, _v_shuffle_ps<3, 0, 3, 0>(src1, src1));
+    auto r2 = _mm256_mul_ps(_v_shuffle_ps<2, 3, 0, 1>(src0, src0),
+                            _v_shuffle_ps<1, 2, 1, 2>(src1, src1));
+    return _mm256_add_ps(r1, r2);
+}
+
+//! dst = src0# * src1
+inline __m256 VECTORCALL _v_mat2adjmul_ps(__m256 src0, __m256 src1)
+{
+    auto r1 = _mm256_mul_ps(_v_shuffle_ps<0, 0, 3, 3>(src0, src0), src1);
+    auto r2 = _mm256_mul_ps(_v_shuffle_ps<2, 2, 1, 1>(src0, src0),
+                            _v_shuffle_ps<1, 0, 3, 2>(src1, src1));
+    return _mm256_sub_ps(r1, r2);
+}
+
+//! dst = src0 * src1#
+inline __m256 VECTORCALL _v_mat2muladj_ps(__m256 src0, __m256 src1)
+{
+    auto r1 = _mm256_mul_ps(src0, _v_shuffle_ps<0, 3, 0, 3>(src1, src1));
+    auto r2 = _mm256_mul_ps(_v_shuffle_ps<2, 3, 0, 1>(src0, src0),
+                            _v_shuffle_ps<1, 2, 1, 2>(src1, src1));
+    return _mm256_sub_ps(r1, r2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Inverse of two 4x4 matrices, one in each 128-bit half of the columns `src`.
+inline void VECTORCALL _v_inverse_ps(__m256 const (&src)[4], __m256 (&dst)[4])
+{
+    auto A = _v_movelh_ps(src[0], src[1]);
+    auto B = _v_movehl_ps(src[1], src[0]);
+    auto C = _v_movelh_ps(src[2], src[3]);
+    auto D = _v_movehl_ps(src[3], src[2]);
+
+    auto r1 = _mm256_mul_ps(_v_shuffle_ps<2, 0, 2, 0>(src[0], src[2]),
+                            _v_shuffle_ps<3, 1, 3, 1>(src[1], src[3]));
+    auto r2 = _mm256_mul_ps(_v_shuffle_ps<3, 1, 3, 1>(src[0], src[2]),
+                            _v_shuffle_ps<2, 0, 2, 0>(src[1], src[3]));
+    auto det = _mm256_sub_ps(r1, r2);
+    auto detA = _v_shuffle_ps<0, 0, 0, 0>(det, det);
+    auto detB = _v_shuffle_ps<1, 1, 1, 1>(det, det);
+    auto detC = _v_shuffle_ps<2, 2, 2, 2>(det, det);
+    auto detD = _v_shuffle_ps<3, 3, 3, 3>(det, det);
+
+    auto D_C = _v_mat2adjmul_ps(D, C);
+    auto A_B = _v_mat2adjmul_ps(A, B);
+
+    auto X_ = _mm256_sub_ps(_mm256_mul_ps(detD, A), _v_mat2mul_ps(B, D_C));
+    auto W_ = _mm256_sub_ps(_mm256_mul_ps(detA, D), _v_mat2mul_ps(C, A_B));
+    auto Y_ = _mm256_sub_ps(_mm256_mul_ps(detB, C), _v_mat2muladj_ps(D, A_B));
+    auto Z_ = _mm256_sub_ps(_mm256_mul_ps(detC, B), _v_mat2muladj_ps(A, D_C));
+
+    auto tr = _mm256_dp_ps(A_B, _v_shuffle_ps<3, 1, 2, 0>(D_C, D_C), 0xff);
+    auto detM = _mm256_add_ps(_mm256_mul_ps(detA, detD), _mm256_mul_ps(detB, detC));
+    detM = _mm256_sub_ps(detM, tr);
+
+    auto rdetM = _mm256_div_ps(_mm256_set_ps(1.f, -1.f, -1.f, 1.f, 1.f, -1.f, -1.f, 1.f), detM);
+
+    X_ = _mm256_mul_ps(X_, rdetM);
+    Y_ = _mm256_mul_ps(Y_, rdetM);
+    Z_ = _mm256_mul_ps(Z_, rdetM);
+    W_ = _mm256_mul_ps(W_, rdetM);
+
+    dst[0] = _v_shuffle_ps<1, 3, 1, 3>(X_, Y_);
+    dst[1] = _v_shuffle_ps<0, 2, 0, 2>(X_, Y_);
+    dst[2] = _v_shuffle_ps<1, 3, 1, 3>(Z_, W_);
+    dst[3] = _v_shuffle_ps<0, 2, 0, 2>(Z_, W_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Equivalents of the `intrinsic` batch transforms, which transform a pair of
+//  vectors in each 256-bit register.
+
+//! Product of the matrix with columns `src0`, duplicated into both 128-bit
+//! halves, and each vector of the pair `src1`, see `intrinsic::_v_transform_ps`.
+template<bool Point>
+inline __m256 VECTORCALL _v_transform_ps(__m256 const (&src0)[4], __m256 src1)
+{
+    auto r1 = _mm256_mul_ps(src0[0], _mm256_permute_ps(src1, 0x00));
+    auto r2 = _mm256_mul_ps(src0[1], _mm256_permute_ps(src1, 0x55));
+    r1 = _v_fmadd_ps(src0[2], _mm256_permute_ps(src1, 0xaa), r1);
+    if (Point) {
+        r2 = _mm256_add_ps(src0[3], r2);
+    }
+    return _mm256_add_ps(r1, r2);
+}
+
+//! Store `src` to the 32-byte aligned address `dst`, bypassing the cache if
+//! `Stream` is true.
+template<bool Stream>
+inline void VECTORCALL _v_store_ps(__m128* dst, __m256 src)
+{
+    if (Stream) {
+        _mm256_stream_ps(reinterpret_cast<float*>(dst), src);
+    } else {
+        _mm256_store_ps(reinterpret_cast<float*>(dst), src);
+    }
+}
+
+//! Transform `count` vectors from `src1` into `dst` by the matrix with columns
+//! `src0`, see `intrinsic::_v_transform_batch_ps`.
+template<bool Point, bool Stream>
+inline void VECTORCALL _v_transform_batch_ps(__m128 const (&src0)[4], __m128 const* src1, __m128* dst, size_t count)
+{
+    __m256 const m[4] = { _v_dup_ps(src0[0]), _v_dup_ps(src0[1]), _v_dup_ps(src0[2]), _v_dup_ps(src0[3]) };
+    size_t ii = 0;
+
+    //  Transform the first vector on its own if needed to align the output
+    //  for 256-bit stores. Input is loaded unaligned.
+    if (count && (reinterpret_cast<uintptr_t>(dst) & 31)) {
+        intrinsic::_v_store_ps<Stream>(dst, intrinsic::_v_transform_ps<Point>(src0, src1[0]));
+        ii = 1;
+    }
+
+    //  Four vectors fill one cache line.
+    for (; ii + 4 <= count; ii += 4) {
+        intrinsic::_v_prefetch_batch(src1, ii, count);
+        auto v0 = _mm256_loadu_ps(reinterpret_cast<float const*>(src1 + ii + 0));
+        auto v1 = _mm256_loadu_ps(reinterpret_cast<float const*>(src1 + ii + 2));
+        _v_store_ps<Stream>(dst + ii + 0, _v_transform_ps<Point>(m, v0));
+        _v_store_ps<Stream>(dst + ii + 2, _v_transform_ps<Point>(m, v1));
+    }
+
+    if (ii + 2 <= count) {
+        auto v0 = _mm256_loadu_ps(reinterpret_cast<float const*>(src1 + ii));
+        _v_store_ps<Stream>(dst + ii, _v_transform_ps<Point>(m, v0));
+        ii += 2;
+    }
+
+    if (ii < count) {
+        intrinsic::_v_store_ps<Stream>(dst + ii, intrinsic::_v_transform_ps<Point>(src0, src1[ii]));
+    }
+
+    //  Order the non-temporal stores before any following stores.
+    if (Stream) {
+        _mm_sfence();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+using Scalar = intrinsic::Scalar;
+using Vector = intrinsic::Vector;
+using HalfVector = intrinsic::HalfVector;
+using Vector3 = intrinsic::Vector3;
+using Quaternion = intrinsic::Quaternion;
+using AffineMatrix = intrinsic::AffineMatrix;
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Columns are stored as individual vectors so that the matrix only requires
+ * the alignment of `Vector`, which is needed for use in standard containers
+ * without aligned allocation. Column pairs are loaded into 256-bit registers
+ * with unaligned loads which are no slower than aligned loads on aligned data.
+ */
+class Matrix {
+public:
+    Matrix() {}
+    //! Construct with column vectors
+    Matrix(Vector const& X, Vector const& Y, Vector const& Z, Vector const& W)
+        : x(X), y(Y), z(Z), w(W) {}
+    Matrix(float m11, float m12, float m13, float m14,
+           float m21, float m22, float m23, float m24,
+           float m31, float m32, float m33, float m34,
+           float m41, float m42, float m43, float m44)
+        : x(m11, m21, m31, m41)
+        , y(m12, m22, m32, m42)
+        , z(m13, m23, m33, m43)
+        , w(m14, m24, m34, m44) {}
+
+    //! Construct the rotation matrix of the unit quaternion `q`.
+    explicit Matrix(Quaternion const& q) {
+        __m128 dst[4];
+        intrinsic::_v_quat_to_matrix_ps(q._value, dst);
+        x = Vector(dst[0]);
+        y = Vector(dst[1]);
+        z = Vector(dst[2]);
+        w = Vector(dst[3]);
+    }
+
+    //! Construct from an affine transform.
+    explicit Matrix(AffineMatrix const& a) {
+        __m128 const src[4] = { a.x._value, a.y._value, a.z._value, _mm_set_ps(1.f, 0.f, 0.f, 0.f) };
+        __m128 dst[4];
+        intrinsic::_v_transpose_ps(src, dst);
+        x = Vector(dst[0]);
+        y = Vector(dst[1]);
+        z = Vector(dst[2]);
+        w = Vector(dst[3]);
+    }
+
+    Vector& VECTORCALL operator[](size_t index) {
+        return (&x)[index];
+    }
+
+    Vector const& VECTORCALL operator[](size_t index) const {
+        return (&x)[index];
+    }
+
+    bool VECTORCALL operator==(Matrix const& a) const {
+        auto r1 = _mm256_cmp_ps(XY(), a.XY(), _CMP_EQ_OQ);
+        auto r2 = _mm256_cmp_ps(ZW(), a.ZW(), _CMP_EQ_OQ);
+        return _mm256_movemask_ps(_mm256_and_ps(r1, r2)) == 0xff;
+    }
+
+    bool VECTORCALL operator!=(Matrix const& a) const {
+        auto r1 = _mm256_cmp_ps(XY(), a.XY(), _CMP_NEQ_UQ);
+        auto r2 = _mm256_cmp_ps(ZW(), a.ZW(), _CMP_NEQ_UQ);
+        return _mm256_movemask_ps(_mm256_or_ps(r1, r2)) != 0x00;
+    }
+
+    Matrix VECTORCALL operator+(Matrix const& a) const {
+        return Matrix(_mm256_add_ps(XY(), a.XY()),
+                      _mm256_add_ps(ZW(), a.ZW()));
+    }
+
+    Matrix VECTORCALL operator-(Matrix const& a) const {
+        return Matrix(_mm256_sub_ps(XY(), a.XY()),
+                      _mm256_sub_ps(ZW(), a.ZW()));
+    }
+
+    Matrix VECTORCALL operator*(Scalar const& s) const {
+        auto ss = _v_dup_ps(s._value);
+        return Matrix(_mm256_mul_ps(XY(), ss),
+                      _mm256_mul_ps(ZW(), ss));
+    }
+
+    Matrix VECTORCALL operator/(Scalar const& s) const {
+        // GCC replaces 256-bit division with an approximate reciprocal when
+        // fast-math is enabled, but not 128-bit division which stays exact.
+        return Matrix(Vector(_mm_div_ps(x._value, s._value)),
+                      Vector(_mm_div_ps(y._value, s._value)),
+                      Vector(_mm_div_ps(z._value, s._value)),
+                      Vector(_mm_div_ps(w._value, s._value)));
+    }
+
+    friend Matrix VECTORCALL operator*(Scalar const& s, Matrix const& m) {
+        return m * s;
+    }
+
+    Vector VECTORCALL operator*(Vector const& v) const {
+        auto vv = _v_dup_ps(v._value);
+
+        //  vy      vy      vy      vy      vx      vx      vx      vx
+        auto rxy = _mm256_permutevar_ps(vv, _mm256_set_epi32(1, 1, 1, 1, 0, 0, 0, 0));
+        //  vw      vw      vw      vw      vz      vz      vz      vz
+        auto rzw = _mm256_permutevar_ps(vv, _mm256_set_epi32(3, 3, 3, 3, 2, 2, 2, 2));
+
+        //  y*vy + w*vw                     x*vx + z*vz
+        auto r1 = _v_fmadd_ps(ZW(), rzw, _mm256_mul_ps(XY(), rxy));
+
+        return _mm_add_ps(_mm256_castps256_ps128(r1),
+                          _mm256_extractf128_ps(r1, 1));
+    }
+
+    Matrix VECTORCALL operator*(Matrix const& a) const {
+        return Matrix(Product(a.XY()), Product(a.ZW()));
+    }
+
+    Matrix VECTORCALL Transpose() const {
+        //  m41     m31     m21     m11
+        //  m42     m32     m22     m12
+        //  m43     m33     m23     m13
+        //  m44     m34     m24     m14
+
+        // Shuffles only operate within each 128-bit half so crossing between
+        // halves of a 256-bit register costs more than the 128-bit transpose.
+        //  m22     m21     m12     m11
+        auto r0 = _mm_unpacklo_ps(x._value, y._value);
+        //  m24     m23     m14     m13
+        auto r2 = _mm_unpacklo_ps(z._value, w._value);
+        //  m42     m41     m32     m31
+        auto r1 = _mm_unpackhi_ps(x._value, y._value);
+        //  m44     m43     m34     m33
+        auto r3 = _mm_unpackhi_ps(z._value, w._value);
+
+        return Matrix(
+            //  m14     m13     m12     m11
+            Vector(_mm_movelh_ps(r0, r2)),
+            //  m24     m23     m22     m21
+            Vector(_mm_movehl_ps(r2, r0)),
+            //  m34     m33     m32     m31
+            Vector(_mm_movelh_ps(r1, r3)),
+            //  m44     m43     m42     m41
+            Vector(_mm_movehl_ps(r3, r1))
+        );
+    }
+
+    //! Return the component-wise product with `a`.
+    Matrix VECTORCALL Hadamard(Matrix const& a) const {
+        return Matrix(_mm256_mul_ps(XY(), a.XY()),
+                      _mm256_mul_ps(ZW(), a.ZW()));
+    }
+
+    //! Return the determinant.
+    Scalar VECTORCALL Determinant() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        return intrinsic::_v_determinant_ps(src);
+    }
+
+    //! Return the inverse. The result is not finite if the matrix is singular,
+    //! i.e. if the determinant is zero.
+    Matrix VECTORCALL Inverse() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        __m128 dst[4];
+        intrinsic::_v_inverse_ps(src, dst);
+        return Matrix(Vector(dst[0]), Vector(dst[1]), Vector(dst[2]), Vector(dst[3]));
+    }
+
+    //! Return the inverse of an affine transform which is composed of only
+    //! rotation, scale and translation, see `intrinsic::_v_inverse_affine_ps`.
+    Matrix VECTORCALL InverseAffine() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        __m128 dst[4];
+        intrinsic::_v_inverse_affine_ps(src, dst);
+        return Matrix(Vector(dst[0]), Vector(dst[1]), Vector(dst[2]), Vector(dst[3]));
+    }
+
+    //! Invert `count` matrices from `src` into `dst`, two at a time with one
+    //! matrix in each half of the 256-bit registers.
+    static void VECTORCALL InverseBatch(Matrix const* src, Matrix* dst, size_t count) {
+        size_t ii = 0;
+
+        for (; ii + 1 < count; ii += 2) {
+            __m256 s[4], d[4];
+            for (size_t jj = 0; jj < 4; ++jj) {
+                s[jj] = _mm256_insertf128_ps(_mm256_castps128_ps256(src[ii][jj]._value),
+                                             src[ii + 1][jj]._value, 1);
+            }
+
+            _v_inverse_ps(s, d);
+
+            for (size_t jj = 0; jj < 4; ++jj) {
+                dst[ii][jj] = Vector(_mm256_castps256_ps128(d[jj]));
+                dst[ii + 1][jj] = Vector(_mm256_extractf128_ps(d[jj], 1));
+            }
+        }
+
+        if (ii < count) {
+            dst[ii] = src[ii].Inverse();
+        }
+    }
+
+    //! Transform `count` points from `src` into `dst`, treating the last
+    //! element of each point as one. If `stream` is true the results are
+    //! written with non-temporal stores, which is faster when `dst` is larger
+    //! than the last level cache and is not read again soon.
+    void VECTORCALL TransformPoints(Vector const* src, Vector* dst, size_t count, bool stream = false) const {
+        __m128 const m[4] = { x._value, y._value, z._value, w._value };
+        if (stream) {
+            _v_transform_batch_ps<true, true>(m, &src->_value, &dst->_value, count);
+        } else {
+            _v_transform_batch_ps<true, false>(m, &src->_value, &dst->_value, count);
+        }
+    }
+
+    //! Transform `count` directions from `src` into `dst`, treating the last
+    //! element of each direction as zero, see `TransformPoints`.
+    void VECTORCALL TransformDirections(Vector const* src, Vector* dst, size_t count, bool stream = false) const {
+        __m128 const m[4] = { x._value, y._value, z._value, w._value };
+        if (stream) {
+            _v_transform_batch_ps<false, true>(m, &src->_value, &dst->_value, count);
+        } else {
+            _v_transform_batch_ps<false, false>(m, &src->_value, &dst->_value, count);
+        }
+    }
+
+    //! Return the unit quaternion of the rotation in the upper 3x3 block,
+    //! which must be orthonormal.
+    Quaternion VECTORCALL ToQuaternion() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        return Quaternion(intrinsic::_v_matrix_to_quat_ps(src));
+    }
+
+    //! Return the first three rows as an affine transform. The last row must
+    //! be { 0, 0, 0, 1 }.
+    AffineMatrix VECTORCALL ToAffineMatrix() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        __m128 dst[4];
+        intrinsic::_v_transpose_ps(src, dst);
+        return AffineMatrix(dst[0], dst[1], dst[2]);
+    }
+
+protected:
+    Vector x, y, z, w;
+
+protected:
+    //! Construct from pairs of column vectors
+    Matrix(__m256 const& XY, __m256 const& ZW)
+        : x(_mm256_castps256_ps128(XY))
+        , y(_mm256_extractf128_ps(XY, 1))
+        , z(_mm256_castps256_ps128(ZW))
+        , w(_mm256_extractf128_ps(ZW, 1)) {}
+
+    //! Load the first pair of column vectors.
+    __m256 VECTORCALL XY() const {
+        return _mm256_loadu_ps(reinterpret_cast<float const*>(&x));
+    }
+
+    //! Load the second pair of column vectors.
+    __m256 VECTORCALL ZW() const {
+        return _mm256_loadu_ps(reinterpret_cast<float const*>(&z));
+    }
+
+    //! Multiply this matrix by a pair of column vectors.
+    __m256 VECTORCALL Product(__m256 const& v) const {
+        //  Broadcast each column into both halves of a register. The element
+        //  of the pair of vectors `v` which scales each column is broadcast
+        //  within each half so that both products are computed at once.
+        auto c0 = _v_dup_ps(x._value);
+        auto c1 = _v_dup_ps(y._value);
+        auto c2 = _v_dup_ps(z._value);
+        auto c3 = _v_dup_ps(w._value);
+
+        auto r1 = _mm256_mul_ps(c0, _mm256_permute_ps(v, 0x00));
+        auto r2 = _mm256_mul_ps(c1, _mm256_permute_ps(v, 0x55));
+        r1 = _v_fmadd_ps(c2, _mm256_permute_ps(v, 0xaa), r1);
+        r2 = _v_fmadd_ps(c3, _mm256_permute_ps(v, 0xff), r2);
+        return _mm256_add_ps(r1, r2);
+    }
+};
+
+static_assert(alignof(Matrix) == alignof(__m128), "Bad alignment!");
+
+} // namespace avx
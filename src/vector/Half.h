@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Conversion between single precision and IEEE 754 half precision, which has
+ * 1 sign bit, 5 exponent bits and 10 mantissa bits. Conversion to half
+ * precision rounds to nearest even, the same as `_mm_cvtps_ph` with
+ * `_MM_FROUND_TO_NEAREST_INT`, so that implementations with and without F16C
+ * produce the same results. These are used by the `reference` implementation
+ * and by the other implementations when F16C is not available.
+ */
+
+//! Convert `f` to half precision, rounding to nearest even. Values too large
+//! for half precision are converted to infinity and NaNs remain NaNs.
+inline uint16_t FloatToHalf(float f)
+{
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+
+    uint16_t sign = uint16_t((x >> 16) & 0x8000);
+    x &= 0x7fffffff;
+
+    // infinity and quiet NaN, keeping the upper bits of the payload
+    if (x >= 0x7f800000) {
+        return uint16_t(sign | 0x7c00 | (x > 0x7f800000 ? 0x0200 | ((x >> 13) & 0x03ff) : 0));
+    }
+
+    // 65520 and above rounds to infinity
+    if (x >= 0x477ff000) {
+        return uint16_t(sign | 0x7c00);
+    }
+
+    // 2^-25 and below rounds to zero
+    if (x <= 0x33000000) {
+        return sign;
+    }
+
+    uint32_t h, rem, half;
+
+    if (x < 0x38800000) {
+        // subnormal, the implicit leading bit is shifted into the mantissa
+        uint32_t shift = 126 - (x >> 23);
+        uint32_t m = (x & 0x007fffff) | 0x00800000;
+        h = m >> shift;
+        rem = m & ((1u << shift) - 1);
+        half = 1u << (shift - 1);
+    } else {
+        // normal, rebias the exponent from 127 to 15
+        h = (x - 0x38000000) >> 13;
+        rem = x & 0x1fff;
+        half = 0x1000;
+    }
+
+    // a carry out of the mantissa correctly increments the exponent
+    h += (rem > half || (rem == half && (h & 1))) ? 1 : 0;
+    return uint16_t(sign | h);
+}
+
+//! Convert the half precision value `h` to single precision, which is exact.
+inline float HalfToFloat(uint16_t h)
+{
+    uint32_t sign = uint32_t(h & 0x8000) << 16;
+    uint32_t e = (h >> 10) & 0x1f;
+    uint32_t m = h & 0x03ff;
+    uint32_t x;
+
+    if (e == 0x1f) {
+        // infinity and quiet NaN
+        x = sign | 0x7f800000 | (m << 13) | (m ? 0x00400000 : 0);
+    } else if (e) {
+        x = sign | ((e + 112) << 23) | (m << 13);
+    } else if (m) {
+        // subnormal, normalize the mantissa
+        e = 113;
+        while (!(m & 0x0400)) {
+            m <<= 1;
+            --e;
+        }
+        x = sign | (e << 23) | ((m & 0x03ff) << 13);
+    } else {
+        x = sign;
+    }
+
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
@@ -1,5 +1,11 @@
 #pragma once
 
+#include "Mask.h"
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
 template<typename V, typename S>
 struct Ray {
     V start;
@@ -26,10 +32,95 @@ struct Hit {
     S t;
 };
 
+//! Result of comparing two `S`, i.e. `bool` or a mask type.
+template<typename S>
+using MaskOf = decltype(S() < S());
+
+//! Floating point type of the elements of `S`, which is `S::value_type` for
+//! implementations which declare it, e.g. `intrinsic_d`, and `float` otherwise.
+template<typename S, typename = void>
+struct ValueType {
+    using type = float;
+};
+
+template<typename S>
+struct ValueType<S, typename std::conditional<true, void, typename S::value_type>::type> {
+    using type = typename S::value_type;
+};
+
+//! Find the real roots `t0 <= t1` of `A t^2 + B t + C = 0` for `A` not zero,
+//! where the result is set. The root of smaller magnitude is computed as
+//! `2C / (-B -+ sqrt(B^2 - 4AC))` instead of `(-B +- sqrt(B^2 - 4AC)) / 2A`,
+//! which avoids the cancellation between `B` and the square root when `4AC`
+//! is small, e.g. for rays which start on a surface, and both roots share a
+//! single division. `S` can be any scalar type, including packets.
+template<typename S>
+inline MaskOf<S> solveQuadratic(S const& A, S const& B, S const& C, S& t0, S& t1)
+{
+    // Scalar types other than `float` provide overloads found by argument-
+    // dependent lookup, `float` must not bind to the integer `abs`.
+    using std::abs;
+    using std::sqrt;
+
+    S Dsqr = B * B - 4.0f * A * C;
+
+    // The roots are not used if the discriminant is negative.
+    S D = sqrt(abs(Dsqr));
+
+    //  q = -(B + sign(B) * D) / 2, the roots are q / A and C / q
+    S q = -0.5f * (B + Select(B < 0.0f, S(-D), D));
+    S r = 1.0f / (A * q);
+
+    //  Both roots are zero if `q` is, i.e. if `B` and `C` are zero.
+    MaskOf<S> zero = q == 0.0f;
+    S r0 = Select(zero, S(0.0f), S(q * q * r));
+    S r1 = Select(zero, S(0.0f), S(A * C * r));
+
+    MaskOf<S> ordered = r0 < r1;
+    t0 = Select(ordered, r0, r1);
+    t1 = Select(ordered, r1, r0);
+    return Dsqr >= 0.0f;
+}
+
+//! Solve `count` quadratics with coefficients in consecutive elements of `A`,
+//! `B` and `C` with `solveQuadratic`, `S::kWidth` at a time for a packet type
+//! `S`, e.g. `intrinsic::ScalarPacket8`. The roots are stored in `t0` and `t1`
+//! and `valid` is set for each quadratic with real roots, the roots of the
+//! others are unspecified.
+template<typename S>
+inline void solveQuadratics(float const* A, float const* B, float const* C, float* t0, float* t1, bool* valid, size_t count)
+{
+    constexpr size_t N = S::kWidth;
+
+    size_t ii = 0;
+    for (; ii + N <= count; ii += N) {
+        S r0, r1;
+        int bits = solveQuadratic(S(A + ii), S(B + ii), S(C + ii), r0, r1).Bits();
+        r0.Store(t0 + ii);
+        r1.Store(t1 + ii);
+        for (size_t jj = 0; jj < N; ++jj) {
+            valid[ii + jj] = (bits >> jj) & 1;
+        }
+    }
+    for (; ii < count; ++ii) {
+        valid[ii] = solveQuadratic<float>(A[ii], B[ii], C[ii], t0[ii], t1[ii]);
+    }
+}
+
+//
+//  Intersection is split into two phases. The `intersect` functions only find
+//  the fraction along the ray of the first intersection at or before `tmax`,
+//  which is all that is needed to find the nearest of many primitives. The
+//  `hit` functions then compute the point and normal for the nearest only.
+//
+
+//! Find the fraction `t` in [0, tmax] of the first intersection of `ray` with
+//! `sphere`, if any.
 template<typename V, typename S>
-bool hitSphere(Ray<V, S> const& ray,
-               Sphere<V, S> const& sphere,
-               Hit<V, S>& hit)
+inline bool intersectSphere(Ray<V, S> const& ray,
+                     Sphere<V, S> const& sphere,
+                     S const& tmax,
+                     S& t)
 {
     V rayVec = ray.end - ray.start;
     V sphereVec = ray.start - sphere.origin;
@@ -38,35 +129,64 @@ bool hitSphere(Ray<V, S> const& ray,
     S B = 2.0f * rayVec * sphereVec;
     S C = sphereVec * sphereVec - sphere.radius * sphere.radius;
 
-    S Dsqr = B * B - 4.0f * A * C;
+    S t0, t1;
 
-    if (Dsqr < 0.0f) {
+    if (None(solveQuadratic(A, B, C, t0, t1))) {
         return false;
     }
 
-    S D = sqrt(Dsqr);
+    if (t0 >= 0.0f && t0 <= tmax) {
+        t = t0;
+    } else if (t1 >= 0.0f && t1 <= tmax) {
+        t = t1;
+    } else {
+        return false;
+    }
 
-    S t0 = 0.5f * (-B - D) / A;
-    S t1 = 0.5f * (-B + D) / A;
+    return true;
+}
 
-    if (t0 >= 0.0f && t0 <= 1.0f) {
-        hit.t = t0;
-    } else if (t1 >= 0.0f && t1 <= 1.0f) {
-        hit.t = t1;
-    } else {
+//! Compute the hit point and normal for an intersection of `ray` with `sphere`
+//! at fraction `t` found by `intersectSphere`. The normal faces the ray origin,
+//! i.e. it points inward if the ray starts inside of the sphere.
+template<typename V, typename S>
+inline void hitSphere(Ray<V, S> const& ray,
+               Sphere<V, S> const& sphere,
+               S const& t,
+               Hit<V, S>& hit)
+{
+    V sphereVec = ray.start - sphere.origin;
+    auto inside = sphereVec * sphereVec < sphere.radius * sphere.radius;
+
+    hit.t = t;
+    hit.point = ray.start + (ray.end - ray.start) * t;
+
+    V normal = hit.point - sphere.origin;
+    hit.normal = Select(inside, V(-normal), normal).Normalize();
+}
+
+template<typename V, typename S>
+inline bool hitSphere(Ray<V, S> const& ray,
+               Sphere<V, S> const& sphere,
+               Hit<V, S>& hit)
+{
+    S t;
+
+    if (!intersectSphere(ray, sphere, S(1.0f), t)) {
         return false;
     }
 
-    hit.point = ray.start + rayVec * t0;
-    hit.normal = t0 >= 0.0f ? V(hit.point - sphere.origin).Normalize()
-                            : V(sphere.origin - hit.point).Normalize();
+    hitSphere(ray, sphere, t, hit);
     return true;
 }
 
+//! Find the fraction `t` in [0, tmax] of the first intersection of `ray` with
+//! `capsule`, if any.
 template<typename V, typename S>
-bool hitCapsule(Ray<V, S> const& ray,
-                Capsule<V, S> const& capsule,
-                Hit<V, S>& hit)
+inline bool intersectCapsule(Ray<V, S> const& ray,
+                      Capsule<V, S> const& capsule,
+                      S const& tmax,
+                      S& t)
 {
     V rayVec = ray.end - ray.start;
     V capsuleVec = capsule.end - capsule.start;
@@ -78,31 +198,240 @@ bool hitCapsule(Ray<V, S> const& ray,
     S B = 2.0f * projVec * capsuleOffset;
     S C = capsuleOffset * capsuleOffset - capsule.radius * capsule.radius;
 
-    S Dsqr = B * B - 4.0f * A * C;
+    S t0, t1;
 
-    if (Dsqr < 0.0f) {
+    if (None(solveQuadratic(A, B, C, t0, t1))) {
         return false;
     }
 
-    S D = sqrt(Dsqr);
-
-    S t0 = 0.5f * (-B - D) / A;
-    S t1 = 0.5f * (-B + D) / A;
-
-    S t = t0 >= 0.0f ? t0 : t1;
-    V hitPoint = ray.start + rayVec * t;
+    S tc = t0 >= 0.0f ? t0 : t1;
+    V hitPoint = ray.start + rayVec * tc;
 
     if (capsuleVec * (hitPoint - capsule.end) > 0.0f) {
-        return hitSphere(ray, {capsule.end, capsule.radius}, hit);
+        return intersectSphere(ray, {capsule.end, capsule.radius}, tmax, t);
     } else if (capsuleVec * (hitPoint - capsule.start) < 0.0f) {
-        return hitSphere(ray, {capsule.start, capsule.radius}, hit);
-    } else if (t < 0.0f || t > 1.0f) {
+        return intersectSphere(ray, {capsule.start, capsule.radius}, tmax, t);
+    } else if (tc < 0.0f || tc > tmax) {
         return false;
     }
 
+    t = tc;
+    return true;
+}
+
+//! Compute the hit point and normal for an intersection of `ray` with `capsule`
+//! at fraction `t` found by `intersectCapsule`. The normal faces the ray origin,
+//! i.e. it points inward if the ray starts inside of the capsule.
+template<typename V, typename S>
+inline void hitCapsule(Ray<V, S> const& ray,
+                Capsule<V, S> const& capsule,
+                S const& t,
+                Hit<V, S>& hit)
+{
+    V capsuleVec = capsule.end - capsule.start;
+    S capsuleLengthSqr = capsuleVec * capsuleVec;
+
+    // Nearest point on the capsule axis to `point`.
+    auto axisPoint = [&](V const& point) -> V {
+        S s = capsuleVec * (point - capsule.start) / capsuleLengthSqr;
+        s = Select(s < 0.0f, S(0.0f), s);
+        s = Select(s > 1.0f, S(1.0f), s);
+        return V(capsule.start + capsuleVec * s);
+    };
+
+    V startVec = ray.start - axisPoint(ray.start);
+    auto inside = startVec * startVec < capsule.radius * capsule.radius;
+
     hit.t = t;
-    hit.point = hitPoint;
-    hit.normal = t0 >= 0.0f ? capsuleVec.Reject(hitPoint - capsule.start).Normalize()
-                            : capsuleVec.Reject(capsule.start - hitPoint).Normalize();
+    hit.point = ray.start + (ray.end - ray.start) * t;
+
+    V normal = hit.point - axisPoint(hit.point);
+    hit.normal = Select(inside, V(-normal), normal).Normalize();
+}
+
+template<typename V, typename S>
+inline bool hitCapsule(Ray<V, S> const& ray,
+                Capsule<V, S> const& capsule,
+                Hit<V, S>& hit)
+{
+    S t;
+
+    if (!intersectCapsule(ray, capsule, S(1.0f), t)) {
+        return false;
+    }
+
+    hitCapsule(ray, capsule, t, hit);
     return true;
 }
+
+//! Find the nearest of `count` spheres intersected by `ray` at a fraction in
+//! [0, t). On input `t` is the maximum fraction; if an intersection is found
+//! `t` and `index` are updated with its fraction and the index of the sphere.
+//! `T` can be any type derived from `Sphere<V, S>`.
+template<typename V, typename S, typename T>
+inline bool intersectSpheres(Ray<V, S> const& ray,
+                      T const* spheres,
+                      size_t count,
+                      S& t,
+                      size_t& index)
+{
+    bool result = false;
+
+    for (size_t ii = 0; ii < count; ++ii) {
+        S tt;
+
+        if (intersectSphere<V, S>(ray, spheres[ii], t, tt) && tt < t) {
+            t = tt;
+            index = ii;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+//! Find the nearest of `count` capsules intersected by `ray` at a fraction in
+//! [0, t). Same semantics as `intersectSpheres`.
+template<typename V, typename S, typename T>
+inline bool intersectCapsules(Ray<V, S> const& ray,
+                       T const* capsules,
+                       size_t count,
+                       S& t,
+                       size_t& index)
+{
+    bool result = false;
+
+    for (size_t ii = 0; ii < count; ++ii) {
+        S tt;
+
+        if (intersectCapsule<V, S>(ray, capsules[ii], t, tt) && tt < t) {
+            t = tt;
+            index = ii;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+//
+//  Branchless variants of the intersection functions evaluate every case and
+//  combine the results with `Select`, returning the comparison mask of `S`
+//  instead of `bool`. They return the same results as the functions above but
+//  avoid mispredicted branches when hits and misses are unpredictable, e.g. for
+//  incoherent rays, at the cost of always computing every case.
+//
+
+//! Branchless `intersectSphere`, `t` is only modified where the result is set.
+template<typename V, typename S>
+inline MaskOf<S> intersectSphereBranchless(Ray<V, S> const& ray,
+                                          Sphere<V, S> const& sphere,
+                                          S const& tmax,
+                                          S& t)
+{
+    V rayVec = ray.end - ray.start;
+    V sphereVec = ray.start - sphere.origin;
+
+    S A = rayVec * rayVec;
+    S B = 2.0f * rayVec * sphereVec;
+    S C = sphereVec * sphereVec - sphere.radius * sphere.radius;
+
+    S t0, t1;
+    MaskOf<S> real = solveQuadratic(A, B, C, t0, t1);
+
+    MaskOf<S> t0_valid = (t0 >= 0.0f) & (t0 <= tmax);
+    MaskOf<S> t1_valid = (t1 >= 0.0f) & (t1 <= tmax);
+    MaskOf<S> result = real & (t0_valid | t1_valid);
+
+    t = Select(result, Select(t0_valid, t0, t1), t);
+    return result;
+}
+
+//! Branchless `intersectCapsule`, `t` is only modified where the result is set.
+template<typename V, typename S>
+inline MaskOf<S> intersectCapsuleBranchless(Ray<V, S> const& ray,
+                                           Capsule<V, S> const& capsule,
+                                           S const& tmax,
+                                           S& t)
+{
+    V rayVec = ray.end - ray.start;
+    V capsuleVec = capsule.end - capsule.start;
+
+    V projVec = capsuleVec.Reject(rayVec);
+    V capsuleOffset = capsuleVec.Reject(ray.start - capsule.start);
+
+    S A = projVec * projVec;
+    S B = 2.0f * projVec * capsuleOffset;
+    S C = capsuleOffset * capsuleOffset - capsule.radius * capsule.radius;
+
+    S t0, t1;
+    MaskOf<S> real = solveQuadratic(A, B, C, t0, t1);
+
+    S tc = Select(t0 >= 0.0f, t0, t1);
+    V hitPoint = ray.start + rayVec * tc;
+
+    // Intersect both end caps and the cylinder, then keep the one which
+    // contains the intersection with the infinite cylinder.
+    S tend = tmax, tstart = tmax;
+    MaskOf<S> end_valid = intersectSphereBranchless<V, S>(ray, {capsule.end, capsule.radius}, tmax, tend);
+    MaskOf<S> start_valid = intersectSphereBranchless<V, S>(ray, {capsule.start, capsule.radius}, tmax, tstart);
+    MaskOf<S> tc_valid = (tc >= 0.0f) & (tc <= tmax);
+
+    MaskOf<S> past_end = capsuleVec * (hitPoint - capsule.end) > 0.0f;
+    MaskOf<S> before_start = capsuleVec * (hitPoint - capsule.start) < 0.0f;
+
+    MaskOf<S> result = real & Select(past_end, end_valid,
+                                            Select(before_start, start_valid, tc_valid));
+    S tt = Select(past_end, tend, Select(before_start, tstart, tc));
+
+    t = Select(result, tt, t);
+    return result;
+}
+
+//! Branchless `intersectSpheres`, only the loop over spheres has a branch.
+template<typename V, typename S, typename T>
+inline bool intersectSpheresBranchless(Ray<V, S> const& ray,
+                                       T const* spheres,
+                                       size_t count,
+                                       S& t,
+                                       size_t& index)
+{
+    bool result = false;
+
+    for (size_t ii = 0; ii < count; ++ii) {
+        S tt = t;
+        auto mask = intersectSphereBranchless<V, S>(ray, spheres[ii], t, tt);
+        mask = mask & (tt < t);
+
+        bool any = Any(mask);
+        t = Select(mask, tt, t);
+        index = any ? ii : index;
+        result |= any;
+    }
+
+    return result;
+}
+
+//! Branchless `intersectCapsules`, only the loop over capsules has a branch.
+template<typename V, typename S, typename T>
+inline bool intersectCapsulesBranchless(Ray<V, S> const& ray,
+                                        T const* capsules,
+                                        size_t count,
+                                        S& t,
+                                        size_t& index)
+{
+    bool result = false;
+
+    for (size_t ii = 0; ii < count; ++ii) {
+        S tt = t;
+        auto mask = intersectCapsuleBranchless<V, S>(ray, capsules[ii], t, tt);
+        mask = mask & (tt < t);
+
+        bool any = Any(mask);
+        t = Select(mask, tt, t);
+        index = any ? ii : index;
+        result |= any;
+    }
+
+    return result;
+}
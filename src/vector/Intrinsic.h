@@ -2,8 +2,11 @@
 
 #include "Features.h"
 #include "Platform.h"
+#include "Half.h"
+#include "Transcendental.h"
 
 #include <cassert>
+#include <cmath>
 
 #include <xmmintrin.h>
 #include <smmintrin.h>
@@ -22,6 +25,10 @@
  * elements' or 'low bits'.
  */
 
+namespace avx {
+class Matrix;
+} // namespace avx
+
 namespace intrinsic {
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -52,10 +59,111 @@ inline __m128 VECTORCALL _v_blend_ps(__m128 src0, __m128 src1)
 #if _HAS_SSE4_1
     return _mm_blend_ps(src0, src1, ((W << 3) | (Z << 2) | (Y << 1) | (X << 0)));
 #else
-    static_assert(/*false*/X & ~X, "_mm_blend_ps is not available on this architecture!");
+    __m128 mask = _mm_castsi128_ps(_mm_set_epi32(-int(W), -int(Z), -int(Y), -int(X)));
+    return _mm_or_ps(_mm_and_ps(mask, src1), _mm_andnot_ps(mask, src0));
 #endif
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Select elements of `src0` and `src1` based on `mask`. Each element of `mask`
+//! must be either all ones or all zeros, i.e. the result of a packed compare.
+//!     dst[i] = mask[i] ? src1[i] : src0[i]
+inline __m128 VECTORCALL _v_blendv_ps(__m128 src0, __m128 src1, __m128 mask)
+{
+#if _HAS_SSE4_1
+    return _mm_blendv_ps(src0, src1, mask);
+#else
+    return _mm_or_ps(_mm_and_ps(mask, src1), _mm_andnot_ps(mask, src0));
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Broadcast element `I` of `src` to each element.
+template<int I>
+inline __m128 VECTORCALL _v_extract_ps(__m128 src)
+{
+    return _v_shuffle_ps<I, I, I, I>(src, src);
+}
+
+//! Replace element `I` of `dst` with element `I` of `src`, e.g. a broadcast
+//! scalar value.
+template<int I>
+inline __m128 VECTORCALL _v_insert_ps(__m128 dst, __m128 src);
+
+template<>
+inline __m128 VECTORCALL _v_insert_ps<0>(__m128 dst, __m128 src)
+{
+#if _HAS_SSE4_1
+    return _v_blend_ps<0, 0, 0, 1>(dst, src);
+#else
+    //  y       x       s       s
+    auto r1 = _mm_movelh_ps(src, dst);
+    //  w       z       y       s
+    return _v_shuffle_ps<3, 2, 3, 0>(r1, dst);
+#endif
+}
+
+template<>
+inline __m128 VECTORCALL _v_insert_ps<1>(__m128 dst, __m128 src)
+{
+#if _HAS_SSE4_1
+    return _v_blend_ps<0, 0, 1, 0>(dst, src);
+#else
+    //  y       x       s       s
+    auto r1 = _mm_movelh_ps(src, dst);
+    //  w       z       s       x
+    return _v_shuffle_ps<3, 2, 1, 2>(r1, dst);
+#endif
+}
+
+template<>
+inline __m128 VECTORCALL _v_insert_ps<2>(__m128 dst, __m128 src)
+{
+#if _HAS_SSE4_1
+    return _v_blend_ps<0, 1, 0, 0>(dst, src);
+#else
+    //  s       s       w       z
+    auto r1 = _mm_movehl_ps(src, dst);
+    //  w       s       y       x
+    return _v_shuffle_ps<1, 2, 1, 0>(dst, r1);
+#endif
+}
+
+template<>
+inline __m128 VECTORCALL _v_insert_ps<3>(__m128 dst, __m128 src)
+{
+#if _HAS_SSE4_1
+    return _v_blend_ps<1, 0, 0, 0>(dst, src);
+#else
+    //  s       s       w       z
+    auto r1 = _mm_movehl_ps(src, dst);
+    //  s       z       y       x
+    return _v_shuffle_ps<3, 0, 1, 0>(dst, r1);
+#endif
+}
+
+//! Broadcast element `index` of `src` to each element. Selects with a single
+//! variable permute if available, otherwise reloads the element from memory,
+//! which is forwarded from the store and avoids branching on `index`.
+inline __m128 VECTORCALL _v_extract_ps(__m128 src, size_t index)
+{
+#if _HAS_AVX
+    return _mm_permutevar_ps(src, _mm_set1_epi32(int(index)));
+#else
+    alignas(16) float f[4];
+    _mm_store_ps(f, src);
+    return _mm_load1_ps(f + index);
+#endif
+}
+
+//! Replace element `index` of `dst` with element `index` of `src`, without
+//! branching on `index`.
+inline __m128 VECTORCALL _v_insert_ps(__m128 dst, __m128 src, size_t index)
+{
+    auto mask = _mm_cmpeq_epi32(_mm_set1_epi32(int(index)), _mm_set_epi32(3, 2, 1, 0));
+    return _v_blendv_ps(dst, src, _mm_castsi128_ps(mask));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Dot product of `src0` and `src1`. Returns the scalar value broadcasted to
 //! each register element. Multiple implementations based on platform features.
@@ -84,18 +192,942 @@ inline __m128 VECTORCALL _v_dp_ps(__m128 src0, __m128 src1)
 #endif
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Multiply and add, fused if available.
+//!     dst[127:0] = src0[127:0] * src1[127:0] + src2[127:0]
+inline __m128 VECTORCALL _v_fmadd_ps(__m128 src0, __m128 src1, __m128 src2)
+{
+#if _HAS_FMA
+    return _mm_fmadd_ps(src0, src1, src2);
+#else
+    return _mm_add_ps(_mm_mul_ps(src0, src1), src2);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Multiply and subtract, fused if available.
+//!     dst[127:0] = src0[127:0] * src1[127:0] - src2[127:0]
+inline __m128 VECTORCALL _v_fmsub_ps(__m128 src0, __m128 src1, __m128 src2)
+{
+#if _HAS_FMA
+    return _mm_fmsub_ps(src0, src1, src2);
+#else
+    return _mm_sub_ps(_mm_mul_ps(src0, src1), src2);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Negated multiply and add, fused if available.
+//!     dst[127:0] = src2[127:0] - src0[127:0] * src1[127:0]
+inline __m128 VECTORCALL _v_fnmadd_ps(__m128 src0, __m128 src1, __m128 src2)
+{
+#if _HAS_FMA
+    return _mm_fnmadd_ps(src0, src1, src2);
+#else
+    return _mm_sub_ps(src2, _mm_mul_ps(src0, src1));
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Products of 2x2 matrices stored in a single register in row-major order,
+//  i.e. { m22, m21, m12, m11 }, used by `_v_inverse_ps`. The adjugate of a 2x2
+//  matrix A is written A#, i.e. { m11, -m21, -m12, m22 }.
+
+//! dst = src0 * src1
+inline __m128 VECTORCALL _v_mat2mul_ps(__m128 src0, __m128 src1)
+{
+    auto r1 = _mm_mul_ps(src0, _v_shuffle_ps<3, 0, 3, 0>(src1, src1));
+    auto r2 = _mm_mul_ps(_v_shuffle_ps<2, 3, 0, 1>(src0, src0),
+                         _v_shuffle_ps<1, 2, 1, 2>(src1, src1));
+    return _mm_add_ps(r1, r2);
+}
+
+//! dst = src0# * src1
+inline __m128 VECTORCALL _v_mat2adjmul_ps(__m128 src0, __m128 src1)
+{
+    auto r1 = _mm_mul_ps(_v_shuffle_ps<0, 0, 3, 3>(src0, src0), src1);
+    auto r2 = _mm_mul_ps(_v_shuffle_ps<2, 2, 1, 1>(src0, src0),
+                         _v_shuffle_ps<1, 0, 3, 2>(src1, src1));
+    return _mm_sub_ps(r1, r2);
+}
+
+//! dst = src0 * src1#
+inline __m128 VECTORCALL _v_mat2muladj_ps(__m128 src0, __m128 src1)
+{
+    auto r1 = _mm_mul_ps(src0, _v_shuffle_ps<0, 3, 0, 3>(src1, src1));
+    auto r2 = _mm_mul_ps(_v_shuffle_ps<2, 3, 0, 1>(src0, src0),
+                         _v_shuffle_ps<1, 2, 1, 2>(src1, src1));
+    return _mm_sub_ps(r1, r2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Determinants of the four 2x2 blocks of the 4x4 matrix with columns `src`.
+//!     dst[127:0] = { |D|, |C|, |B|, |A| }
+//! where A and D are the upper left and lower right blocks. Blocks B and C are
+//! transposed relative to the matrix, which does not change the determinant.
+inline __m128 VECTORCALL _v_det2_ps(__m128 const (&src)[4])
+{
+    auto r1 = _mm_mul_ps(_v_shuffle_ps<2, 0, 2, 0>(src[0], src[2]),
+                         _v_shuffle_ps<3, 1, 3, 1>(src[1], src[3]));
+    auto r2 = _mm_mul_ps(_v_shuffle_ps<3, 1, 3, 1>(src[0], src[2]),
+                         _v_shuffle_ps<2, 0, 2, 0>(src[1], src[3]));
+    return _mm_sub_ps(r1, r2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Inverse of the 4x4 matrix with columns `src` by blockwise inversion with
+//! 2x2 adjugates, which is valid for any invertible matrix. Returns the
+//! determinant broadcast to each element. The inverse of the transpose is the
+//! transpose of the inverse, so the algorithm is the same for columns or rows.
+inline __m128 VECTORCALL _v_inverse_ps(__m128 const (&src)[4], __m128 (&dst)[4])
+{
+    //  Treat each column as a row of the matrix M = | A  B |
+    //                                               | C  D |
+    auto A = _mm_movelh_ps(src[0], src[1]);
+    auto B = _mm_movehl_ps(src[1], src[0]);
+    auto C = _mm_movelh_ps(src[2], src[3]);
+    auto D = _mm_movehl_ps(src[3], src[2]);
+
+    auto det = _v_det2_ps(src);
+    auto detA = _v_shuffle_ps<0, 0, 0, 0>(det, det);
+    auto detB = _v_shuffle_ps<1, 1, 1, 1>(det, det);
+    auto detC = _v_shuffle_ps<2, 2, 2, 2>(det, det);
+    auto detD = _v_shuffle_ps<3, 3, 3, 3>(det, det);
+
+    auto D_C = _v_mat2adjmul_ps(D, C);
+    auto A_B = _v_mat2adjmul_ps(A, B);
+
+    //  inverse(M) = 1/|M| * | X#  Y# |
+    //                       | Z#  W# |
+    auto X_ = _mm_sub_ps(_mm_mul_ps(detD, A), _v_mat2mul_ps(B, D_C));
+    auto W_ = _mm_sub_ps(_mm_mul_ps(detA, D), _v_mat2mul_ps(C, A_B));
+    auto Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), _v_mat2muladj_ps(D, A_B));
+    auto Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), _v_mat2muladj_ps(A, D_C));
+
+    //  |M| = |A|*|D| + |B|*|C| - tr((A#B)(D#C))
+    auto tr = _v_dp_ps(A_B, _v_shuffle_ps<3, 1, 2, 0>(D_C, D_C));
+    auto detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+    detM = _mm_sub_ps(detM, tr);
+
+    //  Signs of the adjugate are applied with the reciprocal of |M|.
+    auto rdetM = _mm_div_ps(_mm_set_ps(1.f, -1.f, -1.f, 1.f), detM);
+
+    X_ = _mm_mul_ps(X_, rdetM);
+    Y_ = _mm_mul_ps(Y_, rdetM);
+    Z_ = _mm_mul_ps(Z_, rdetM);
+    W_ = _mm_mul_ps(W_, rdetM);
+
+    //  Transpose each adjugate block into the columns of the result.
+    dst[0] = _v_shuffle_ps<1, 3, 1, 3>(X_, Y_);
+    dst[1] = _v_shuffle_ps<0, 2, 0, 2>(X_, Y_);
+    dst[2] = _v_shuffle_ps<1, 3, 1, 3>(Z_, W_);
+    dst[3] = _v_shuffle_ps<0, 2, 0, 2>(Z_, W_);
+
+    return detM;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Determinant of the 4x4 matrix with columns `src` broadcast to each element,
+//! computed the same way as in `_v_inverse_ps`.
+inline __m128 VECTORCALL _v_determinant_ps(__m128 const (&src)[4])
+{
+    auto A = _mm_movelh_ps(src[0], src[1]);
+    auto B = _mm_movehl_ps(src[1], src[0]);
+    auto C = _mm_movelh_ps(src[2], src[3]);
+    auto D = _mm_movehl_ps(src[3], src[2]);
+
+    auto det = _v_det2_ps(src);
+    //  |B|*|C|             |A|*|D|
+    auto r1 = _mm_mul_ps(_v_shuffle_ps<1, 1, 1, 1>(det, det), _v_shuffle_ps<2, 2, 2, 2>(det, det));
+    auto r2 = _mm_mul_ps(_v_shuffle_ps<0, 0, 0, 0>(det, det), _v_shuffle_ps<3, 3, 3, 3>(det, det));
+
+    auto D_C = _v_mat2adjmul_ps(D, C);
+    auto A_B = _v_mat2adjmul_ps(A, B);
+    auto tr = _v_dp_ps(A_B, _v_shuffle_ps<3, 1, 2, 0>(D_C, D_C));
+
+    return _mm_sub_ps(_mm_add_ps(r2, r1), tr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Inverse of the affine 4x4 matrix with columns `src`, whose last row must be
+//! { 0, 0, 0, 1 } and whose upper 3x3 block must have orthogonal columns, i.e.
+//! a rotation with scale but without shear, followed by a translation. The
+//! inverse of the 3x3 block is its transpose divided by the squared scales.
+inline void VECTORCALL _v_inverse_affine_ps(__m128 const (&src)[4], __m128 (&dst)[4])
+{
+    //  m22     m12     m21     m11
+    auto t0 = _mm_movelh_ps(src[0], src[1]);
+    //  0       m32     0       m31
+    auto t1 = _mm_movehl_ps(src[1], src[0]);
+
+    //  0       m13     m12     m11
+    auto r0 = _v_shuffle_ps<3, 0, 2, 0>(t0, src[2]);
+    //  0       m23     m22     m21
+    auto r1 = _v_shuffle_ps<3, 1, 3, 1>(t0, src[2]);
+    //  0       m33     m32     m31
+    auto r2 = _v_shuffle_ps<3, 2, 2, 0>(t1, src[2]);
+
+    //  Squared length of each column of the 3x3 block. The last element is
+    //  replaced with one so that the last row of the result remains zero.
+    auto lsqr = _mm_mul_ps(r0, r0);
+    lsqr = _v_fmadd_ps(r1, r1, lsqr);
+    lsqr = _v_fmadd_ps(r2, r2, lsqr);
+    lsqr = _v_blend_ps<1, 0, 0, 0>(lsqr, _mm_set_ps1(1.f));
+    auto rlsqr = _mm_div_ps(_mm_set_ps1(1.f), lsqr);
+
+    r0 = _mm_mul_ps(r0, rlsqr);
+    r1 = _mm_mul_ps(r1, rlsqr);
+    r2 = _mm_mul_ps(r2, rlsqr);
+
+    //  Translation is the negated translation in the inverted basis.
+    auto t = src[3];
+    auto r3 = _mm_mul_ps(r0, _v_shuffle_ps<0, 0, 0, 0>(t, t));
+    r3 = _v_fmadd_ps(r1, _v_shuffle_ps<1, 1, 1, 1>(t, t), r3);
+    r3 = _v_fmadd_ps(r2, _v_shuffle_ps<2, 2, 2, 2>(t, t), r3);
+
+    dst[0] = r0;
+    dst[1] = r1;
+    dst[2] = r2;
+    dst[3] = _mm_sub_ps(_mm_set_ps(1.f, 0.f, 0.f, 0.f), r3);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Quaternions are stored as { w, z, y, x } where w is the real part, i.e. the
+//  imaginary part is in the same elements as the xyz components of a vector.
+
+//! Cross product in R3, the last element of the result is zero.
+inline __m128 VECTORCALL _v_cross_ps(__m128 src0, __m128 src1)
+{
+    //  w0*w1   x0*z1   z0*y1   y0*x1
+    auto r1 = _mm_mul_ps(src0, _v_shuffle_ps<3, 0, 2, 1>(src1, src1));
+    //  w0*w1   x0*z1 - z0*x1   z0*y1 - y0*z1   y0*x1 - x0*y1
+    auto r2 = _v_fnmadd_ps(_v_shuffle_ps<3, 0, 2, 1>(src0, src0), src1, r1);
+
+    return _v_shuffle_ps<3, 0, 2, 1>(r2, r2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Hamilton product of the quaternions `src0` and `src1`.
+inline __m128 VECTORCALL _v_quat_mul_ps(__m128 src0, __m128 src1)
+{
+    //  w1      z1      y1      x1      * w0
+    auto r1 = _mm_mul_ps(_v_shuffle_ps<3, 3, 3, 3>(src0, src0), src1);
+    //  -x1     y1      -z1     w1      * x0
+    auto r2 = _mm_xor_ps(_v_shuffle_ps<0, 1, 2, 3>(src1, src1), _mm_set_ps(-0.f, 0.f, -0.f, 0.f));
+    r1 = _v_fmadd_ps(_v_shuffle_ps<0, 0, 0, 0>(src0, src0), r2, r1);
+    //  -y1     -x1     w1      z1      * y0
+    auto r3 = _mm_xor_ps(_v_shuffle_ps<1, 0, 3, 2>(src1, src1), _mm_set_ps(-0.f, -0.f, 0.f, 0.f));
+    r1 = _v_fmadd_ps(_v_shuffle_ps<1, 1, 1, 1>(src0, src0), r3, r1);
+    //  -z1     w1      x1      -y1     * z0
+    auto r4 = _mm_xor_ps(_v_shuffle_ps<2, 3, 0, 1>(src1, src1), _mm_set_ps(-0.f, 0.f, 0.f, -0.f));
+    return _v_fmadd_ps(_v_shuffle_ps<2, 2, 2, 2>(src0, src0), r4, r1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Rotate the vector `src1` by the unit quaternion `src0`. The last element of
+//! `src1` is unchanged.
+inline __m128 VECTORCALL _v_quat_rotate_ps(__m128 src0, __m128 src1)
+{
+    //  t = 2 * (q.xyz x v)
+    auto t = _v_cross_ps(src0, src1);
+    t = _mm_add_ps(t, t);
+    //  v + q.w * t + q.xyz x t
+    auto r1 = _mm_add_ps(src1, _v_cross_ps(src0, t));
+    return _v_fmadd_ps(_v_shuffle_ps<3, 3, 3, 3>(src0, src0), t, r1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Coefficient of the end point of spherical linear interpolation between two
+//! unit quaternions whose dot product is `src0`, at the fraction `src1`, i.e.
+//!     dst[i] = sin(src1[i] * theta[i]) / sin(theta[i])
+//! where theta[i] = acos(src0[i]). Each element of `src0` must be in [0, 1].
+//! This uses the degree 8 polynomial approximation from Eberly, "A Fast and
+//! Accurate Algorithm for Computing SLERP", which does not require any inverse
+//! trigonometric functions. The error is at most 2e-5, when the quaternions are
+//! nearly orthogonal, and much smaller for nearby quaternions.
+inline __m128 VECTORCALL _v_slerp_coeff_ps(__m128 src0, __m128 src1)
+{
+    constexpr float kMu = 1.85298109240830f;
+    constexpr float u[8] = {
+        1.f / (1 * 3), 1.f / (2 * 5), 1.f / (3 * 7), 1.f / (4 * 9),
+        1.f / (5 * 11), 1.f / (6 * 13), 1.f / (7 * 15), kMu / (8 * 17),
+    };
+    constexpr float v[8] = {
+        1.f / 3, 2.f / 5, 3.f / 7, 4.f / 9,
+        5.f / 11, 6.f / 13, 7.f / 15, kMu * 8 / 17,
+    };
+
+    auto one = _mm_set_ps1(1.f);
+    auto xm1 = _mm_sub_ps(src0, one);
+    auto tsqr = _mm_mul_ps(src1, src1);
+
+    //  1 + b[0] * (1 + b[1] * (... * (1 + b[7])))
+    //  b[i] = (u[i] * t^2 - v[i]) * (x - 1)
+    auto r1 = one;
+    for (int ii = 7; ii >= 0; --ii) {
+        auto b = _mm_mul_ps(_v_fmsub_ps(_mm_set_ps1(u[ii]), tsqr, _mm_set_ps1(v[ii])), xm1);
+        r1 = _v_fmadd_ps(b, r1, one);
+    }
+
+    return _mm_mul_ps(src1, r1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Spherical linear interpolation between the unit quaternions `src0` and
+//! `src1` at the fraction `src2`, which must be broadcast to each element.
+//! Interpolates along the shortest arc, i.e. `src1` is negated if the dot
+//! product is negative.
+inline __m128 VECTORCALL _v_quat_slerp_ps(__m128 src0, __m128 src1, __m128 src2)
+{
+    auto d = _v_dp_ps(src0, src1);
+    auto sign = _mm_and_ps(d, _mm_set_ps1(-0.f));
+
+    //  1-t     t       1-t     t
+    auto t = _v_blend_ps<1, 0, 1, 0>(src2, _mm_sub_ps(_mm_set_ps1(1.f), src2));
+    auto c = _v_slerp_coeff_ps(_mm_xor_ps(d, sign), t);
+
+    auto c0 = _v_shuffle_ps<1, 1, 1, 1>(c, c);
+    auto c1 = _mm_xor_ps(_v_shuffle_ps<0, 0, 0, 0>(c, c), sign);
+    return _v_fmadd_ps(c1, src1, _mm_mul_ps(c0, src0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Spherical linear interpolation of four pairs of quaternions from `src0` and
+//! `src1` at the fractions in each element of `src2`. The interpolation
+//! coefficients of every pair are computed together, with one pair in each
+//! element, instead of separately in each quaternion register.
+inline void VECTORCALL _v_quat_slerp4_ps(__m128 const (&src0)[4], __m128 const (&src1)[4], __m128 src2, __m128 (&dst)[4])
+{
+    auto p0 = _mm_mul_ps(src0[0], src1[0]);
+    auto p1 = _mm_mul_ps(src0[1], src1[1]);
+    auto p2 = _mm_mul_ps(src0[2], src1[2]);
+    auto p3 = _mm_mul_ps(src0[3], src1[3]);
+
+    //  y1+w1   y0+w0   x1+z1   x0+z0
+    auto r0 = _mm_add_ps(_mm_unpacklo_ps(p0, p1), _mm_unpackhi_ps(p0, p1));
+    //  y3+w3   y2+w2   x3+z3   x2+z2
+    auto r1 = _mm_add_ps(_mm_unpacklo_ps(p2, p3), _mm_unpackhi_ps(p2, p3));
+    //  d3      d2      d1      d0
+    auto d = _mm_add_ps(_mm_movelh_ps(r0, r1), _mm_movehl_ps(r1, r0));
+
+    auto sign = _mm_and_ps(d, _mm_set_ps1(-0.f));
+    auto x = _mm_xor_ps(d, sign);
+
+    auto c0 = _v_slerp_coeff_ps(x, _mm_sub_ps(_mm_set_ps1(1.f), src2));
+    auto c1 = _mm_xor_ps(_v_slerp_coeff_ps(x, src2), sign);
+
+    dst[0] = _v_fmadd_ps(_v_shuffle_ps<0, 0, 0, 0>(c1, c1), src1[0],
+                         _mm_mul_ps(_v_shuffle_ps<0, 0, 0, 0>(c0, c0), src0[0]));
+    dst[1] = _v_fmadd_ps(_v_shuffle_ps<1, 1, 1, 1>(c1, c1), src1[1],
+                         _mm_mul_ps(_v_shuffle_ps<1, 1, 1, 1>(c0, c0), src0[1]));
+    dst[2] = _v_fmadd_ps(_v_shuffle_ps<2, 2, 2, 2>(c1, c1), src1[2],
+                         _mm_mul_ps(_v_shuffle_ps<2, 2, 2, 2>(c0, c0), src0[2]));
+    dst[3] = _v_fmadd_ps(_v_shuffle_ps<3, 3, 3, 3>(c1, c1), src1[3],
+                         _mm_mul_ps(_v_shuffle_ps<3, 3, 3, 3>(c0, c0), src0[3]));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Rotation matrix of the unit quaternion `src`, as columns `dst`.
+inline void VECTORCALL _v_quat_to_matrix_ps(__m128 src, __m128 (&dst)[4])
+{
+    //  Each column is the sum of an identity column and two products of an
+    //  imaginary component with a permutation of the quaternion, e.g.
+    //      x' = (1, 0, 0) + 2y * (-y, x, -w) + 2z * (-z, w, x)
+
+    //  0       -w      x       -y
+    auto a = _mm_mul_ps(_v_shuffle_ps<3, 3, 0, 1>(src, src), _mm_set_ps(0.f, -1.f, 1.f, -1.f));
+    //  0       x       w       -z
+    auto b = _mm_mul_ps(_v_shuffle_ps<3, 0, 3, 2>(src, src), _mm_set_ps(0.f, 1.f, 1.f, -1.f));
+    //  0       y       -z      -w
+    auto c = _mm_mul_ps(_v_shuffle_ps<3, 1, 2, 3>(src, src), _mm_set_ps(0.f, 1.f, -1.f, -1.f));
+
+    auto q2 = _mm_add_ps(src, src);
+    auto x2 = _v_shuffle_ps<0, 0, 0, 0>(q2, q2);
+    auto y2 = _v_shuffle_ps<1, 1, 1, 1>(q2, q2);
+    auto z2 = _v_shuffle_ps<2, 2, 2, 2>(q2, q2);
+
+    //  e0 + 2y * a + 2z * b
+    auto r0 = _v_fmadd_ps(y2, a, _v_fmadd_ps(z2, b, _mm_set_ps(0.f, 0.f, 0.f, 1.f)));
+    //  e1 - 2x * a + 2z * c
+    auto r1 = _v_fnmadd_ps(x2, a, _v_fmadd_ps(z2, c, _mm_set_ps(0.f, 0.f, 1.f, 0.f)));
+    //  e2 - 2x * b - 2y * c
+    auto r2 = _v_fnmadd_ps(x2, b, _v_fnmadd_ps(y2, c, _mm_set_ps(0.f, 1.f, 0.f, 0.f)));
+
+    dst[0] = r0;
+    dst[1] = r1;
+    dst[2] = r2;
+    dst[3] = _mm_set_ps(1.f, 0.f, 0.f, 0.f);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Unit quaternion of the rotation matrix with columns `src`. Only the upper
+//! 3x3 block is used, which must be orthonormal. The largest component is
+//! computed from the diagonal and the others from the off-diagonal elements to
+//! avoid cancellation, see Shepperd, "Quaternion from Rotation Matrix".
+inline __m128 VECTORCALL _v_matrix_to_quat_ps(__m128 const (&src)[4])
+{
+    auto m00 = _v_shuffle_ps<0, 0, 0, 0>(src[0], src[0]);
+    auto m11 = _v_shuffle_ps<1, 1, 1, 1>(src[1], src[1]);
+    auto m22 = _v_shuffle_ps<2, 2, 2, 2>(src[2], src[2]);
+
+    //  4w^2    4z^2    4y^2    4x^2
+    auto sqr = _v_fmadd_ps(m00, _mm_set_ps(1.f, -1.f, -1.f, 1.f), _mm_set_ps1(1.f));
+    sqr = _v_fmadd_ps(m11, _mm_set_ps(1.f, -1.f, 1.f, -1.f), sqr);
+    sqr = _v_fmadd_ps(m22, _mm_set_ps(1.f, 1.f, -1.f, -1.f), sqr);
+
+    //  m10     m10     m02     m21
+    auto r1 = _v_shuffle_ps<1, 1, 2, 0>(_v_shuffle_ps<0, 0, 2, 2>(src[1], src[2]), src[0]);
+    //  m01     m01     m20     m12
+    auto r2 = _v_shuffle_ps<0, 0, 2, 0>(_v_shuffle_ps<2, 2, 1, 1>(src[2], src[0]), src[1]);
+
+    //  --      4xy     4xz     4yz
+    alignas(16) float s[4];
+    _mm_store_ps(s, _mm_add_ps(r1, r2));
+    //  --      4wz     4wy     4wx
+    alignas(16) float d[4];
+    _mm_store_ps(d, _mm_sub_ps(r1, r2));
+    alignas(16) float v[4];
+    _mm_store_ps(v, sqr);
+
+    //  Scale the products with the largest component q[k] by 1 / (4 q[k]).
+    __m128 r3;
+    float vk;
+    if (v[3] >= v[0] && v[3] >= v[1] && v[3] >= v[2]) {
+        r3 = _mm_set_ps(v[3], d[2], d[1], d[0]);
+        vk = v[3];
+    } else if (v[0] >= v[1] && v[0] >= v[2]) {
+        r3 = _mm_set_ps(d[0], s[1], s[2], v[0]);
+        vk = v[0];
+    } else if (v[1] >= v[2]) {
+        r3 = _mm_set_ps(d[1], s[0], v[1], s[2]);
+        vk = v[1];
+    } else {
+        r3 = _mm_set_ps(d[2], v[2], s[0], s[1]);
+        vk = v[2];
+    }
+
+    return _mm_mul_ps(r3, _mm_set_ps1(.5f / std::sqrt(vk)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Affine transforms are stored as the first three rows of a 4x4 matrix, the
+//  last row is implicitly { 0, 0, 0, 1 }.
+
+//! Transpose the 4x4 matrix `src` into `dst`.
+inline void VECTORCALL _v_transpose_ps(__m128 const (&src)[4], __m128 (&dst)[4])
+{
+    auto r0 = _mm_unpacklo_ps(src[0], src[1]);
+    auto r1 = _mm_unpackhi_ps(src[0], src[1]);
+    auto r2 = _mm_unpacklo_ps(src[2], src[3]);
+    auto r3 = _mm_unpackhi_ps(src[2], src[3]);
+
+    dst[0] = _mm_movelh_ps(r0, r2);
+    dst[1] = _mm_movehl_ps(r2, r0);
+    dst[2] = _mm_movelh_ps(r1, r3);
+    dst[3] = _mm_movehl_ps(r3, r1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Product of the affine transform with rows `src0` and the vector `src1`. The
+//! last element is the last element of `src1`.
+inline __m128 VECTORCALL _v_affine_mul_ps(__m128 const (&src0)[3], __m128 src1)
+{
+    auto p0 = _mm_mul_ps(src0[0], src1);
+    auto p1 = _mm_mul_ps(src0[1], src1);
+    auto p2 = _mm_mul_ps(src0[2], src1);
+    //  w       0       0       0
+    auto p3 = _v_blend_ps<0, 1, 1, 1>(src1, _mm_setzero_ps());
+
+    //  Sum the elements of each product with a transpose.
+    //  y1+w1   y0+w0   x1+z1   x0+z0
+    auto r0 = _mm_add_ps(_mm_unpacklo_ps(p0, p1), _mm_unpackhi_ps(p0, p1));
+    //  y3+w3   y2+w2   x3+z3   x2+z2
+    auto r1 = _mm_add_ps(_mm_unpacklo_ps(p2, p3), _mm_unpackhi_ps(p2, p3));
+
+    return _mm_add_ps(_mm_movelh_ps(r0, r1), _mm_movehl_ps(r1, r0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Product of the affine transforms with rows `src0` and `src1`.
+inline void VECTORCALL _v_affine_mul_ps(__m128 const (&src0)[3], __m128 const (&src1)[3], __m128 (&dst)[3])
+{
+    for (size_t ii = 0; ii < 3; ++ii) {
+        auto a = src0[ii];
+        //  The translation of `src0` is added through the implicit last row
+        //  of `src1`, which only has a non-zero element in the last column.
+        auto r1 = _v_blend_ps<0, 1, 1, 1>(a, _mm_setzero_ps());
+        r1 = _v_fmadd_ps(_v_shuffle_ps<0, 0, 0, 0>(a, a), src1[0], r1);
+        r1 = _v_fmadd_ps(_v_shuffle_ps<1, 1, 1, 1>(a, a), src1[1], r1);
+        dst[ii] = _v_fmadd_ps(_v_shuffle_ps<2, 2, 2, 2>(a, a), src1[2], r1);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Batch transforms keep the matrix in registers for the whole batch. Input
+//  is prefetched one cache line at a time and results can optionally be
+//  written with non-temporal stores, which avoid evicting other data from the
+//  cache when the output is larger than the last level cache.
+
+//! Distance in bytes ahead of the current input at which batch operations
+//! prefetch.
+constexpr size_t _v_prefetch_distance = 512;
+
+//! Prefetch the input `_v_prefetch_distance` bytes ahead of `src[ii]`, only
+//! while that is still within the `count` elements of `src`.
+template<typename T>
+inline void VECTORCALL _v_prefetch_batch(T const* src, size_t ii, size_t count)
+{
+    constexpr size_t kDistance = _v_prefetch_distance / sizeof(T);
+    if (ii + kDistance < count) {
+        _mm_prefetch(reinterpret_cast<char const*>(src + ii + kDistance), _MM_HINT_T0);
+    }
+}
+
+//! Product of the matrix with columns `src0` and the vector `src1`, with the
+//! last element of `src1` treated as one if `Point` is true, otherwise zero.
+template<bool Point>
+inline __m128 VECTORCALL _v_transform_ps(__m128 const (&src0)[4], __m128 src1)
+{
+    auto r1 = _mm_mul_ps(src0[0], _v_shuffle_ps<0, 0, 0, 0>(src1, src1));
+    auto r2 = _mm_mul_ps(src0[1], _v_shuffle_ps<1, 1, 1, 1>(src1, src1));
+    r1 = _v_fmadd_ps(src0[2], _v_shuffle_ps<2, 2, 2, 2>(src1, src1), r1);
+    if (Point) {
+        r2 = _mm_add_ps(src0[3], r2);
+    }
+    return _mm_add_ps(r1, r2);
+}
+
+//! Store `src` to the aligned address `dst`, bypassing the cache if `Stream`
+//! is true.
+template<bool Stream>
+inline void VECTORCALL _v_store_ps(__m128* dst, __m128 src)
+{
+    if (Stream) {
+        _mm_stream_ps(reinterpret_cast<float*>(dst), src);
+    } else {
+        _mm_store_ps(reinterpret_cast<float*>(dst), src);
+    }
+}
+
+//! Transform `count` vectors from `src1` into `dst` by the matrix with columns
+//! `src0`, see `_v_transform_ps`.
+template<bool Point, bool Stream>
+inline void VECTORCALL _v_transform_batch_ps(__m128 const (&src0)[4], __m128 const* src1, __m128* dst, size_t count)
+{
+    size_t ii = 0;
+
+    //  Four vectors fill one cache line.
+    for (; ii + 4 <= count; ii += 4) {
+        _v_prefetch_batch(src1, ii, count);
+        _v_store_ps<Stream>(dst + ii + 0, _v_transform_ps<Point>(src0, src1[ii + 0]));
+        _v_store_ps<Stream>(dst + ii + 1, _v_transform_ps<Point>(src0, src1[ii + 1]));
+        _v_store_ps<Stream>(dst + ii + 2, _v_transform_ps<Point>(src0, src1[ii + 2]));
+        _v_store_ps<Stream>(dst + ii + 3, _v_transform_ps<Point>(src0, src1[ii + 3]));
+    }
+
+    for (; ii < count; ++ii) {
+        _v_store_ps<Stream>(dst + ii, _v_transform_ps<Point>(src0, src1[ii]));
+    }
+
+    //  Order the non-temporal stores before any following stores.
+    if (Stream) {
+        _mm_sfence();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Half precision conversions use F16C if available, otherwise the scalar
+//  conversions in `Half.h` which round the same way.
+
+//! Convert the elements of `src` to half precision in the lower 64 bits of
+//! the result, rounding to nearest even.
+inline __m128i VECTORCALL _v_cvtps_ph(__m128 src)
+{
+#if _HAS_F16C
+    return _mm_cvtps_ph(src, _MM_FROUND_TO_NEAREST_INT);
+#else
+    alignas(16) float f[4];
+    _mm_store_ps(f, src);
+    return _mm_set_epi16(0, 0, 0, 0,
+                         short(FloatToHalf(f[3])),
+                         short(FloatToHalf(f[2])),
+                         short(FloatToHalf(f[1])),
+                         short(FloatToHalf(f[0])));
+#endif
+}
+
+//! Convert the half precision elements in the lower 64 bits of `src` to single
+//! precision, which is exact.
+inline __m128 VECTORCALL _v_cvtph_ps(__m128i src)
+{
+#if _HAS_F16C
+    return _mm_cvtph_ps(src);
+#else
+    alignas(16) uint16_t h[8];
+    _mm_store_si128(reinterpret_cast<__m128i*>(h), src);
+    return _mm_set_ps(HalfToFloat(h[3]),
+                      HalfToFloat(h[2]),
+                      HalfToFloat(h[1]),
+                      HalfToFloat(h[0]));
+#endif
+}
+
+//! Convert `count` vectors from `src` to half precision, four elements each
+//! in `dst`.
+inline void VECTORCALL _v_cvtps_ph_batch(__m128 const* src, uint16_t* dst, size_t count)
+{
+    size_t ii = 0;
+#if _HAS_F16C
+    //  Convert pairs of vectors with 256-bit conversions.
+    for (; ii + 2 <= count; ii += 2) {
+        auto v = _mm256_loadu_ps(reinterpret_cast<float const*>(src + ii));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + ii * 4),
+                         _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+    }
+#endif // _HAS_F16C
+    for (; ii < count; ++ii) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + ii * 4), _v_cvtps_ph(src[ii]));
+    }
+}
+
+//! Convert `count` vectors of four half precision elements each from `src` to
+//! single precision in `dst`.
+inline void VECTORCALL _v_cvtph_ps_batch(uint16_t const* src, __m128* dst, size_t count)
+{
+    size_t ii = 0;
+#if _HAS_F16C
+    //  Convert pairs of vectors with 256-bit conversions.
+    for (; ii + 2 <= count; ii += 2) {
+        auto h = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + ii * 4));
+        _mm256_storeu_ps(reinterpret_cast<float*>(dst + ii), _mm256_cvtph_ps(h));
+    }
+#endif // _HAS_F16C
+    for (; ii < count; ++ii) {
+        dst[ii] = _v_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(src + ii * 4)));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Packed vectors of three elements are loaded and stored without accessing
+//  memory past the third element, so that the last element of an array can be
+//  accessed when it ends at a page boundary.
+
+//! Load three elements from `src` with the first element of `w` in the fourth.
+//!     dst[127:0] = { w[31:0], src[2], src[1], src[0] }
+inline __m128 VECTORCALL _v_load3_ps(float const* src, __m128 w)
+{
+    auto xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<double const*>(src)));
+    return _mm_movelh_ps(xy, _mm_unpacklo_ps(_mm_load_ss(src + 2), w));
+}
+
+//! Store the lower three elements of `src` to `dst`.
+inline void VECTORCALL _v_store3_ps(float* dst, __m128 src)
+{
+    _mm_storel_pi(reinterpret_cast<__m64*>(dst), src);
+    _mm_store_ss(dst + 2, _mm_movehl_ps(src, src));
+}
+
+//! Load `count` vectors of three elements each from `src` to `dst` with `w` in
+//! the fourth element.
+inline void VECTORCALL _v_load3_ps_batch(float const* src, __m128* dst, size_t count, float w)
+{
+    auto r3 = _mm_set1_ps(w);
+
+    size_t ii = 0;
+    //  Load four vectors from three registers.
+    for (; ii + 4 <= count; ii += 4) {
+        //  x1      z0      y0      x0
+        auto r0 = _mm_loadu_ps(src + ii * 3);
+        //  y2      x2      z1      y1
+        auto r1 = _mm_loadu_ps(src + ii * 3 + 4);
+        //  z3      y3      x3      z2
+        auto r2 = _mm_loadu_ps(src + ii * 3 + 8);
+
+        //  y1      y1      x1      x1
+        auto t1 = _v_shuffle_ps<0, 0, 3, 3>(r0, r1);
+        //  w       w       z1      z1
+        auto u1 = _v_shuffle_ps<0, 0, 1, 1>(r1, r3);
+        //  w       w       z2      z2
+        auto u2 = _v_shuffle_ps<0, 0, 0, 0>(r2, r3);
+        //  w       w       z3      z3
+        auto u3 = _v_shuffle_ps<0, 0, 3, 3>(r2, r3);
+
+        dst[ii + 0] = _v_blend_ps<1, 0, 0, 0>(r0, r3);
+        dst[ii + 1] = _v_shuffle_ps<2, 0, 2, 0>(t1, u1);
+        dst[ii + 2] = _v_shuffle_ps<2, 0, 3, 2>(r1, u2);
+        dst[ii + 3] = _v_shuffle_ps<2, 0, 2, 1>(r2, u3);
+    }
+    for (; ii < count; ++ii) {
+        dst[ii] = _v_load3_ps(src + ii * 3, r3);
+    }
+}
+
+//! Store the lower three elements of `count` vectors from `src` to `dst`.
+inline void VECTORCALL _v_store3_ps_batch(__m128 const* src, float* dst, size_t count)
+{
+    size_t ii = 0;
+    //  Store four vectors in three registers.
+    for (; ii + 4 <= count; ii += 4) {
+        auto r0 = src[ii + 0];
+        auto r1 = src[ii + 1];
+        auto r2 = src[ii + 2];
+        auto r3 = src[ii + 3];
+
+        //  x1      x1      z0      z0
+        auto t0 = _v_shuffle_ps<0, 0, 2, 2>(r0, r1);
+        //  x3      x3      z2      z2
+        auto t2 = _v_shuffle_ps<0, 0, 2, 2>(r2, r3);
+
+        //  x1      z0      y0      x0
+        _mm_storeu_ps(dst + ii * 3, _v_shuffle_ps<2, 0, 1, 0>(r0, t0));
+        //  y2      x2      z1      y1
+        _mm_storeu_ps(dst + ii * 3 + 4, _v_shuffle_ps<1, 0, 2, 1>(r1, r2));
+        //  z3      y3      x3      z2
+        _mm_storeu_ps(dst + ii * 3 + 8, _v_shuffle_ps<2, 1, 2, 0>(t2, r3));
+    }
+    for (; ii < count; ++ii) {
+        _v_store3_ps(dst + ii * 3, src[ii]);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Absolute value of each element of `src`.
+inline __m128 VECTORCALL _v_abs_ps(__m128 src)
+{
+    return _mm_andnot_ps(_mm_set_ps1(-0.f), src);
+}
+
+//! Round each element of `src` toward negative infinity.
+inline __m128 VECTORCALL _v_floor_ps(__m128 src)
+{
+#if _HAS_SSE4_1
+    return _mm_round_ps(src, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+#else
+    //  Values of magnitude 2^23 and above are already integers and may not
+    //  be representable as 32-bit integers.
+    auto large = _mm_cmpge_ps(_v_abs_ps(src), _mm_set_ps1(8388608.f));
+    auto r1 = _mm_cvtepi32_ps(_mm_cvttps_epi32(src));
+    //  Truncation rounds negative values up.
+    auto r2 = _mm_sub_ps(r1, _mm_and_ps(_mm_cmpgt_ps(r1, src), _mm_set_ps1(1.f)));
+    return _v_blendv_ps(r2, src, large);
+#endif
+}
+
+//! Round each element of `src` toward positive infinity.
+inline __m128 VECTORCALL _v_ceil_ps(__m128 src)
+{
+#if _HAS_SSE4_1
+    return _mm_round_ps(src, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+#else
+    auto large = _mm_cmpge_ps(_v_abs_ps(src), _mm_set_ps1(8388608.f));
+    auto r1 = _mm_cvtepi32_ps(_mm_cvttps_epi32(src));
+    //  Truncation rounds positive values down.
+    auto r2 = _mm_add_ps(r1, _mm_and_ps(_mm_cmplt_ps(r1, src), _mm_set_ps1(1.f)));
+    return _v_blendv_ps(r2, src, large);
+#endif
+}
+
+//! Minimum of the elements of `src`, broadcast to each element.
+inline __m128 VECTORCALL _v_reduce_min_ps(__m128 src)
+{
+    //  z       w       x       y
+    auto r1 = _mm_min_ps(src, _v_shuffle_ps<2, 3, 0, 1>(src, src));
+    return _mm_min_ps(r1, _v_shuffle_ps<1, 0, 3, 2>(r1, r1));
+}
+
+//! Maximum of the elements of `src`, broadcast to each element.
+inline __m128 VECTORCALL _v_reduce_max_ps(__m128 src)
+{
+    //  z       w       x       y
+    auto r1 = _mm_max_ps(src, _v_shuffle_ps<2, 3, 0, 1>(src, src));
+    return _mm_max_ps(r1, _v_shuffle_ps<1, 0, 3, 2>(r1, r1));
+}
+
+//! Sum of the elements of `src`, broadcast to each element.
+inline __m128 VECTORCALL _v_reduce_add_ps(__m128 src)
+{
+    //  z       w       x       y
+    auto r1 = _mm_add_ps(src, _v_shuffle_ps<2, 3, 0, 1>(src, src));
+    return _mm_add_ps(r1, _v_shuffle_ps<1, 0, 3, 2>(r1, r1));
+}
+
+//! Element-wise minimum and maximum of `count` vectors in `src`. The bounds
+//! of an empty array are +infinity and -infinity.
+inline void VECTORCALL _v_bounds_batch_ps(__m128 const* src, size_t count, __m128& min, __m128& max)
+{
+    auto r0 = _mm_set_ps1(HUGE_VALF);
+    auto r1 = _mm_set_ps1(-HUGE_VALF);
+
+    size_t ii = 0;
+#if _HAS_AVX
+    //  Accumulate pairs of vectors in each register, two registers at a time.
+    auto r2 = _mm256_set1_ps(HUGE_VALF);
+    auto r3 = _mm256_set1_ps(-HUGE_VALF);
+    auto r4 = r2;
+    auto r5 = r3;
+    for (; ii + 4 <= count; ii += 4) {
+        auto v0 = _mm256_loadu_ps(reinterpret_cast<float const*>(src + ii));
+        auto v1 = _mm256_loadu_ps(reinterpret_cast<float const*>(src + ii + 2));
+        r2 = _mm256_min_ps(r2, v0);
+        r3 = _mm256_max_ps(r3, v0);
+        r4 = _mm256_min_ps(r4, v1);
+        r5 = _mm256_max_ps(r5, v1);
+    }
+    r2 = _mm256_min_ps(r2, r4);
+    r3 = _mm256_max_ps(r3, r5);
+    r0 = _mm_min_ps(_mm256_castps256_ps128(r2), _mm256_extractf128_ps(r2, 1));
+    r1 = _mm_max_ps(_mm256_castps256_ps128(r3), _mm256_extractf128_ps(r3, 1));
+#endif // _HAS_AVX
+    for (; ii < count; ++ii) {
+        r0 = _mm_min_ps(r0, src[ii]);
+        r1 = _mm_max_ps(r1, src[ii]);
+    }
+
+    min = r0;
+    max = r1;
+}
+
+//! Maximum of the squared lengths of `count` vectors in `src`, broadcast to
+//! each element, or zero for an empty array.
+inline __m128 VECTORCALL _v_max_lsqr_batch_ps(__m128 const* src, size_t count)
+{
+    auto r0 = _mm_setzero_ps();
+
+    //  Sums of squares are computed for four vectors at a time by transposing
+    //  pairs of elements, the order of the sums does not matter for the max.
+    size_t ii = 0;
+#if _HAS_AVX
+    //  Eight vectors at a time with two vectors in each register.
+    auto r1 = _mm256_setzero_ps();
+    for (; ii + 8 <= count; ii += 8) {
+        auto v0 = _mm256_loadu_ps(reinterpret_cast<float const*>(src + ii));
+        auto v1 = _mm256_loadu_ps(reinterpret_cast<float const*>(src + ii + 2));
+        auto v2 = _mm256_loadu_ps(reinterpret_cast<float const*>(src + ii + 4));
+        auto v3 = _mm256_loadu_ps(reinterpret_cast<float const*>(src + ii + 6));
+        v0 = _mm256_mul_ps(v0, v0);
+        v1 = _mm256_mul_ps(v1, v1);
+        v2 = _mm256_mul_ps(v2, v2);
+        v3 = _mm256_mul_ps(v3, v3);
+        //  y1+w1   y0+w0   x1+z1   x0+z0
+        auto t0 = _mm256_add_ps(_mm256_unpacklo_ps(v0, v1), _mm256_unpackhi_ps(v0, v1));
+        auto t1 = _mm256_add_ps(_mm256_unpacklo_ps(v2, v3), _mm256_unpackhi_ps(v2, v3));
+        auto t2 = _mm256_add_ps(_mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0)),
+                                _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2)));
+        r1 = _mm256_max_ps(r1, t2);
+    }
+    r0 = _mm_max_ps(_mm256_castps256_ps128(r1), _mm256_extractf128_ps(r1, 1));
+#else
+    for (; ii + 4 <= count; ii += 4) {
+        auto v0 = _mm_mul_ps(src[ii + 0], src[ii + 0]);
+        auto v1 = _mm_mul_ps(src[ii + 1], src[ii + 1]);
+        auto v2 = _mm_mul_ps(src[ii + 2], src[ii + 2]);
+        auto v3 = _mm_mul_ps(src[ii + 3], src[ii + 3]);
+        //  y1+w1   y0+w0   x1+z1   x0+z0
+        auto t0 = _mm_add_ps(_mm_unpacklo_ps(v0, v1), _mm_unpackhi_ps(v0, v1));
+        auto t1 = _mm_add_ps(_mm_unpacklo_ps(v2, v3), _mm_unpackhi_ps(v2, v3));
+        r0 = _mm_max_ps(r0, _mm_add_ps(_mm_movelh_ps(t0, t1), _mm_movehl_ps(t1, t0)));
+    }
+#endif // _HAS_AVX
+    r0 = _v_reduce_max_ps(r0);
+    for (; ii < count; ++ii) {
+        r0 = _mm_max_ps(r0, _v_dp_ps(src[ii], src[ii]));
+    }
+    return r0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Forward declarations
+class Mask;
 class Scalar;
 class VectorScalar;
 class Vector;
+class HalfVector;
+class Vector3;
+class Quaternion;
+class AffineMatrix;
 class Matrix;
+template<size_t N> class VectorPacket;
+
+#if _FUSED_EXPRESSIONS
+template<typename T> class _v_product;
+#else
+//! Products are evaluated immediately unless fused expressions are enabled.
+template<typename T> using _v_product = T;
+#endif // _FUSED_EXPRESSIONS
+
+//! Return the product of `src0` and `src1` as `T`, see `_v_product`.
+template<typename T> _v_product<T> VECTORCALL _v_mul(__m128 src0, __m128 src1);
 
 #if !_HAS_SSE
 #   error Intrinsics implementation requires at least SSE instruction set!
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Result of a packed comparison, each element is either all ones or all zeros.
+ * Comparisons of `Scalar` set every element to the same value so the mask can
+ * be tested as a `bool` or used with `Select` to choose between values without
+ * a branch. Operators combine masks element-wise.
+ */
+class Mask {
+public:
+    Mask() {}
+
+    //! Returns true if any element is set, so that comparisons of `Scalar`
+    //! can still be used as `bool`, e.g. `bool inside = s < t;`.
+    VECTORCALL operator bool() const {
+        return _mm_movemask_ps(_value) != 0;
+    }
+
+    Mask VECTORCALL operator&(Mask const& a) const {
+        return _mm_and_ps(_value, a._value);
+    }
+
+    Mask VECTORCALL operator|(Mask const& a) const {
+        return _mm_or_ps(_value, a._value);
+    }
+
+    Mask VECTORCALL operator^(Mask const& a) const {
+        return _mm_xor_ps(_value, a._value);
+    }
+
+    Mask VECTORCALL operator~() const {
+        return _mm_xor_ps(_value, _mm_castsi128_ps(_mm_set1_epi32(-1)));
+    }
+
+    friend bool VECTORCALL Any(Mask const& a) {
+        return _mm_movemask_ps(a._value) != 0x0;
+    }
+
+    friend bool VECTORCALL All(Mask const& a) {
+        return _mm_movemask_ps(a._value) == 0xf;
+    }
+
+    friend bool VECTORCALL None(Mask const& a) {
+        return _mm_movemask_ps(a._value) == 0x0;
+    }
+
+    //! Return elements of `a` where `mask` is set, otherwise elements of `b`.
+    friend Mask VECTORCALL Select(Mask const& mask, Mask const& a, Mask const& b) {
+        return _v_blendv_ps(b._value, a._value, mask._value);
+    }
+
+private:
+    __m128 _value;
+
+private:
+    friend Scalar;
+    friend VectorScalar;
+    friend Vector;
+
+    friend Scalar VECTORCALL Select(Mask const& mask, Scalar const& a, Scalar const& b);
+    friend Vector VECTORCALL Select(Mask const& mask, Vector const& a, Vector const& b);
+
+    Mask(__m128 const& value)
+        : _value(value) {}
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /**
  */
@@ -109,44 +1141,44 @@ public:
         return _mm_cvtss_f32(_value);
     }
 
-    bool VECTORCALL operator==(Scalar const& a) const {
-        return _mm_comieq_ss(_value, a._value) == 1;
+    Mask VECTORCALL operator==(Scalar const& a) const {
+        return _mm_cmpeq_ps(_value, a._value);
     }
 
-    bool VECTORCALL operator!=(Scalar const& a) const {
-        return _mm_comineq_ss(_value, a._value) == 1;
+    Mask VECTORCALL operator!=(Scalar const& a) const {
+        return _mm_cmpneq_ps(_value, a._value);
     }
 
-    bool VECTORCALL operator<(Scalar const& a) const {
-        return _mm_comilt_ss(_value, a._value) == 1;
+    Mask VECTORCALL operator<(Scalar const& a) const {
+        return _mm_cmplt_ps(_value, a._value);
     }
 
-    bool VECTORCALL operator>(Scalar const& a) const {
-        return _mm_comigt_ss(_value, a._value) == 1;
+    Mask VECTORCALL operator>(Scalar const& a) const {
+        return _mm_cmpgt_ps(_value, a._value);
     }
 
-    bool VECTORCALL operator<=(Scalar const& a) const {
-        return _mm_comile_ss(_value, a._value) == 1;
+    Mask VECTORCALL operator<=(Scalar const& a) const {
+        return _mm_cmple_ps(_value, a._value);
     }
 
-    bool VECTORCALL operator>=(Scalar const& a) const {
-        return _mm_comige_ss(_value, a._value) == 1;
+    Mask VECTORCALL operator>=(Scalar const& a) const {
+        return _mm_cmpge_ps(_value, a._value);
     }
 
-    friend bool VECTORCALL operator<(float a, Scalar const& b) {
-        return _mm_comilt_ss(_mm_set_ss(a), b._value) == 1;
+    friend Mask VECTORCALL operator<(float a, Scalar const& b) {
+        return Scalar(a) < b;
     }
 
-    friend bool VECTORCALL operator>(float a, Scalar const& b) {
-        return _mm_comigt_ss(_mm_set_ss(a), b._value) == 1;
+    friend Mask VECTORCALL operator>(float a, Scalar const& b) {
+        return Scalar(a) > b;
     }
 
-    friend bool VECTORCALL operator<=(float a, Scalar const& b) {
-        return _mm_comile_ss(_mm_set_ss(a), b._value) == 1;
+    friend Mask VECTORCALL operator<=(float a, Scalar const& b) {
+        return Scalar(a) <= b;
     }
 
-    friend bool VECTORCALL operator>=(float a, Scalar const& b) {
-        return _mm_comige_ss(_mm_set_ss(a), b._value) == 1;
+    friend Mask VECTORCALL operator>=(float a, Scalar const& b) {
+        return Scalar(a) >= b;
     }
 
     Scalar VECTORCALL operator-() const {
@@ -161,9 +1193,7 @@ public:
         return _mm_sub_ps(_value, a._value);
     }
 
-    Scalar VECTORCALL operator*(Scalar const& a) const {
-        return _mm_mul_ps(_value, a._value);
-    }
+    _v_product<Scalar> VECTORCALL operator*(Scalar const& a) const;
 
     Scalar VECTORCALL operator/(Scalar const& a) const {
         return _mm_div_ps(_value, a._value);
@@ -177,9 +1207,7 @@ public:
         return _mm_sub_ps(_mm_set_ps1(a), b._value);
     }
 
-    friend Scalar VECTORCALL operator*(float a, Scalar const& b) {
-        return _mm_mul_ps(_mm_set_ps1(a), b._value);
-    }
+    friend _v_product<Scalar> VECTORCALL operator*(float a, Scalar const& b);
 
     friend Scalar VECTORCALL operator/(float a, Scalar const& b) {
         return _mm_div_ps(_mm_set_ps1(a), b._value);
@@ -194,11 +1222,36 @@ public:
     }
 
     friend Scalar VECTORCALL exp(Scalar const& a) {
-        return std::exp(_mm_cvtss_f32(a._value));
+        return _v_exp_ps(a._value);
+    }
+
+    friend Scalar VECTORCALL exp2(Scalar const& a) {
+        return _v_exp2_ps(a._value);
+    }
+
+    friend Scalar VECTORCALL log(Scalar const& a) {
+        return _v_log_ps(a._value);
+    }
+
+    friend Scalar VECTORCALL log2(Scalar const& a) {
+        return _v_log2_ps(a._value);
     }
 
     friend Scalar VECTORCALL pow(Scalar const& a, Scalar const& b) {
-        return std::pow(_mm_cvtss_f32(a._value), _mm_cvtss_f32(b._value));
+        return _v_pow_ps(a._value, b._value);
+    }
+
+    friend Scalar VECTORCALL sin(Scalar const& a) {
+        return _v_sin_ps(a._value);
+    }
+
+    friend Scalar VECTORCALL cos(Scalar const& a) {
+        return _v_cos_ps(a._value);
+    }
+
+    //! Return `a` if `mask` is set, otherwise `b`.
+    friend Scalar VECTORCALL Select(Mask const& mask, Scalar const& a, Scalar const& b) {
+        return _v_blendv_ps(b._value, a._value, mask._value);
     }
 
 private:
@@ -207,7 +1260,13 @@ private:
 private:
     friend VectorScalar;
     friend Vector;
+    friend Quaternion;
     friend Matrix;
+    friend avx::Matrix;
+#if _FUSED_EXPRESSIONS
+    template<typename> friend class _v_product;
+#endif // _FUSED_EXPRESSIONS
+    template<typename T> friend _v_product<T> VECTORCALL _v_mul(__m128, __m128);
 
     Scalar(__m128 const& value)
         : _value(value)
@@ -226,108 +1285,44 @@ private:
  */
 class VectorScalar {
 public:
-    bool VECTORCALL operator==(Scalar const& s) const {
+    Mask VECTORCALL operator==(Scalar const& s) const {
         return s == *this;
     }
 
-    bool VECTORCALL operator!=(Scalar const& s) const {
+    Mask VECTORCALL operator!=(Scalar const& s) const {
         return s != *this;
     }
 
-    bool VECTORCALL operator<(Scalar const& s) const {
+    Mask VECTORCALL operator<(Scalar const& s) const {
         return s > *this;
     }
 
-    bool VECTORCALL operator>(Scalar const& s) const {
+    Mask VECTORCALL operator>(Scalar const& s) const {
         return s < *this;
     }
 
-    bool VECTORCALL operator<=(Scalar const& s) const {
+    Mask VECTORCALL operator<=(Scalar const& s) const {
         return s >= *this;
     }
 
-    bool VECTORCALL operator>=(Scalar const& s) const {
+    Mask VECTORCALL operator>=(Scalar const& s) const {
         return s <= *this;
     }
 
     VECTORCALL operator Scalar() const {
-        switch (_index) {
-            case 0: return _v_shuffle_ps<0, 0, 0, 0>(_value, _value);
-            case 1: return _v_shuffle_ps<1, 1, 1, 1>(_value, _value);
-            case 2: return _v_shuffle_ps<2, 2, 2, 2>(_value, _value);
-            case 3: return _v_shuffle_ps<3, 3, 3, 3>(_value, _value);
-            default: UNREACHABLE;
-        }
-    }
-
-    void VECTORCALL operator=(Scalar const& a) {
-        switch (_index) {
-            case 0: return AssignX::op(_value, a._value);
-            case 1: return AssignY::op(_value, a._value);
-            case 2: return AssignZ::op(_value, a._value);
-            case 3: return AssignW::op(_value, a._value);
-            default: UNREACHABLE;
-        }
-    }
-
-private:
-    friend Vector;
-
-    VectorScalar(__m128& value, size_t index)
-        : _value(value)
-        , _index(index) {}
-
-    struct AssignX {
-        static void VECTORCALL op(__m128& v, __m128 const& s) {
-#if _HAS_SSE4_1
-            v = _v_blend_ps<0, 0, 0, 1>(v, s);
-#else
-            //  y       x       s       s
-            auto r1 = _mm_movelh_ps(s, v);
-            //  w       z       y       s
-            v = _v_shuffle_ps<3, 2, 3, 0>(r1, v);
-#endif
-        }
-    };
-
-    struct AssignY {
-        static void VECTORCALL op(__m128& v, __m128 const& s) {
-#if _HAS_SSE4_1
-            v = _v_blend_ps<0, 0, 1, 0>(v, s);
-#else
-            //  y       x       s       s
-            auto r1 = _mm_movelh_ps(s, v);
-            //  w       z       s       x
-            v = _v_shuffle_ps<3, 2, 1, 2>(r1, v);
-#endif
-        }
-    };
+        return _v_extract_ps(_value, _index);
+    }
 
-    struct AssignZ {
-        static void VECTORCALL op(__m128& v, __m128 const& s) {
-#if _HAS_SSE4_1
-            v = _v_blend_ps<0, 1, 0, 0>(v, s);
-#else
-            //  s       s       w       z
-            auto r1 = _mm_movehl_ps(s, v);
-            //  w       s       y       x
-            v = _v_shuffle_ps<1, 2, 1, 0>(v, r1);
-#endif
-        }
-    };
+    void VECTORCALL operator=(Scalar const& a) {
+        _value = _v_insert_ps(_value, a._value, _index);
+    }
 
-    struct AssignW {
-        static void VECTORCALL op(__m128& v, __m128 const& s) {
-#if _HAS_SSE4_1
-            v = _v_blend_ps<1, 0, 0, 0>(v, s);
-#else
-            //  s       s       w       z
-            auto r1 = _mm_movehl_ps(s, v);
-            //  s       z       y       x
-            v = _v_shuffle_ps<3, 0, 1, 0>(v, r1);
-#endif
-        }
-    };
+private:
+    friend Vector;
+
+    VectorScalar(__m128& value, size_t index)
+        : _value(value)
+        , _index(index) {}
 
 private:
     __m128& _value;
@@ -348,13 +1343,27 @@ public:
     }
 
     Scalar VECTORCALL operator[](size_t index) const {
-        switch (index) {
-            case 0: return _v_shuffle_ps<0, 0, 0, 0>(_value, _value);
-            case 1: return _v_shuffle_ps<1, 1, 1, 1>(_value, _value);
-            case 2: return _v_shuffle_ps<2, 2, 2, 2>(_value, _value);
-            case 3: return _v_shuffle_ps<3, 3, 3, 3>(_value, _value);
-            default: UNREACHABLE;
-        }
+        return _v_extract_ps(_value, index);
+    }
+
+    //! Return element `I` of this vector.
+    template<int I>
+    Scalar VECTORCALL Extract() const {
+        static_assert(0 <= I && I < 4, "Element index out of range!");
+        return _v_extract_ps<I>(_value);
+    }
+
+    //! Return this vector with element `I` replaced by `s`.
+    template<int I>
+    Vector VECTORCALL Insert(Scalar const& s) const {
+        static_assert(0 <= I && I < 4, "Element index out of range!");
+        return _v_insert_ps<I>(_value, s._value);
+    }
+
+    //! Return the vector { v[X], v[Y], v[Z], v[W] } of elements of this vector.
+    template<int X, int Y, int Z, int W>
+    Vector VECTORCALL Swizzle() const {
+        return _v_shuffle_ps<W, Z, Y, X>(_value, _value);
     }
 
     bool VECTORCALL operator==(Vector const& a) const {
@@ -373,13 +1382,9 @@ public:
         return _mm_sub_ps(_value, a._value);
     }
 
-    Vector VECTORCALL operator*(Scalar const& s) const {
-        return _mm_mul_ps(_value, s._value);
-    }
+    _v_product<Vector> VECTORCALL operator*(Scalar const& s) const;
 
-    friend Vector VECTORCALL operator*(Scalar const& s, Vector const& a) {
-        return a * s;
-    }
+    friend _v_product<Vector> VECTORCALL operator*(Scalar const& s, Vector const& a);
 
     Vector VECTORCALL operator/(Scalar const& s) const {
         return _mm_div_ps(_value, s._value);
@@ -451,13 +1456,7 @@ public:
     //! Return the reflection of `a` onto this vector.
     Vector VECTORCALL Reflect(Vector const& a) const {
         auto proj = Project(a)._value;
-#if _HAS_FMA
-        auto scale = _mm_set_ps1(-2.0f);
-        return _mm_fmadd_ps(proj, scale, a._value);
-#else
-        auto r1 = _mm_mul_ps(_mm_set_ps1(2.0f), proj);
-        return _mm_sub_ps(a._value, r1);
-#endif
+        return _v_fnmadd_ps(_mm_set_ps1(2.0f), proj, a._value);
     }
 
     //! Return the component-wise product with `a`.
@@ -465,11 +1464,99 @@ public:
         return _mm_mul_ps(_value, a._value);
     }
 
+    //! Return the component-wise minimum with `a`.
+    Vector VECTORCALL Min(Vector const& a) const {
+        return _mm_min_ps(_value, a._value);
+    }
+
+    //! Return the component-wise maximum with `a`.
+    Vector VECTORCALL Max(Vector const& a) const {
+        return _mm_max_ps(_value, a._value);
+    }
+
+    //! Return each element clamped to the same element of `lo` and `hi`.
+    Vector VECTORCALL Clamp(Vector const& lo, Vector const& hi) const {
+        return _mm_min_ps(_mm_max_ps(_value, lo._value), hi._value);
+    }
+
+    //! Return each element clamped to `lo` and `hi`.
+    Vector VECTORCALL Clamp(Scalar const& lo, Scalar const& hi) const {
+        return _mm_min_ps(_mm_max_ps(_value, lo._value), hi._value);
+    }
+
+    //! Return the linear interpolation from this vector to `a` by `t`.
+    Vector VECTORCALL Lerp(Vector const& a, Scalar const& t) const {
+        return _v_fmadd_ps(_mm_sub_ps(a._value, _value), t._value, _value);
+    }
+
+    //! Return the component-wise absolute value.
+    Vector VECTORCALL Abs() const {
+        return _v_abs_ps(_value);
+    }
+
+    //! Return each element rounded toward negative infinity.
+    Vector VECTORCALL Floor() const {
+        return _v_floor_ps(_value);
+    }
+
+    //! Return each element rounded toward positive infinity.
+    Vector VECTORCALL Ceil() const {
+        return _v_ceil_ps(_value);
+    }
+
+    //! Return the minimum of the elements of this vector.
+    Scalar VECTORCALL HorizontalMin() const {
+        return _v_reduce_min_ps(_value);
+    }
+
+    //! Return the maximum of the elements of this vector.
+    Scalar VECTORCALL HorizontalMax() const {
+        return _v_reduce_max_ps(_value);
+    }
+
+    //! Return the sum of the elements of this vector.
+    Scalar VECTORCALL HorizontalSum() const {
+        return _v_reduce_add_ps(_value);
+    }
+
+    //! Return the component-wise minimum and maximum of `count` vectors in
+    //! `src`, which are +infinity and -infinity if `count` is zero.
+    static void VECTORCALL Bounds(Vector const* src, size_t count, Vector& min, Vector& max) {
+        _v_bounds_batch_ps(&src->_value, count, min._value, max._value);
+    }
+
+    //! Return the maximum length of `count` vectors in `src`, or zero if
+    //! `count` is zero.
+    static Scalar VECTORCALL MaxLength(Vector const* src, size_t count) {
+        return _mm_sqrt_ps(_v_max_lsqr_batch_ps(&src->_value, count));
+    }
+
+    //! Return `a` if `mask` is set, otherwise `b`, for each element.
+    friend Vector VECTORCALL Select(Mask const& mask, Vector const& a, Vector const& b) {
+        return _v_blendv_ps(b._value, a._value, mask._value);
+    }
+
+    //! Return this vector converted to half precision for storage.
+    HalfVector VECTORCALL ToHalfVector() const;
+
+    //! Return the first three elements of this vector for packed storage.
+    Vector3 VECTORCALL ToVector3() const;
+
 private:
     __m128 _value;
 
 private:
+    friend HalfVector;
+    friend Vector3;
+    friend Quaternion;
+    friend AffineMatrix;
     friend Matrix;
+    friend avx::Matrix;
+    template<size_t> friend class VectorPacket;
+#if _FUSED_EXPRESSIONS
+    template<typename> friend class _v_product;
+#endif // _FUSED_EXPRESSIONS
+    template<typename T> friend _v_product<T> VECTORCALL _v_mul(__m128, __m128);
 
     Vector(__m128 const& value)
         : _value(value) {}
@@ -477,6 +1564,393 @@ private:
 
 static_assert(alignof(Vector) == alignof(__m128), "Bad alignment!");
 
+#if _FUSED_EXPRESSIONS
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Product of two scalars or of a vector and a scalar which keeps its factors,
+ * so that adding or subtracting another value of the same type is fused into
+ * a single multiply-add, e.g. `ray.start + rayVec * t` or `B * B - 4 * A * C`.
+ * The product is also computed on construction so that it can be used as `T`
+ * for any other operation, the multiply is removed by the compiler if only
+ * the fused result is used.
+ */
+template<typename T>
+class _v_product : public T {
+public:
+    friend T VECTORCALL operator+(_v_product const& p, T const& c) {
+        return make(_v_fmadd_ps(p._a, p._b, value(c)));
+    }
+
+    friend T VECTORCALL operator+(T const& c, _v_product const& p) {
+        return make(_v_fmadd_ps(p._a, p._b, value(c)));
+    }
+
+    friend T VECTORCALL operator+(_v_product const& p, _v_product const& q) {
+        return make(_v_fmadd_ps(p._a, p._b, value(q)));
+    }
+
+    friend T VECTORCALL operator-(_v_product const& p, T const& c) {
+        return make(_v_fmsub_ps(p._a, p._b, value(c)));
+    }
+
+    friend T VECTORCALL operator-(T const& c, _v_product const& p) {
+        return make(_v_fnmadd_ps(p._a, p._b, value(c)));
+    }
+
+    friend T VECTORCALL operator-(_v_product const& p, _v_product const& q) {
+        return make(_v_fmsub_ps(p._a, p._b, value(q)));
+    }
+
+private:
+    __m128 _a;
+    __m128 _b;
+
+private:
+    template<typename U> friend _v_product<U> VECTORCALL _v_mul(__m128, __m128);
+
+    // Friend functions are not friends of `T`, access its members through
+    // this class instead.
+    static __m128 VECTORCALL value(T const& a) {
+        return a._value;
+    }
+
+    static T VECTORCALL make(__m128 const& a) {
+        return T(a);
+    }
+
+    _v_product(__m128 const& a, __m128 const& b)
+        : T(_mm_mul_ps(a, b))
+        , _a(a)
+        , _b(b) {}
+};
+
+//  Sums of a scalar product and a float would otherwise be ambiguous between
+//  converting the float to `Scalar` and converting the product to `Scalar`.
+
+inline Scalar VECTORCALL operator+(_v_product<Scalar> const& p, float c) {
+    return p + Scalar(c);
+}
+
+inline Scalar VECTORCALL operator+(float c, _v_product<Scalar> const& p) {
+    return Scalar(c) + p;
+}
+
+inline Scalar VECTORCALL operator-(_v_product<Scalar> const& p, float c) {
+    return p - Scalar(c);
+}
+
+inline Scalar VECTORCALL operator-(float c, _v_product<Scalar> const& p) {
+    return Scalar(c) - p;
+}
+
+template<typename T>
+inline _v_product<T> VECTORCALL _v_mul(__m128 src0, __m128 src1)
+{
+    return _v_product<T>(src0, src1);
+}
+
+#else // _FUSED_EXPRESSIONS
+
+template<typename T>
+inline _v_product<T> VECTORCALL _v_mul(__m128 src0, __m128 src1)
+{
+    return T(_mm_mul_ps(src0, src1));
+}
+
+#endif // _FUSED_EXPRESSIONS
+
+////////////////////////////////////////////////////////////////////////////////
+//  Products are defined after `_v_product` which derives from `Scalar` and
+//  `Vector` and is therefore incomplete within either class.
+
+inline _v_product<Scalar> VECTORCALL Scalar::operator*(Scalar const& a) const {
+    return _v_mul<Scalar>(_value, a._value);
+}
+
+inline _v_product<Scalar> VECTORCALL operator*(float a, Scalar const& b) {
+    return _v_mul<Scalar>(_mm_set_ps1(a), b._value);
+}
+
+inline _v_product<Vector> VECTORCALL Vector::operator*(Scalar const& s) const {
+    return _v_mul<Vector>(_value, s._value);
+}
+
+inline _v_product<Vector> VECTORCALL operator*(Scalar const& s, Vector const& a) {
+    return a * s;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Half precision storage for a `Vector` in 8 bytes, for data which is streamed
+ * from memory more often than it is modified, e.g. normals and colors. There
+ * is no arithmetic on half precision values, they are converted to `Vector`
+ * and back.
+ */
+class alignas(8) HalfVector {
+public:
+    HalfVector() {}
+    HalfVector(float X, float Y, float Z, float W)
+        : HalfVector(Vector(X, Y, Z, W)) {}
+    //! Convert `v` to half precision, rounding to nearest even.
+    explicit HalfVector(Vector const& v) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(_value), _v_cvtps_ph(v._value));
+    }
+
+    //! Return this vector converted to single precision.
+    Vector VECTORCALL ToVector() const {
+        return _v_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(_value)));
+    }
+
+    //! Convert `count` vectors from `src` to half precision in `dst`.
+    static void VECTORCALL Pack(Vector const* src, HalfVector* dst, size_t count) {
+        _v_cvtps_ph_batch(&src->_value, dst->_value, count);
+    }
+
+    //! Convert `count` vectors from `src` to single precision in `dst`.
+    static void VECTORCALL Unpack(HalfVector const* src, Vector* dst, size_t count) {
+        _v_cvtph_ps_batch(src->_value, &dst->_value, count);
+    }
+
+private:
+    uint16_t _value[4];
+};
+
+static_assert(sizeof(HalfVector) == 8, "Bad size!");
+
+inline HalfVector VECTORCALL Vector::ToHalfVector() const {
+    return HalfVector(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Packed storage for the first three elements of a `Vector` in 12 bytes, for
+ * large arrays of positions and directions which would otherwise waste a
+ * quarter of their memory and cache on the fourth element. There is no
+ * arithmetic on packed vectors, they are converted to `Vector` and back.
+ */
+class Vector3 {
+public:
+    Vector3() {}
+    Vector3(float X, float Y, float Z)
+        : _value{X, Y, Z} {}
+    //! Store the first three elements of `v`.
+    explicit Vector3(Vector const& v) {
+        _v_store3_ps(_value, v._value);
+    }
+
+    //! Return this vector with `w` in the fourth element, e.g. 1 for points.
+    Vector VECTORCALL ToVector(float w = 0.f) const {
+        return _v_load3_ps(_value, _mm_set_ss(w));
+    }
+
+    //! Store the first three elements of `count` vectors from `src` in `dst`.
+    static void VECTORCALL Pack(Vector const* src, Vector3* dst, size_t count) {
+        _v_store3_ps_batch(&src->_value, dst->_value, count);
+    }
+
+    //! Load `count` vectors from `src` to `dst` with `w` in the fourth element.
+    static void VECTORCALL Unpack(Vector3 const* src, Vector* dst, size_t count, float w = 0.f) {
+        _v_load3_ps_batch(src->_value, &dst->_value, count, w);
+    }
+
+private:
+    float _value[3];
+};
+
+static_assert(sizeof(Vector3) == 12, "Bad size!");
+
+inline Vector3 VECTORCALL Vector::ToVector3() const {
+    return Vector3(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Rotation quaternion stored in a single register as { w, z, y, x }, where w
+ * is the real part. Operations other than the Hamilton product, conjugate and
+ * normalization expect unit quaternions.
+ */
+class Quaternion {
+public:
+    Quaternion() {}
+    Quaternion(float X, float Y, float Z, float W)
+        : _value(_mm_set_ps(W, Z, Y, X)) {}
+
+    //! Construct a rotation of `angle` radians about the unit vector `axis`.
+    Quaternion(Vector const& axis, float angle) {
+        __m128 s, c;
+        _v_sincos_ps(_mm_set_ps1(.5f * angle), s, c);
+        _value = _v_blend_ps<1, 0, 0, 0>(_mm_mul_ps(axis._value, s), c);
+    }
+
+    bool VECTORCALL operator==(Quaternion const& a) const {
+        return _mm_movemask_ps(_mm_cmpeq_ps(_value, a._value)) == 0xf;
+    }
+
+    bool VECTORCALL operator!=(Quaternion const& a) const {
+        return _mm_movemask_ps(_mm_cmpneq_ps(_value, a._value)) != 0x0;
+    }
+
+    //! Hamilton product, i.e. the rotation by `a` followed by this rotation.
+    Quaternion VECTORCALL operator*(Quaternion const& a) const {
+        return _v_quat_mul_ps(_value, a._value);
+    }
+
+    Quaternion VECTORCALL operator-() const {
+        return _mm_sub_ps(_mm_setzero_ps(), _value);
+    }
+
+    //! Return the conjugate, which is the inverse rotation.
+    Quaternion VECTORCALL Conjugate() const {
+        return _mm_xor_ps(_value, _mm_set_ps(0.f, -0.f, -0.f, -0.f));
+    }
+
+    //! Dot product in R4.
+    Scalar VECTORCALL Dot(Quaternion const& a) const {
+        return _v_dp_ps(_value, a._value);
+    }
+
+    Scalar VECTORCALL Length() const {
+        return _mm_sqrt_ps(_v_dp_ps(_value, _value));
+    }
+
+    Quaternion VECTORCALL Normalize() const {
+        return _mm_div_ps(_value, _mm_sqrt_ps(_v_dp_ps(_value, _value)));
+    }
+
+    //! Return `v` rotated by this quaternion. The w component is unchanged.
+    Vector VECTORCALL Rotate(Vector const& v) const {
+        return _v_quat_rotate_ps(_value, v._value);
+    }
+
+    //! Return the normalized linear interpolation to `a` at the fraction `t`.
+    Quaternion VECTORCALL Nlerp(Quaternion const& a, Scalar const& t) const {
+        auto d = _v_dp_ps(_value, a._value);
+        auto sign = _mm_and_ps(d, _mm_set_ps1(-0.f));
+        auto r1 = _mm_sub_ps(_mm_xor_ps(a._value, sign), _value);
+        auto r2 = _v_fmadd_ps(r1, t._value, _value);
+        return _mm_div_ps(r2, _mm_sqrt_ps(_v_dp_ps(r2, r2)));
+    }
+
+    //! Return the spherical linear interpolation to `a` at the fraction `t`.
+    Quaternion VECTORCALL Slerp(Quaternion const& a, Scalar const& t) const {
+        return _v_quat_slerp_ps(_value, a._value, t._value);
+    }
+
+    //! Spherical linear interpolation of `count` pairs of quaternions from `a`
+    //! and `b` at the fractions `t` into `dst`, see `_v_quat_slerp4_ps`.
+    static void VECTORCALL SlerpBatch(Quaternion const* a, Quaternion const* b, float const* t, Quaternion* dst, size_t count) {
+        size_t ii = 0;
+
+        for (; ii + 3 < count; ii += 4) {
+            __m128 const src0[4] = { a[ii]._value, a[ii + 1]._value, a[ii + 2]._value, a[ii + 3]._value };
+            __m128 const src1[4] = { b[ii]._value, b[ii + 1]._value, b[ii + 2]._value, b[ii + 3]._value };
+            __m128 r[4];
+            _v_quat_slerp4_ps(src0, src1, _mm_loadu_ps(t + ii), r);
+
+            dst[ii + 0]._value = r[0];
+            dst[ii + 1]._value = r[1];
+            dst[ii + 2]._value = r[2];
+            dst[ii + 3]._value = r[3];
+        }
+
+        for (; ii < count; ++ii) {
+            dst[ii]._value = _v_quat_slerp_ps(a[ii]._value, b[ii]._value, _mm_set_ps1(t[ii]));
+        }
+    }
+
+private:
+    __m128 _value;
+
+private:
+    friend Matrix;
+    friend avx::Matrix;
+
+    Quaternion(__m128 const& value)
+        : _value(value) {}
+};
+
+static_assert(alignof(Quaternion) == alignof(__m128), "Bad alignment!");
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Affine transform stored as the first three rows of a 4x4 matrix, the last
+ * row is implicitly { 0, 0, 0, 1 }. Storing rows instead of columns requires
+ * 48 bytes instead of 64 and skips the products with the last row.
+ */
+class AffineMatrix {
+public:
+    AffineMatrix() {}
+    //! Construct with column vectors, the last element of each is ignored.
+    AffineMatrix(Vector const& X, Vector const& Y, Vector const& Z, Vector const& W) {
+        __m128 const src[4] = { X._value, Y._value, Z._value, W._value };
+        __m128 dst[4];
+        _v_transpose_ps(src, dst);
+        x = dst[0];
+        y = dst[1];
+        z = dst[2];
+    }
+    AffineMatrix(float m11, float m12, float m13, float m14,
+                 float m21, float m22, float m23, float m24,
+                 float m31, float m32, float m33, float m34)
+        : x(m11, m12, m13, m14)
+        , y(m21, m22, m23, m24)
+        , z(m31, m32, m33, m34) {}
+
+    bool VECTORCALL operator==(AffineMatrix const& a) const {
+        return x == a.x && y == a.y && z == a.z;
+    }
+
+    bool VECTORCALL operator!=(AffineMatrix const& a) const {
+        return x != a.x || y != a.y || z != a.z;
+    }
+
+    //! Product with `v` as a 4x4 matrix, i.e. the last element is unchanged.
+    Vector VECTORCALL operator*(Vector const& v) const {
+        __m128 const src[3] = { x._value, y._value, z._value };
+        return _v_affine_mul_ps(src, v._value);
+    }
+
+    //! Return the composition of this transform with `a`, i.e. the transform
+    //! by `a` followed by this transform.
+    AffineMatrix VECTORCALL operator*(AffineMatrix const& a) const {
+        __m128 const src0[3] = { x._value, y._value, z._value };
+        __m128 const src1[3] = { a.x._value, a.y._value, a.z._value };
+        __m128 dst[3];
+        _v_affine_mul_ps(src0, src1, dst);
+        return AffineMatrix(dst[0], dst[1], dst[2]);
+    }
+
+    //! Return the point `p` transformed by rotation, scale and translation.
+    //! The last element of `p` is ignored and the last element of the result
+    //! is one.
+    Vector VECTORCALL TransformPoint(Vector const& p) const {
+        __m128 const src[3] = { x._value, y._value, z._value };
+        return _v_affine_mul_ps(src, _v_blend_ps<1, 0, 0, 0>(p._value, _mm_set_ps1(1.f)));
+    }
+
+    //! Return the direction `v` transformed by rotation and scale only. The
+    //! last element of `v` is ignored and the last element of the result is
+    //! zero.
+    Vector VECTORCALL TransformDirection(Vector const& v) const {
+        __m128 const src[3] = { x._value, y._value, z._value };
+        return _v_affine_mul_ps(src, _v_blend_ps<1, 0, 0, 0>(v._value, _mm_setzero_ps()));
+    }
+
+protected:
+    //! Rows of the matrix, e.g. `x` produces the x component of a product.
+    Vector x, y, z;
+
+protected:
+    friend Matrix;
+    friend avx::Matrix;
+
+    AffineMatrix(__m128 const& X, __m128 const& Y, __m128 const& Z)
+        : x(X), y(Y), z(Z) {}
+};
+
+static_assert(sizeof(AffineMatrix) == 3 * sizeof(__m128), "Bad size!");
+
 ////////////////////////////////////////////////////////////////////////////////
 /**
  */
@@ -495,6 +1969,27 @@ public:
         , z(m13, m23, m33, m43)
         , w(m14, m24, m34, m44) {}
 
+    //! Construct the rotation matrix of the unit quaternion `q`.
+    explicit Matrix(Quaternion const& q) {
+        __m128 dst[4];
+        _v_quat_to_matrix_ps(q._value, dst);
+        x = dst[0];
+        y = dst[1];
+        z = dst[2];
+        w = dst[3];
+    }
+
+    //! Construct from an affine transform.
+    explicit Matrix(AffineMatrix const& a) {
+        __m128 const src[4] = { a.x._value, a.y._value, a.z._value, _mm_set_ps(1.f, 0.f, 0.f, 0.f) };
+        __m128 dst[4];
+        _v_transpose_ps(src, dst);
+        x = dst[0];
+        y = dst[1];
+        z = dst[2];
+        w = dst[3];
+    }
+
     Vector& VECTORCALL operator[](size_t index) {
         return (&x)[index];
     }
@@ -601,6 +2096,77 @@ public:
                       _mm_mul_ps(w._value, a.w._value));
     }
 
+    //! Return the determinant.
+    Scalar VECTORCALL Determinant() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        return _v_determinant_ps(src);
+    }
+
+    //! Return the inverse. The result is not finite if the matrix is singular,
+    //! i.e. if the determinant is zero.
+    Matrix VECTORCALL Inverse() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        __m128 dst[4];
+        _v_inverse_ps(src, dst);
+        return Matrix(dst[0], dst[1], dst[2], dst[3]);
+    }
+
+    //! Return the inverse of an affine transform which is composed of only
+    //! rotation, scale and translation, see `_v_inverse_affine_ps`.
+    Matrix VECTORCALL InverseAffine() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        __m128 dst[4];
+        _v_inverse_affine_ps(src, dst);
+        return Matrix(dst[0], dst[1], dst[2], dst[3]);
+    }
+
+    //! Invert `count` matrices from `src` into `dst`.
+    static void VECTORCALL InverseBatch(Matrix const* src, Matrix* dst, size_t count) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = src[ii].Inverse();
+        }
+    }
+
+    //! Transform `count` points from `src` into `dst`, treating the last
+    //! element of each point as one. If `stream` is true the results are
+    //! written with non-temporal stores, which is faster when `dst` is larger
+    //! than the last level cache and is not read again soon.
+    void VECTORCALL TransformPoints(Vector const* src, Vector* dst, size_t count, bool stream = false) const {
+        __m128 const m[4] = { x._value, y._value, z._value, w._value };
+        if (stream) {
+            _v_transform_batch_ps<true, true>(m, &src->_value, &dst->_value, count);
+        } else {
+            _v_transform_batch_ps<true, false>(m, &src->_value, &dst->_value, count);
+        }
+    }
+
+    //! Transform `count` directions from `src` into `dst`, treating the last
+    //! element of each direction as zero, see `TransformPoints`.
+    void VECTORCALL TransformDirections(Vector const* src, Vector* dst, size_t count, bool stream = false) const {
+        __m128 const m[4] = { x._value, y._value, z._value, w._value };
+        if (stream) {
+            _v_transform_batch_ps<false, true>(m, &src->_value, &dst->_value, count);
+        } else {
+            _v_transform_batch_ps<false, false>(m, &src->_value, &dst->_value, count);
+        }
+    }
+
+    //! Return the unit quaternion of the rotation in the upper 3x3 block,
+    //! which must be orthonormal.
+    Quaternion VECTORCALL ToQuaternion() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        return _v_matrix_to_quat_ps(src);
+    }
+
+    //! Return the first three rows as an affine transform. The last row must
+    //! be { 0, 0, 0, 1 }.
+    AffineMatrix VECTORCALL ToAffineMatrix() const {
+        __m128 const src[4] = { x._value, y._value, z._value, w._value };
+        __m128 dst[4];
+        _v_transpose_ps(src, dst);
+        return AffineMatrix(dst[0], dst[1], dst[2]);
+    }
+
 protected:
     Vector x, y, z, w;
 
@@ -0,0 +1,740 @@
+#pragma once
+
+#include "Features.h"
+#include "Platform.h"
+
+#include <cassert>
+#include <cmath>
+
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <immintrin.h>
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Double precision implementation with the same interface as the `intrinsic`
+ * scalar, vector and matrix types, for coordinates whose magnitude leaves too
+ * few bits of single precision for the detail around them, e.g. positions far
+ * from the origin of a large world.
+ *
+ * Following the conventions of `intrinsic`, register values are written from
+ * most to least significant. Vectors are stored as a pair of 128-bit registers
+ *
+ *  V.lo[127:0] = { y, x }
+ *  V.hi[127:0] = { w, z }
+ *
+ * so that they only require the alignment of `__m128d`, which is needed for
+ * use in standard containers without aligned allocation. Operations are done
+ * on both halves at once in a 256-bit register when AVX is available and on
+ * each half otherwise. Scalars are broadcast to both elements of a 128-bit
+ * register.
+ */
+
+#if !_HAS_SSE2
+#   error Double precision implementation requires at least SSE2 instruction set!
+#endif
+
+namespace intrinsic_d {
+
+////////////////////////////////////////////////////////////////////////////////
+//! Storage of four doubles as a pair of 128-bit registers.
+struct _v_pd4 {
+    __m128d lo;
+    __m128d hi;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//  Operations on four doubles in the register type `_v_reg`, which is loaded
+//  from and stored to `_v_pd4`.
+
+#if _HAS_AVX
+
+using _v_reg = __m256d;
+
+inline _v_reg VECTORCALL _v_load_pd(_v_pd4 const& src)
+{
+    return _mm256_insertf128_pd(_mm256_castpd128_pd256(src.lo), src.hi, 1);
+}
+
+inline _v_pd4 VECTORCALL _v_store_pd(_v_reg src)
+{
+    return { _mm256_castpd256_pd128(src), _mm256_extractf128_pd(src, 1) };
+}
+
+//! Broadcast `src`, whose elements must be equal, to each element.
+inline _v_reg VECTORCALL _v_dup_pd(__m128d src)
+{
+    return _mm256_insertf128_pd(_mm256_castpd128_pd256(src), src, 1);
+}
+
+inline _v_reg VECTORCALL _v_add_pd(_v_reg src0, _v_reg src1) { return _mm256_add_pd(src0, src1); }
+inline _v_reg VECTORCALL _v_sub_pd(_v_reg src0, _v_reg src1) { return _mm256_sub_pd(src0, src1); }
+inline _v_reg VECTORCALL _v_mul_pd(_v_reg src0, _v_reg src1) { return _mm256_mul_pd(src0, src1); }
+inline _v_reg VECTORCALL _v_div_pd(_v_reg src0, _v_reg src1) { return _mm256_div_pd(src0, src1); }
+
+//! Returns the mask of elements which are equal in bits [3:0].
+inline int VECTORCALL _v_cmpeq_mask_pd(_v_reg src0, _v_reg src1)
+{
+    return _mm256_movemask_pd(_mm256_cmp_pd(src0, src1, _CMP_EQ_OQ));
+}
+
+//! Multiply and add, fused if available.
+//!     dst[255:0] = src0[255:0] * src1[255:0] + src2[255:0]
+inline _v_reg VECTORCALL _v_fmadd_pd(_v_reg src0, _v_reg src1, _v_reg src2)
+{
+#if _HAS_FMA
+    return _mm256_fmadd_pd(src0, src1, src2);
+#else
+    return _mm256_add_pd(_mm256_mul_pd(src0, src1), src2);
+#endif
+}
+
+//! Select elements of `src` based on the template arguments.
+//!     dst[255:0] = { src[w], src[z], src[y], src[x] }
+template<int W, int Z, int Y, int X>
+inline _v_reg VECTORCALL _v_permute_pd(_v_reg src)
+{
+    static_assert(0 <= W && W < 4, "Element index out of range!");
+    static_assert(0 <= Z && Z < 4, "Element index out of range!");
+    static_assert(0 <= Y && Y < 4, "Element index out of range!");
+    static_assert(0 <= X && X < 4, "Element index out of range!");
+
+#if _HAS_AVX2
+    return _mm256_permute4x64_pd(src, ((W << 6) | (Z << 4) | (Y << 2) | (X << 0)));
+#else
+    //  Permutes only select within each 128-bit half, so select from copies
+    //  of each half and blend the results.
+    //  y       x       y       x
+    auto r1 = _mm256_permute2f128_pd(src, src, 0x00);
+    //  w       z       w       z
+    auto r2 = _mm256_permute2f128_pd(src, src, 0x11);
+    constexpr int odd = ((W & 1) << 3) | ((Z & 1) << 2) | ((Y & 1) << 1) | ((X & 1) << 0);
+    constexpr int high = ((W >> 1) << 3) | ((Z >> 1) << 2) | ((Y >> 1) << 1) | ((X >> 1) << 0);
+    return _mm256_blend_pd(_mm256_permute_pd(r1, odd), _mm256_permute_pd(r2, odd), high);
+#endif
+}
+
+//! Dot product of `src0` and `src1`, broadcast to both elements.
+inline __m128d VECTORCALL _v_dp_pd(_v_reg src0, _v_reg src1)
+{
+    auto r1 = _mm256_mul_pd(src0, src1);
+    //  z+w     z+w     x+y     x+y
+    auto r2 = _mm256_hadd_pd(r1, r1);
+    return _mm_add_pd(_mm256_castpd256_pd128(r2), _mm256_extractf128_pd(r2, 1));
+}
+
+#else // _HAS_AVX
+
+using _v_reg = _v_pd4;
+
+inline _v_reg VECTORCALL _v_load_pd(_v_pd4 const& src)
+{
+    return src;
+}
+
+inline _v_pd4 VECTORCALL _v_store_pd(_v_reg src)
+{
+    return src;
+}
+
+//! Broadcast `src`, whose elements must be equal, to each element.
+inline _v_reg VECTORCALL _v_dup_pd(__m128d src)
+{
+    return { src, src };
+}
+
+inline _v_reg VECTORCALL _v_add_pd(_v_reg src0, _v_reg src1) { return { _mm_add_pd(src0.lo, src1.lo), _mm_add_pd(src0.hi, src1.hi) }; }
+inline _v_reg VECTORCALL _v_sub_pd(_v_reg src0, _v_reg src1) { return { _mm_sub_pd(src0.lo, src1.lo), _mm_sub_pd(src0.hi, src1.hi) }; }
+inline _v_reg VECTORCALL _v_mul_pd(_v_reg src0, _v_reg src1) { return { _mm_mul_pd(src0.lo, src1.lo), _mm_mul_pd(src0.hi, src1.hi) }; }
+inline _v_reg VECTORCALL _v_div_pd(_v_reg src0, _v_reg src1) { return { _mm_div_pd(src0.lo, src1.lo), _mm_div_pd(src0.hi, src1.hi) }; }
+
+//! Returns the mask of elements which are equal in bits [3:0].
+inline int VECTORCALL _v_cmpeq_mask_pd(_v_reg src0, _v_reg src1)
+{
+    return _mm_movemask_pd(_mm_cmpeq_pd(src0.lo, src1.lo))
+         | _mm_movemask_pd(_mm_cmpeq_pd(src0.hi, src1.hi)) << 2;
+}
+
+//! Multiply and add, fused if available.
+//!     dst = src0 * src1 + src2
+inline _v_reg VECTORCALL _v_fmadd_pd(_v_reg src0, _v_reg src1, _v_reg src2)
+{
+#if _HAS_FMA
+    return { _mm_fmadd_pd(src0.lo, src1.lo, src2.lo), _mm_fmadd_pd(src0.hi, src1.hi, src2.hi) };
+#else
+    return _v_add_pd(_v_mul_pd(src0, src1), src2);
+#endif
+}
+
+//! Select elements of `src` based on the template arguments.
+//!     dst = { src[w], src[z], src[y], src[x] }
+template<int W, int Z, int Y, int X>
+inline _v_reg VECTORCALL _v_permute_pd(_v_reg src)
+{
+    static_assert(0 <= W && W < 4, "Element index out of range!");
+    static_assert(0 <= Z && Z < 4, "Element index out of range!");
+    static_assert(0 <= Y && Y < 4, "Element index out of range!");
+    static_assert(0 <= X && X < 4, "Element index out of range!");
+
+    return {
+        _mm_shuffle_pd(X < 2 ? src.lo : src.hi, Y < 2 ? src.lo : src.hi, ((Y & 1) << 1) | (X & 1)),
+        _mm_shuffle_pd(Z < 2 ? src.lo : src.hi, W < 2 ? src.lo : src.hi, ((W & 1) << 1) | (Z & 1)),
+    };
+}
+
+//! Dot product of `src0` and `src1`, broadcast to both elements.
+inline __m128d VECTORCALL _v_dp_pd(_v_reg src0, _v_reg src1)
+{
+    //  y*y+w*w x*x+z*z
+    auto r1 = _mm_add_pd(_mm_mul_pd(src0.lo, src1.lo), _mm_mul_pd(src0.hi, src1.hi));
+    return _mm_add_pd(r1, _mm_shuffle_pd(r1, r1, 1));
+}
+
+#endif // _HAS_AVX
+
+////////////////////////////////////////////////////////////////////////////////
+//! Select elements of `src0` and `src1` based on `mask`. Each element of `mask`
+//! must be either all ones or all zeros, i.e. the result of a packed compare.
+//!     dst[i] = mask[i] ? src1[i] : src0[i]
+inline __m128d VECTORCALL _v_blendv_pd(__m128d src0, __m128d src1, __m128d mask)
+{
+#if _HAS_SSE4_1
+    return _mm_blendv_pd(src0, src1, mask);
+#else
+    return _mm_or_pd(_mm_and_pd(mask, src1), _mm_andnot_pd(mask, src0));
+#endif
+}
+
+//! Broadcast element `index` of `src` to both elements of the result.
+inline __m128d VECTORCALL _v_broadcast_pd(_v_pd4 const& src, size_t index)
+{
+    switch (index) {
+        case 0: return _mm_unpacklo_pd(src.lo, src.lo);
+        case 1: return _mm_unpackhi_pd(src.lo, src.lo);
+        case 2: return _mm_unpacklo_pd(src.hi, src.hi);
+        case 3: return _mm_unpackhi_pd(src.hi, src.hi);
+        default: UNREACHABLE;
+    }
+}
+
+//! Replace element `index` of `dst` with the first element of `src`.
+inline void VECTORCALL _v_insert_pd(_v_pd4& dst, __m128d src, size_t index)
+{
+    switch (index) {
+        case 0: dst.lo = _mm_move_sd(dst.lo, src); return;
+        case 1: dst.lo = _mm_unpacklo_pd(dst.lo, src); return;
+        case 2: dst.hi = _mm_move_sd(dst.hi, src); return;
+        case 3: dst.hi = _mm_unpacklo_pd(dst.hi, src); return;
+        default: UNREACHABLE;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Forward declarations
+class Mask;
+class Scalar;
+class VectorScalar;
+class Vector;
+class Matrix;
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Result of a comparison of `Scalar`, see `intrinsic::Mask`.
+ */
+class Mask {
+public:
+    Mask() {}
+
+    //! Returns true if any element is set, so that comparisons of `Scalar`
+    //! can still be used as `bool`, e.g. `bool inside = s < t;`.
+    VECTORCALL operator bool() const {
+        return _mm_movemask_pd(_value) != 0;
+    }
+
+    Mask VECTORCALL operator&(Mask const& a) const {
+        return _mm_and_pd(_value, a._value);
+    }
+
+    Mask VECTORCALL operator|(Mask const& a) const {
+        return _mm_or_pd(_value, a._value);
+    }
+
+    Mask VECTORCALL operator^(Mask const& a) const {
+        return _mm_xor_pd(_value, a._value);
+    }
+
+    Mask VECTORCALL operator~() const {
+        return _mm_xor_pd(_value, _mm_castsi128_pd(_mm_set1_epi32(-1)));
+    }
+
+    friend bool VECTORCALL Any(Mask const& a) {
+        return _mm_movemask_pd(a._value) != 0x0;
+    }
+
+    friend bool VECTORCALL All(Mask const& a) {
+        return _mm_movemask_pd(a._value) == 0x3;
+    }
+
+    friend bool VECTORCALL None(Mask const& a) {
+        return _mm_movemask_pd(a._value) == 0x0;
+    }
+
+    //! Return elements of `a` where `mask` is set, otherwise elements of `b`.
+    friend Mask VECTORCALL Select(Mask const& mask, Mask const& a, Mask const& b) {
+        return _v_blendv_pd(b._value, a._value, mask._value);
+    }
+
+private:
+    __m128d _value;
+
+private:
+    friend Scalar;
+    friend VectorScalar;
+    friend Vector;
+
+    friend Scalar VECTORCALL Select(Mask const& mask, Scalar const& a, Scalar const& b);
+    friend Vector VECTORCALL Select(Mask const& mask, Vector const& a, Vector const& b);
+
+    Mask(__m128d const& value)
+        : _value(value) {}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ */
+class Scalar {
+public:
+    using value_type = double;
+
+public:
+    Scalar() {}
+    Scalar(double X)
+        : _value(_mm_set1_pd(X)) {}
+
+    explicit operator float() const {
+        return float(_mm_cvtsd_f64(_value));
+    }
+
+    explicit operator double() const {
+        return _mm_cvtsd_f64(_value);
+    }
+
+    Mask VECTORCALL operator==(Scalar const& a) const {
+        return _mm_cmpeq_pd(_value, a._value);
+    }
+
+    Mask VECTORCALL operator!=(Scalar const& a) const {
+        return _mm_cmpneq_pd(_value, a._value);
+    }
+
+    Mask VECTORCALL operator<(Scalar const& a) const {
+        return _mm_cmplt_pd(_value, a._value);
+    }
+
+    Mask VECTORCALL operator>(Scalar const& a) const {
+        return _mm_cmpgt_pd(_value, a._value);
+    }
+
+    Mask VECTORCALL operator<=(Scalar const& a) const {
+        return _mm_cmple_pd(_value, a._value);
+    }
+
+    Mask VECTORCALL operator>=(Scalar const& a) const {
+        return _mm_cmpge_pd(_value, a._value);
+    }
+
+    friend Mask VECTORCALL operator<(double a, Scalar const& b) {
+        return Scalar(a) < b;
+    }
+
+    friend Mask VECTORCALL operator>(double a, Scalar const& b) {
+        return Scalar(a) > b;
+    }
+
+    friend Mask VECTORCALL operator<=(double a, Scalar const& b) {
+        return Scalar(a) <= b;
+    }
+
+    friend Mask VECTORCALL operator>=(double a, Scalar const& b) {
+        return Scalar(a) >= b;
+    }
+
+    Scalar VECTORCALL operator-() const {
+        return _mm_sub_pd(_mm_setzero_pd(), _value);
+    }
+
+    Scalar VECTORCALL operator+(Scalar const& a) const {
+        return _mm_add_pd(_value, a._value);
+    }
+
+    Scalar VECTORCALL operator-(Scalar const& a) const {
+        return _mm_sub_pd(_value, a._value);
+    }
+
+    Scalar VECTORCALL operator*(Scalar const& a) const {
+        return _mm_mul_pd(_value, a._value);
+    }
+
+    Scalar VECTORCALL operator/(Scalar const& a) const {
+        return _mm_div_pd(_value, a._value);
+    }
+
+    friend Scalar VECTORCALL operator+(double a, Scalar const& b) {
+        return _mm_add_pd(_mm_set1_pd(a), b._value);
+    }
+
+    friend Scalar VECTORCALL operator-(double a, Scalar const& b) {
+        return _mm_sub_pd(_mm_set1_pd(a), b._value);
+    }
+
+    friend Scalar VECTORCALL operator*(double a, Scalar const& b) {
+        return _mm_mul_pd(_mm_set1_pd(a), b._value);
+    }
+
+    friend Scalar VECTORCALL operator/(double a, Scalar const& b) {
+        return _mm_div_pd(_mm_set1_pd(a), b._value);
+    }
+
+    friend Scalar VECTORCALL abs(Scalar const& a) {
+        return _mm_andnot_pd(_mm_set1_pd(-0.0), a._value);
+    }
+
+    friend Scalar VECTORCALL sqrt(Scalar const& a) {
+        return _mm_sqrt_pd(a._value);
+    }
+
+    //  There are no packed transcendental functions in double precision, the
+    //  standard library functions are used on the broadcast element.
+
+    friend Scalar VECTORCALL exp(Scalar const& a) {
+        return std::exp(double(a));
+    }
+
+    friend Scalar VECTORCALL exp2(Scalar const& a) {
+        return std::exp2(double(a));
+    }
+
+    friend Scalar VECTORCALL log(Scalar const& a) {
+        return std::log(double(a));
+    }
+
+    friend Scalar VECTORCALL log2(Scalar const& a) {
+        return std::log2(double(a));
+    }
+
+    friend Scalar VECTORCALL pow(Scalar const& a, Scalar const& b) {
+        return std::pow(double(a), double(b));
+    }
+
+    friend Scalar VECTORCALL sin(Scalar const& a) {
+        return std::sin(double(a));
+    }
+
+    friend Scalar VECTORCALL cos(Scalar const& a) {
+        return std::cos(double(a));
+    }
+
+    //! Return `a` if `mask` is set, otherwise `b`.
+    friend Scalar VECTORCALL Select(Mask const& mask, Scalar const& a, Scalar const& b) {
+        return _v_blendv_pd(b._value, a._value, mask._value);
+    }
+
+private:
+    __m128d _value;
+
+private:
+    friend VectorScalar;
+    friend Vector;
+    friend Matrix;
+
+    Scalar(__m128d const& value)
+        : _value(value) {}
+};
+
+static_assert(alignof(Scalar) == alignof(__m128d), "Bad alignment!");
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Reference to an element of a `Vector`, see `intrinsic::VectorScalar`.
+ */
+class VectorScalar {
+public:
+    Mask VECTORCALL operator==(Scalar const& s) const {
+        return s == *this;
+    }
+
+    Mask VECTORCALL operator!=(Scalar const& s) const {
+        return s != *this;
+    }
+
+    Mask VECTORCALL operator<(Scalar const& s) const {
+        return s > *this;
+    }
+
+    Mask VECTORCALL operator>(Scalar const& s) const {
+        return s < *this;
+    }
+
+    Mask VECTORCALL operator<=(Scalar const& s) const {
+        return s >= *this;
+    }
+
+    Mask VECTORCALL operator>=(Scalar const& s) const {
+        return s <= *this;
+    }
+
+    VECTORCALL operator Scalar() const {
+        return _v_broadcast_pd(_value, _index);
+    }
+
+    void VECTORCALL operator=(Scalar const& a) {
+        _v_insert_pd(_value, a._value, _index);
+    }
+
+private:
+    friend Vector;
+
+    VectorScalar(_v_pd4& value, size_t index)
+        : _value(value)
+        , _index(index) {}
+
+    _v_pd4& _value;
+    size_t _index;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ */
+class Vector {
+public:
+    Vector() {}
+    Vector(double X, double Y, double Z, double W)
+        : _value{_mm_set_pd(Y, X), _mm_set_pd(W, Z)} {}
+
+    VectorScalar VECTORCALL operator[](size_t index) {
+        return VectorScalar(_value, index);
+    }
+
+    Scalar VECTORCALL operator[](size_t index) const {
+        return _v_broadcast_pd(_value, index);
+    }
+
+    bool VECTORCALL operator==(Vector const& a) const {
+        return _v_cmpeq_mask_pd(Reg(), a.Reg()) == 0xf;
+    }
+
+    bool VECTORCALL operator!=(Vector const& a) const {
+        return _v_cmpeq_mask_pd(Reg(), a.Reg()) != 0xf;
+    }
+
+    Vector VECTORCALL operator+(Vector const& a) const {
+        return _v_add_pd(Reg(), a.Reg());
+    }
+
+    Vector VECTORCALL operator-(Vector const& a) const {
+        return _v_sub_pd(Reg(), a.Reg());
+    }
+
+    Vector VECTORCALL operator*(Scalar const& s) const {
+        return _v_mul_pd(Reg(), _v_dup_pd(s._value));
+    }
+
+    friend Vector VECTORCALL operator*(Scalar const& s, Vector const& a) {
+        return a * s;
+    }
+
+    Vector VECTORCALL operator/(Scalar const& s) const {
+        return _v_div_pd(Reg(), _v_dup_pd(s._value));
+    }
+
+    Vector VECTORCALL operator-() const {
+        return _v_sub_pd(_v_dup_pd(_mm_setzero_pd()), Reg());
+    }
+
+    Scalar VECTORCALL Length() const {
+        return _mm_sqrt_pd(_v_dp_pd(Reg(), Reg()));
+    }
+
+    //! Same as `Length`, there is no reciprocal square root approximation in
+    //! double precision.
+    Scalar VECTORCALL LengthFast() const {
+        return Length();
+    }
+
+    Scalar VECTORCALL LengthSqr() const {
+        return _v_dp_pd(Reg(), Reg());
+    }
+
+    Vector VECTORCALL Normalize() const {
+        return _v_div_pd(Reg(), _v_dup_pd(_mm_sqrt_pd(_v_dp_pd(Reg(), Reg()))));
+    }
+
+    //! Same as `Normalize`, see `LengthFast`.
+    Vector VECTORCALL NormalizeFast() const {
+        return Normalize();
+    }
+
+    //! Dot product in R4.
+    Scalar VECTORCALL operator*(Vector const& a) const {
+        return _v_dp_pd(Reg(), a.Reg());
+    }
+
+    //! Cross product in R3.
+    Vector VECTORCALL operator%(Vector const& a) const {
+        auto r0 = Reg();
+        auto r1 = a.Reg();
+
+        //  w0*w1   x0*y1   z0*x1   y0*z1
+        auto prod1 = _v_mul_pd(_v_permute_pd<3, 0, 2, 1>(r0), _v_permute_pd<3, 1, 0, 2>(r1));
+        //  w0*w1   y0*x1   x0*z1   z0*y1
+        auto prod2 = _v_mul_pd(_v_permute_pd<3, 1, 0, 2>(r0), _v_permute_pd<3, 0, 2, 1>(r1));
+
+        return _v_sub_pd(prod1, prod2);
+    }
+
+    //! Return the projection of `a` onto this vector.
+    Vector VECTORCALL Project(Vector const& a) const {
+        auto lsqr = _v_dp_pd(Reg(), Reg());
+        auto dota = _v_dp_pd(Reg(), a.Reg());
+        return _v_mul_pd(Reg(), _v_dup_pd(_mm_div_pd(dota, lsqr)));
+    }
+
+    //! Return the rejection of `a` onto this vector.
+    Vector VECTORCALL Reject(Vector const& a) const {
+        return _v_sub_pd(a.Reg(), Project(a).Reg());
+    }
+
+    //! Return the reflection of `a` onto this vector.
+    Vector VECTORCALL Reflect(Vector const& a) const {
+        auto proj = Project(a).Reg();
+        return _v_sub_pd(a.Reg(), _v_add_pd(proj, proj));
+    }
+
+    //! Return the component-wise product with `a`.
+    Vector VECTORCALL Hadamard(Vector const& a) const {
+        return _v_mul_pd(Reg(), a.Reg());
+    }
+
+    //! Return `a` if `mask` is set, otherwise `b`, for each element.
+    friend Vector VECTORCALL Select(Mask const& mask, Vector const& a, Vector const& b) {
+        return _v_pd4{_v_blendv_pd(b._value.lo, a._value.lo, mask._value),
+                      _v_blendv_pd(b._value.hi, a._value.hi, mask._value)};
+    }
+
+private:
+    _v_pd4 _value;
+
+private:
+    friend Matrix;
+
+    Vector(_v_pd4 const& value)
+        : _value(value) {}
+
+#if _HAS_AVX
+    Vector(_v_reg const& value)
+        : _value(_v_store_pd(value)) {}
+#endif // _HAS_AVX
+
+    //! Load into a register for operations on all elements.
+    _v_reg VECTORCALL Reg() const {
+        return _v_load_pd(_value);
+    }
+};
+
+static_assert(alignof(Vector) == alignof(__m128d), "Bad alignment!");
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ */
+class Matrix {
+public:
+    Matrix() {}
+    //! Construct with column vectors
+    Matrix(Vector const& X, Vector const& Y, Vector const& Z, Vector const& W)
+        : x(X), y(Y), z(Z), w(W) {}
+    Matrix(double m11, double m12, double m13, double m14,
+           double m21, double m22, double m23, double m24,
+           double m31, double m32, double m33, double m34,
+           double m41, double m42, double m43, double m44)
+        : x(m11, m21, m31, m41)
+        , y(m12, m22, m32, m42)
+        , z(m13, m23, m33, m43)
+        , w(m14, m24, m34, m44) {}
+
+    Vector& VECTORCALL operator[](size_t index) {
+        return (&x)[index];
+    }
+
+    Vector const& VECTORCALL operator[](size_t index) const {
+        return (&x)[index];
+    }
+
+    bool VECTORCALL operator==(Matrix const& a) const {
+        return x == a.x && y == a.y && z == a.z && w == a.w;
+    }
+
+    bool VECTORCALL operator!=(Matrix const& a) const {
+        return x != a.x || y != a.y || z != a.z || w != a.w;
+    }
+
+    Matrix VECTORCALL operator+(Matrix const& a) const {
+        return Matrix(x + a.x, y + a.y, z + a.z, w + a.w);
+    }
+
+    Matrix VECTORCALL operator-(Matrix const& a) const {
+        return Matrix(x - a.x, y - a.y, z - a.z, w - a.w);
+    }
+
+    Matrix VECTORCALL operator*(Scalar const& s) const {
+        return Matrix(x * s, y * s, z * s, w * s);
+    }
+
+    Matrix VECTORCALL operator/(Scalar const& s) const {
+        return Matrix(x / s, y / s, z / s, w / s);
+    }
+
+    friend Matrix VECTORCALL operator*(Scalar const& s, Matrix const& m) {
+        return m * s;
+    }
+
+    Vector VECTORCALL operator*(Vector const& v) const {
+        auto r1 = _v_mul_pd(x.Reg(), _v_dup_pd(_v_broadcast_pd(v._value, 0)));
+        auto r2 = _v_mul_pd(y.Reg(), _v_dup_pd(_v_broadcast_pd(v._value, 1)));
+        r1 = _v_fmadd_pd(z.Reg(), _v_dup_pd(_v_broadcast_pd(v._value, 2)), r1);
+        r2 = _v_fmadd_pd(w.Reg(), _v_dup_pd(_v_broadcast_pd(v._value, 3)), r2);
+        return _v_add_pd(r1, r2);
+    }
+
+    Matrix VECTORCALL operator*(Matrix const& a) const {
+        return Matrix((*this) * a.x,
+                      (*this) * a.y,
+                      (*this) * a.z,
+                      (*this) * a.w);
+    }
+
+    Matrix VECTORCALL Transpose() const {
+        //  Each half of the result is a 2x2 transpose of a half of two columns.
+        return Matrix(
+            Vector(_v_pd4{_mm_unpacklo_pd(x._value.lo, y._value.lo), _mm_unpacklo_pd(z._value.lo, w._value.lo)}),
+            Vector(_v_pd4{_mm_unpackhi_pd(x._value.lo, y._value.lo), _mm_unpackhi_pd(z._value.lo, w._value.lo)}),
+            Vector(_v_pd4{_mm_unpacklo_pd(x._value.hi, y._value.hi), _mm_unpacklo_pd(z._value.hi, w._value.hi)}),
+            Vector(_v_pd4{_mm_unpackhi_pd(x._value.hi, y._value.hi), _mm_unpackhi_pd(z._value.hi, w._value.hi)})
+        );
+    }
+
+    //! Return the component-wise product with `a`.
+    Matrix VECTORCALL Hadamard(Matrix const& a) const {
+        return Matrix(x.Hadamard(a.x),
+                      y.Hadamard(a.y),
+                      z.Hadamard(a.z),
+                      w.Hadamard(a.w));
+    }
+
+protected:
+    Vector x, y, z, w;
+};
+
+static_assert(alignof(Matrix) == alignof(__m128d), "Bad alignment!");
+
+} // namespace intrinsic_d
@@ -0,0 +1,39 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Selection and reduction of comparison results for implementations whose
+ * comparisons return `bool`, e.g. the `reference` and `aliased` scalars.
+ * Implementations with packed comparisons return a mask type instead and
+ * provide overloads of the same functions which are found by argument-
+ * dependent lookup, so that generic code can be written without branches:
+ *
+ *      t = Select(t0 >= 0.f, t0, t1);
+ *
+ * Both arguments to `Select` are always evaluated.
+ */
+
+//! Return `a` if `mask` is set, otherwise `b`.
+template<typename T>
+inline T Select(bool mask, T const& a, T const& b)
+{
+    return mask ? a : b;
+}
+
+//! Returns true if any element of `mask` is set.
+inline bool Any(bool mask)
+{
+    return mask;
+}
+
+//! Returns true if every element of `mask` is set.
+inline bool All(bool mask)
+{
+    return mask;
+}
+
+//! Returns true if no element of `mask` is set.
+inline bool None(bool mask)
+{
+    return !mask;
+}
@@ -0,0 +1,628 @@
+#pragma once
+
+#include "Intrinsic.h"
+
+#include <cstddef>
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Packet types store the components of several vectors in structure of arrays
+ * layout, i.e. each register holds the same component of 4 or 8 vectors:
+ *
+ *      x[127:0] = {   x3,   x2,   x1,   x0}
+ *      y[127:0] = {   y3,   y2,   y1,   y0}
+ *      z[127:0] = {   z3,   z2,   z1,   z0}
+ *      w[127:0] = {   w3,   w2,   w1,   w0}
+ *
+ * Each of the vectors is referred to as a 'lane'. In this layout the dot and
+ * cross products are only vertical multiplies and adds without any of the
+ * shuffles or horizontal adds needed for a single `Vector`, at the cost of
+ * only being useful when the same operation is applied to many vectors.
+ *
+ * Arrays of `Vector` are converted to and from this layout with in-register
+ * transposes, 4x4 for packets of 4 and two 4x4 blocks in the upper and lower
+ * halves for packets of 8, either from consecutive vectors or from vectors
+ * at arbitrary indices, e.g. a list of primitives.
+ */
+
+namespace intrinsic {
+
+////////////////////////////////////////////////////////////////////////////////
+//! Register operations used by packet types, i.e. those of `_math_ops` and
+//! transposes to and from arrays of `Vector`, specialized by packet width.
+template<size_t N> struct _packet_ops;
+
+template<>
+struct _packet_ops<4> : _math_ops<4> {
+    //! Transpose the vectors `src[0..3]` to one register per component.
+    static void VECTORCALL load_aos(__m128 const* src, __m128 (&dst)[4]) {
+        __m128 r[4] = {src[0], src[1], src[2], src[3]};
+        _v_transpose_ps(r, dst);
+    }
+
+    //! Transpose the vectors `src[indices[0..3]]` to one register per component.
+    static void VECTORCALL gather_aos(__m128 const* src, uint32_t const* indices, __m128 (&dst)[4]) {
+        __m128 r[4] = {src[indices[0]], src[indices[1]], src[indices[2]], src[indices[3]]};
+        _v_transpose_ps(r, dst);
+    }
+
+    //! Transpose one register per component to the vectors `dst[0..3]`.
+    static void VECTORCALL store_aos(__m128* dst, __m128 const (&src)[4]) {
+        __m128 r[4];
+        _v_transpose_ps(src, r);
+        dst[0] = r[0];
+        dst[1] = r[1];
+        dst[2] = r[2];
+        dst[3] = r[3];
+    }
+
+    //! Transpose one register per component to the vectors `dst[indices[0..3]]`.
+    static void VECTORCALL scatter_aos(__m128* dst, uint32_t const* indices, __m128 const (&src)[4]) {
+        __m128 r[4];
+        _v_transpose_ps(src, r);
+        dst[indices[0]] = r[0];
+        dst[indices[1]] = r[1];
+        dst[indices[2]] = r[2];
+        dst[indices[3]] = r[3];
+    }
+};
+
+#if _HAS_AVX
+template<>
+struct _packet_ops<8> : _math_ops<8> {
+    //! Transpose the vectors `src[0..7]` to one register per component.
+    static void VECTORCALL load_aos(__m128 const* src, __m256 (&dst)[4]) {
+        //  v4      v0
+        auto r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(src[0]), src[4], 1);
+        auto r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(src[1]), src[5], 1);
+        auto r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(src[2]), src[6], 1);
+        auto r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(src[3]), src[7], 1);
+        transpose(r0, r1, r2, r3, dst);
+    }
+
+    //! Transpose the vectors `src[indices[0..7]]` to one register per component.
+    static void VECTORCALL gather_aos(__m128 const* src, uint32_t const* indices, __m256 (&dst)[4]) {
+        //  Loading whole vectors is faster than a `_mm256_i32gather_ps` for
+        //  each component, which loads each element separately.
+        auto r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(src[indices[0]]), src[indices[4]], 1);
+        auto r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(src[indices[1]]), src[indices[5]], 1);
+        auto r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(src[indices[2]]), src[indices[6]], 1);
+        auto r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(src[indices[3]]), src[indices[7]], 1);
+        transpose(r0, r1, r2, r3, dst);
+    }
+
+    //! Transpose one register per component to the vectors `dst[0..7]`.
+    static void VECTORCALL store_aos(__m128* dst, __m256 const (&src)[4]) {
+        __m256 r[4];
+        transpose(src[0], src[1], src[2], src[3], r);
+        //  Pairs of consecutive vectors are in the same half of each register.
+        float* d = reinterpret_cast<float*>(dst);
+        _mm256_storeu_ps(d + 0, _mm256_permute2f128_ps(r[0], r[1], 0x20));
+        _mm256_storeu_ps(d + 8, _mm256_permute2f128_ps(r[2], r[3], 0x20));
+        _mm256_storeu_ps(d + 16, _mm256_permute2f128_ps(r[0], r[1], 0x31));
+        _mm256_storeu_ps(d + 24, _mm256_permute2f128_ps(r[2], r[3], 0x31));
+    }
+
+    //! Transpose one register per component to the vectors `dst[indices[0..7]]`.
+    static void VECTORCALL scatter_aos(__m128* dst, uint32_t const* indices, __m256 const (&src)[4]) {
+        __m256 r[4];
+        transpose(src[0], src[1], src[2], src[3], r);
+        dst[indices[0]] = _mm256_castps256_ps128(r[0]);
+        dst[indices[1]] = _mm256_castps256_ps128(r[1]);
+        dst[indices[2]] = _mm256_castps256_ps128(r[2]);
+        dst[indices[3]] = _mm256_castps256_ps128(r[3]);
+        dst[indices[4]] = _mm256_extractf128_ps(r[0], 1);
+        dst[indices[5]] = _mm256_extractf128_ps(r[1], 1);
+        dst[indices[6]] = _mm256_extractf128_ps(r[2], 1);
+        dst[indices[7]] = _mm256_extractf128_ps(r[3], 1);
+    }
+
+    //! Transpose the 4x4 blocks in the lower and upper halves of `a..d`, which
+    //! is its own inverse.
+    static void VECTORCALL transpose(__m256 a, __m256 b, __m256 c, __m256 d, __m256 (&dst)[4]) {
+        //  b1      a1      b0      a0
+        auto t0 = _mm256_unpacklo_ps(a, b);
+        //  b3      a3      b2      a2
+        auto t1 = _mm256_unpackhi_ps(a, b);
+        //  d1      c1      d0      c0
+        auto t2 = _mm256_unpacklo_ps(c, d);
+        //  d3      c3      d2      c2
+        auto t3 = _mm256_unpackhi_ps(c, d);
+
+        dst[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        dst[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        dst[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        dst[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    }
+};
+#endif // _HAS_AVX
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Forward declarations
+template<size_t N> class MaskPacket;
+template<size_t N> class ScalarPacket;
+template<size_t N> class VectorPacket;
+template<size_t N> class Random;
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Result of a comparison in each lane, for use with `Select` and the reductions
+ * `Any`, `All` and `None` in generic code, see `Mask.h`.
+ */
+template<size_t N>
+class MaskPacket {
+    using ops = _packet_ops<N>;
+    using T = typename ops::type;
+
+public:
+    static constexpr size_t kWidth = N;
+
+public:
+    MaskPacket() {}
+
+    //! Return a bit for each lane, with the bit of the first lane lowest.
+    int VECTORCALL Bits() const {
+        return ops::movemask(_value);
+    }
+
+    MaskPacket VECTORCALL operator&(MaskPacket const& a) const {
+        return ops::and_(_value, a._value);
+    }
+
+    MaskPacket VECTORCALL operator|(MaskPacket const& a) const {
+        return ops::or_(_value, a._value);
+    }
+
+    friend bool VECTORCALL Any(MaskPacket const& a) {
+        return ops::movemask(a._value) != 0;
+    }
+
+    friend bool VECTORCALL All(MaskPacket const& a) {
+        return ops::movemask(a._value) == (1 << N) - 1;
+    }
+
+    friend bool VECTORCALL None(MaskPacket const& a) {
+        return ops::movemask(a._value) == 0;
+    }
+
+    friend MaskPacket VECTORCALL Select(MaskPacket const& mask, MaskPacket const& a, MaskPacket const& b) {
+        return ops::select(mask._value, a._value, b._value);
+    }
+
+private:
+    T _value;
+
+private:
+    friend ScalarPacket<N>;
+
+    MaskPacket(T const& value)
+        : _value(value) {}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * One scalar value per lane.
+ */
+template<size_t N>
+class ScalarPacket {
+    using ops = _packet_ops<N>;
+    using T = typename ops::type;
+
+public:
+    static constexpr size_t kWidth = N;
+
+public:
+    ScalarPacket() {}
+    //! Broadcast `X` to each lane.
+    ScalarPacket(float X)
+        : _value(ops::set1(X)) {}
+    //! Load each lane from consecutive elements of `X`.
+    explicit ScalarPacket(float const* X)
+        : _value(ops::loadu(X)) {}
+
+    //! Return the value in the given lane.
+    float VECTORCALL operator[](size_t lane) const {
+        float values[kWidth];
+        ops::storeu(values, _value);
+        return values[lane];
+    }
+
+    //! Store each lane to consecutive elements of `X`.
+    void VECTORCALL Store(float* X) const {
+        ops::storeu(X, _value);
+    }
+
+    ScalarPacket VECTORCALL operator-() const {
+        return ops::sub(ops::zero(), _value);
+    }
+
+    ScalarPacket VECTORCALL operator+(ScalarPacket const& a) const {
+        return ops::add(_value, a._value);
+    }
+
+    ScalarPacket VECTORCALL operator-(ScalarPacket const& a) const {
+        return ops::sub(_value, a._value);
+    }
+
+    ScalarPacket VECTORCALL operator*(ScalarPacket const& a) const {
+        return ops::mul(_value, a._value);
+    }
+
+    ScalarPacket VECTORCALL operator/(ScalarPacket const& a) const {
+        return ops::div(_value, a._value);
+    }
+
+    MaskPacket<N> VECTORCALL operator==(ScalarPacket const& a) const {
+        return ops::cmpeq(_value, a._value);
+    }
+
+    MaskPacket<N> VECTORCALL operator!=(ScalarPacket const& a) const {
+        return ops::cmpneq(_value, a._value);
+    }
+
+    MaskPacket<N> VECTORCALL operator<(ScalarPacket const& a) const {
+        return ops::cmplt(_value, a._value);
+    }
+
+    MaskPacket<N> VECTORCALL operator<=(ScalarPacket const& a) const {
+        return ops::cmple(_value, a._value);
+    }
+
+    MaskPacket<N> VECTORCALL operator>(ScalarPacket const& a) const {
+        return ops::cmpgt(_value, a._value);
+    }
+
+    MaskPacket<N> VECTORCALL operator>=(ScalarPacket const& a) const {
+        return ops::cmpge(_value, a._value);
+    }
+
+    friend ScalarPacket VECTORCALL operator+(float a, ScalarPacket const& b) {
+        return ops::add(ops::set1(a), b._value);
+    }
+
+    friend ScalarPacket VECTORCALL operator-(float a, ScalarPacket const& b) {
+        return ops::sub(ops::set1(a), b._value);
+    }
+
+    friend ScalarPacket VECTORCALL operator*(float a, ScalarPacket const& b) {
+        return ops::mul(ops::set1(a), b._value);
+    }
+
+    friend ScalarPacket VECTORCALL operator/(float a, ScalarPacket const& b) {
+        return ops::div(ops::set1(a), b._value);
+    }
+
+    friend ScalarPacket VECTORCALL Select(MaskPacket<N> const& mask, ScalarPacket const& a, ScalarPacket const& b) {
+        return ops::select(value(mask), a._value, b._value);
+    }
+
+    friend ScalarPacket VECTORCALL abs(ScalarPacket const& a) {
+        return ops::andnot(ops::set1(-0.f), a._value);
+    }
+
+    friend ScalarPacket VECTORCALL sqrt(ScalarPacket const& a) {
+        return ops::sqrt(a._value);
+    }
+
+    friend ScalarPacket VECTORCALL exp(ScalarPacket const& a) {
+        return _math<N, Accuracy::High>::exp(a._value);
+    }
+
+    friend ScalarPacket VECTORCALL exp2(ScalarPacket const& a) {
+        return _math<N, Accuracy::High>::exp2(a._value);
+    }
+
+    friend ScalarPacket VECTORCALL log(ScalarPacket const& a) {
+        return _math<N, Accuracy::High>::log(a._value);
+    }
+
+    friend ScalarPacket VECTORCALL log2(ScalarPacket const& a) {
+        return _math<N, Accuracy::High>::log2(a._value);
+    }
+
+    friend ScalarPacket VECTORCALL pow(ScalarPacket const& a, ScalarPacket const& b) {
+        return _math<N, Accuracy::High>::pow(a._value, b._value);
+    }
+
+    friend ScalarPacket VECTORCALL sin(ScalarPacket const& a) {
+        return _math<N, Accuracy::High>::sin(a._value);
+    }
+
+    friend ScalarPacket VECTORCALL cos(ScalarPacket const& a) {
+        return _math<N, Accuracy::High>::cos(a._value);
+    }
+
+private:
+    T _value;
+
+private:
+    friend VectorPacket<N>;
+    friend Random<N>;
+
+    ScalarPacket(T const& value)
+        : _value(value) {}
+
+    static T VECTORCALL value(MaskPacket<N> const& mask) {
+        return mask._value;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * One vector per lane, with one register per component.
+ */
+template<size_t N>
+class VectorPacket {
+    using ops = _packet_ops<N>;
+    using T = typename ops::type;
+
+public:
+    using Scalar = ScalarPacket<N>;
+
+    static constexpr size_t kWidth = N;
+
+public:
+    VectorPacket() {}
+    //! Construct with component packets
+    VectorPacket(Scalar const& X, Scalar const& Y, Scalar const& Z, Scalar const& W)
+        : x(X), y(Y), z(Z), w(W) {}
+    //! Broadcast a single vector to each lane.
+    VectorPacket(float X, float Y, float Z, float W)
+        : x(X), y(Y), z(Z), w(W) {}
+    //! Load each lane from consecutive elements of the component arrays.
+    VectorPacket(float const* X, float const* Y, float const* Z, float const* W)
+        : x(X), y(Y), z(Z), w(W) {}
+    //! Load each lane from consecutive vectors of `v`.
+    explicit VectorPacket(Vector const* v) {
+        T r[4];
+        ops::load_aos(&v->_value, r);
+        *this = VectorPacket(r[0], r[1], r[2], r[3]);
+    }
+    //! Load each lane from the vector of `v` at the index in the same lane of
+    //! `indices`.
+    VectorPacket(Vector const* v, uint32_t const* indices) {
+        T r[4];
+        ops::gather_aos(&v->_value, indices, r);
+        *this = VectorPacket(r[0], r[1], r[2], r[3]);
+    }
+    //! Gather each lane from an array of vectors of any implementation.
+    template<typename V>
+    explicit VectorPacket(V const (&v)[kWidth]) {
+        float values[4][kWidth];
+        for (size_t ii = 0; ii < kWidth; ++ii) {
+            values[0][ii] = float(v[ii][0]);
+            values[1][ii] = float(v[ii][1]);
+            values[2][ii] = float(v[ii][2]);
+            values[3][ii] = float(v[ii][3]);
+        }
+        *this = VectorPacket(values[0], values[1], values[2], values[3]);
+    }
+
+    //! Store each lane to consecutive elements of the component arrays.
+    void VECTORCALL Store(float* X, float* Y, float* Z, float* W) const {
+        x.Store(X);
+        y.Store(Y);
+        z.Store(Z);
+        w.Store(W);
+    }
+
+    //! Store each lane to consecutive vectors of `v`.
+    void VECTORCALL Store(Vector* v) const {
+        T const r[4] = {x._value, y._value, z._value, w._value};
+        ops::store_aos(&v->_value, r);
+    }
+
+    //! Store each lane to the vector of `v` at the index in the same lane of
+    //! `indices`, which must be distinct.
+    void VECTORCALL Store(Vector* v, uint32_t const* indices) const {
+        T const r[4] = {x._value, y._value, z._value, w._value};
+        ops::scatter_aos(&v->_value, indices, r);
+    }
+
+    //! Transpose `count` vectors from `src` to consecutive elements of the
+    //! component arrays.
+    static void VECTORCALL Transpose(Vector const* src, float* X, float* Y, float* Z, float* W, size_t count) {
+        size_t ii = 0;
+        for (; ii + N <= count; ii += N) {
+            VectorPacket(src + ii).Store(X + ii, Y + ii, Z + ii, W + ii);
+        }
+        for (; ii < count; ++ii) {
+            Split(src[ii], X + ii, Y + ii, Z + ii, W + ii);
+        }
+    }
+
+    //! Transpose `count` consecutive elements of the component arrays to the
+    //! vectors in `dst`.
+    static void VECTORCALL Transpose(float const* X, float const* Y, float const* Z, float const* W, Vector* dst, size_t count) {
+        size_t ii = 0;
+        for (; ii + N <= count; ii += N) {
+            VectorPacket(X + ii, Y + ii, Z + ii, W + ii).Store(dst + ii);
+        }
+        for (; ii < count; ++ii) {
+            dst[ii] = Vector(X[ii], Y[ii], Z[ii], W[ii]);
+        }
+    }
+
+    //! Transpose the vectors of `src` at each of `count` indices to consecutive
+    //! elements of the component arrays.
+    static void VECTORCALL Gather(Vector const* src, uint32_t const* indices, float* X, float* Y, float* Z, float* W, size_t count) {
+        size_t ii = 0;
+        for (; ii + N <= count; ii += N) {
+            VectorPacket(src, indices + ii).Store(X + ii, Y + ii, Z + ii, W + ii);
+        }
+        for (; ii < count; ++ii) {
+            Split(src[indices[ii]], X + ii, Y + ii, Z + ii, W + ii);
+        }
+    }
+
+    //! Transpose `count` consecutive elements of the component arrays to the
+    //! vectors of `dst` at each of the distinct `indices`.
+    static void VECTORCALL Scatter(float const* X, float const* Y, float const* Z, float const* W, uint32_t const* indices, Vector* dst, size_t count) {
+        size_t ii = 0;
+        for (; ii + N <= count; ii += N) {
+            VectorPacket(X + ii, Y + ii, Z + ii, W + ii).Store(dst, indices + ii);
+        }
+        for (; ii < count; ++ii) {
+            dst[indices[ii]] = Vector(X[ii], Y[ii], Z[ii], W[ii]);
+        }
+    }
+
+    //! Return the packet of the given component.
+    Scalar& VECTORCALL operator[](size_t index) {
+        return (&x)[index];
+    }
+
+    //! Return the packet of the given component.
+    Scalar const& VECTORCALL operator[](size_t index) const {
+        return (&x)[index];
+    }
+
+    VectorPacket VECTORCALL operator+(VectorPacket const& a) const {
+        return VectorPacket(ops::add(x._value, a.x._value),
+                            ops::add(y._value, a.y._value),
+                            ops::add(z._value, a.z._value),
+                            ops::add(w._value, a.w._value));
+    }
+
+    VectorPacket VECTORCALL operator-(VectorPacket const& a) const {
+        return VectorPacket(ops::sub(x._value, a.x._value),
+                            ops::sub(y._value, a.y._value),
+                            ops::sub(z._value, a.z._value),
+                            ops::sub(w._value, a.w._value));
+    }
+
+    VectorPacket VECTORCALL operator*(Scalar const& s) const {
+        return VectorPacket(ops::mul(x._value, s._value),
+                            ops::mul(y._value, s._value),
+                            ops::mul(z._value, s._value),
+                            ops::mul(w._value, s._value));
+    }
+
+    friend VectorPacket VECTORCALL operator*(Scalar const& s, VectorPacket const& a) {
+        return a * s;
+    }
+
+    VectorPacket VECTORCALL operator/(Scalar const& s) const {
+        return VectorPacket(ops::div(x._value, s._value),
+                            ops::div(y._value, s._value),
+                            ops::div(z._value, s._value),
+                            ops::div(w._value, s._value));
+    }
+
+    VectorPacket VECTORCALL operator-() const {
+        return VectorPacket(ops::sub(ops::zero(), x._value),
+                            ops::sub(ops::zero(), y._value),
+                            ops::sub(ops::zero(), z._value),
+                            ops::sub(ops::zero(), w._value));
+    }
+
+    Scalar VECTORCALL Length() const {
+        return ops::sqrt(dot(*this));
+    }
+
+    Scalar VECTORCALL LengthFast() const {
+        auto lsqr = dot(*this);
+        return ops::mul(lsqr, ops::rsqrt(lsqr));
+    }
+
+    Scalar VECTORCALL LengthSqr() const {
+        return dot(*this);
+    }
+
+    VectorPacket VECTORCALL Normalize() const {
+        return *this / Scalar(ops::sqrt(dot(*this)));
+    }
+
+    VectorPacket VECTORCALL NormalizeFast() const {
+        return *this * Scalar(ops::rsqrt(dot(*this)));
+    }
+
+    //! Dot product in R4.
+    Scalar VECTORCALL operator*(VectorPacket const& a) const {
+        return dot(a);
+    }
+
+    //! Cross product in R3.
+    VectorPacket VECTORCALL operator%(VectorPacket const& a) const {
+        return VectorPacket(ops::fmsub(y._value, a.z._value, ops::mul(z._value, a.y._value)),
+                            ops::fmsub(z._value, a.x._value, ops::mul(x._value, a.z._value)),
+                            ops::fmsub(x._value, a.y._value, ops::mul(y._value, a.x._value)),
+                            ops::zero());
+    }
+
+    //! Return the projection of `a` onto this vector.
+    VectorPacket VECTORCALL Project(VectorPacket const& a) const {
+        auto lsqr = dot(*this);
+        auto dota = dot(a);
+        return *this * Scalar(ops::div(dota, lsqr));
+    }
+
+    //! Return the rejection of `a` onto this vector.
+    VectorPacket VECTORCALL Reject(VectorPacket const& a) const {
+        auto s = ops::div(dot(a), dot(*this));
+        return VectorPacket(ops::fnmadd(x._value, s, a.x._value),
+                            ops::fnmadd(y._value, s, a.y._value),
+                            ops::fnmadd(z._value, s, a.z._value),
+                            ops::fnmadd(w._value, s, a.w._value));
+    }
+
+    //! Return the reflection of `a` onto this vector.
+    VectorPacket VECTORCALL Reflect(VectorPacket const& a) const {
+        auto s = ops::div(ops::mul(ops::set1(2.0f), dot(a)), dot(*this));
+        return VectorPacket(ops::fnmadd(x._value, s, a.x._value),
+                            ops::fnmadd(y._value, s, a.y._value),
+                            ops::fnmadd(z._value, s, a.z._value),
+                            ops::fnmadd(w._value, s, a.w._value));
+    }
+
+    //! Return the component-wise product with `a`.
+    VectorPacket VECTORCALL Hadamard(VectorPacket const& a) const {
+        return VectorPacket(ops::mul(x._value, a.x._value),
+                            ops::mul(y._value, a.y._value),
+                            ops::mul(z._value, a.z._value),
+                            ops::mul(w._value, a.w._value));
+    }
+
+protected:
+    Scalar x, y, z, w;
+
+protected:
+    friend Random<N>;
+
+    VectorPacket(T const& X, T const& Y, T const& Z, T const& W)
+        : x(X), y(Y), z(Z), w(W) {}
+
+    //! Store the elements of `v` to `X`, `Y`, `Z` and `W`.
+    static void VECTORCALL Split(Vector const& v, float* X, float* Y, float* Z, float* W) {
+        alignas(16) float values[4];
+        _mm_store_ps(values, v._value);
+        *X = values[0];
+        *Y = values[1];
+        *Z = values[2];
+        *W = values[3];
+    }
+
+    //! Dot product in R4 as a chain of vertical multiply-adds.
+    T VECTORCALL dot(VectorPacket const& a) const {
+        auto r1 = ops::mul(x._value, a.x._value);
+        auto r2 = ops::fmadd(y._value, a.y._value, r1);
+        auto r3 = ops::fmadd(z._value, a.z._value, r2);
+        return ops::fmadd(w._value, a.w._value, r3);
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+using MaskPacket4 = MaskPacket<4>;
+using ScalarPacket4 = ScalarPacket<4>;
+using VectorPacket4 = VectorPacket<4>;
+
+#if _HAS_AVX
+using MaskPacket8 = MaskPacket<8>;
+using ScalarPacket8 = ScalarPacket<8>;
+using VectorPacket8 = VectorPacket<8>;
+#endif // _HAS_AVX
+
+} // namespace intrinsic
@@ -0,0 +1,1228 @@
+#pragma once
+
+#include "Platform.h"
+#include "Half.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if !_HAS_VECTOR_EXTENSIONS
+#error "The portable implementation requires GCC or Clang vector extensions!"
+#endif // !_HAS_VECTOR_EXTENSIONS
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Implementation using the generic vector extensions of GCC and Clang instead
+ * of target specific intrinsics, so that it can be compiled for any target
+ * supported by either compiler. Arithmetic on vector types is lowered to the
+ * native SIMD instructions of the target, or to scalar code on targets without
+ * them. Registers are written in element order, i.e.
+ *
+ *  V = {     x,     y,     z,     w}
+ *
+ * which is the reverse of the convention used for the intrinsic helpers.
+ * Operations which are rarely performed, e.g. conversions between matrices
+ * and quaternions, are implemented the same way as the reference
+ * implementation.
+ */
+
+namespace portable {
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef float _v_f4 __attribute__((vector_size(16)));
+typedef int32_t _v_i4 __attribute__((vector_size(16)));
+typedef float _v_f8 __attribute__((vector_size(32)));
+typedef int32_t _v_i8 __attribute__((vector_size(32)));
+
+//! Return the elements { src0[X], src0[Y], src0[Z], src0[W] } of the vector
+//! { src0, src1 }, i.e. indices 4 through 7 select elements of `src1`.
+template<int X, int Y, int Z, int W, typename T>
+inline T _v_shuffle(T src0, T src1)
+{
+    static_assert(sizeof(T) == 16, "Bad vector size!");
+#if defined(__clang__) || __GNUC__ >= 12
+    return __builtin_shufflevector(src0, src1, X, Y, Z, W);
+#else
+    return __builtin_shuffle(src0, src1, _v_i4{X, Y, Z, W});
+#endif
+}
+
+//! Return the elements { src[X], src[Y], src[Z], src[W] }.
+template<int X, int Y, int Z, int W, typename T>
+inline T _v_permute(T src)
+{
+    return _v_shuffle<X, Y, Z, W>(src, src);
+}
+
+//! Return the elements of `src` selected by `I0` through `I7` for each half
+//! of an eight element vector in `dst`. Eight element vectors are passed by
+//! reference since their calling convention depends on the target.
+template<int I0, int I1, int I2, int I3, int I4, int I5, int I6, int I7>
+inline void _v_permute8(_v_f8 const& src, _v_f8& dst)
+{
+#if defined(__clang__) || __GNUC__ >= 12
+    dst = __builtin_shufflevector(src, src, I0, I1, I2, I3, I4, I5, I6, I7);
+#else
+    dst = __builtin_shuffle(src, _v_i8{I0, I1, I2, I3, I4, I5, I6, I7});
+#endif
+}
+
+//! Return `s` broadcast to each element.
+inline _v_f4 _v_splat(float s)
+{
+    return _v_f4{s, s, s, s};
+}
+
+//! dst[i] = mask[i] ? src0[i] : src1[i], where each element of `mask` is
+//! either all zero or all one bits, e.g. the result of a comparison.
+template<typename T, typename M>
+inline T _v_select(M mask, T src0, T src1)
+{
+    return (T)((mask & (M)src0) | (~mask & (M)src1));
+}
+
+//! Return `src` with the sign bit of each element inverted where the same
+//! element of `sign` is negative, i.e. multiplied by the sign of `sign`.
+inline _v_f4 _v_flip_sign(_v_f4 src, _v_f4 sign)
+{
+    return (_v_f4)((_v_i4)src ^ ((_v_i4)sign & int32_t(0x80000000)));
+}
+
+//! Return true if every element of the comparison result `mask` is set.
+inline bool _v_all(_v_i4 mask)
+{
+    mask &= _v_permute<1, 0, 3, 2>(mask);
+    mask &= _v_permute<2, 3, 0, 1>(mask);
+    return mask[0] != 0;
+}
+
+//! Return true if any element of the comparison result `mask` is set.
+inline bool _v_any(_v_i4 mask)
+{
+    mask |= _v_permute<1, 0, 3, 2>(mask);
+    mask |= _v_permute<2, 3, 0, 1>(mask);
+    return mask[0] != 0;
+}
+
+inline _v_f4 _v_min(_v_f4 src0, _v_f4 src1)
+{
+    return _v_select(src0 < src1, src0, src1);
+}
+
+inline _v_f4 _v_max(_v_f4 src0, _v_f4 src1)
+{
+    return _v_select(src0 > src1, src0, src1);
+}
+
+inline _v_f4 _v_abs(_v_f4 src)
+{
+    return (_v_f4)((_v_i4)src & int32_t(0x7fffffff));
+}
+
+//! Round each element of `src` toward zero. Each element must be exactly
+//! representable as a 32-bit integer.
+inline _v_f4 _v_trunc(_v_f4 src)
+{
+#if defined(__clang__) || __GNUC__ >= 9
+    return __builtin_convertvector(__builtin_convertvector(src, _v_i4), _v_f4);
+#else
+    return _v_f4{float(int32_t(src[0])), float(int32_t(src[1])),
+                 float(int32_t(src[2])), float(int32_t(src[3]))};
+#endif
+}
+
+//! Round each element of `src` toward negative infinity. Elements with
+//! magnitude of at least 2^23 are already integers and are returned as is.
+inline _v_f4 _v_floor(_v_f4 src)
+{
+    auto small = _v_abs(src) < _v_splat(8388608.f);
+    auto t = _v_trunc(_v_select(small, src, _v_splat(0.f)));
+    t -= _v_select(t > src, _v_splat(1.f), _v_splat(0.f));
+    return _v_select(small, t, src);
+}
+
+//! Round each element of `src` toward positive infinity, see `_v_floor`.
+inline _v_f4 _v_ceil(_v_f4 src)
+{
+    auto small = _v_abs(src) < _v_splat(8388608.f);
+    auto t = _v_trunc(_v_select(small, src, _v_splat(0.f)));
+    t += _v_select(t < src, _v_splat(1.f), _v_splat(0.f));
+    return _v_select(small, t, src);
+}
+
+//! Minimum of the elements of `src` broadcast to each element.
+inline _v_f4 _v_reduce_min(_v_f4 src)
+{
+    auto r1 = _v_min(src, _v_permute<1, 0, 3, 2>(src));
+    return _v_min(r1, _v_permute<2, 3, 0, 1>(r1));
+}
+
+//! Maximum of the elements of `src` broadcast to each element.
+inline _v_f4 _v_reduce_max(_v_f4 src)
+{
+    auto r1 = _v_max(src, _v_permute<1, 0, 3, 2>(src));
+    return _v_max(r1, _v_permute<2, 3, 0, 1>(r1));
+}
+
+//! Sum of the elements of `src` broadcast to each element, summed in pairs,
+//! i.e. (x + y) + (z + w).
+inline _v_f4 _v_reduce_add(_v_f4 src)
+{
+    auto r1 = src + _v_permute<1, 0, 3, 2>(src);
+    return r1 + _v_permute<2, 3, 0, 1>(r1);
+}
+
+//! Dot product in R4 broadcast to each element.
+inline _v_f4 _v_dot(_v_f4 src0, _v_f4 src1)
+{
+    return _v_reduce_add(src0 * src1);
+}
+
+//! Return the sums of the elements of each of `src0` through `src3`, i.e.
+//!     dst = { sum(src0), sum(src1), sum(src2), sum(src3) }
+inline _v_f4 _v_sum4(_v_f4 src0, _v_f4 src1, _v_f4 src2, _v_f4 src3)
+{
+    //  x0+z0   x1+z1   y0+w0   y1+w1
+    auto r1 = _v_shuffle<0, 4, 1, 5>(src0, src1) + _v_shuffle<2, 6, 3, 7>(src0, src1);
+    //  x2+z2   x3+z3   y2+w2   y3+w3
+    auto r2 = _v_shuffle<0, 4, 1, 5>(src2, src3) + _v_shuffle<2, 6, 3, 7>(src2, src3);
+    return _v_shuffle<0, 1, 4, 5>(r1, r2) + _v_shuffle<2, 3, 6, 7>(r1, r2);
+}
+
+//! Cross product in R3, the last element of the result is zero.
+inline _v_f4 _v_cross(_v_f4 src0, _v_f4 src1)
+{
+    return _v_permute<1, 2, 0, 3>(src0) * _v_permute<2, 0, 1, 3>(src1)
+         - _v_permute<2, 0, 1, 3>(src0) * _v_permute<1, 2, 0, 3>(src1);
+}
+
+//! Transpose of the 4x4 matrix with columns `src`.
+inline void _v_transpose(_v_f4 const (&src)[4], _v_f4 (&dst)[4])
+{
+    //  x0      y0      x1      y1
+    auto t0 = _v_shuffle<0, 4, 1, 5>(src[0], src[1]);
+    //  z0      w0      z1      w1
+    auto t1 = _v_shuffle<0, 4, 1, 5>(src[2], src[3]);
+    //  x2      y2      x3      y3
+    auto t2 = _v_shuffle<2, 6, 3, 7>(src[0], src[1]);
+    //  z2      w2      z3      w3
+    auto t3 = _v_shuffle<2, 6, 3, 7>(src[2], src[3]);
+
+    dst[0] = _v_shuffle<0, 1, 4, 5>(t0, t1);
+    dst[1] = _v_shuffle<2, 3, 6, 7>(t0, t1);
+    dst[2] = _v_shuffle<0, 1, 4, 5>(t2, t3);
+    dst[3] = _v_shuffle<2, 3, 6, 7>(t2, t3);
+}
+
+//! Product of the 4x4 matrix with columns `src0` and the vector `src1`.
+inline _v_f4 _v_matrix_mul(_v_f4 const (&src0)[4], _v_f4 src1)
+{
+    auto r1 = src0[0] * _v_permute<0, 0, 0, 0>(src1)
+            + src0[1] * _v_permute<1, 1, 1, 1>(src1);
+    auto r2 = src0[2] * _v_permute<2, 2, 2, 2>(src1)
+            + src0[3] * _v_permute<3, 3, 3, 3>(src1);
+    return r1 + r2;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Products of 2x2 matrices stored in a single vector in row-major order, i.e.
+//  { m11, m12, m21, m22 }, used by `_v_inverse`. The adjugate of a 2x2 matrix
+//  A is written A#, i.e. { m22, -m12, -m21, m11 }.
+
+//! dst = src0 * src1
+inline _v_f4 _v_mat2mul(_v_f4 src0, _v_f4 src1)
+{
+    return src0 * _v_permute<0, 3, 0, 3>(src1)
+         + _v_permute<1, 0, 3, 2>(src0) * _v_permute<2, 1, 2, 1>(src1);
+}
+
+//! dst = src0# * src1
+inline _v_f4 _v_mat2adjmul(_v_f4 src0, _v_f4 src1)
+{
+    return _v_permute<3, 3, 0, 0>(src0) * src1
+         - _v_permute<1, 1, 2, 2>(src0) * _v_permute<2, 3, 0, 1>(src1);
+}
+
+//! dst = src0 * src1#
+inline _v_f4 _v_mat2muladj(_v_f4 src0, _v_f4 src1)
+{
+    return src0 * _v_permute<3, 0, 3, 0>(src1)
+         - _v_permute<1, 0, 3, 2>(src0) * _v_permute<2, 1, 2, 1>(src1);
+}
+
+//! Determinants of the four 2x2 blocks of the 4x4 matrix with columns `src`.
+//!     dst = { |A|, |B|, |C|, |D| }
+//! where A and D are the upper left and lower right blocks.
+inline _v_f4 _v_det2(_v_f4 const (&src)[4])
+{
+    return _v_shuffle<0, 2, 4, 6>(src[0], src[2]) * _v_shuffle<1, 3, 5, 7>(src[1], src[3])
+         - _v_shuffle<1, 3, 5, 7>(src[0], src[2]) * _v_shuffle<0, 2, 4, 6>(src[1], src[3]);
+}
+
+//! Inverse of the 4x4 matrix with columns `src` by blockwise inversion with
+//! 2x2 adjugates, the same as `intrinsic::_v_inverse_ps`. Returns the
+//! determinant broadcast to each element.
+inline _v_f4 _v_inverse(_v_f4 const (&src)[4], _v_f4 (&dst)[4])
+{
+    //  Treat each column as a row of the matrix M = | A  B |
+    //                                               | C  D |
+    auto A = _v_shuffle<0, 1, 4, 5>(src[0], src[1]);
+    auto B = _v_shuffle<2, 3, 6, 7>(src[0], src[1]);
+    auto C = _v_shuffle<0, 1, 4, 5>(src[2], src[3]);
+    auto D = _v_shuffle<2, 3, 6, 7>(src[2], src[3]);
+
+    auto det = _v_det2(src);
+    auto detA = _v_permute<0, 0, 0, 0>(det);
+    auto detB = _v_permute<1, 1, 1, 1>(det);
+    auto detC = _v_permute<2, 2, 2, 2>(det);
+    auto detD = _v_permute<3, 3, 3, 3>(det);
+
+    auto D_C = _v_mat2adjmul(D, C);
+    auto A_B = _v_mat2adjmul(A, B);
+
+    //  inverse(M) = 1/|M| * | X#  Y# |
+    //                       | Z#  W# |
+    auto X_ = detD * A - _v_mat2mul(B, D_C);
+    auto W_ = detA * D - _v_mat2mul(C, A_B);
+    auto Y_ = detB * C - _v_mat2muladj(D, A_B);
+    auto Z_ = detC * B - _v_mat2muladj(A, D_C);
+
+    //  |M| = |A|*|D| + |B|*|C| - tr((A#B)(D#C))
+    auto tr = _v_dot(A_B, _v_permute<0, 2, 1, 3>(D_C));
+    auto detM = detA * detD + detB * detC - tr;
+
+    //  Signs of the adjugate are applied with the reciprocal of |M|.
+    auto rdetM = _v_f4{1.f, -1.f, -1.f, 1.f} / detM;
+
+    X_ *= rdetM;
+    Y_ *= rdetM;
+    Z_ *= rdetM;
+    W_ *= rdetM;
+
+    //  Transpose each adjugate block into the columns of the result.
+    dst[0] = _v_shuffle<3, 1, 7, 5>(X_, Y_);
+    dst[1] = _v_shuffle<2, 0, 6, 4>(X_, Y_);
+    dst[2] = _v_shuffle<3, 1, 7, 5>(Z_, W_);
+    dst[3] = _v_shuffle<2, 0, 6, 4>(Z_, W_);
+
+    return detM;
+}
+
+//! Determinant of the 4x4 matrix with columns `src` broadcast to each element,
+//! computed the same way as in `_v_inverse`.
+inline _v_f4 _v_determinant(_v_f4 const (&src)[4])
+{
+    auto A = _v_shuffle<0, 1, 4, 5>(src[0], src[1]);
+    auto B = _v_shuffle<2, 3, 6, 7>(src[0], src[1]);
+    auto C = _v_shuffle<0, 1, 4, 5>(src[2], src[3]);
+    auto D = _v_shuffle<2, 3, 6, 7>(src[2], src[3]);
+
+    auto det = _v_det2(src);
+    //  |A|*|D|                                         |B|*|C|
+    auto r1 = _v_permute<0, 0, 0, 0>(det) * _v_permute<3, 3, 3, 3>(det)
+            + _v_permute<1, 1, 1, 1>(det) * _v_permute<2, 2, 2, 2>(det);
+
+    auto D_C = _v_mat2adjmul(D, C);
+    auto A_B = _v_mat2adjmul(A, B);
+    return r1 - _v_dot(A_B, _v_permute<0, 2, 1, 3>(D_C));
+}
+
+//! Inverse of the affine 4x4 matrix with columns `src`, see
+//! `intrinsic::_v_inverse_affine_ps`.
+inline void _v_inverse_affine(_v_f4 const (&src)[4], _v_f4 (&dst)[4])
+{
+    //  Rows of the 3x3 block, the last element of each is zero.
+    _v_f4 const cols[4] = {src[0], src[1], src[2], _v_splat(0.f)};
+    _v_f4 rows[4];
+    _v_transpose(cols, rows);
+
+    //  Squared length of each column of the 3x3 block. The last element is
+    //  replaced with one so that the last row of the result remains zero.
+    auto lsqr = rows[0] * rows[0] + rows[1] * rows[1] + rows[2] * rows[2];
+    lsqr = _v_shuffle<0, 1, 2, 4>(lsqr, _v_splat(1.f));
+    auto rlsqr = _v_splat(1.f) / lsqr;
+
+    auto r0 = rows[0] * rlsqr;
+    auto r1 = rows[1] * rlsqr;
+    auto r2 = rows[2] * rlsqr;
+
+    //  Translation is the negated translation in the inverted basis.
+    auto t = src[3];
+    auto r3 = r0 * _v_permute<0, 0, 0, 0>(t)
+            + r1 * _v_permute<1, 1, 1, 1>(t)
+            + r2 * _v_permute<2, 2, 2, 2>(t);
+
+    dst[0] = r0;
+    dst[1] = r1;
+    dst[2] = r2;
+    dst[3] = _v_f4{0.f, 0.f, 0.f, 1.f} - r3;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Quaternions are stored as { x, y, z, w } where w is the real part.
+
+//! Hamilton product of the quaternions `src0` and `src1`.
+inline _v_f4 _v_quat_mul(_v_f4 src0, _v_f4 src1)
+{
+    //  w0 * { x1,  y1,  z1,  w1 }
+    auto r1 = _v_permute<3, 3, 3, 3>(src0) * src1;
+    //  x0 * { w1, -z1,  y1, -x1 }
+    r1 += _v_permute<0, 0, 0, 0>(src0) * _v_flip_sign(_v_permute<3, 2, 1, 0>(src1), _v_f4{1.f, -1.f, 1.f, -1.f});
+    //  y0 * { z1,  w1, -x1, -y1 }
+    r1 += _v_permute<1, 1, 1, 1>(src0) * _v_flip_sign(_v_permute<2, 3, 0, 1>(src1), _v_f4{1.f, 1.f, -1.f, -1.f});
+    //  z0 * {-y1,  x1,  w1, -z1 }
+    r1 += _v_permute<2, 2, 2, 2>(src0) * _v_flip_sign(_v_permute<1, 0, 3, 2>(src1), _v_f4{-1.f, 1.f, 1.f, -1.f});
+    return r1;
+}
+
+//! Rotate the vector `src1` by the unit quaternion `src0`. The last element of
+//! `src1` is unchanged.
+inline _v_f4 _v_quat_rotate(_v_f4 src0, _v_f4 src1)
+{
+    //  t = 2 * (q.xyz x v)
+    auto t = _v_cross(src0, src1);
+    t += t;
+    //  v + q.w * t + q.xyz x t
+    return src1 + _v_permute<3, 3, 3, 3>(src0) * t + _v_cross(src0, t);
+}
+
+//! Coefficient of the end point of spherical linear interpolation between two
+//! unit quaternions whose dot product is `src0`, at the fraction `src1`, see
+//! `intrinsic::_v_slerp_coeff_ps`.
+inline _v_f4 _v_slerp_coeff(_v_f4 src0, _v_f4 src1)
+{
+    constexpr float kMu = 1.85298109240830f;
+    constexpr float u[8] = {
+        1.f / (1 * 3), 1.f / (2 * 5), 1.f / (3 * 7), 1.f / (4 * 9),
+        1.f / (5 * 11), 1.f / (6 * 13), 1.f / (7 * 15), kMu / (8 * 17),
+    };
+    constexpr float v[8] = {
+        1.f / 3, 2.f / 5, 3.f / 7, 4.f / 9,
+        5.f / 11, 6.f / 13, 7.f / 15, kMu * 8 / 17,
+    };
+
+    auto one = _v_splat(1.f);
+    auto xm1 = src0 - one;
+    auto tsqr = src1 * src1;
+
+    //  1 + b[0] * (1 + b[1] * (... * (1 + b[7])))
+    //  b[i] = (u[i] * t^2 - v[i]) * (x - 1)
+    auto r1 = one;
+    for (int ii = 7; ii >= 0; --ii) {
+        auto b = (_v_splat(u[ii]) * tsqr - _v_splat(v[ii])) * xm1;
+        r1 = b * r1 + one;
+    }
+
+    return src1 * r1;
+}
+
+//! Spherical linear interpolation between the unit quaternions `src0` and
+//! `src1` at the fraction `t` along the shortest arc.
+inline _v_f4 _v_quat_slerp(_v_f4 src0, _v_f4 src1, float t)
+{
+    auto d = _v_dot(src0, src1);
+
+    //  1-t     t       1-t     t
+    auto c = _v_slerp_coeff(_v_abs(d), _v_f4{1.f - t, t, 1.f - t, t});
+
+    auto c0 = _v_permute<0, 0, 0, 0>(c);
+    auto c1 = _v_flip_sign(_v_permute<1, 1, 1, 1>(c), d);
+    return c0 * src0 + c1 * src1;
+}
+
+//! Spherical linear interpolation of four pairs of quaternions from `src0` and
+//! `src1` at the fractions in each element of `src2`, with the coefficients of
+//! one pair in each element.
+inline void _v_quat_slerp4(_v_f4 const (&src0)[4], _v_f4 const (&src1)[4], _v_f4 src2, _v_f4 (&dst)[4])
+{
+    auto d = _v_sum4(src0[0] * src1[0],
+                     src0[1] * src1[1],
+                     src0[2] * src1[2],
+                     src0[3] * src1[3]);
+    auto x = _v_abs(d);
+
+    auto c0 = _v_slerp_coeff(x, _v_splat(1.f) - src2);
+    auto c1 = _v_flip_sign(_v_slerp_coeff(x, src2), d);
+
+    dst[0] = _v_permute<0, 0, 0, 0>(c0) * src0[0] + _v_permute<0, 0, 0, 0>(c1) * src1[0];
+    dst[1] = _v_permute<1, 1, 1, 1>(c0) * src0[1] + _v_permute<1, 1, 1, 1>(c1) * src1[1];
+    dst[2] = _v_permute<2, 2, 2, 2>(c0) * src0[2] + _v_permute<2, 2, 2, 2>(c1) * src1[2];
+    dst[3] = _v_permute<3, 3, 3, 3>(c0) * src0[3] + _v_permute<3, 3, 3, 3>(c1) * src1[3];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Batch transforms load eight element vectors, i.e. two `Vector`s at a time,
+//  which are lowered to a single register on targets with 256-bit vectors and
+//  to pairs of registers otherwise. Comparisons of eight element vectors are
+//  lowered to scalar code without 256-bit vectors, so the other batch
+//  operations use pairs of four element vectors instead.
+
+//! Transform `count` vectors from `src1` into `dst` by the matrix with columns
+//! `src0`, replacing the last element of each vector with `w`.
+inline void _v_transform_batch(_v_f4 const (&src0)[4], _v_f4 const* src1, _v_f4* dst, size_t count, float w)
+{
+    _v_f8 c0, c1, c2, c3;
+    for (int ii = 0; ii < 4; ++ii) {
+        c0[ii] = c0[ii + 4] = src0[0][ii];
+        c1[ii] = c1[ii + 4] = src0[1][ii];
+        c2[ii] = c2[ii + 4] = src0[2][ii];
+        c3[ii] = c3[ii + 4] = src0[3][ii] * w;
+    }
+
+    size_t ii = 0;
+    for (; ii + 2 <= count; ii += 2) {
+        _v_f8 v, vx, vy, vz;
+        std::memcpy(&v, src1 + ii, sizeof(v));
+        _v_permute8<0, 0, 0, 0, 4, 4, 4, 4>(v, vx);
+        _v_permute8<1, 1, 1, 1, 5, 5, 5, 5>(v, vy);
+        _v_permute8<2, 2, 2, 2, 6, 6, 6, 6>(v, vz);
+        auto r1 = c0 * vx + c3;
+        r1 += c1 * vy + c2 * vz;
+        std::memcpy(dst + ii, &r1, sizeof(r1));
+    }
+
+    _v_f4 const m[4] = {src0[0], src0[1], src0[2], src0[3] * w};
+    for (; ii < count; ++ii) {
+        dst[ii] = _v_matrix_mul(m, _v_shuffle<0, 1, 2, 7>(src1[ii], _v_splat(1.f)));
+    }
+}
+
+//! Component-wise minimum and maximum of `count` vectors in `src`, which are
+//! +infinity and -infinity if `count` is zero.
+inline void _v_bounds_batch(_v_f4 const* src, size_t count, _v_f4& min, _v_f4& max)
+{
+    //  Two pairs of accumulators to hide the latency of each comparison.
+    _v_f4 min0 = _v_splat(HUGE_VALF), min1 = min0;
+    _v_f4 max0 = -min0, max1 = max0;
+
+    size_t ii = 0;
+    for (; ii + 2 <= count; ii += 2) {
+        min0 = _v_min(min0, src[ii + 0]);
+        max0 = _v_max(max0, src[ii + 0]);
+        min1 = _v_min(min1, src[ii + 1]);
+        max1 = _v_max(max1, src[ii + 1]);
+    }
+
+    if (ii < count) {
+        min0 = _v_min(min0, src[ii]);
+        max0 = _v_max(max0, src[ii]);
+    }
+
+    min = _v_min(min0, min1);
+    max = _v_max(max0, max1);
+}
+
+//! Maximum squared length of `count` vectors in `src`, or zero if `count` is
+//! zero. Squared lengths of four vectors are summed at a time by `_v_sum4`.
+inline float _v_max_lsqr_batch(_v_f4 const* src, size_t count)
+{
+    auto lsqr = _v_splat(0.f);
+
+    size_t ii = 0;
+    for (; ii + 4 <= count; ii += 4) {
+        lsqr = _v_max(lsqr, _v_sum4(src[ii + 0] * src[ii + 0],
+                                    src[ii + 1] * src[ii + 1],
+                                    src[ii + 2] * src[ii + 2],
+                                    src[ii + 3] * src[ii + 3]));
+    }
+
+    for (; ii < count; ++ii) {
+        lsqr = _v_max(lsqr, _v_dot(src[ii], src[ii]));
+    }
+
+    return _v_reduce_max(lsqr)[0];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+using Scalar = float;
+
+using std::abs;
+using std::sqrt;
+using std::size_t;
+
+class HalfVector;
+class Vector3;
+class Quaternion;
+class AffineMatrix;
+class Matrix;
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ */
+class alignas(16) Vector {
+public:
+    Vector() {}
+    Vector(float X, float Y, float Z, float W)
+        : _value(_v_f4{X, Y, Z, W}) {}
+
+    Scalar& operator[](size_t index) {
+        return (&x)[index];
+    }
+
+    Scalar const& operator[](size_t index) const {
+        return (&x)[index];
+    }
+
+    //! Return element `I` of this vector.
+    template<int I>
+    Scalar Extract() const {
+        static_assert(0 <= I && I < 4, "Element index out of range!");
+        return _value[I];
+    }
+
+    //! Return this vector with element `I` replaced by `s`.
+    template<int I>
+    Vector Insert(Scalar s) const {
+        static_assert(0 <= I && I < 4, "Element index out of range!");
+        auto v = _value;
+        v[I] = s;
+        return v;
+    }
+
+    //! Return the vector { v[X], v[Y], v[Z], v[W] } of elements of this vector.
+    template<int X, int Y, int Z, int W>
+    Vector Swizzle() const {
+        static_assert(0 <= X && X < 4, "Element index out of range!");
+        static_assert(0 <= Y && Y < 4, "Element index out of range!");
+        static_assert(0 <= Z && Z < 4, "Element index out of range!");
+        static_assert(0 <= W && W < 4, "Element index out of range!");
+        return _v_permute<X, Y, Z, W>(_value);
+    }
+
+    bool operator==(Vector const& a) const {
+        return _v_all(_value == a._value);
+    }
+
+    bool operator!=(Vector const& a) const {
+        return _v_any(_value != a._value);
+    }
+
+    Vector operator+(Vector const& a) const {
+        return _value + a._value;
+    }
+
+    Vector operator-(Vector const& a) const {
+        return _value - a._value;
+    }
+
+    Vector operator*(Scalar s) const {
+        return _value * _v_splat(s);
+    }
+
+    friend Vector operator*(Scalar s, Vector const& a) {
+        return a * s;
+    }
+
+    Vector operator/(Scalar s) const {
+        return _value / _v_splat(s);
+    }
+
+    Vector operator-() const {
+        return -_value;
+    }
+
+    Scalar Length() const {
+        return std::sqrt(LengthSqr());
+    }
+
+    Scalar LengthFast() const {
+        return std::sqrt(LengthSqr());
+    }
+
+    Scalar LengthSqr() const {
+        return _v_dot(_value, _value)[0];
+    }
+
+    Vector Normalize() const {
+        return _value / _v_splat(Length());
+    }
+
+    Vector NormalizeFast() const {
+        return Normalize();
+    }
+
+    //! Dot product in R4.
+    Scalar operator*(Vector const& a) const {
+        return _v_dot(_value, a._value)[0];
+    }
+
+    //! Cross product in R3.
+    Vector operator%(Vector const& a) const {
+        assert(std::abs(w) == 0.0f && std::abs(a.w) == 0.0f);
+        return _v_cross(_value, a._value);
+    }
+
+    //! Return the projection of `a` onto this vector.
+    Vector Project(Vector const& a) const {
+        return _value * (_v_dot(_value, a._value) / _v_dot(_value, _value));
+    }
+
+    //! Return the rejection of `a` onto this vector.
+    Vector Reject(Vector const& a) const {
+        return a - Project(a);
+    }
+
+    //! Return the reflection of `a` onto this vector.
+    Vector Reflect(Vector const& a) const {
+        auto proj = Project(a)._value;
+        return a._value - (proj + proj);
+    }
+
+    //! Return the component-wise product with `a`.
+    Vector Hadamard(Vector const& a) const {
+        return _value * a._value;
+    }
+
+    //! Return the component-wise minimum with `a`.
+    Vector Min(Vector const& a) const {
+        return _v_min(_value, a._value);
+    }
+
+    //! Return the component-wise maximum with `a`.
+    Vector Max(Vector const& a) const {
+        return _v_max(_value, a._value);
+    }
+
+    //! Return each element clamped to the same element of `lo` and `hi`.
+    Vector Clamp(Vector const& lo, Vector const& hi) const {
+        return _v_min(_v_max(_value, lo._value), hi._value);
+    }
+
+    //! Return each element clamped to `lo` and `hi`.
+    Vector Clamp(Scalar lo, Scalar hi) const {
+        return _v_min(_v_max(_value, _v_splat(lo)), _v_splat(hi));
+    }
+
+    //! Return the linear interpolation from this vector to `a` by `t`.
+    Vector Lerp(Vector const& a, Scalar t) const {
+        return _value + (a._value - _value) * _v_splat(t);
+    }
+
+    //! Return the component-wise absolute value.
+    Vector Abs() const {
+        return _v_abs(_value);
+    }
+
+    //! Return each element rounded toward negative infinity.
+    Vector Floor() const {
+        return _v_floor(_value);
+    }
+
+    //! Return each element rounded toward positive infinity.
+    Vector Ceil() const {
+        return _v_ceil(_value);
+    }
+
+    //! Return the minimum of the elements of this vector.
+    Scalar HorizontalMin() const {
+        return _v_reduce_min(_value)[0];
+    }
+
+    //! Return the maximum of the elements of this vector.
+    Scalar HorizontalMax() const {
+        return _v_reduce_max(_value)[0];
+    }
+
+    //! Return the sum of the elements of this vector.
+    Scalar HorizontalSum() const {
+        return _v_reduce_add(_value)[0];
+    }
+
+    //! Return the component-wise minimum and maximum of `count` vectors in
+    //! `src`, which are +infinity and -infinity if `count` is zero.
+    static void Bounds(Vector const* src, size_t count, Vector& min, Vector& max) {
+        _v_bounds_batch(reinterpret_cast<_v_f4 const*>(src), count, min._value, max._value);
+    }
+
+    //! Return the maximum length of `count` vectors in `src`, or zero if
+    //! `count` is zero.
+    static Scalar MaxLength(Vector const* src, size_t count) {
+        return std::sqrt(_v_max_lsqr_batch(reinterpret_cast<_v_f4 const*>(src), count));
+    }
+
+    //! Return this vector converted to half precision for storage.
+    HalfVector ToHalfVector() const;
+
+    //! Return the first three elements of this vector for packed storage.
+    Vector3 ToVector3() const;
+
+protected:
+    union {
+        _v_f4 _value;
+        struct {
+            float x, y, z, w;
+        };
+    };
+
+protected:
+    friend class HalfVector;
+    friend class Vector3;
+    friend class Quaternion;
+    friend class AffineMatrix;
+    friend class Matrix;
+
+    Vector(_v_f4 value)
+        : _value(value) {}
+};
+
+static_assert(sizeof(Vector) == sizeof(_v_f4), "Bad size!");
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Half precision storage for a `Vector` in 8 bytes, see `Half.h`.
+ */
+class alignas(8) HalfVector {
+public:
+    HalfVector() {}
+    HalfVector(float X, float Y, float Z, float W)
+        : x(FloatToHalf(X)), y(FloatToHalf(Y)), z(FloatToHalf(Z)), w(FloatToHalf(W)) {}
+    //! Convert `v` to half precision, rounding to nearest even.
+    explicit HalfVector(Vector const& v)
+        : HalfVector(v.x, v.y, v.z, v.w) {}
+
+    //! Return this vector converted to single precision.
+    Vector ToVector() const {
+        return Vector(HalfToFloat(x), HalfToFloat(y), HalfToFloat(z), HalfToFloat(w));
+    }
+
+    //! Convert `count` vectors from `src` to half precision in `dst`.
+    static void Pack(Vector const* src, HalfVector* dst, size_t count) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = HalfVector(src[ii]);
+        }
+    }
+
+    //! Convert `count` vectors from `src` to single precision in `dst`.
+    static void Unpack(HalfVector const* src, Vector* dst, size_t count) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = src[ii].ToVector();
+        }
+    }
+
+protected:
+    uint16_t x, y, z, w;
+};
+
+inline HalfVector Vector::ToHalfVector() const {
+    return HalfVector(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Packed storage for the first three elements of a `Vector` in 12 bytes.
+ */
+class Vector3 {
+public:
+    Vector3() {}
+    Vector3(float X, float Y, float Z)
+        : x(X), y(Y), z(Z) {}
+    //! Store the first three elements of `v`.
+    explicit Vector3(Vector const& v)
+        : Vector3(v.x, v.y, v.z) {}
+
+    //! Return this vector with `w` in the fourth element, e.g. 1 for points.
+    Vector ToVector(float w = 0.f) const {
+        return Vector(x, y, z, w);
+    }
+
+    //! Store the first three elements of `count` vectors from `src` in `dst`.
+    static void Pack(Vector const* src, Vector3* dst, size_t count) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = Vector3(src[ii]);
+        }
+    }
+
+    //! Load `count` vectors from `src` to `dst` with `w` in the fourth element.
+    static void Unpack(Vector3 const* src, Vector* dst, size_t count, float w = 0.f) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = src[ii].ToVector(w);
+        }
+    }
+
+protected:
+    float x, y, z;
+};
+
+inline Vector3 Vector::ToVector3() const {
+    return Vector3(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Rotation quaternion, where w is the real part. Operations other than the
+ * Hamilton product, conjugate and normalization expect unit quaternions.
+ */
+class alignas(16) Quaternion {
+public:
+    Quaternion() {}
+    Quaternion(float X, float Y, float Z, float W)
+        : _value(_v_f4{X, Y, Z, W}) {}
+
+    //! Construct a rotation of `angle` radians about the unit vector `axis`.
+    Quaternion(Vector const& axis, float angle)
+        : _value(axis._value * _v_splat(std::sin(.5f * angle))) {
+        _value[3] = std::cos(.5f * angle);
+    }
+
+    bool operator==(Quaternion const& a) const {
+        return _v_all(_value == a._value);
+    }
+
+    bool operator!=(Quaternion const& a) const {
+        return _v_any(_value != a._value);
+    }
+
+    //! Hamilton product, i.e. the rotation by `a` followed by this rotation.
+    Quaternion operator*(Quaternion const& a) const {
+        return _v_quat_mul(_value, a._value);
+    }
+
+    Quaternion operator-() const {
+        return -_value;
+    }
+
+    //! Return the conjugate, which is the inverse rotation.
+    Quaternion Conjugate() const {
+        return _v_flip_sign(_value, _v_f4{-1.f, -1.f, -1.f, 1.f});
+    }
+
+    //! Dot product in R4.
+    Scalar Dot(Quaternion const& a) const {
+        return _v_dot(_value, a._value)[0];
+    }
+
+    Scalar Length() const {
+        return std::sqrt(Dot(*this));
+    }
+
+    Quaternion Normalize() const {
+        return _value / _v_splat(Length());
+    }
+
+    //! Return `v` rotated by this quaternion. The w component is unchanged.
+    Vector Rotate(Vector const& v) const {
+        return _v_quat_rotate(_value, v._value);
+    }
+
+    //! Return the normalized linear interpolation to `a` at the fraction `t`.
+    Quaternion Nlerp(Quaternion const& a, Scalar t) const {
+        Scalar s = Dot(a) < 0.f ? -t : t;
+        return Quaternion(_value + (a._value * _v_splat(s) - _value * _v_splat(t))).Normalize();
+    }
+
+    //! Return the spherical linear interpolation to `a` at the fraction `t`,
+    //! see `_v_quat_slerp`.
+    Quaternion Slerp(Quaternion const& a, Scalar t) const {
+        return _v_quat_slerp(_value, a._value, t);
+    }
+
+    //! Spherical linear interpolation of `count` pairs of quaternions from `a`
+    //! and `b` at the fractions `t` into `dst`, see `_v_quat_slerp4`.
+    static void SlerpBatch(Quaternion const* a, Quaternion const* b, float const* t, Quaternion* dst, size_t count) {
+        size_t ii = 0;
+
+        for (; ii + 3 < count; ii += 4) {
+            _v_f4 const src0[4] = { a[ii]._value, a[ii + 1]._value, a[ii + 2]._value, a[ii + 3]._value };
+            _v_f4 const src1[4] = { b[ii]._value, b[ii + 1]._value, b[ii + 2]._value, b[ii + 3]._value };
+            _v_f4 src2;
+            std::memcpy(&src2, t + ii, sizeof(src2));
+            _v_f4 r[4];
+            _v_quat_slerp4(src0, src1, src2, r);
+
+            dst[ii + 0]._value = r[0];
+            dst[ii + 1]._value = r[1];
+            dst[ii + 2]._value = r[2];
+            dst[ii + 3]._value = r[3];
+        }
+
+        for (; ii < count; ++ii) {
+            dst[ii] = a[ii].Slerp(b[ii], t[ii]);
+        }
+    }
+
+protected:
+    union {
+        _v_f4 _value;
+        struct {
+            float x, y, z, w;
+        };
+    };
+
+protected:
+    friend class Matrix;
+
+    Quaternion(_v_f4 value)
+        : _value(value) {}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Affine transform stored as the first three rows of a 4x4 matrix, the last
+ * row is implicitly { 0, 0, 0, 1 }.
+ */
+class alignas(16) AffineMatrix {
+public:
+    AffineMatrix() {}
+    //! Construct with column vectors, the last element of each is ignored.
+    AffineMatrix(Vector const& X, Vector const& Y, Vector const& Z, Vector const& W) {
+        _v_f4 const src[4] = {X._value, Y._value, Z._value, W._value};
+        _v_f4 dst[4];
+        _v_transpose(src, dst);
+        x = dst[0];
+        y = dst[1];
+        z = dst[2];
+    }
+    AffineMatrix(float m11, float m12, float m13, float m14,
+                 float m21, float m22, float m23, float m24,
+                 float m31, float m32, float m33, float m34)
+        : x(m11, m12, m13, m14)
+        , y(m21, m22, m23, m24)
+        , z(m31, m32, m33, m34) {}
+
+    bool operator==(AffineMatrix const& a) const {
+        return x == a.x && y == a.y && z == a.z;
+    }
+
+    bool operator!=(AffineMatrix const& a) const {
+        return x != a.x || y != a.y || z != a.z;
+    }
+
+    //! Product with `v` as a 4x4 matrix, i.e. the last element is unchanged.
+    Vector operator*(Vector const& v) const {
+        auto r1 = _v_sum4(x._value * v._value,
+                          y._value * v._value,
+                          z._value * v._value,
+                          _v_splat(0.f));
+        return _v_shuffle<0, 1, 2, 7>(r1, v._value);
+    }
+
+    //! Return the composition of this transform with `a`, i.e. the transform
+    //! by `a` followed by this transform.
+    AffineMatrix operator*(AffineMatrix const& a) const {
+        AffineMatrix m;
+
+        for (size_t ii = 0; ii < 3; ++ii) {
+            auto r = (&x)[ii]._value;
+            (&m.x)[ii] = a.x._value * _v_permute<0, 0, 0, 0>(r)
+                       + a.y._value * _v_permute<1, 1, 1, 1>(r)
+                       + a.z._value * _v_permute<2, 2, 2, 2>(r)
+                       + _v_shuffle<4, 4, 4, 3>(r, _v_splat(0.f));
+        }
+        return m;
+    }
+
+    //! Return the point `p` transformed by rotation, scale and translation.
+    //! The last element of `p` is ignored and the last element of the result
+    //! is one.
+    Vector TransformPoint(Vector const& p) const {
+        return *this * Vector(_v_shuffle<0, 1, 2, 4>(p._value, _v_splat(1.f)));
+    }
+
+    //! Return the direction `v` transformed by rotation and scale only. The
+    //! last element of `v` is ignored and the last element of the result is
+    //! zero.
+    Vector TransformDirection(Vector const& v) const {
+        return *this * Vector(_v_shuffle<0, 1, 2, 4>(v._value, _v_splat(0.f)));
+    }
+
+protected:
+    //! Rows of the matrix, e.g. `x` produces the x component of a product.
+    Vector x, y, z;
+
+protected:
+    friend class Matrix;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ */
+class alignas(16) Matrix {
+public:
+    Matrix() {}
+    //! Construct with column vectors
+    Matrix(Vector const& X, Vector const& Y, Vector const& Z, Vector const& W)
+        : x(X), y(Y), z(Z), w(W) {}
+    Matrix(float m11, float m12, float m13, float m14,
+           float m21, float m22, float m23, float m24,
+           float m31, float m32, float m33, float m34,
+           float m41, float m42, float m43, float m44)
+        : x(m11, m21, m31, m41)
+        , y(m12, m22, m32, m42)
+        , z(m13, m23, m33, m43)
+        , w(m14, m24, m34, m44) {}
+
+    //! Construct the rotation matrix of the unit quaternion `q`.
+    explicit Matrix(Quaternion const& q)
+        : x(1.f - 2.f * (q.y * q.y + q.z * q.z),
+                  2.f * (q.x * q.y + q.w * q.z),
+                  2.f * (q.x * q.z - q.w * q.y), 0.f)
+        , y(      2.f * (q.x * q.y - q.w * q.z),
+            1.f - 2.f * (q.x * q.x + q.z * q.z),
+                  2.f * (q.y * q.z + q.w * q.x), 0.f)
+        , z(      2.f * (q.x * q.z + q.w * q.y),
+                  2.f * (q.y * q.z - q.w * q.x),
+            1.f - 2.f * (q.x * q.x + q.y * q.y), 0.f)
+        , w(0.f, 0.f, 0.f, 1.f) {}
+
+    //! Construct from an affine transform.
+    explicit Matrix(AffineMatrix const& a) {
+        _v_f4 const src[4] = {a.x._value, a.y._value, a.z._value, _v_f4{0.f, 0.f, 0.f, 1.f}};
+        _v_f4 dst[4];
+        _v_transpose(src, dst);
+        *this = Matrix(dst);
+    }
+
+    Vector& operator[](size_t index) {
+        return (&x)[index];
+    }
+
+    Vector const& operator[](size_t index) const {
+        return (&x)[index];
+    }
+
+    bool operator==(Matrix const& a) const {
+        return x == a.x && y == a.y && z == a.z && w == a.w;
+    }
+
+    bool operator!=(Matrix const& a) const {
+        return x != a.x || y != a.y || z != a.z || w != a.w;
+    }
+
+    Matrix operator+(Matrix const& a) const {
+        return Matrix(x + a.x, y + a.y, z + a.z, w + a.w);
+    }
+
+    Matrix operator-(Matrix const& a) const {
+        return Matrix(x - a.x, y - a.y, z - a.z, w - a.w);
+    }
+
+    Matrix operator*(Scalar s) const {
+        return Matrix(x * s, y * s, z * s, w * s);
+    }
+
+    Matrix operator/(Scalar s) const {
+        return Matrix(x / s, y / s, z / s, w / s);
+    }
+
+    friend Matrix operator*(Scalar s, Matrix const& m) {
+        return m * s;
+    }
+
+    Vector operator*(Vector const& u) const {
+        return _v_matrix_mul(columns(), u._value);
+    }
+
+    Matrix operator*(Matrix const& a) const {
+        auto const& src = columns();
+        return Matrix(_v_matrix_mul(src, a.x._value),
+                      _v_matrix_mul(src, a.y._value),
+                      _v_matrix_mul(src, a.z._value),
+                      _v_matrix_mul(src, a.w._value));
+    }
+
+    Matrix Transpose() const {
+        _v_f4 dst[4];
+        _v_transpose(columns(), dst);
+        return Matrix(dst);
+    }
+
+    //! Return the component-wise product with `a`.
+    Matrix Hadamard(Matrix const& a) const {
+        return Matrix(x.Hadamard(a.x),
+                      y.Hadamard(a.y),
+                      z.Hadamard(a.z),
+                      w.Hadamard(a.w));
+    }
+
+    //! Return the determinant.
+    Scalar Determinant() const {
+        return _v_determinant(columns())[0];
+    }
+
+    //! Return the inverse. The result is not finite if the matrix is singular,
+    //! i.e. if the determinant is zero.
+    Matrix Inverse() const {
+        _v_f4 dst[4];
+        _v_inverse(columns(), dst);
+        return Matrix(dst);
+    }
+
+    //! Return the inverse of an affine transform which is composed of only
+    //! rotation, scale and translation, see `_v_inverse_affine`.
+    Matrix InverseAffine() const {
+        _v_f4 dst[4];
+        _v_inverse_affine(columns(), dst);
+        return Matrix(dst);
+    }
+
+    //! Invert `count` matrices from `src` into `dst`.
+    static void InverseBatch(Matrix const* src, Matrix* dst, size_t count) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = src[ii].Inverse();
+        }
+    }
+
+    //! Transform `count` points from `src` into `dst`, treating the last
+    //! element of each point as one. `stream` has no effect.
+    void TransformPoints(Vector const* src, Vector* dst, size_t count, bool /*stream*/ = false) const {
+        _v_transform_batch(columns(),
+                           reinterpret_cast<_v_f4 const*>(src),
+                           reinterpret_cast<_v_f4*>(dst),
+                           count, 1.f);
+    }
+
+    //! Transform `count` directions from `src` into `dst`, treating the last
+    //! element of each direction as zero. `stream` has no effect.
+    void TransformDirections(Vector const* src, Vector* dst, size_t count, bool /*stream*/ = false) const {
+        _v_transform_batch(columns(),
+                           reinterpret_cast<_v_f4 const*>(src),
+                           reinterpret_cast<_v_f4*>(dst),
+                           count, 0.f);
+    }
+
+    //! Return the unit quaternion of the rotation in the upper 3x3 block,
+    //! which must be orthonormal. The largest component is computed from the
+    //! diagonal and the others from the off-diagonal elements.
+    Quaternion ToQuaternion() const {
+        float trace = x.x + y.y + z.z;
+
+        if (trace >= x.x && trace >= y.y && trace >= z.z) {
+            float s = 2.f * std::sqrt(1.f + trace);
+            return Quaternion((y.z - z.y) / s, (z.x - x.z) / s, (x.y - y.x) / s, .25f * s);
+        } else if (x.x >= y.y && x.x >= z.z) {
+            float s = 2.f * std::sqrt(1.f + x.x - y.y - z.z);
+            return Quaternion(.25f * s, (y.x + x.y) / s, (z.x + x.z) / s, (y.z - z.y) / s);
+        } else if (y.y >= z.z) {
+            float s = 2.f * std::sqrt(1.f + y.y - x.x - z.z);
+            return Quaternion((y.x + x.y) / s, .25f * s, (z.y + y.z) / s, (z.x - x.z) / s);
+        } else {
+            float s = 2.f * std::sqrt(1.f + z.z - x.x - y.y);
+            return Quaternion((z.x + x.z) / s, (z.y + y.z) / s, .25f * s, (x.y - y.x) / s);
+        }
+    }
+
+    //! Return the first three rows as an affine transform. The last row must
+    //! be { 0, 0, 0, 1 }.
+    AffineMatrix ToAffineMatrix() const {
+        return AffineMatrix(x, y, z, w);
+    }
+
+protected:
+    Vector x, y, z, w;
+
+protected:
+    Matrix(_v_f4 const (&src)[4])
+        : x(src[0]), y(src[1]), z(src[2]), w(src[3]) {}
+
+    //! Columns as an array for the `_v_` helpers.
+    _v_f4 const (&columns() const)[4] {
+        return reinterpret_cast<_v_f4 const (&)[4]>(x);
+    }
+};
+
+} // namespace portable
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "Packet.h"
+
+#include <cstddef>
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Pseudorandom number generators which produce one sample in each lane of a
+ * packet per call, see `Packet.h`. Each lane is an independent xoshiro128+
+ * generator, from Blackman and Vigna, "Scrambled Linear Pseudorandom Number
+ * Generators", which only requires 32-bit adds, shifts and logical operations
+ * so that every lane is advanced at once. The upper 23 bits of each output
+ * are used as the mantissa of a uniform float in [0, 1), which avoids the
+ * weaker low bits of xoshiro128+.
+ *
+ * Generators are seeded with a `seed` and a `stream`, e.g. a thread or pixel
+ * index, and the same seed and stream always produce the same sequence.
+ * Lanes of different streams are seeded with distinct splitmix64 sequences
+ * and, with a period of 2^128 - 1, do not overlap in practice.
+ */
+
+namespace intrinsic {
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * `N` independent generators, one per lane.
+ */
+template<size_t N>
+class Random {
+    using ops = _math_ops<N>;
+    using T = typename ops::type;
+    using I = typename ops::itype;
+
+public:
+    static constexpr size_t kWidth = N;
+
+public:
+    //! Seed each lane from `seed` and the index of the `stream`.
+    explicit Random(uint64_t seed, uint64_t stream = 0) {
+        uint32_t state[4][N];
+
+        uint64_t key = SplitMix64(seed);
+
+        for (size_t ii = 0; ii < N; ++ii) {
+            uint64_t x = key ^ (stream * N + ii);
+            uint64_t s01 = SplitMix64(x);
+            uint64_t s23 = SplitMix64(x);
+            //  The all zero state is the only one which is not allowed.
+            if (!(s01 | s23)) {
+                s01 = 1;
+            }
+            state[0][ii] = uint32_t(s01);
+            state[1][ii] = uint32_t(s01 >> 32);
+            state[2][ii] = uint32_t(s23);
+            state[3][ii] = uint32_t(s23 >> 32);
+        }
+
+        for (size_t ii = 0; ii < 4; ++ii) {
+            _state[ii] = ops::iloadu(state[ii]);
+        }
+    }
+
+    //! Return a uniform sample in [0, 1) in each lane.
+    ScalarPacket<N> VECTORCALL Uniform() {
+        return UniformReg();
+    }
+
+    //! Return a uniform sample in [lo, hi) in each lane.
+    ScalarPacket<N> VECTORCALL Uniform(float lo, float hi) {
+        return ops::fmadd(UniformReg(), ops::set1(hi - lo), ops::set1(lo));
+    }
+
+    //! Return a direction uniformly distributed on the unit sphere in each
+    //! lane. The last element of each direction is zero.
+    VectorPacket<N> VECTORCALL UnitSphere() {
+        //  z = 1 - 2u is uniform on [-1, 1], and so is the area of the
+        //  sphere above z, by Archimedes' hat-box theorem.
+        T z = ops::fnmadd(ops::set1(2.f), UniformReg(), ops::set1(1.f));
+        T r = ops::sqrt(ops::fnmadd(z, z, ops::set1(1.f)));
+
+        T s, c;
+        _math<N, Accuracy::Medium>::sincos(ops::mul(UniformReg(), ops::set1(kTwoPi)), s, c);
+
+        return VectorPacket<N>(ops::mul(r, c), ops::mul(r, s), z, ops::zero());
+    }
+
+    //! Return a direction uniformly distributed on the hemisphere about the
+    //! unit vector `n` in each lane, i.e. a sample of the unit sphere which
+    //! is negated if it points away from `n`.
+    VectorPacket<N> VECTORCALL Hemisphere(VectorPacket<N> const& n) {
+        auto d = UnitSphere();
+        T sign = ops::and_(d.dot(n), ops::set1(-0.f));
+        return VectorPacket<N>(ops::xor_(d.x._value, sign),
+                               ops::xor_(d.y._value, sign),
+                               ops::xor_(d.z._value, sign),
+                               d.w._value);
+    }
+
+    //! Return a cosine weighted direction on the hemisphere about the unit
+    //! vector `n` in each lane, whose last element must be zero. The sum of
+    //! `n` and a direction on the unit sphere is proportional to the cosine
+    //! weighted distribution about `n`, which does not require a basis. The
+    //! sum is `n` itself in the unlikely event that it is too short.
+    VectorPacket<N> VECTORCALL CosineHemisphere(VectorPacket<N> const& n) {
+        auto d = n + UnitSphere();
+        T lsqr = d.dot(d);
+        T mask = ops::cmpgt(lsqr, ops::set1(1e-12f));
+        T s = ops::div(ops::set1(1.f), ops::sqrt(lsqr));
+        return VectorPacket<N>(ops::select(mask, ops::mul(d.x._value, s), n.x._value),
+                               ops::select(mask, ops::mul(d.y._value, s), n.y._value),
+                               ops::select(mask, ops::mul(d.z._value, s), n.z._value),
+                               ops::zero());
+    }
+
+    //! Store `N` uniform samples in [0, 1) in `dst`.
+    void VECTORCALL Uniform(float* dst) {
+        Uniform().Store(dst);
+    }
+
+    //! Store `N` directions uniformly distributed on the unit sphere in `dst`,
+    //! for vectors of any implementation.
+    template<typename V>
+    void VECTORCALL UnitSphere(V* dst) {
+        Store(UnitSphere(), dst);
+    }
+
+    //! Store `N` directions uniformly distributed on the hemisphere about the
+    //! unit vector `n` in `dst`, see `Hemisphere`.
+    template<typename V>
+    void VECTORCALL Hemisphere(V const& n, V* dst) {
+        Store(Hemisphere(Broadcast(n)), dst);
+    }
+
+    //! Store `N` cosine weighted directions on the hemisphere about the unit
+    //! vector `n` in `dst`, see `CosineHemisphere`.
+    template<typename V>
+    void VECTORCALL CosineHemisphere(V const& n, V* dst) {
+        Store(CosineHemisphere(Broadcast(n)), dst);
+    }
+
+protected:
+    I _state[4];
+
+    static constexpr float kTwoPi = 6.28318530717958647692f;
+
+protected:
+    //! Advance the generator of each lane and return its output.
+    I VECTORCALL Next() {
+        I result = ops::iadd(_state[0], _state[3]);
+        I t = ops::template slli<9>(_state[1]);
+
+        _state[2] = ops::ixor(_state[2], _state[0]);
+        _state[3] = ops::ixor(_state[3], _state[1]);
+        _state[1] = ops::ixor(_state[1], _state[2]);
+        _state[0] = ops::ixor(_state[0], _state[3]);
+
+        _state[2] = ops::ixor(_state[2], t);
+        _state[3] = ops::ior(ops::template slli<11>(_state[3]),
+                             ops::template srli<21>(_state[3]));
+
+        return result;
+    }
+
+    //! Uniform sample in [0, 1) from the upper 23 bits of `Next`, which are
+    //! the mantissa of a float in [1, 2).
+    T VECTORCALL UniformReg() {
+        I bits = ops::ior(ops::template srli<9>(Next()), ops::iset1(0x3f800000));
+        return ops::sub(ops::castps(bits), ops::set1(1.f));
+    }
+
+    //! Return the next output of the splitmix64 sequence with state `x`.
+    static uint64_t SplitMix64(uint64_t& x) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    //! Return `v` in each lane, for vectors of any implementation.
+    template<typename V>
+    static VectorPacket<N> VECTORCALL Broadcast(V const& v) {
+        return VectorPacket<N>(float(v[0]), float(v[1]), float(v[2]), float(v[3]));
+    }
+
+    //! Store each lane of `p` in `dst`, for vectors of any implementation.
+    template<typename V>
+    static void VECTORCALL Store(VectorPacket<N> const& p, V* dst) {
+        float values[4][N];
+        p.Store(values[0], values[1], values[2], values[3]);
+        for (size_t ii = 0; ii < N; ++ii) {
+            dst[ii] = V(values[0][ii], values[1][ii], values[2][ii], values[3][ii]);
+        }
+    }
+};
+
+template<size_t N> constexpr float Random<N>::kTwoPi;
+
+////////////////////////////////////////////////////////////////////////////////
+
+using Random4 = Random<4>;
+
+#if _HAS_AVX
+using Random8 = Random<8>;
+#endif // _HAS_AVX
+
+} // namespace intrinsic
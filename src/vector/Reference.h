@@ -1,5 +1,8 @@
 #pragma once
 
+#include "Half.h"
+
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cmath>
@@ -16,6 +19,9 @@ using std::abs;
 using std::sqrt;
 using std::size_t;
 
+class HalfVector;
+class Vector3;
+
 ////////////////////////////////////////////////////////////////////////////////
 /**
  */
@@ -33,6 +39,32 @@ public:
         return (&x)[index];
     }
 
+    //! Return element `I` of this vector.
+    template<int I>
+    Scalar Extract() const {
+        static_assert(0 <= I && I < 4, "Element index out of range!");
+        return (&x)[I];
+    }
+
+    //! Return this vector with element `I` replaced by `s`.
+    template<int I>
+    Vector Insert(Scalar s) const {
+        static_assert(0 <= I && I < 4, "Element index out of range!");
+        Vector v = *this;
+        (&v.x)[I] = s;
+        return v;
+    }
+
+    //! Return the vector { v[X], v[Y], v[Z], v[W] } of elements of this vector.
+    template<int X, int Y, int Z, int W>
+    Vector Swizzle() const {
+        static_assert(0 <= X && X < 4, "Element index out of range!");
+        static_assert(0 <= Y && Y < 4, "Element index out of range!");
+        static_assert(0 <= Z && Z < 4, "Element index out of range!");
+        static_assert(0 <= W && W < 4, "Element index out of range!");
+        return Vector((&x)[X], (&x)[Y], (&x)[Z], (&x)[W]);
+    }
+
     bool operator==(Vector const& a) const {
         return (x == a.x && y == a.y && z == a.z && w == a.w);
     }
@@ -118,9 +150,361 @@ public:
         return {x * a.x, y * a.y, z * a.z, w * a.w};
     }
 
+    //! Return the component-wise minimum with `a`.
+    Vector Min(Vector const& a) const {
+        return {std::min(x, a.x), std::min(y, a.y), std::min(z, a.z), std::min(w, a.w)};
+    }
+
+    //! Return the component-wise maximum with `a`.
+    Vector Max(Vector const& a) const {
+        return {std::max(x, a.x), std::max(y, a.y), std::max(z, a.z), std::max(w, a.w)};
+    }
+
+    //! Return each element clamped to the same element of `lo` and `hi`.
+    Vector Clamp(Vector const& lo, Vector const& hi) const {
+        return Max(lo).Min(hi);
+    }
+
+    //! Return each element clamped to `lo` and `hi`.
+    Vector Clamp(Scalar lo, Scalar hi) const {
+        return Clamp(Vector(lo, lo, lo, lo), Vector(hi, hi, hi, hi));
+    }
+
+    //! Return the linear interpolation from this vector to `a` by `t`.
+    Vector Lerp(Vector const& a, Scalar t) const {
+        return *this + (a - *this) * t;
+    }
+
+    //! Return the component-wise absolute value.
+    Vector Abs() const {
+        return {std::abs(x), std::abs(y), std::abs(z), std::abs(w)};
+    }
+
+    //! Return each element rounded toward negative infinity.
+    Vector Floor() const {
+        return {std::floor(x), std::floor(y), std::floor(z), std::floor(w)};
+    }
+
+    //! Return each element rounded toward positive infinity.
+    Vector Ceil() const {
+        return {std::ceil(x), std::ceil(y), std::ceil(z), std::ceil(w)};
+    }
+
+    //! Return the minimum of the elements of this vector.
+    Scalar HorizontalMin() const {
+        return std::min(std::min(x, y), std::min(z, w));
+    }
+
+    //! Return the maximum of the elements of this vector.
+    Scalar HorizontalMax() const {
+        return std::max(std::max(x, y), std::max(z, w));
+    }
+
+    //! Return the sum of the elements of this vector.
+    Scalar HorizontalSum() const {
+        return (x + y) + (z + w);
+    }
+
+    //! Return the component-wise minimum and maximum of `count` vectors in
+    //! `src`, which are +infinity and -infinity if `count` is zero.
+    static void Bounds(Vector const* src, size_t count, Vector& min, Vector& max) {
+        min = Vector(HUGE_VALF, HUGE_VALF, HUGE_VALF, HUGE_VALF);
+        max = -min;
+        for (size_t ii = 0; ii < count; ++ii) {
+            min = min.Min(src[ii]);
+            max = max.Max(src[ii]);
+        }
+    }
+
+    //! Return the maximum length of `count` vectors in `src`, or zero if
+    //! `count` is zero.
+    static Scalar MaxLength(Vector const* src, size_t count) {
+        Scalar lsqr = 0.f;
+        for (size_t ii = 0; ii < count; ++ii) {
+            lsqr = std::max(lsqr, src[ii].LengthSqr());
+        }
+        return std::sqrt(lsqr);
+    }
+
+    //! Return this vector converted to half precision for storage.
+    HalfVector ToHalfVector() const;
+
+    //! Return the first three elements of this vector for packed storage.
+    Vector3 ToVector3() const;
+
 protected:
     Scalar x, y, z, w;
 
+protected:
+    friend class HalfVector;
+    friend class Vector3;
+    friend class Quaternion;
+    friend class AffineMatrix;
+    friend class Matrix;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Half precision storage for a `Vector` in 8 bytes, see `Half.h`.
+ */
+class alignas(8) HalfVector {
+public:
+    HalfVector() {}
+    HalfVector(float X, float Y, float Z, float W)
+        : x(FloatToHalf(X)), y(FloatToHalf(Y)), z(FloatToHalf(Z)), w(FloatToHalf(W)) {}
+    //! Convert `v` to half precision, rounding to nearest even.
+    explicit HalfVector(Vector const& v)
+        : HalfVector(v.x, v.y, v.z, v.w) {}
+
+    //! Return this vector converted to single precision.
+    Vector ToVector() const {
+        return Vector(HalfToFloat(x), HalfToFloat(y), HalfToFloat(z), HalfToFloat(w));
+    }
+
+    //! Convert `count` vectors from `src` to half precision in `dst`.
+    static void Pack(Vector const* src, HalfVector* dst, size_t count) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = HalfVector(src[ii]);
+        }
+    }
+
+    //! Convert `count` vectors from `src` to single precision in `dst`.
+    static void Unpack(HalfVector const* src, Vector* dst, size_t count) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = src[ii].ToVector();
+        }
+    }
+
+protected:
+    uint16_t x, y, z, w;
+};
+
+inline HalfVector Vector::ToHalfVector() const {
+    return HalfVector(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Packed storage for the first three elements of a `Vector` in 12 bytes.
+ */
+class Vector3 {
+public:
+    Vector3() {}
+    Vector3(float X, float Y, float Z)
+        : x(X), y(Y), z(Z) {}
+    //! Store the first three elements of `v`.
+    explicit Vector3(Vector const& v)
+        : Vector3(v.x, v.y, v.z) {}
+
+    //! Return this vector with `w` in the fourth element, e.g. 1 for points.
+    Vector ToVector(float w = 0.f) const {
+        return Vector(x, y, z, w);
+    }
+
+    //! Store the first three elements of `count` vectors from `src` in `dst`.
+    static void Pack(Vector const* src, Vector3* dst, size_t count) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = Vector3(src[ii]);
+        }
+    }
+
+    //! Load `count` vectors from `src` to `dst` with `w` in the fourth element.
+    static void Unpack(Vector3 const* src, Vector* dst, size_t count, float w = 0.f) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = src[ii].ToVector(w);
+        }
+    }
+
+protected:
+    float x, y, z;
+};
+
+inline Vector3 Vector::ToVector3() const {
+    return Vector3(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Rotation quaternion, where w is the real part. Operations other than the
+ * Hamilton product, conjugate and normalization expect unit quaternions.
+ */
+class alignas(16) Quaternion {
+public:
+    Quaternion() {}
+    Quaternion(float X, float Y, float Z, float W)
+        : x(X), y(Y), z(Z), w(W) {}
+
+    //! Construct a rotation of `angle` radians about the unit vector `axis`.
+    Quaternion(Vector const& axis, float angle) {
+        float s = std::sin(.5f * angle);
+        x = axis.x * s;
+        y = axis.y * s;
+        z = axis.z * s;
+        w = std::cos(.5f * angle);
+    }
+
+    bool operator==(Quaternion const& a) const {
+        return (x == a.x && y == a.y && z == a.z && w == a.w);
+    }
+
+    bool operator!=(Quaternion const& a) const {
+        return (x != a.x || y != a.y || z != a.z || w != a.w);
+    }
+
+    //! Hamilton product, i.e. the rotation by `a` followed by this rotation.
+    Quaternion operator*(Quaternion const& a) const {
+        return Quaternion(w * a.x + x * a.w + y * a.z - z * a.y,
+                          w * a.y - x * a.z + y * a.w + z * a.x,
+                          w * a.z + x * a.y - y * a.x + z * a.w,
+                          w * a.w - x * a.x - y * a.y - z * a.z);
+    }
+
+    Quaternion operator-() const {
+        return Quaternion(-x, -y, -z, -w);
+    }
+
+    //! Return the conjugate, which is the inverse rotation.
+    Quaternion Conjugate() const {
+        return Quaternion(-x, -y, -z, w);
+    }
+
+    //! Dot product in R4.
+    Scalar Dot(Quaternion const& a) const {
+        return x * a.x + y * a.y + z * a.z + w * a.w;
+    }
+
+    Scalar Length() const {
+        return std::sqrt(Dot(*this));
+    }
+
+    Quaternion Normalize() const {
+        Scalar s = 1.f / Length();
+        return Quaternion(x * s, y * s, z * s, w * s);
+    }
+
+    //! Return `v` rotated by this quaternion. The w component is unchanged.
+    Vector Rotate(Vector const& v) const {
+        //  t = 2 * (q.xyz x v)
+        float tx = 2.f * (y * v.z - z * v.y);
+        float ty = 2.f * (z * v.x - x * v.z);
+        float tz = 2.f * (x * v.y - y * v.x);
+        //  v + q.w * t + q.xyz x t
+        return Vector(v.x + w * tx + (y * tz - z * ty),
+                      v.y + w * ty + (z * tx - x * tz),
+                      v.z + w * tz + (x * ty - y * tx),
+                      v.w);
+    }
+
+    //! Return the normalized linear interpolation to `a` at the fraction `t`.
+    Quaternion Nlerp(Quaternion const& a, Scalar t) const {
+        Scalar s = Dot(a) < 0.f ? -t : t;
+        return Quaternion(x + (a.x * s - x * t),
+                          y + (a.y * s - y * t),
+                          z + (a.z * s - z * t),
+                          w + (a.w * s - w * t)).Normalize();
+    }
+
+    //! Return the spherical linear interpolation to `a` at the fraction `t`.
+    Quaternion Slerp(Quaternion const& a, Scalar t) const {
+        Scalar d = Dot(a);
+        Scalar sign = d < 0.f ? -1.f : 1.f;
+        Scalar theta = std::acos(std::min(1.f, d * sign));
+        Scalar s = std::sin(theta);
+
+        // Fall back to linear interpolation when the angle is too small for
+        // the quotient of sines to be accurate.
+        Scalar s0 = 1.f - t;
+        Scalar s1 = t;
+        if (s > 1e-6f) {
+            s0 = std::sin((1.f - t) * theta) / s;
+            s1 = std::sin(t * theta) / s;
+        }
+        s1 *= sign;
+
+        return Quaternion(x * s0 + a.x * s1,
+                          y * s0 + a.y * s1,
+                          z * s0 + a.z * s1,
+                          w * s0 + a.w * s1);
+    }
+
+    //! Spherical linear interpolation of `count` pairs of quaternions from `a`
+    //! and `b` at the fractions `t` into `dst`.
+    static void SlerpBatch(Quaternion const* a, Quaternion const* b, float const* t, Quaternion* dst, size_t count) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = a[ii].Slerp(b[ii], t[ii]);
+        }
+    }
+
+protected:
+    Scalar x, y, z, w;
+
+protected:
+    friend class Matrix;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Affine transform stored as the first three rows of a 4x4 matrix, the last
+ * row is implicitly { 0, 0, 0, 1 }.
+ */
+class alignas(16) AffineMatrix {
+public:
+    AffineMatrix() {}
+    //! Construct with column vectors, the last element of each is ignored.
+    AffineMatrix(Vector const& X, Vector const& Y, Vector const& Z, Vector const& W)
+        : x(X.x, Y.x, Z.x, W.x)
+        , y(X.y, Y.y, Z.y, W.y)
+        , z(X.z, Y.z, Z.z, W.z) {}
+    AffineMatrix(float m11, float m12, float m13, float m14,
+                 float m21, float m22, float m23, float m24,
+                 float m31, float m32, float m33, float m34)
+        : x(m11, m12, m13, m14)
+        , y(m21, m22, m23, m24)
+        , z(m31, m32, m33, m34) {}
+
+    bool operator==(AffineMatrix const& a) const {
+        return x == a.x && y == a.y && z == a.z;
+    }
+
+    bool operator!=(AffineMatrix const& a) const {
+        return x != a.x || y != a.y || z != a.z;
+    }
+
+    //! Product with `v` as a 4x4 matrix, i.e. the last element is unchanged.
+    Vector operator*(Vector const& v) const {
+        return Vector(x * v, y * v, z * v, v.w);
+    }
+
+    //! Return the composition of this transform with `a`, i.e. the transform
+    //! by `a` followed by this transform.
+    AffineMatrix operator*(AffineMatrix const& a) const {
+        AffineMatrix m;
+
+        for (size_t ii = 0; ii < 3; ++ii) {
+            Vector const& r = (&x)[ii];
+            (&m.x)[ii] = a.x * r.x + a.y * r.y + a.z * r.z + Vector(0.f, 0.f, 0.f, r.w);
+        }
+        return m;
+    }
+
+    //! Return the point `p` transformed by rotation, scale and translation.
+    //! The last element of `p` is ignored and the last element of the result
+    //! is one.
+    Vector TransformPoint(Vector const& p) const {
+        return *this * Vector(p.x, p.y, p.z, 1.f);
+    }
+
+    //! Return the direction `v` transformed by rotation and scale only. The
+    //! last element of `v` is ignored and the last element of the result is
+    //! zero.
+    Vector TransformDirection(Vector const& v) const {
+        return *this * Vector(v.x, v.y, v.z, 0.f);
+    }
+
+protected:
+    //! Rows of the matrix, e.g. `x` produces the x component of a product.
+    Vector x, y, z;
+
 protected:
     friend class Matrix;
 };
@@ -143,6 +527,26 @@ public:
         , z(m13, m23, m33, m43)
         , w(m14, m24, m34, m44) {}
 
+    //! Construct the rotation matrix of the unit quaternion `q`.
+    explicit Matrix(Quaternion const& q)
+        : x(1.f - 2.f * (q.y * q.y + q.z * q.z),
+                  2.f * (q.x * q.y + q.w * q.z),
+                  2.f * (q.x * q.z - q.w * q.y), 0.f)
+        , y(      2.f * (q.x * q.y - q.w * q.z),
+            1.f - 2.f * (q.x * q.x + q.z * q.z),
+                  2.f * (q.y * q.z + q.w * q.x), 0.f)
+        , z(      2.f * (q.x * q.z + q.w * q.y),
+                  2.f * (q.y * q.z - q.w * q.x),
+            1.f - 2.f * (q.x * q.x + q.y * q.y), 0.f)
+        , w(0.f, 0.f, 0.f, 1.f) {}
+
+    //! Construct from an affine transform.
+    explicit Matrix(AffineMatrix const& a)
+        : x(a.x.x, a.y.x, a.z.x, 0.f)
+        , y(a.x.y, a.y.y, a.z.y, 0.f)
+        , z(a.x.z, a.y.z, a.z.z, 0.f)
+        , w(a.x.w, a.y.w, a.z.w, 1.f) {}
+
     Vector& operator[](size_t index) {
         return (&x)[index];
     }
@@ -220,6 +624,135 @@ public:
                       w.Hadamard(a.w));
     }
 
+    //! Return the determinant.
+    Scalar Determinant() const {
+        //  Determinants of the 2x2 minors of the first two and last two rows.
+        float s0 = x.x * y.y - y.x * x.y;
+        float s1 = x.x * z.y - z.x * x.y;
+        float s2 = x.x * w.y - w.x * x.y;
+        float s3 = y.x * z.y - z.x * y.y;
+        float s4 = y.x * w.y - w.x * y.y;
+        float s5 = z.x * w.y - w.x * z.y;
+
+        float c5 = z.z * w.w - w.z * z.w;
+        float c4 = y.z * w.w - w.z * y.w;
+        float c3 = y.z * z.w - z.z * y.w;
+        float c2 = x.z * w.w - w.z * x.w;
+        float c1 = x.z * z.w - z.z * x.w;
+        float c0 = x.z * y.w - y.z * x.w;
+
+        return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    }
+
+    //! Return the inverse. The result is not finite if the matrix is singular,
+    //! i.e. if the determinant is zero.
+    Matrix Inverse() const {
+        float s0 = x.x * y.y - y.x * x.y;
+        float s1 = x.x * z.y - z.x * x.y;
+        float s2 = x.x * w.y - w.x * x.y;
+        float s3 = y.x * z.y - z.x * y.y;
+        float s4 = y.x * w.y - w.x * y.y;
+        float s5 = z.x * w.y - w.x * z.y;
+
+        float c5 = z.z * w.w - w.z * z.w;
+        float c4 = y.z * w.w - w.z * y.w;
+        float c3 = y.z * z.w - z.z * y.w;
+        float c2 = x.z * w.w - w.z * x.w;
+        float c1 = x.z * z.w - z.z * x.w;
+        float c0 = x.z * y.w - y.z * x.w;
+
+        float invdet = 1.f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+        return Matrix(( y.y * c5 - z.y * c4 + w.y * c3) * invdet,
+                      (-y.x * c5 + z.x * c4 - w.x * c3) * invdet,
+                      ( y.w * s5 - z.w * s4 + w.w * s3) * invdet,
+                      (-y.z * s5 + z.z * s4 - w.z * s3) * invdet,
+
+                      (-x.y * c5 + z.y * c2 - w.y * c1) * invdet,
+                      ( x.x * c5 - z.x * c2 + w.x * c1) * invdet,
+                      (-x.w * s5 + z.w * s2 - w.w * s1) * invdet,
+                      ( x.z * s5 - z.z * s2 + w.z * s1) * invdet,
+
+                      ( x.y * c4 - y.y * c2 + w.y * c0) * invdet,
+                      (-x.x * c4 + y.x * c2 - w.x * c0) * invdet,
+                      ( x.w * s4 - y.w * s2 + w.w * s0) * invdet,
+                      (-x.z * s4 + y.z * s2 - w.z * s0) * invdet,
+
+                      (-x.y * c3 + y.y * c1 - z.y * c0) * invdet,
+                      ( x.x * c3 - y.x * c1 + z.x * c0) * invdet,
+                      (-x.w * s3 + y.w * s1 - z.w * s0) * invdet,
+                      ( x.z * s3 - y.z * s1 + z.z * s0) * invdet);
+    }
+
+    //! Return the inverse of an affine transform which is composed of only
+    //! rotation, scale and translation, i.e. whose last row is { 0, 0, 0, 1 }
+    //! and whose upper 3x3 block has orthogonal columns.
+    Matrix InverseAffine() const {
+        float rx = 1.f / (x.x * x.x + x.y * x.y + x.z * x.z);
+        float ry = 1.f / (y.x * y.x + y.y * y.y + y.z * y.z);
+        float rz = 1.f / (z.x * z.x + z.y * z.y + z.z * z.z);
+
+        Vector r0(x.x * rx, y.x * ry, z.x * rz, 0.f);
+        Vector r1(x.y * rx, y.y * ry, z.y * rz, 0.f);
+        Vector r2(x.z * rx, y.z * ry, z.z * rz, 0.f);
+        Vector r3(-(r0.x * w.x + r1.x * w.y + r2.x * w.z),
+                  -(r0.y * w.x + r1.y * w.y + r2.y * w.z),
+                  -(r0.z * w.x + r1.z * w.y + r2.z * w.z),
+                  1.f);
+
+        return Matrix(r0, r1, r2, r3);
+    }
+
+    //! Invert `count` matrices from `src` into `dst`.
+    static void InverseBatch(Matrix const* src, Matrix* dst, size_t count) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = src[ii].Inverse();
+        }
+    }
+
+    //! Transform `count` points from `src` into `dst`, treating the last
+    //! element of each point as one. `stream` has no effect.
+    void TransformPoints(Vector const* src, Vector* dst, size_t count, bool /*stream*/ = false) const {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = *this * Vector(src[ii].x, src[ii].y, src[ii].z, 1.f);
+        }
+    }
+
+    //! Transform `count` directions from `src` into `dst`, treating the last
+    //! element of each direction as zero. `stream` has no effect.
+    void TransformDirections(Vector const* src, Vector* dst, size_t count, bool /*stream*/ = false) const {
+        for (size_t ii = 0; ii < count; ++ii) {
+            dst[ii] = *this * Vector(src[ii].x, src[ii].y, src[ii].z, 0.f);
+        }
+    }
+
+    //! Return the unit quaternion of the rotation in the upper 3x3 block,
+    //! which must be orthonormal. The largest component is computed from the
+    //! diagonal and the others from the off-diagonal elements.
+    Quaternion ToQuaternion() const {
+        float trace = x.x + y.y + z.z;
+
+        if (trace >= x.x && trace >= y.y && trace >= z.z) {
+            float s = 2.f * std::sqrt(1.f + trace);
+            return Quaternion((y.z - z.y) / s, (z.x - x.z) / s, (x.y - y.x) / s, .25f * s);
+        } else if (x.x >= y.y && x.x >= z.z) {
+            float s = 2.f * std::sqrt(1.f + x.x - y.y - z.z);
+            return Quaternion(.25f * s, (y.x + x.y) / s, (z.x + x.z) / s, (y.z - z.y) / s);
+        } else if (y.y >= z.z) {
+            float s = 2.f * std::sqrt(1.f + y.y - x.x - z.z);
+            return Quaternion((y.x + x.y) / s, .25f * s, (z.y + y.z) / s, (z.x - x.z) / s);
+        } else {
+            float s = 2.f * std::sqrt(1.f + z.z - x.x - y.y);
+            return Quaternion((z.x + x.z) / s, (z.y + y.z) / s, .25f * s, (x.y - y.x) / s);
+        }
+    }
+
+    //! Return the first three rows as an affine transform. The last row must
+    //! be { 0, 0, 0, 1 }.
+    AffineMatrix ToAffineMatrix() const {
+        return AffineMatrix(x, y, z, w);
+    }
+
 protected:
     Vector x, y, z, w;
 };
@@ -0,0 +1,615 @@
+#pragma once
+
+#include "Features.h"
+#include "Platform.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Polynomial approximations of exponential, logarithmic and trigonometric
+ * functions on every element of a register. Arguments are reduced to a small
+ * interval, i.e. exponents and multiples of pi/4 are split off, and each
+ * function is approximated on the reduced interval by a polynomial.
+ *
+ * The degree of the polynomials is selected by `Accuracy`; lower accuracy uses
+ * fewer terms. The `High` polynomials are those of the Cephes library. Domains
+ * and special values are handled without branches as follows:
+ *
+ *  exp, exp2   Results are flushed to zero below the smallest normal float and
+ *              clamped to slightly less than the largest finite float.
+ *  log, log2   Zero and denormal arguments return the logarithm of the
+ *              smallest normal float and negative arguments return NaN.
+ *  pow         Computed as exp2(y * log2(x)) for x > 0, so the relative error
+ *              grows with the magnitude of y * log2(x). pow(0, y) is zero for
+ *              y > 0 and negative x returns NaN regardless of y.
+ *  sin, cos    Reduction by multiples of pi/4 is accurate for |x| < 8192.
+ *
+ * Infinities are never produced or expected as arguments so the functions are
+ * unaffected by fast-math builds which assume finite values.
+ */
+
+namespace intrinsic {
+
+//! Accuracy of transcendental function approximations.
+enum class Accuracy {
+    Low,        //!< relative error below 1e-3, about 11 bits
+    Medium,     //!< relative error below 1e-5, about 17 bits
+    High,       //!< within a few units in the last place
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Register operations used by transcendental functions and packet types,
+//! specialized by the number of elements in each register.
+template<size_t N> struct _math_ops;
+
+template<>
+struct _math_ops<4> {
+    using type = __m128;
+    using itype = __m128i;
+
+    static __m128 VECTORCALL set1(float a) { return _mm_set_ps1(a); }
+    static __m128 VECTORCALL zero() { return _mm_setzero_ps(); }
+    static __m128 VECTORCALL loadu(float const* a) { return _mm_loadu_ps(a); }
+    static void VECTORCALL storeu(float* a, __m128 b) { _mm_storeu_ps(a, b); }
+
+    static __m128 VECTORCALL add(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+    static __m128 VECTORCALL sub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+    static __m128 VECTORCALL mul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+    static __m128 VECTORCALL div(__m128 a, __m128 b) { return _mm_div_ps(a, b); }
+    static __m128 VECTORCALL sqrt(__m128 a) { return _mm_sqrt_ps(a); }
+    static __m128 VECTORCALL rsqrt(__m128 a) { return _mm_rsqrt_ps(a); }
+    static __m128 VECTORCALL min(__m128 a, __m128 b) { return _mm_min_ps(a, b); }
+    static __m128 VECTORCALL max(__m128 a, __m128 b) { return _mm_max_ps(a, b); }
+    static __m128 VECTORCALL and_(__m128 a, __m128 b) { return _mm_and_ps(a, b); }
+    static __m128 VECTORCALL or_(__m128 a, __m128 b) { return _mm_or_ps(a, b); }
+    static __m128 VECTORCALL xor_(__m128 a, __m128 b) { return _mm_xor_ps(a, b); }
+    static __m128 VECTORCALL andnot(__m128 a, __m128 b) { return _mm_andnot_ps(a, b); }
+    static __m128 VECTORCALL cmpeq(__m128 a, __m128 b) { return _mm_cmpeq_ps(a, b); }
+    static __m128 VECTORCALL cmpneq(__m128 a, __m128 b) { return _mm_cmpneq_ps(a, b); }
+    static __m128 VECTORCALL cmplt(__m128 a, __m128 b) { return _mm_cmplt_ps(a, b); }
+    static __m128 VECTORCALL cmple(__m128 a, __m128 b) { return _mm_cmple_ps(a, b); }
+    static __m128 VECTORCALL cmpgt(__m128 a, __m128 b) { return _mm_cmpgt_ps(a, b); }
+    static __m128 VECTORCALL cmpge(__m128 a, __m128 b) { return _mm_cmpge_ps(a, b); }
+    static int VECTORCALL movemask(__m128 a) { return _mm_movemask_ps(a); }
+
+    //! dst[i] = mask[i] ? a[i] : b[i]
+    static __m128 VECTORCALL select(__m128 mask, __m128 a, __m128 b) {
+#if _HAS_SSE4_1
+        return _mm_blendv_ps(b, a, mask);
+#else
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+#endif
+    }
+
+    //! a * b + c
+    static __m128 VECTORCALL fmadd(__m128 a, __m128 b, __m128 c) {
+#if _HAS_FMA
+        return _mm_fmadd_ps(a, b, c);
+#else
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+    }
+
+    //! Return `a` as an opaque value, which prevents fast-math builds from
+    //! reassociating the operations which produced it with later ones.
+    static __m128 VECTORCALL opaque(__m128 a) {
+#if defined(__GNUC__) || defined(__clang__)
+        __asm__("" : "+x"(a));
+#endif
+        return a;
+    }
+
+    //! c - a * b
+    static __m128 VECTORCALL fnmadd(__m128 a, __m128 b, __m128 c) {
+#if _HAS_FMA
+        return _mm_fnmadd_ps(a, b, c);
+#else
+        return _mm_sub_ps(c, _mm_mul_ps(a, b));
+#endif
+    }
+
+    //! a * b - c
+    static __m128 VECTORCALL fmsub(__m128 a, __m128 b, __m128 c) {
+#if _HAS_FMA
+        return _mm_fmsub_ps(a, b, c);
+#else
+        return _mm_sub_ps(_mm_mul_ps(a, b), c);
+#endif
+    }
+
+    //! Convert with rounding to nearest, or with truncation.
+    static __m128i VECTORCALL cvt(__m128 a) { return _mm_cvtps_epi32(a); }
+    static __m128i VECTORCALL cvtt(__m128 a) { return _mm_cvttps_epi32(a); }
+    static __m128 VECTORCALL cvtf(__m128i a) { return _mm_cvtepi32_ps(a); }
+    static __m128 VECTORCALL castps(__m128i a) { return _mm_castsi128_ps(a); }
+    static __m128i VECTORCALL castsi(__m128 a) { return _mm_castps_si128(a); }
+
+    static __m128i VECTORCALL iset1(int32_t a) { return _mm_set1_epi32(a); }
+    static __m128i VECTORCALL iloadu(uint32_t const* a) { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(a)); }
+    static __m128i VECTORCALL iadd(__m128i a, __m128i b) { return _mm_add_epi32(a, b); }
+    static __m128i VECTORCALL isub(__m128i a, __m128i b) { return _mm_sub_epi32(a, b); }
+    static __m128i VECTORCALL iand(__m128i a, __m128i b) { return _mm_and_si128(a, b); }
+    static __m128i VECTORCALL ior(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+    static __m128i VECTORCALL ixor(__m128i a, __m128i b) { return _mm_xor_si128(a, b); }
+    static __m128i VECTORCALL iandnot(__m128i a, __m128i b) { return _mm_andnot_si128(a, b); }
+    static __m128i VECTORCALL icmpeq(__m128i a, __m128i b) { return _mm_cmpeq_epi32(a, b); }
+    template<int imm> static __m128i VECTORCALL slli(__m128i a) { return _mm_slli_epi32(a, imm); }
+    template<int imm> static __m128i VECTORCALL srli(__m128i a) { return _mm_srli_epi32(a, imm); }
+};
+
+#if _HAS_AVX
+template<>
+struct _math_ops<8> {
+    using type = __m256;
+    using itype = __m256i;
+
+    static __m256 VECTORCALL set1(float a) { return _mm256_set1_ps(a); }
+    static __m256 VECTORCALL zero() { return _mm256_setzero_ps(); }
+    static __m256 VECTORCALL loadu(float const* a) { return _mm256_loadu_ps(a); }
+    static void VECTORCALL storeu(float* a, __m256 b) { _mm256_storeu_ps(a, b); }
+
+    static __m256 VECTORCALL add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+    static __m256 VECTORCALL sub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+    static __m256 VECTORCALL mul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+    static __m256 VECTORCALL div(__m256 a, __m256 b) { return _mm256_div_ps(a, b); }
+    static __m256 VECTORCALL sqrt(__m256 a) { return _mm256_sqrt_ps(a); }
+    static __m256 VECTORCALL rsqrt(__m256 a) { return _mm256_rsqrt_ps(a); }
+    static __m256 VECTORCALL min(__m256 a, __m256 b) { return _mm256_min_ps(a, b); }
+    static __m256 VECTORCALL max(__m256 a, __m256 b) { return _mm256_max_ps(a, b); }
+    static __m256 VECTORCALL and_(__m256 a, __m256 b) { return _mm256_and_ps(a, b); }
+    static __m256 VECTORCALL or_(__m256 a, __m256 b) { return _mm256_or_ps(a, b); }
+    static __m256 VECTORCALL xor_(__m256 a, __m256 b) { return _mm256_xor_ps(a, b); }
+    static __m256 VECTORCALL andnot(__m256 a, __m256 b) { return _mm256_andnot_ps(a, b); }
+    static __m256 VECTORCALL cmpeq(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static __m256 VECTORCALL cmpneq(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+    static __m256 VECTORCALL cmplt(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static __m256 VECTORCALL cmple(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static __m256 VECTORCALL cmpgt(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static __m256 VECTORCALL cmpge(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static int VECTORCALL movemask(__m256 a) { return _mm256_movemask_ps(a); }
+
+    //! dst[i] = mask[i] ? a[i] : b[i]
+    static __m256 VECTORCALL select(__m256 mask, __m256 a, __m256 b) {
+        return _mm256_blendv_ps(b, a, mask);
+    }
+
+    //! a * b + c
+    static __m256 VECTORCALL fmadd(__m256 a, __m256 b, __m256 c) {
+#if _HAS_FMA
+        return _mm256_fmadd_ps(a, b, c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+
+    //! Return `a` as an opaque value, which prevents fast-math builds from
+    //! reassociating the operations which produced it with later ones.
+    static __m256 VECTORCALL opaque(__m256 a) {
+#if defined(__GNUC__) || defined(__clang__)
+        __asm__("" : "+x"(a));
+#endif
+        return a;
+    }
+
+    //! c - a * b
+    static __m256 VECTORCALL fnmadd(__m256 a, __m256 b, __m256 c) {
+#if _HAS_FMA
+        return _mm256_fnmadd_ps(a, b, c);
+#else
+        return _mm256_sub_ps(c, _mm256_mul_ps(a, b));
+#endif
+    }
+
+    //! a * b - c
+    static __m256 VECTORCALL fmsub(__m256 a, __m256 b, __m256 c) {
+#if _HAS_FMA
+        return _mm256_fmsub_ps(a, b, c);
+#else
+        return _mm256_sub_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+
+    //! Convert with rounding to nearest, or with truncation.
+    static __m256i VECTORCALL cvt(__m256 a) { return _mm256_cvtps_epi32(a); }
+    static __m256i VECTORCALL cvtt(__m256 a) { return _mm256_cvttps_epi32(a); }
+    static __m256 VECTORCALL cvtf(__m256i a) { return _mm256_cvtepi32_ps(a); }
+    static __m256 VECTORCALL castps(__m256i a) { return _mm256_castsi256_ps(a); }
+    static __m256i VECTORCALL castsi(__m256 a) { return _mm256_castps_si256(a); }
+
+    static __m256i VECTORCALL iset1(int32_t a) { return _mm256_set1_epi32(a); }
+    static __m256i VECTORCALL iloadu(uint32_t const* a) { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a)); }
+
+#if _HAS_AVX2
+    static __m256i VECTORCALL iadd(__m256i a, __m256i b) { return _mm256_add_epi32(a, b); }
+    static __m256i VECTORCALL isub(__m256i a, __m256i b) { return _mm256_sub_epi32(a, b); }
+    static __m256i VECTORCALL iand(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+    static __m256i VECTORCALL ior(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+    static __m256i VECTORCALL ixor(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+    static __m256i VECTORCALL iandnot(__m256i a, __m256i b) { return _mm256_andnot_si256(a, b); }
+    static __m256i VECTORCALL icmpeq(__m256i a, __m256i b) { return _mm256_cmpeq_epi32(a, b); }
+    template<int imm> static __m256i VECTORCALL slli(__m256i a) { return _mm256_slli_epi32(a, imm); }
+    template<int imm> static __m256i VECTORCALL srli(__m256i a) { return _mm256_srli_epi32(a, imm); }
+#else
+    //  Integer operations on 256-bit registers require AVX2, otherwise each
+    //  half is operated on separately.
+    static __m128i VECTORCALL lo(__m256i a) { return _mm256_castsi256_si128(a); }
+    static __m128i VECTORCALL hi(__m256i a) { return _mm256_extractf128_si256(a, 1); }
+    static __m256i VECTORCALL combine(__m128i lo, __m128i hi) {
+        return _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    }
+
+    static __m256i VECTORCALL iadd(__m256i a, __m256i b) {
+        return combine(_mm_add_epi32(lo(a), lo(b)), _mm_add_epi32(hi(a), hi(b)));
+    }
+    static __m256i VECTORCALL isub(__m256i a, __m256i b) {
+        return combine(_mm_sub_epi32(lo(a), lo(b)), _mm_sub_epi32(hi(a), hi(b)));
+    }
+    static __m256i VECTORCALL iand(__m256i a, __m256i b) {
+        return _mm256_castps_si256(_mm256_and_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+    }
+    static __m256i VECTORCALL iandnot(__m256i a, __m256i b) {
+        return _mm256_castps_si256(_mm256_andnot_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+    }
+    static __m256i VECTORCALL ior(__m256i a, __m256i b) {
+        return _mm256_castps_si256(_mm256_or_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+    }
+    static __m256i VECTORCALL ixor(__m256i a, __m256i b) {
+        return _mm256_castps_si256(_mm256_xor_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+    }
+    static __m256i VECTORCALL icmpeq(__m256i a, __m256i b) {
+        return combine(_mm_cmpeq_epi32(lo(a), lo(b)), _mm_cmpeq_epi32(hi(a), hi(b)));
+    }
+    template<int imm> static __m256i VECTORCALL slli(__m256i a) {
+        return combine(_mm_slli_epi32(lo(a), imm), _mm_slli_epi32(hi(a), imm));
+    }
+    template<int imm> static __m256i VECTORCALL srli(__m256i a) {
+        return combine(_mm_srli_epi32(lo(a), imm), _mm_srli_epi32(hi(a), imm));
+    }
+#endif // _HAS_AVX2
+};
+#endif // _HAS_AVX
+
+////////////////////////////////////////////////////////////////////////////////
+//! Implementation of transcendental functions for registers of `N` elements.
+template<size_t N, Accuracy A>
+class _math {
+    using ops = _math_ops<N>;
+    using type = typename ops::type;
+    using itype = typename ops::itype;
+
+public:
+    //! e^x
+    static type VECTORCALL exp(type x) {
+        //  x = n * ln(2) + r, |r| <= ln(2) / 2
+        type xc = ops::min(ops::max(x, ops::set1(kMinLog)), ops::set1(kMaxLog));
+        type n = Exponent(ops::mul(xc, ops::set1(kLog2e)));
+
+        //  Subtract n * ln(2) in two parts to preserve the low bits of r.
+        type r = ops::opaque(ops::fnmadd(n, ops::set1(kLn2Hi), xc));
+        r = ops::fnmadd(n, ops::set1(kLn2Lo), r);
+
+        return Scale(x, ops::set1(kMinLog), ExpReduced(r), n);
+    }
+
+    //! 2^x
+    static type VECTORCALL exp2(type x) {
+        //  x = n + f, |f| <= 1/2
+        type xc = ops::min(ops::max(x, ops::set1(kMinLog2)), ops::set1(kMaxLog2));
+        type n = Exponent(xc);
+        type r = ops::mul(ops::sub(xc, n), ops::set1(kLn2));
+
+        return Scale(x, ops::set1(kMinLog2), ExpReduced(r), n);
+    }
+
+    //! Natural logarithm of x.
+    static type VECTORCALL log(type x) {
+        type e, m;
+        type y = LogReduced(x, e, m);
+
+        //  log(x) = e * ln(2) + log(1 + m), with e * ln(2) added in two parts.
+        //  Terms are summed from smallest to largest so that the smaller terms
+        //  are not absorbed by the larger ones.
+        y = ops::opaque(ops::fmadd(e, ops::set1(kLn2Lo), y));
+        y = ops::opaque(ops::add(m, y));
+        y = ops::fmadd(e, ops::set1(kLn2Hi), y);
+
+        return ops::or_(y, ops::cmplt(x, ops::set1(0.f)));
+    }
+
+    //! Base-2 logarithm of x.
+    static type VECTORCALL log2(type x) {
+        type e, m;
+        type y = LogReduced(x, e, m);
+
+        //  log2(x) = e + log(1 + m) * log2(e), with log2(e) = 1 + kLog2eM1 so
+        //  that the larger part of the product is exact.
+        type z = ops::mul(y, ops::set1(kLog2eM1));
+        z = ops::opaque(ops::fmadd(m, ops::set1(kLog2eM1), z));
+        z = ops::opaque(ops::add(z, y));
+        z = ops::opaque(ops::add(z, m));
+        z = ops::add(z, e);
+
+        return ops::or_(z, ops::cmplt(x, ops::set1(0.f)));
+    }
+
+    //! x^y
+    static type VECTORCALL pow(type x, type y) {
+        type r = exp2(ops::mul(y, log2(x)));
+
+        //  0^y = 0 for y > 0, regardless of how small y * log2(x) is.
+        type zero = ops::and_(ops::cmpeq(x, ops::set1(0.f)), ops::cmpgt(y, ops::set1(0.f)));
+        return ops::andnot(zero, r);
+    }
+
+    //! Sine of x in radians.
+    static type VECTORCALL sin(type x) {
+        itype j;
+        type s, c;
+        SinCosReduced(x, j, s, c);
+
+        //  The octant selects the polynomial and the sign of the result, which
+        //  is negated in octants 4-7 and for negative arguments.
+        type sign = ops::xor_(ops::and_(x, SignMask()), ops::castps(ops::template slli<29>(ops::iand(j, ops::iset1(4)))));
+        type poly = ops::castps(ops::icmpeq(ops::iand(j, ops::iset1(2)), ops::iset1(0)));
+        return ops::xor_(ops::select(poly, s, c), sign);
+    }
+
+    //! Cosine of x in radians.
+    static type VECTORCALL cos(type x) {
+        itype j;
+        type s, c;
+        SinCosReduced(x, j, s, c);
+
+        //  cos(x) = sin(x + pi/2), i.e. the octant is offset by 2.
+        itype k = ops::isub(j, ops::iset1(2));
+        type sign = ops::castps(ops::template slli<29>(ops::iandnot(k, ops::iset1(4))));
+        type poly = ops::castps(ops::icmpeq(ops::iand(k, ops::iset1(2)), ops::iset1(0)));
+        return ops::xor_(ops::select(poly, s, c), sign);
+    }
+
+    //! Sine and cosine of x in radians, sharing the argument reduction.
+    static void VECTORCALL sincos(type x, type& sin_x, type& cos_x) {
+        itype j;
+        type s, c;
+        SinCosReduced(x, j, s, c);
+
+        type sin_sign = ops::xor_(ops::and_(x, SignMask()), ops::castps(ops::template slli<29>(ops::iand(j, ops::iset1(4)))));
+        type cos_sign = ops::castps(ops::template slli<29>(ops::iandnot(ops::isub(j, ops::iset1(2)), ops::iset1(4))));
+        type poly = ops::castps(ops::icmpeq(ops::iand(j, ops::iset1(2)), ops::iset1(0)));
+
+        sin_x = ops::xor_(ops::select(poly, s, c), sin_sign);
+        cos_x = ops::xor_(ops::select(poly, c, s), cos_sign);
+    }
+
+protected:
+    static constexpr float kLog2e = 1.44269504088896341f;
+    static constexpr float kLog2eM1 = 0.44269504088896341f;
+    static constexpr float kLn2 = 0.693147180559945309f;
+    //! ln(2) split into a part with only the upper 12 bits set and the rest.
+    static constexpr float kLn2Hi = 0.693359375f;
+    static constexpr float kLn2Lo = -2.12194440e-4f;
+
+    //! Range of arguments to exp and exp2 with normal finite results, with
+    //! margin for the error of the polynomial at the upper end.
+    static constexpr float kMinLog = -87.3365448f;
+    static constexpr float kMaxLog = 88.72f;
+    static constexpr float kMinLog2 = -126.f;
+    static constexpr float kMaxLog2 = 127.99f;
+
+    static constexpr float kSqrtHalf = 0.707106781186547524f;
+
+    //! 4 / pi, and pi / 4 split into three parts.
+    static constexpr float kFourOverPi = 1.27323954473516f;
+    static constexpr float kPiOver4A = 0.78515625f;
+    static constexpr float kPiOver4B = 2.4187564849853515625e-4f;
+    static constexpr float kPiOver4C = 3.77489497744594108e-8f;
+
+    static type VECTORCALL SignMask() {
+        return ops::castps(ops::iset1(INT32_MIN));
+    }
+
+    //! Round to the nearest integer, at most 127 so that 2^n is finite. The
+    //! reduced argument is then slightly larger than 1/2 for the largest
+    //! arguments to exp and exp2.
+    static type VECTORCALL Exponent(type x) {
+        return ops::min(ops::cvtf(ops::cvt(x)), ops::set1(127.f));
+    }
+
+    //! Evaluate the polynomial with coefficients `c` from highest to lowest
+    //! degree at `x`.
+    template<size_t K>
+    static type VECTORCALL Poly(type x, float const (&c)[K]) {
+        type y = ops::set1(c[0]);
+        for (size_t ii = 1; ii < K; ++ii) {
+            y = ops::fmadd(y, x, ops::set1(c[ii]));
+        }
+        return y;
+    }
+
+    //! e^r for |r| <= ln(2) / 2, as 1 + r + r^2 * P(r).
+    static type VECTORCALL ExpReduced(type r) {
+        static constexpr float kLow[] = {1.6662816851e-1f, 5.0394108881e-1f};
+        static constexpr float kMedium[] = {4.1277735264e-2f, 1.6753514370e-1f, 5.0005116173e-1f};
+        static constexpr float kHigh[] = {1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+                                          4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f};
+
+        type p = A == Accuracy::Low ? Poly(r, kLow)
+               : A == Accuracy::Medium ? Poly(r, kMedium)
+               : Poly(r, kHigh);
+
+        return ops::add(ops::fmadd(p, ops::mul(r, r), r), ops::set1(1.f));
+    }
+
+    //! Multiply `y` by 2^n and flush to zero where `x` is less than `min`.
+    static type VECTORCALL Scale(type x, type min, type y, type n) {
+        itype e = ops::cvt(n);
+        type pow2n = ops::castps(ops::template slli<23>(ops::iadd(e, ops::iset1(127))));
+        //  Fast-math builds would otherwise distribute the product over the sum
+        //  in `y`, which flushes terms to zero for the smallest results.
+        return ops::and_(ops::mul(ops::opaque(y), pow2n), ops::cmpge(x, min));
+    }
+
+    //! Split `x` into `2^e * (1 + m)` with sqrt(1/2) <= 1 + m < sqrt(2) and
+    //! return `log(1 + m) - m`.
+    static type VECTORCALL LogReduced(type x, type& e, type& m) {
+        static constexpr float kLow[] = {1.7324850878e-1f, -2.6461238997e-1f, 3.3567347665e-1f};
+        static constexpr float kMedium[] = {1.1781789097e-1f, -1.8407180673e-1f, 2.0442207051e-1f,
+                                            -2.4943833155e-1f, 3.3320860132e-1f};
+        static constexpr float kHigh[] = {7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f,
+                                          -1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f,
+                                          2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f};
+
+        //  Zero and denormals are treated as the smallest normal value.
+        type xc = ops::max(x, ops::castps(ops::iset1(0x00800000)));
+        itype bits = ops::castsi(xc);
+
+        //  x = 2^e * f, 1/2 <= f < 1
+        e = ops::cvtf(ops::isub(ops::template srli<23>(bits), ops::iset1(126)));
+        type f = ops::castps(ops::iadd(ops::iand(bits, ops::iset1(0x007fffff)), ops::iset1(0x3f000000)));
+
+        //  Move f into [sqrt(1/2), sqrt(2)) by doubling it if it is too small.
+        type small = ops::cmplt(f, ops::set1(kSqrtHalf));
+        e = ops::opaque(ops::sub(e, ops::and_(small, ops::set1(1.f))));
+        m = ops::add(ops::sub(f, ops::set1(1.f)), ops::and_(small, f));
+
+        //  log(1 + m) - m = m^3 * P(m) - m^2 / 2
+        type m2 = ops::mul(m, m);
+        type p = A == Accuracy::Low ? Poly(m, kLow)
+               : A == Accuracy::Medium ? Poly(m, kMedium)
+               : Poly(m, kHigh);
+
+        return ops::fnmadd(ops::set1(.5f), m2, ops::mul(ops::mul(p, m), m2));
+    }
+
+    //! Reduce |x| by the multiple of pi/4 with even octant `j` to `r` and
+    //! return `s` = sin(r) and `c` = cos(r).
+    static void VECTORCALL SinCosReduced(type x, itype& j, type& s, type& c) {
+        static constexpr float kSinLow[] = {-1.6242790993e-1f};
+        static constexpr float kSinMedium[] = {8.1632820482e-3f, -1.6663390384e-1f};
+        static constexpr float kSinHigh[] = {-1.9515295891e-4f, 8.3321608736e-3f, -1.6666654611e-1f};
+        static constexpr float kCosLow[] = {4.0899302984e-2f};
+        static constexpr float kCosMedium[] = {-1.3648713563e-3f, 4.1661071261e-2f};
+        static constexpr float kCosHigh[] = {2.443315711809948e-5f, -1.388731625493765e-3f, 4.166664568298827e-2f};
+
+        type ax = ops::andnot(SignMask(), x);
+
+        //  j = (int(|x| * 4 / pi) + 1) & ~1
+        j = ops::cvtt(ops::mul(ax, ops::set1(kFourOverPi)));
+        j = ops::iand(ops::iadd(j, ops::iset1(1)), ops::iset1(~1));
+        type y = ops::cvtf(j);
+
+        //  Subtract y * pi / 4 in three parts to preserve the low bits of r.
+        type r = ops::opaque(ops::fnmadd(y, ops::set1(kPiOver4A), ax));
+        r = ops::opaque(ops::fnmadd(y, ops::set1(kPiOver4B), r));
+        r = ops::fnmadd(y, ops::set1(kPiOver4C), r);
+
+        type z = ops::mul(r, r);
+
+        //  sin(r) = r + r^3 * P(r^2)
+        type ps = A == Accuracy::Low ? Poly(z, kSinLow)
+                : A == Accuracy::Medium ? Poly(z, kSinMedium)
+                : Poly(z, kSinHigh);
+        s = ops::fmadd(ops::mul(ps, z), r, r);
+
+        //  cos(r) = 1 - r^2 / 2 + r^4 * Q(r^2)
+        type pc = A == Accuracy::Low ? Poly(z, kCosLow)
+                : A == Accuracy::Medium ? Poly(z, kCosMedium)
+                : Poly(z, kCosHigh);
+        c = ops::add(ops::fnmadd(ops::set1(.5f), z, ops::mul(ops::mul(pc, z), z)), ops::set1(1.f));
+    }
+};
+
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kLog2e;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kLog2eM1;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kLn2;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kLn2Hi;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kLn2Lo;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kMinLog;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kMaxLog;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kMinLog2;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kMaxLog2;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kSqrtHalf;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kFourOverPi;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kPiOver4A;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kPiOver4B;
+template<size_t N, Accuracy A> constexpr float _math<N, A>::kPiOver4C;
+
+////////////////////////////////////////////////////////////////////////////////
+//! dst[i] = e^src[i]
+template<Accuracy A = Accuracy::High>
+inline __m128 VECTORCALL _v_exp_ps(__m128 src) { return _math<4, A>::exp(src); }
+
+//! dst[i] = 2^src[i]
+template<Accuracy A = Accuracy::High>
+inline __m128 VECTORCALL _v_exp2_ps(__m128 src) { return _math<4, A>::exp2(src); }
+
+//! dst[i] = log(src[i])
+template<Accuracy A = Accuracy::High>
+inline __m128 VECTORCALL _v_log_ps(__m128 src) { return _math<4, A>::log(src); }
+
+//! dst[i] = log2(src[i])
+template<Accuracy A = Accuracy::High>
+inline __m128 VECTORCALL _v_log2_ps(__m128 src) { return _math<4, A>::log2(src); }
+
+//! dst[i] = src0[i]^src1[i]
+template<Accuracy A = Accuracy::High>
+inline __m128 VECTORCALL _v_pow_ps(__m128 src0, __m128 src1) { return _math<4, A>::pow(src0, src1); }
+
+//! dst[i] = sin(src[i])
+template<Accuracy A = Accuracy::High>
+inline __m128 VECTORCALL _v_sin_ps(__m128 src) { return _math<4, A>::sin(src); }
+
+//! dst[i] = cos(src[i])
+template<Accuracy A = Accuracy::High>
+inline __m128 VECTORCALL _v_cos_ps(__m128 src) { return _math<4, A>::cos(src); }
+
+//! sin_dst[i] = sin(src[i]), cos_dst[i] = cos(src[i])
+template<Accuracy A = Accuracy::High>
+inline void VECTORCALL _v_sincos_ps(__m128 src, __m128& sin_dst, __m128& cos_dst) {
+    _math<4, A>::sincos(src, sin_dst, cos_dst);
+}
+
+#if _HAS_AVX
+////////////////////////////////////////////////////////////////////////////////
+//! dst[i] = e^src[i]
+template<Accuracy A = Accuracy::High>
+inline __m256 VECTORCALL _v_exp_ps(__m256 src) { return _math<8, A>::exp(src); }
+
+//! dst[i] = 2^src[i]
+template<Accuracy A = Accuracy::High>
+inline __m256 VECTORCALL _v_exp2_ps(__m256 src) { return _math<8, A>::exp2(src); }
+
+//! dst[i] = log(src[i])
+template<Accuracy A = Accuracy::High>
+inline __m256 VECTORCALL _v_log_ps(__m256 src) { return _math<8, A>::log(src); }
+
+//! dst[i] = log2(src[i])
+template<Accuracy A = Accuracy::High>
+inline __m256 VECTORCALL _v_log2_ps(__m256 src) { return _math<8, A>::log2(src); }
+
+//! dst[i] = src0[i]^src1[i]
+template<Accuracy A = Accuracy::High>
+inline __m256 VECTORCALL _v_pow_ps(__m256 src0, __m256 src1) { return _math<8, A>::pow(src0, src1); }
+
+//! dst[i] = sin(src[i])
+template<Accuracy A = Accuracy::High>
+inline __m256 VECTORCALL _v_sin_ps(__m256 src) { return _math<8, A>::sin(src); }
+
+//! dst[i] = cos(src[i])
+template<Accuracy A = Accuracy::High>
+inline __m256 VECTORCALL _v_cos_ps(__m256 src) { return _math<8, A>::cos(src); }
+
+//! sin_dst[i] = sin(src[i]), cos_dst[i] = cos(src[i])
+template<Accuracy A = Accuracy::High>
+inline void VECTORCALL _v_sincos_ps(__m256 src, __m256& sin_dst, __m256& cos_dst) {
+    _math<8, A>::sincos(src, sin_dst, cos_dst);
+}
+#endif // _HAS_AVX
+
+} // namespace intrinsic